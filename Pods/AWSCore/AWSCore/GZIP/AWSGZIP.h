@@ -35,6 +35,36 @@
 
 void awsgzip_loadGZIP(void);
 
+typedef void (^AWSGZIPOutputHandler)(const void *bytes, NSUInteger length);
+
+/**
+ Compresses to or decompresses from the gzip format incrementally, so that a payload can be processed
+ as it arrives instead of all at once. The zlib state and the output buffer are kept across calls,
+ and across payloads after -reset.
+ */
+@interface AWSGZIPStream : NSObject
+
+- (instancetype)initCompressorWithCompressionLevel:(float)level;
+- (instancetype)initDecompressor;
+
+/**
+ Processes the bytes and passes any output to the handler, in one or more calls. The output bytes are
+ only valid during the call. Returns NO if the input is not valid gzip data.
+ */
+- (BOOL)processBytes:(const void *)bytes length:(NSUInteger)length outputHandler:(AWSGZIPOutputHandler)outputHandler;
+
+/**
+ Passes the remaining output to the handler. A decompressor returns NO if the gzip data was incomplete.
+ */
+- (BOOL)finishWithOutputHandler:(AWSGZIPOutputHandler)outputHandler;
+
+/**
+ Prepares the stream for the next payload, keeping its memory.
+ */
+- (void)reset;
+
+@end
+
 @interface NSData (AWSGZIP)
 
 - (NSData *)awsgzip_gzippedDataWithCompressionLevel:(float)level;
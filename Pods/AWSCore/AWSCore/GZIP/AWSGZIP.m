@@ -38,6 +38,212 @@ void awsgzip_loadGZIP(){
 }
 
 static const NSUInteger ChunkSize = 16384;
+static const NSUInteger PoolSize = 4;
+
+
+@interface AWSGZIPStream ()
+
+@property (nonatomic, readonly, getter=isCompressor) BOOL compressor;
+@property (nonatomic, readonly) int level;
+
+- (NSData *)compressedData:(NSData *)data;
+
+@end
+
+
+@implementation AWSGZIPStream
+{
+    z_stream _stream;
+    BOOL _compressor;
+    int _level;
+    BOOL _finished;
+    uint8_t *_buffer;
+}
+
+- (instancetype)initCompressorWithCompressionLevel:(float)level
+{
+    if ((self = [super init]))
+    {
+        _compressor = YES;
+        _level = (level < 0.0f)? Z_DEFAULT_COMPRESSION: (int)(roundf(level * 9));
+        _buffer = malloc(ChunkSize);
+        if (!_buffer || deflateInit2(&_stream, _level, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (instancetype)initDecompressor
+{
+    if ((self = [super init]))
+    {
+        _buffer = malloc(ChunkSize);
+        if (!_buffer || inflateInit2(&_stream, 47) != Z_OK)
+        {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_compressor)
+    {
+        deflateEnd(&_stream);
+    }
+    else
+    {
+        inflateEnd(&_stream);
+    }
+    free(_buffer);
+}
+
+- (BOOL)runWithFlush:(int)flush outputHandler:(AWSGZIPOutputHandler)outputHandler
+{
+    do
+    {
+        _stream.next_out = _buffer;
+        _stream.avail_out = (uInt)ChunkSize;
+        int status = _compressor? deflate(&_stream, flush): inflate(&_stream, Z_NO_FLUSH);
+        if (status == Z_STREAM_ERROR || status == Z_DATA_ERROR || status == Z_MEM_ERROR || status == Z_NEED_DICT)
+        {
+            return NO;
+        }
+        NSUInteger length = ChunkSize - _stream.avail_out;
+        if (length > 0)
+        {
+            outputHandler(_buffer, length);
+        }
+        if (status == Z_STREAM_END)
+        {
+            _finished = YES;
+            break;
+        }
+        if (status == Z_BUF_ERROR)
+        {
+            //No progress is possible without more input.
+            break;
+        }
+    }
+    while (_stream.avail_out == 0 || _stream.avail_in > 0);
+    return YES;
+}
+
+- (BOOL)processBytes:(const void *)bytes length:(NSUInteger)length outputHandler:(AWSGZIPOutputHandler)outputHandler
+{
+    //avail_in is 32 bits wide.
+    while (length > 0 && !_finished)
+    {
+        uInt chunkLength = (uInt)MIN(length, (NSUInteger)UINT_MAX);
+        _stream.next_in = (Bytef *)bytes;
+        _stream.avail_in = chunkLength;
+        if (![self runWithFlush:Z_NO_FLUSH outputHandler:outputHandler])
+        {
+            return NO;
+        }
+        bytes = (const uint8_t *)bytes + chunkLength;
+        length -= chunkLength;
+    }
+    return YES;
+}
+
+- (BOOL)finishWithOutputHandler:(AWSGZIPOutputHandler)outputHandler
+{
+    if (_compressor && !_finished)
+    {
+        _stream.next_in = Z_NULL;
+        _stream.avail_in = 0;
+        if (![self runWithFlush:Z_FINISH outputHandler:outputHandler])
+        {
+            return NO;
+        }
+    }
+    return _finished;
+}
+
+- (void)reset
+{
+    if (_compressor)
+    {
+        deflateReset(&_stream);
+    }
+    else
+    {
+        inflateReset(&_stream);
+    }
+    _finished = NO;
+}
+
+//Compresses a whole buffer with a single deflate call into an output sized for the worst case,
+//so the output is never grown and copied.
+- (NSData *)compressedData:(NSData *)data
+{
+    if ([data length] > UINT_MAX)
+    {
+        return nil;
+    }
+    NSMutableData *output = [NSMutableData dataWithLength:deflateBound(&_stream, (uLong)[data length])];
+    _stream.next_in = (Bytef *)[data bytes];
+    _stream.avail_in = (uInt)[data length];
+    _stream.next_out = [output mutableBytes];
+    _stream.avail_out = (uInt)[output length];
+    if (deflate(&_stream, Z_FINISH) != Z_STREAM_END)
+    {
+        return nil;
+    }
+    _finished = YES;
+    output.length = _stream.total_out;
+    return output;
+}
+
+@end
+
+
+//Creating a z_stream allocates several hundred KB for a compressor, so a few idle streams are kept for reuse.
+static NSMutableArray<AWSGZIPStream *> *awsgzip_pool()
+{
+    static NSMutableArray<AWSGZIPStream *> *pool;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        pool = [NSMutableArray new];
+    });
+    return pool;
+}
+
+static AWSGZIPStream *awsgzip_dequeueStream(BOOL compressor, float level)
+{
+    int compression = (level < 0.0f)? Z_DEFAULT_COMPRESSION: (int)(roundf(level * 9));
+    NSMutableArray<AWSGZIPStream *> *pool = awsgzip_pool();
+    @synchronized(pool)
+    {
+        for (NSUInteger i = 0; i < [pool count]; i++)
+        {
+            AWSGZIPStream *stream = pool[i];
+            if ([stream isCompressor] == compressor && (!compressor || [stream level] == compression))
+            {
+                [pool removeObjectAtIndex:i];
+                return stream;
+            }
+        }
+    }
+    return compressor? [[AWSGZIPStream alloc] initCompressorWithCompressionLevel:level]: [[AWSGZIPStream alloc] initDecompressor];
+}
+
+static void awsgzip_enqueueStream(AWSGZIPStream *stream)
+{
+    [stream reset];
+    NSMutableArray<AWSGZIPStream *> *pool = awsgzip_pool();
+    @synchronized(pool)
+    {
+        if ([pool count] < PoolSize)
+        {
+            [pool addObject:stream];
+        }
+    }
+}
 
 
 @implementation NSData (AWSGZIP)
@@ -46,33 +252,27 @@ static const NSUInteger ChunkSize = 16384;
 {
     if ([self length])
     {
-        z_stream stream;
-        stream.zalloc = Z_NULL;
-        stream.zfree = Z_NULL;
-        stream.opaque = Z_NULL;
-        stream.avail_in = (uint)[self length];
-        stream.next_in = (Bytef *)[self bytes];
-        stream.total_out = 0;
-        stream.avail_out = 0;
-        
-        int compression = (level < 0.0f)? Z_DEFAULT_COMPRESSION: (int)(roundf(level * 9));
-        if (deflateInit2(&stream, compression, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) == Z_OK)
+        AWSGZIPStream *compressor = awsgzip_dequeueStream(YES, level);
+        NSData *data = [compressor compressedData:self];
+        if (!data && compressor)
         {
-            NSMutableData *data = [NSMutableData dataWithLength:ChunkSize];
-            while (stream.avail_out == 0)
+            //Too large for a single call. Compress in chunks instead.
+            [compressor reset];
+            NSMutableData *output = [NSMutableData dataWithCapacity:ChunkSize];
+            AWSGZIPOutputHandler append = ^(const void *bytes, NSUInteger length) {
+                [output appendBytes:bytes length:length];
+            };
+            if ([compressor processBytes:[self bytes] length:[self length] outputHandler:append] &&
+                [compressor finishWithOutputHandler:append])
             {
-                if (stream.total_out >= [data length])
-                {
-                    data.length += ChunkSize;
-                }
-                stream.next_out = (uint8_t *)[data mutableBytes] + stream.total_out;
-                stream.avail_out = (uInt)([data length] - stream.total_out);
-                deflate(&stream, Z_FINISH);
+                data = output;
             }
-            deflateEnd(&stream);
-            data.length = stream.total_out;
-            return data;
         }
+        if (compressor)
+        {
+            awsgzip_enqueueStream(compressor);
+        }
+        return data;
     }
     return nil;
 }
@@ -86,37 +286,18 @@ static const NSUInteger ChunkSize = 16384;
 {
     if ([self length])
     {
-        z_stream stream;
-        stream.zalloc = Z_NULL;
-        stream.zfree = Z_NULL;
-        stream.avail_in = (uint)[self length];
-        stream.next_in = (Bytef *)[self bytes];
-        stream.total_out = 0;
-        stream.avail_out = 0;
-        
-        NSMutableData *data = [NSMutableData dataWithLength:(NSUInteger)([self length] * 1.5)];
-        if (inflateInit2(&stream, 47) == Z_OK)
+        AWSGZIPStream *decompressor = awsgzip_dequeueStream(NO, -1.0f);
+        NSMutableData *output = [NSMutableData dataWithCapacity:(NSUInteger)([self length] * 1.5)];
+        AWSGZIPOutputHandler append = ^(const void *bytes, NSUInteger length) {
+            [output appendBytes:bytes length:length];
+        };
+        BOOL succeeded = [decompressor processBytes:[self bytes] length:[self length] outputHandler:append] &&
+                         [decompressor finishWithOutputHandler:append];
+        if (decompressor)
         {
-            int status = Z_OK;
-            while (status == Z_OK)
-            {
-                if (stream.total_out >= [data length])
-                {
-                    data.length += [self length] / 2;
-                }
-                stream.next_out = (uint8_t *)[data mutableBytes] + stream.total_out;
-                stream.avail_out = (uInt)([data length] - stream.total_out);
-                status = inflate (&stream, Z_SYNC_FLUSH);
-            }
-            if (inflateEnd(&stream) == Z_OK)
-            {
-                if (status == Z_STREAM_END)
-                {
-                    data.length = stream.total_out;
-                    return data;
-                }
-            }
+            awsgzip_enqueueStream(decompressor);
         }
+        return succeeded? output: nil;
     }
     return nil;
 }
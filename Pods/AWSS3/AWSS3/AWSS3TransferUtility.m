@@ -22,6 +22,8 @@
 
 #import <AWSCore/AWSFMDB.h>
 #import <AWSCore/AWSSynchronizedMutableDictionary.h>
+#import <fcntl.h>
+#import <unistd.h>
 
 // Public constants
 NSString *const AWSS3TransferUtilityErrorDomain = @"com.amazonaws.AWSS3TransferUtilityErrorDomain";
@@ -36,8 +38,11 @@ static NSString *const AWSInfoS3TransferUtility = @"S3TransferUtility";
 static NSString *const AWSS3TransferUtilityRetryExceeded = @"AWSS3TransferUtilityRetryExceeded";
 static NSString *const AWSS3TransferUtilityRetrySucceeded = @"AWSS3TransferUtilityRetrySucceeded";
 static NSUInteger const AWSS3TransferUtilityMultiPartSize = 5 * 1024 * 1024;
+static size_t const AWSS3TransferUtilityPartCopyBufferSize = 256 * 1024;
 static NSString *const AWSS3TransferUtiltityRequestTimeoutErrorCode = @"RequestTimeout";
 static int const AWSS3TransferUtilityMultiPartDefaultConcurrencyLimit = 5;
+static NSInteger const AWSS3TransferUtilityMultiPartInitialConcurrency = 2;
+static CFTimeInterval const AWSS3TransferUtilityThroughputSampleInterval = 2;
 
 
 #pragma mark - Private classes
@@ -119,6 +124,11 @@ static int const AWSS3TransferUtilityMultiPartDefaultConcurrencyLimit = 5;
 @property (strong, nonatomic) NSString *transferID;
 @property AWSS3TransferUtilityTransferStatusType status;
 @property NSNumber *contentLength;
+@property NSInteger partConcurrency;
+@property NSInteger partConcurrencyStep;
+@property CFAbsoluteTime throughputSampleStartTime;
+@property int64_t throughputSampleBytes;
+@property double previousThroughput;
 @end
 
 @interface AWSS3TransferUtilityDownloadTask()
@@ -789,7 +799,7 @@ static AWSS3TransferUtility *_defaultS3TransferUtility = nil;
         }
         
         long numberOfPartsInProgress = [multiPartUploadTask.inProgressPartsDictionary count];
-        while (numberOfPartsInProgress < [self.transferUtilityConfiguration.multiPartConcurrencyLimit integerValue]) {
+        while (numberOfPartsInProgress < [self partConcurrencyForUploadTask:multiPartUploadTask]) {
             if ([multiPartUploadTask.waitingPartsDictionary count] > 0) {
                 //Get a part from the waitingList
                 AWSS3TransferUtilityUploadSubTask *nextSubTask = [[multiPartUploadTask.waitingPartsDictionary allValues] objectAtIndex:0];
@@ -1314,6 +1324,7 @@ static AWSS3TransferUtility *_defaultS3TransferUtility = nil;
         
         AWSDDLogInfo(@"Initiated multipart upload on server: %@", output.uploadId);
         AWSDDLogInfo(@"Concurrency Limit is %@", self.transferUtilityConfiguration.multiPartConcurrencyLimit);
+        NSInteger partConcurrency = [self partConcurrencyForUploadTask:transferUtilityMultiPartUploadTask];
         //Loop through the file and upload the parts one by one
         for (int32_t i = 1; i < partCount + 1; i++) {
             NSUInteger dataLength = AWSS3TransferUtilityMultiPartSize;
@@ -1332,7 +1343,7 @@ static AWSS3TransferUtility *_defaultS3TransferUtility = nil;
             subTask.eTag = @"";
             
             //Move to inProgress or Waiting based on concurrency limit
-            if (i <= [self.transferUtilityConfiguration.multiPartConcurrencyLimit integerValue]) {
+            if (i <= partConcurrency) {
                 subTask.status = AWSS3TransferUtilityTransferStatusInProgress;
                 //Save in Database
                 [AWSS3TransferUtilityDatabaseHelper insertMultiPartUploadRequestSubTaskInDB:transferUtilityMultiPartUploadTask subTask:subTask databaseQueue:self.databaseQueue];
@@ -1376,15 +1387,54 @@ static AWSS3TransferUtility *_defaultS3TransferUtility = nil;
         return nil;
     }
     
-    //Create a temporary file for this part.
-    NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingAtPath:fileName];
-    [fileHandle seekToFileOffset:(partNumber - 1) * AWSS3TransferUtilityMultiPartSize];
-    NSData *partData = [fileHandle readDataOfLength:dataLength];
+    //Create a temporary file for this part. The background session can only upload from files, so the part is
+    //copied out of the main file, one small buffer at a time instead of holding the whole part in memory.
     NSString *partFile = [self.cacheDirectoryPath stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
-    NSURL *tempURL = [NSURL fileURLWithPath:partFile];
-    [partData writeToURL:tempURL atomically:YES];
-    partData = nil;
-    [fileHandle closeFile];
+    off_t offset = (off_t)(partNumber - 1) * AWSS3TransferUtilityMultiPartSize;
+    size_t remaining = dataLength;
+    int inputFD = open([fileName fileSystemRepresentation], O_RDONLY);
+    int outputFD = open([partFile fileSystemRepresentation], O_WRONLY | O_CREAT | O_EXCL, 0600);
+    char *buffer = malloc(AWSS3TransferUtilityPartCopyBufferSize);
+    if (inputFD >= 0 && outputFD >= 0 && buffer) {
+        while (remaining > 0) {
+            ssize_t bytesRead = pread(inputFD, buffer, MIN(remaining, AWSS3TransferUtilityPartCopyBufferSize), offset);
+            if (bytesRead <= 0) {
+                break;
+            }
+            ssize_t bytesWritten = 0;
+            while (bytesWritten < bytesRead) {
+                ssize_t result = write(outputFD, buffer + bytesWritten, bytesRead - bytesWritten);
+                if (result < 0) {
+                    break;
+                }
+                bytesWritten += result;
+            }
+            if (bytesWritten < bytesRead) {
+                break;
+            }
+            offset += bytesRead;
+            remaining -= bytesRead;
+        }
+    }
+    free(buffer);
+    if (inputFD >= 0) {
+        close(inputFD);
+    }
+    if (outputFD >= 0) {
+        close(outputFD);
+    }
+
+    if (remaining > 0) {
+        [self removeFile:partFile];
+        NSString *errorMessage = [NSString stringWithFormat:@"Unable to create temporary file for Part #: %ld", partNumber];
+        NSDictionary *userInfo = [NSDictionary dictionaryWithObject:errorMessage
+                                                             forKey:@"Message"];
+        
+        *error = [NSError errorWithDomain:AWSS3TransferUtilityErrorDomain
+                                     code:AWSS3TransferUtilityErrorClientError
+                                 userInfo:userInfo];
+        return nil;
+    }
     return partFile;
 }
 
@@ -2084,28 +2134,40 @@ didCompleteWithError:(NSError *)error {
                                                                    status:subTask.status
                                                               retry_count:transferUtilityMultiPartUploadTask.retryCount databaseQueue:self.databaseQueue];
             
-            //If there are parts waiting to be uploaded, pick one from the list and move it to inProgress
+            [self updatePartConcurrencyForUploadTask:transferUtilityMultiPartUploadTask completedBytes:subTask.totalBytesExpectedToSend];
+            
+            //If there are parts waiting to be uploaded, move as many of them to inProgress as the part concurrency allows.
+            //Start at least one when none are in progress, so that the transfer keeps going.
             if ([transferUtilityMultiPartUploadTask.waitingPartsDictionary count] != 0) {
-                //Get a part from the waitingList
-                AWSS3TransferUtilityUploadSubTask *nextSubTask = [[transferUtilityMultiPartUploadTask.waitingPartsDictionary allValues] objectAtIndex:0];
-                
-                //Remove it from the waitingList
-                [transferUtilityMultiPartUploadTask.waitingPartsDictionary removeObjectForKey:nextSubTask.partNumber];
-                
-                //Create the subtask and start the transfer
-                NSError *error = [self createUploadSubTask:transferUtilityMultiPartUploadTask subTask:nextSubTask];
-                if ( error ) {
-                    transferUtilityMultiPartUploadTask.status = AWSS3TransferUtilityTransferStatusError;
-                    //Add it to list of completed Tasks
-                    [self.completedTaskDictionary setObject:transferUtilityMultiPartUploadTask forKey:transferUtilityMultiPartUploadTask.transferID];
+                NSInteger numberOfPartsInProgress = [transferUtilityMultiPartUploadTask.inProgressPartsDictionary count];
+                NSInteger numberOfPartsToStart = [self partConcurrencyForUploadTask:transferUtilityMultiPartUploadTask] - numberOfPartsInProgress;
+                if (numberOfPartsInProgress == 0) {
+                    numberOfPartsToStart = MAX(numberOfPartsToStart, 1);
+                }
+                while (numberOfPartsToStart > 0 && [transferUtilityMultiPartUploadTask.waitingPartsDictionary count] != 0) {
+                    //Get a part from the waitingList
+                    AWSS3TransferUtilityUploadSubTask *nextSubTask = [[transferUtilityMultiPartUploadTask.waitingPartsDictionary allValues] objectAtIndex:0];
                     
-                    //cancel the multipart transfer
-                    [transferUtilityMultiPartUploadTask cancel];
+                    //Remove it from the waitingList
+                    [transferUtilityMultiPartUploadTask.waitingPartsDictionary removeObjectForKey:nextSubTask.partNumber];
                     
-                    //Call the completion handler if one was present
-                    if (transferUtilityMultiPartUploadTask.expression.completionHandler) {
-                        transferUtilityMultiPartUploadTask.expression.completionHandler(transferUtilityMultiPartUploadTask, error);
+                    //Create the subtask and start the transfer
+                    NSError *error = [self createUploadSubTask:transferUtilityMultiPartUploadTask subTask:nextSubTask];
+                    if ( error ) {
+                        transferUtilityMultiPartUploadTask.status = AWSS3TransferUtilityTransferStatusError;
+                        //Add it to list of completed Tasks
+                        [self.completedTaskDictionary setObject:transferUtilityMultiPartUploadTask forKey:transferUtilityMultiPartUploadTask.transferID];
+                        
+                        //cancel the multipart transfer
+                        [transferUtilityMultiPartUploadTask cancel];
+                        
+                        //Call the completion handler if one was present
+                        if (transferUtilityMultiPartUploadTask.expression.completionHandler) {
+                            transferUtilityMultiPartUploadTask.expression.completionHandler(transferUtilityMultiPartUploadTask, error);
+                        }
+                        break;
                     }
+                    numberOfPartsToStart--;
                 }
             }
             //If there are no more inProgress parts, then we are done.
@@ -2248,6 +2310,47 @@ totalBytesExpectedToSend:(int64_t)totalBytesExpectedToSend {
 
 #pragma mark - Helper methods
 
+//Multipart uploads start with a few parts in flight, then probe for the number of concurrent parts with the best
+//throughput, up to the configured concurrency limit.
+- (NSInteger) partConcurrencyForUploadTask: (AWSS3TransferUtilityMultiPartUploadTask *) task {
+    NSInteger limit = MAX([self.transferUtilityConfiguration.multiPartConcurrencyLimit integerValue], 1);
+    if (task.partConcurrency == 0) {
+        task.partConcurrency = MIN(AWSS3TransferUtilityMultiPartInitialConcurrency, limit);
+        task.partConcurrencyStep = 1;
+        task.throughputSampleStartTime = CFAbsoluteTimeGetCurrent();
+    }
+    return MIN(task.partConcurrency, limit);
+}
+
+- (void) updatePartConcurrencyForUploadTask: (AWSS3TransferUtilityMultiPartUploadTask *) task
+                             completedBytes: (int64_t) completedBytes {
+    NSInteger partConcurrency = [self partConcurrencyForUploadTask:task];
+    task.throughputSampleBytes += completedBytes;
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    CFTimeInterval elapsed = now - task.throughputSampleStartTime;
+    if (elapsed < AWSS3TransferUtilityThroughputSampleInterval) {
+        return;
+    }
+    
+    //Keep changing the concurrency in the same direction while the throughput holds up, and turn around when it drops
+    //or when a bound is reached. Otherwise a single slow sample would walk the concurrency down to 1 for good.
+    double throughput = task.throughputSampleBytes / elapsed;
+    if (task.previousThroughput > 0 && throughput < task.previousThroughput * 0.9) {
+        task.partConcurrencyStep = -task.partConcurrencyStep;
+    }
+    NSInteger limit = MAX([self.transferUtilityConfiguration.multiPartConcurrencyLimit integerValue], 1);
+    NSInteger nextPartConcurrency = partConcurrency + task.partConcurrencyStep;
+    if (nextPartConcurrency < 1 || nextPartConcurrency > limit) {
+        task.partConcurrencyStep = -task.partConcurrencyStep;
+        nextPartConcurrency = partConcurrency + task.partConcurrencyStep;
+    }
+    task.partConcurrency = MAX(MIN(nextPartConcurrency, limit), 1);
+    task.previousThroughput = throughput;
+    task.throughputSampleBytes = 0;
+    task.throughputSampleStartTime = now;
+    AWSDDLogDebug(@"Multipart throughput is %.0f bytes/s, part concurrency is now %ld", throughput, (long)task.partConcurrency);
+}
+
 - (void) cleanupForMultiPartUploadTask: (AWSS3TransferUtilityMultiPartUploadTask *) task  {
     
     //Add it to list of completed Tasks
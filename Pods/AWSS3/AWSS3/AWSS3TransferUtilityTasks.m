@@ -92,6 +92,11 @@
 @property (strong, nonatomic) NSString *transferID;
 @property AWSS3TransferUtilityTransferStatusType status;
 @property NSNumber *contentLength;
+@property NSInteger partConcurrency;
+@property NSInteger partConcurrencyStep;
+@property CFAbsoluteTime throughputSampleStartTime;
+@property int64_t throughputSampleBytes;
+@property double previousThroughput;
 @end
 
 @interface AWSS3TransferUtilityUploadSubTask()
@@ -13,6 +13,27 @@ NS_ASSUME_NONNULL_BEGIN
 @class PINMemoryCache;
 @class PINOperationQueue;
 
+/**
+ Latency of one kind of cache operation, see <PINMemoryCacheStatistics>.
+ */
+typedef struct {
+    NSUInteger count;
+    NSTimeInterval totalTime;
+    NSTimeInterval maxTime;
+} PINMemoryCacheOperationLatency;
+
+/**
+ Counters collected while <statisticsEnabled> is `YES`.
+ */
+typedef struct {
+    NSUInteger hits;
+    NSUInteger misses;
+    NSUInteger evictions;
+    PINMemoryCacheOperationLatency get;
+    PINMemoryCacheOperationLatency set;
+    PINMemoryCacheOperationLatency trim;
+} PINMemoryCacheStatistics;
+
 
 /**
  `PINMemoryCache` is a fast, thread safe key/value store similar to `NSCache`. On iOS it will clear itself
@@ -76,6 +97,32 @@ PIN_SUBCLASSING_RESTRICTED
  */
 @property (assign) BOOL removeAllObjectsOnEnteringBackground;
 
+/**
+ When `YES`, the cache uses a segmented LRU: new objects enter a probationary segment and are only moved to
+ the protected segment once they are accessed again. Objects are evicted from the probationary segment first,
+ so a burst of objects that are only seen once can't flush out the ones that are used repeatedly.
+ The protected segment is limited to 80% of the <costLimit>. Defaults to `NO`, which is a plain LRU.
+ */
+@property (assign) BOOL segmentedAdmission;
+
+#pragma mark - Statistics
+/// @name Statistics
+
+/**
+ When `YES`, hits, misses, evictions and the latency of gets, sets and trims are counted. Defaults to `NO`.
+ */
+@property (assign) BOOL statisticsEnabled;
+
+/**
+ The counters collected since the cache was created or <resetStatistics> was called.
+ */
+@property (readonly) PINMemoryCacheStatistics statistics;
+
+/**
+ Resets all counters in <statistics> to zero.
+ */
+- (void)resetStatistics;
+
 #pragma mark - Event Blocks
 /// @name Event Blocks
 
@@ -4,6 +4,7 @@
 
 #import "PINMemoryCache.h"
 
+#import <mach/mach_time.h>
 #import <pthread.h>
 #import <PINOperation/PINOperation.h>
 
@@ -14,13 +15,89 @@
 static NSString * const PINMemoryCachePrefix = @"com.pinterest.PINMemoryCache";
 static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
 
-@interface PINMemoryCache ()
+/// Fraction of the cost limit the protected segment may hold when segmentedAdmission is on.
+static const double PINMemoryCacheProtectedCostRatio = 0.8;
+
+typedef NS_ENUM(NSUInteger, PINMemoryCacheSegment) {
+    PINMemoryCacheSegmentProbation = 0,
+    PINMemoryCacheSegmentProtected,
+    PINMemoryCacheSegmentCount,
+};
+
+/**
+ A node of the LRU lists. Entries are owned by the key index; the list links are unretained.
+ */
+@interface PINMemoryCacheEntry : NSObject {
+    @package
+    NSString *_key;
+    id _object;
+    NSUInteger _cost;
+    CFAbsoluteTime _accessTime;
+    PINMemoryCacheSegment _segment;
+    __unsafe_unretained PINMemoryCacheEntry *_prev;
+    __unsafe_unretained PINMemoryCacheEntry *_next;
+}
+@end
+
+@implementation PINMemoryCacheEntry
+@end
+
+typedef struct {
+    __unsafe_unretained PINMemoryCacheEntry *head;  // most recently used
+    __unsafe_unretained PINMemoryCacheEntry *tail;  // least recently used
+    NSUInteger cost;
+} PINMemoryCacheList;
+
+static inline void PINMemoryCacheListUnlink(PINMemoryCacheList *list, PINMemoryCacheEntry *entry)
+{
+    if (entry->_prev) {
+        entry->_prev->_next = entry->_next;
+    } else {
+        list->head = entry->_next;
+    }
+    if (entry->_next) {
+        entry->_next->_prev = entry->_prev;
+    } else {
+        list->tail = entry->_prev;
+    }
+    entry->_prev = nil;
+    entry->_next = nil;
+    list->cost -= entry->_cost;
+}
+
+static inline void PINMemoryCacheListPushHead(PINMemoryCacheList *list, PINMemoryCacheEntry *entry)
+{
+    entry->_prev = nil;
+    entry->_next = list->head;
+    if (list->head) {
+        list->head->_prev = entry;
+    } else {
+        list->tail = entry;
+    }
+    list->head = entry;
+    list->cost += entry->_cost;
+}
+
+static inline void PINMemoryCacheRecordLatency(PINMemoryCacheOperationLatency *latency, uint64_t elapsed)
+{
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    NSTimeInterval time = (double)elapsed * timebase.numer / timebase.denom / NSEC_PER_SEC;
+    latency->count++;
+    latency->totalTime += time;
+    latency->maxTime = MAX(latency->maxTime, time);
+}
+
+@interface PINMemoryCache () {
+    PINMemoryCacheList _lists[PINMemoryCacheSegmentCount];
+    PINMemoryCacheStatistics _statistics;
+}
 @property (copy, nonatomic) NSString *name;
 @property (strong, nonatomic) PINOperationQueue *operationQueue;
 @property (assign, nonatomic) pthread_mutex_t mutex;
-@property (strong, nonatomic) NSMutableDictionary *dictionary;
-@property (strong, nonatomic) NSMutableDictionary *dates;
-@property (strong, nonatomic) NSMutableDictionary *costs;
+@property (strong, nonatomic) NSMutableDictionary<NSString *, PINMemoryCacheEntry *> *entries;
 @end
 
 @implementation PINMemoryCache
@@ -30,6 +107,8 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
 @synthesize costLimit = _costLimit;
 @synthesize totalCost = _totalCost;
 @synthesize ttlCache = _ttlCache;
+@synthesize segmentedAdmission = _segmentedAdmission;
+@synthesize statisticsEnabled = _statisticsEnabled;
 @synthesize willAddObjectBlock = _willAddObjectBlock;
 @synthesize willRemoveObjectBlock = _willRemoveObjectBlock;
 @synthesize willRemoveAllObjectsBlock = _willRemoveAllObjectsBlock;
@@ -68,9 +147,7 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
         _name = [name copy];
         _operationQueue = operationQueue;
         
-        _dictionary = [[NSMutableDictionary alloc] init];
-        _dates = [[NSMutableDictionary alloc] init];
-        _costs = [[NSMutableDictionary alloc] init];
+        _entries = [[NSMutableDictionary alloc] init];
         
         _willAddObjectBlock = nil;
         _willRemoveObjectBlock = nil;
@@ -148,11 +225,50 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
     } withPriority:PINOperationQueuePriorityHigh];
 }
 
+- (void)_locked_removeEntry:(PINMemoryCacheEntry *)entry
+{
+    PINMemoryCacheListUnlink(&_lists[entry->_segment], entry);
+    _totalCost -= entry->_cost;
+    [_entries removeObjectForKey:entry->_key];
+}
+
+/**
+ Marks an entry as used. With segmented admission, a second access moves it from probation to the protected
+ segment, and the least recently used protected entries are moved back to probation to make room.
+ */
+- (void)_locked_touchEntry:(PINMemoryCacheEntry *)entry now:(CFAbsoluteTime)now
+{
+    entry->_accessTime = now;
+    PINMemoryCacheListUnlink(&_lists[entry->_segment], entry);
+
+    if (_segmentedAdmission) {
+        entry->_segment = PINMemoryCacheSegmentProtected;
+    }
+    PINMemoryCacheListPushHead(&_lists[entry->_segment], entry);
+
+    if (_segmentedAdmission && _costLimit > 0) {
+        PINMemoryCacheList *protected = &_lists[PINMemoryCacheSegmentProtected];
+        NSUInteger protectedLimit = (NSUInteger)(_costLimit * PINMemoryCacheProtectedCostRatio);
+        while (protected->cost > protectedLimit && protected->tail != entry) {
+            PINMemoryCacheEntry *demoted = protected->tail;
+            PINMemoryCacheListUnlink(protected, demoted);
+            demoted->_segment = PINMemoryCacheSegmentProbation;
+            PINMemoryCacheListPushHead(&_lists[PINMemoryCacheSegmentProbation], demoted);
+        }
+    }
+}
+
+/// The next entry to evict: the least recently used probationary entry, then the least recently used protected one.
+- (PINMemoryCacheEntry *)_locked_evictionCandidate
+{
+    return _lists[PINMemoryCacheSegmentProbation].tail ?: _lists[PINMemoryCacheSegmentProtected].tail;
+}
+
 - (void)removeObjectAndExecuteBlocksForKey:(NSString *)key
 {
     [self lock];
-        id object = _dictionary[key];
-        NSNumber *cost = _costs[key];
+        PINMemoryCacheEntry *entry = _entries[key];
+        id object = entry ? entry->_object : nil;
         PINCacheObjectBlock willRemoveObjectBlock = _willRemoveObjectBlock;
         PINCacheObjectBlock didRemoveObjectBlock = _didRemoveObjectBlock;
     [self unlock];
@@ -161,84 +277,124 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
         willRemoveObjectBlock(self, key, object);
 
     [self lock];
-        if (cost)
-            _totalCost -= [cost unsignedIntegerValue];
-
-        [_dictionary removeObjectForKey:key];
-        [_dates removeObjectForKey:key];
-        [_costs removeObjectForKey:key];
+        entry = _entries[key];
+        if (entry)
+            [self _locked_removeEntry:entry];
     [self unlock];
     
     if (didRemoveObjectBlock)
         didRemoveObjectBlock(self, key, nil);
 }
 
+/**
+ Removes the entries returned by `nextEntry`, which is called under the lock until it returns nil.
+ Without remove blocks this happens in a single critical section; otherwise the lock is dropped for every
+ object so that the blocks run unlocked. Evicted objects are released after unlocking.
+ */
+- (void)evictEntriesUsingBlock:(PINMemoryCacheEntry * _Nullable (^)(void))nextEntry
+{
+    uint64_t start = mach_absolute_time();
+    NSMutableArray *evictedObjects = [[NSMutableArray alloc] init];
+
+    while (YES) {
+        NSString *keyNeedingBlocks = nil;
+        [self lock];
+            BOOL hasRemoveBlocks = (_willRemoveObjectBlock != nil || _didRemoveObjectBlock != nil);
+            PINMemoryCacheEntry *entry = nil;
+            while ((entry = nextEntry())) {
+                if (_statisticsEnabled)
+                    _statistics.evictions++;
+
+                if (hasRemoveBlocks) {
+                    keyNeedingBlocks = entry->_key;
+                    break;
+                }
+                [evictedObjects addObject:entry];
+                [self _locked_removeEntry:entry];
+            }
+            if (!keyNeedingBlocks && _statisticsEnabled)
+                PINMemoryCacheRecordLatency(&_statistics.trim, mach_absolute_time() - start);
+        [self unlock];
+
+        if (!keyNeedingBlocks)
+            break;
+
+        [self removeObjectAndExecuteBlocksForKey:keyNeedingBlocks];
+    }
+}
+
 - (void)trimMemoryToDate:(NSDate *)trimDate
 {
+    CFAbsoluteTime trimTime = trimDate.timeIntervalSinceReferenceDate;
+    
+    // Collect the expired entries in a single pass rather than rescanning the lists for every eviction.
+    NSMutableArray<PINMemoryCacheEntry *> *expiredEntries = [[NSMutableArray alloc] init];
     [self lock];
-        NSArray *keysSortedByDate = [_dates keysSortedByValueUsingSelector:@selector(compare:)];
-        NSDictionary *dates = [_dates copy];
+        // The protected list is ordered by access time. Entries demoted to probation keep their older access
+        // time, so that list is only ordered when segmented admission is off, in which case it's empty.
+        for (PINMemoryCacheEntry *entry = _lists[PINMemoryCacheSegmentProbation].tail; entry; entry = entry->_prev) {
+            if (entry->_accessTime < trimTime)
+                [expiredEntries addObject:entry];
+        }
+        for (PINMemoryCacheEntry *entry = _lists[PINMemoryCacheSegmentProtected].tail; entry && entry->_accessTime < trimTime; entry = entry->_prev) {
+            [expiredEntries addObject:entry];
+        }
     [self unlock];
     
-    for (NSString *key in keysSortedByDate) { // oldest objects first
-        NSDate *accessDate = dates[key];
-        if (!accessDate)
-            continue;
-        
-        if ([accessDate compare:trimDate] == NSOrderedAscending) { // older than trim date
-            [self removeObjectAndExecuteBlocksForKey:key];
-        } else {
-            break;
-        }
+    if (expiredEntries.count == 0) {
+        return;
     }
+    
+    NSEnumerator *enumerator = [expiredEntries objectEnumerator]; // oldest objects first
+    [self evictEntriesUsingBlock:^PINMemoryCacheEntry *{
+        PINMemoryCacheEntry *entry = nil;
+        while ((entry = [enumerator nextObject])) {
+            // Skip entries removed or accessed since they were collected.
+            if (self->_entries[entry->_key] == entry && entry->_accessTime < trimTime)
+                return entry;
+        }
+        return nil;
+    }];
 }
 
 - (void)trimToCostLimit:(NSUInteger)limit
 {
-    NSUInteger totalCost = 0;
-    
     [self lock];
-        totalCost = _totalCost;
-        NSArray *keysSortedByCost = [_costs keysSortedByValueUsingSelector:@selector(compare:)];
+        NSUInteger totalCost = _totalCost;
+        NSArray *entriesSortedByCost = nil;
+        if (totalCost > limit) {
+            // Trimming by cost is rare, so it still sorts.
+            entriesSortedByCost = [_entries.allValues sortedArrayUsingComparator:^NSComparisonResult(PINMemoryCacheEntry *entry1, PINMemoryCacheEntry *entry2) {
+                if (entry1->_cost == entry2->_cost)
+                    return NSOrderedSame;
+                return entry1->_cost > entry2->_cost ? NSOrderedAscending : NSOrderedDescending;
+            }];
+        }
     [self unlock];
     
     if (totalCost <= limit) {
         return;
     }
 
-    for (NSString *key in [keysSortedByCost reverseObjectEnumerator]) { // costliest objects first
-        [self removeObjectAndExecuteBlocksForKey:key];
+    NSEnumerator *enumerator = [entriesSortedByCost objectEnumerator]; // costliest objects first
+    [self evictEntriesUsingBlock:^PINMemoryCacheEntry *{
+        if (self->_totalCost <= limit)
+            return nil;
 
-        [self lock];
-            totalCost = _totalCost;
-        [self unlock];
-        
-        if (totalCost <= limit)
-            break;
-    }
+        PINMemoryCacheEntry *entry = nil;
+        while ((entry = [enumerator nextObject])) {
+            if (self->_entries[entry->_key] == entry)
+                return entry;
+        }
+        return nil;
+    }];
 }
 
 - (void)trimToCostLimitByDate:(NSUInteger)limit
 {
-    NSUInteger totalCost = 0;
-    
-    [self lock];
-        totalCost = _totalCost;
-        NSArray *keysSortedByDate = [_dates keysSortedByValueUsingSelector:@selector(compare:)];
-    [self unlock];
-    
-    if (totalCost <= limit)
-        return;
-
-    for (NSString *key in keysSortedByDate) { // oldest objects first
-        [self removeObjectAndExecuteBlocksForKey:key];
-
-        [self lock];
-            totalCost = _totalCost;
-        [self unlock];
-        if (totalCost <= limit)
-            break;
-    }
+    [self evictEntriesUsingBlock:^PINMemoryCacheEntry *{
+        return (self->_totalCost > limit) ? [self _locked_evictionCandidate] : nil;
+    }];
 }
 
 - (void)trimToAgeLimitRecursively
@@ -372,7 +528,7 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
         return NO;
     
     [self lock];
-        BOOL containsObject = (_dictionary[key] != nil);
+        BOOL containsObject = (_entries[key] != nil);
     [self unlock];
     return containsObject;
 }
@@ -382,20 +538,26 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
     if (!key)
         return nil;
     
-    NSDate *now = [[NSDate alloc] init];
+    uint64_t start = mach_absolute_time();
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
     [self lock];
         id object = nil;
+        PINMemoryCacheEntry *entry = _entries[key];
         // If the cache should behave like a TTL cache, then only fetch the object if there's a valid ageLimit and  the object is still alive
-        if (!self->_ttlCache || self->_ageLimit <= 0 || fabs([[_dates objectForKey:key] timeIntervalSinceDate:now]) < self->_ageLimit) {
-            object = _dictionary[key];
+        if (entry && (!self->_ttlCache || self->_ageLimit <= 0 || fabs(entry->_accessTime - now) < self->_ageLimit)) {
+            object = entry->_object;
+            [self _locked_touchEntry:entry now:now];
+        }
+
+        if (_statisticsEnabled) {
+            if (object) {
+                _statistics.hits++;
+            } else {
+                _statistics.misses++;
+            }
+            PINMemoryCacheRecordLatency(&_statistics.get, mach_absolute_time() - start);
         }
     [self unlock];
-        
-    if (object) {
-        [self lock];
-            _dates[key] = now;
-        [self unlock];
-    }
 
     return object;
 }
@@ -433,17 +595,38 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
     if (willAddObjectBlock)
         willAddObjectBlock(self, key, object);
     
+    uint64_t start = mach_absolute_time();
+    id oldObject = nil;
     [self lock];
-        NSNumber* oldCost = _costs[key];
-        if (oldCost)
-            _totalCost -= [oldCost unsignedIntegerValue];
-
-        _dictionary[key] = object;
-        _dates[key] = [[NSDate alloc] init];
-        _costs[key] = @(cost);
-        
+        PINMemoryCacheEntry *entry = _entries[key];
+        if (entry) {
+            // Replacing an object counts as an access.
+            _lists[entry->_segment].cost -= entry->_cost;
+            _totalCost -= entry->_cost;
+            oldObject = entry->_object;
+            entry->_object = object;
+            entry->_cost = cost;
+            _lists[entry->_segment].cost += cost;
+            [self _locked_touchEntry:entry now:CFAbsoluteTimeGetCurrent()];
+        } else {
+            entry = [[PINMemoryCacheEntry alloc] init];
+            entry->_key = [key copy];
+            entry->_object = object;
+            entry->_cost = cost;
+            entry->_accessTime = CFAbsoluteTimeGetCurrent();
+            // New objects start out on probation when segmented, otherwise everything lives in one list.
+            entry->_segment = _segmentedAdmission ? PINMemoryCacheSegmentProbation : PINMemoryCacheSegmentProtected;
+            PINMemoryCacheListPushHead(&_lists[entry->_segment], entry);
+            _entries[entry->_key] = entry;
+        }
         _totalCost += cost;
+
+        if (_statisticsEnabled)
+            PINMemoryCacheRecordLatency(&_statistics.set, mach_absolute_time() - start);
     [self unlock];
+        
+    // Release the replaced object outside the lock.
+    oldObject = nil;
     
     if (didAddObjectBlock)
         didAddObjectBlock(self, key, object);
@@ -493,13 +676,18 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
     if (willRemoveAllObjectsBlock)
         willRemoveAllObjectsBlock(self);
     
+    NSMutableDictionary *entries = nil;
     [self lock];
-        [_dictionary removeAllObjects];
-        [_dates removeAllObjects];
-        [_costs removeAllObjects];
+        entries = _entries;
+        _entries = [[NSMutableDictionary alloc] init];
+        for (NSUInteger segment = 0; segment < PINMemoryCacheSegmentCount; segment++)
+            _lists[segment] = (PINMemoryCacheList){ nil, nil, 0 };
     
         _totalCost = 0;
     [self unlock];
+
+    // Release the objects outside the lock.
+    entries = nil;
     
     if (didRemoveAllObjectsBlock)
         didRemoveAllObjectsBlock(self);
@@ -512,16 +700,25 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
         return;
     
     [self lock];
-        NSDate *now = [[NSDate alloc] init];
-        NSArray *keysSortedByDate = [_dates keysSortedByValueUsingSelector:@selector(compare:)];
+        CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+        BOOL stop = NO;
+        PINMemoryCacheEntry *probationEntry = _lists[PINMemoryCacheSegmentProbation].tail;
+        PINMemoryCacheEntry *protectedEntry = _lists[PINMemoryCacheSegmentProtected].tail;
         
-        for (NSString *key in keysSortedByDate) {
+        // Merge both lists from their least recently used ends, oldest objects first.
+        while (!stop && (probationEntry || protectedEntry)) {
+            PINMemoryCacheEntry *entry = nil;
+            if (!protectedEntry || (probationEntry && probationEntry->_accessTime <= protectedEntry->_accessTime)) {
+                entry = probationEntry;
+                probationEntry = probationEntry->_prev;
+            } else {
+                entry = protectedEntry;
+                protectedEntry = protectedEntry->_prev;
+            }
+
             // If the cache should behave like a TTL cache, then only fetch the object if there's a valid ageLimit and  the object is still alive
-            if (!self->_ttlCache || self->_ageLimit <= 0 || fabs([[_dates objectForKey:key] timeIntervalSinceDate:now]) < self->_ageLimit) {
-                BOOL stop = NO;
-                block(self, key, _dictionary[key], &stop);
-                if (stop)
-                    break;
+            if (!self->_ttlCache || self->_ageLimit <= 0 || fabs(entry->_accessTime - now) < self->_ageLimit) {
+                block(self, entry->_key, entry->_object, &stop);
             }
         }
     [self unlock];
@@ -720,6 +917,54 @@ static NSString * const PINMemoryCacheSharedName = @"PINMemoryCacheSharedName";
 }
 
 
+- (BOOL)segmentedAdmission
+{
+    [self lock];
+        BOOL segmentedAdmission = _segmentedAdmission;
+    [self unlock];
+
+    return segmentedAdmission;
+}
+
+- (void)setSegmentedAdmission:(BOOL)segmentedAdmission
+{
+    [self lock];
+        _segmentedAdmission = segmentedAdmission;
+    [self unlock];
+}
+
+- (BOOL)statisticsEnabled
+{
+    [self lock];
+        BOOL statisticsEnabled = _statisticsEnabled;
+    [self unlock];
+
+    return statisticsEnabled;
+}
+
+- (void)setStatisticsEnabled:(BOOL)statisticsEnabled
+{
+    [self lock];
+        _statisticsEnabled = statisticsEnabled;
+    [self unlock];
+}
+
+- (PINMemoryCacheStatistics)statistics
+{
+    [self lock];
+        PINMemoryCacheStatistics statistics = _statistics;
+    [self unlock];
+
+    return statistics;
+}
+
+- (void)resetStatistics
+{
+    [self lock];
+        _statistics = (PINMemoryCacheStatistics){ 0 };
+    [self unlock];
+}
+
 - (void)lock
 {
     __unused int result = pthread_mutex_lock(&_mutex);
@@ -0,0 +1,149 @@
+//  PINCache is a modified version of TMCache
+//  Modifications by Garrett Moon
+//  Copyright (c) 2015 Pinterest. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+#import <PINCache/PINCacheMacros.h>
+#import <PINCache/PINCaching.h>
+#import <PINCache/PINCacheObjectSubscripting.h>
+#import <PINCache/PINDiskCache.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class PINOperationQueue;
+
+extern NSString * const PINSlabDiskCachePrefix;
+
+/**
+ `PINSlabDiskCache` is a disk cache with the same <PINCaching> API as <PINDiskCache>, backed by a few large
+ append-only slab files instead of one file per key.
+
+ Objects are appended to the current slab file and read back through a memory mapping of it, without copying.
+ A compact binary index (key hash, slab, offset, length and access time) is loaded with a single read at startup,
+ so there is no directory scan, and reads update access times in memory only. Changes, including access times, are
+ appended to a journal in batches, and the index is only rewritten once the journal outgrows it.
+
+ Removing an object only drops it from the index. Trimming removes objects from the index and then compacts the
+ slabs: slabs that are mostly dead are rewritten into the current slab and deleted.
+
+ Because objects don't live in their own files, there are no file URL based APIs. Use <PINDiskCache> if you need them.
+ */
+PIN_SUBCLASSING_RESTRICTED
+@interface PINSlabDiskCache : NSObject <PINCaching, PINCacheObjectSubscripting>
+
+#pragma mark - Properties
+/// @name Core
+
+/**
+ The name of this cache, used to create a directory under Library/Caches and also appearing in stack traces.
+ */
+@property (readonly) NSString *name;
+
+/**
+ The URL of the directory used by this cache, usually `Library/Caches/com.pinterest.PINSlabDiskCache.(name)`
+ */
+@property (readonly) NSURL *cacheURL;
+
+/**
+ The number of bytes taken by live objects in the slabs, including their record headers and keys.
+ Slabs may hold more bytes than this until they are compacted.
+ */
+@property (readonly) NSUInteger byteCount;
+
+/**
+ The maximum number of bytes allowed on disk. This value is checked every time an object is set, if the written
+ size exceeds the limit a trim call is queued. Defaults to 50 MB.
+ */
+@property (assign) NSUInteger byteLimit;
+
+/**
+ The maximum number of seconds an object is allowed to exist in the cache. Setting this to a value
+ greater than `0.0` will start a recurring GCD timer with the same period that calls <trimToDate:>.
+ Setting it back to `0.0` will stop the timer. Defaults to 30 days.
+ */
+@property (assign) NSTimeInterval ageLimit;
+
+/**
+ The size at which a slab file is closed and a new one is started.
+ */
+@property (readonly) NSUInteger slabSize;
+
+#pragma mark - Initialization
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Multiple instances with the same name are *not* allowed and can *not* safely
+ access the same data on disk.
+
+ @param name The name of the cache.
+ @result A new cache with the specified name.
+ */
+- (instancetype)initWithName:(NSString *)name;
+
+/**
+ The designated initializer.
+
+ @param name The name of the cache.
+ @param rootPath The path of the cache.
+ @param slabSize The size of each slab file. Pass 0 for the default of 16 MB.
+ @param serializer A block used to serialize object. If nil provided, default NSKeyedArchiver serialized will be used.
+ @param deserializer A block used to deserialize object. If nil provided, default NSKeyedUnarchiver serialized will be used.
+ @param operationQueue A PINOperationQueue to run asynchronous operations
+ @result A new cache with the specified name.
+ */
+- (instancetype)initWithName:(NSString *)name
+                    rootPath:(NSString *)rootPath
+                    slabSize:(NSUInteger)slabSize
+                  serializer:(nullable PINDiskCacheSerializerBlock)serializer
+                deserializer:(nullable PINDiskCacheDeserializerBlock)deserializer
+              operationQueue:(PINOperationQueue *)operationQueue NS_DESIGNATED_INITIALIZER;
+
+#pragma mark - Asynchronous Methods
+/// @name Asynchronous Methods
+
+/**
+ Removes objects from the cache, least recently used first, until the cache is equal to or smaller than the
+ specified byteCount, then compacts the slabs. This method returns immediately and executes the passed block
+ as soon as the cache has been trimmed.
+
+ @param byteCount The cache will be trimmed equal to or smaller than this size.
+ @param block A block to be executed serially after the cache has been trimmed, or nil.
+ */
+- (void)trimToSizeByDateAsync:(NSUInteger)byteCount completion:(nullable PINCacheBlock)block;
+
+/**
+ Rewrites mostly dead slabs into the current one. This method returns immediately.
+
+ @param block A block to be executed serially after the slabs have been compacted, or nil.
+ */
+- (void)compactAsync:(nullable PINCacheBlock)block;
+
+#pragma mark - Synchronous Methods
+/// @name Synchronous Methods
+
+/**
+ Removes objects from the cache, least recently used first, until the cache is equal to or smaller than the
+ specified byteCount, then compacts the slabs. This method blocks the calling thread until the cache has been trimmed.
+
+ @see trimToSizeByDateAsync:
+ @param byteCount The cache will be trimmed equal to or smaller than this size.
+ */
+- (void)trimToSizeByDate:(NSUInteger)byteCount;
+
+/**
+ Rewrites mostly dead slabs into the current one and deletes them.
+ This method blocks the calling thread until the slabs have been compacted.
+ */
+- (void)compact;
+
+/**
+ Writes pending index changes, such as batched access times, to disk.
+ This method blocks the calling thread until the index has been written.
+ */
+- (void)synchronize;
+
+@end
+
+NS_ASSUME_NONNULL_END
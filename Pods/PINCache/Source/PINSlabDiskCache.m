@@ -0,0 +1,1312 @@
+//  PINCache is a modified version of TMCache
+//  Modifications by Garrett Moon
+//  Copyright (c) 2015 Pinterest. All rights reserved.
+
+#import "PINSlabDiskCache.h"
+
+#import <fcntl.h>
+#import <pthread.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <sys/uio.h>
+#import <unistd.h>
+
+#import <PINOperation/PINOperation.h>
+
+#define PINSlabDiskCacheError(error) if (error) { NSLog(@"%@ (%d) ERROR: %@", \
+[[NSString stringWithUTF8String:__FILE__] lastPathComponent], \
+__LINE__, [error localizedDescription]); }
+
+#define PINSlabDiskCachePOSIXError(result) if (result == -1) { NSLog(@"%@ (%d) ERROR: %s", \
+[[NSString stringWithUTF8String:__FILE__] lastPathComponent], \
+__LINE__, strerror(errno)); }
+
+#define PINSlabDiskCacheException(exception) if (exception) { NSAssert(NO, [exception reason]); }
+
+NSString * const PINSlabDiskCachePrefix = @"com.pinterest.PINSlabDiskCache";
+
+static NSString * const PINSlabDiskCacheOperationIdentifierTrimToDate = @"PINSlabDiskCacheOperationIdentifierTrimToDate";
+static NSString * const PINSlabDiskCacheOperationIdentifierTrimToSizeByDate = @"PINSlabDiskCacheOperationIdentifierTrimToSizeByDate";
+static NSString * const PINSlabDiskCacheIndexFileName = @"index";
+static NSString * const PINSlabDiskCacheJournalFileName = @"journal";
+static NSString * const PINSlabDiskCacheSlabFilePrefix = @"slab.";
+
+static const NSUInteger PINSlabDiskCacheDefaultSlabSize = 16 * 1024 * 1024;
+static const NSTimeInterval PINSlabDiskCacheIndexFlushDelay = 2.0;
+
+static const uint32_t PINSlabRecordMagic = 0x50494E53;  // "PINS"
+static const uint32_t PINSlabIndexMagic = 0x50494E49;   // "PINI"
+static const uint32_t PINSlabIndexVersion = 2;
+static const uint32_t PINSlabJournalMagic = 0x50494E4A; // "PINJ"
+static const uint32_t PINSlabJournalVersion = 1;
+// The index is rewritten once the journal holds more records than this, or than the index itself.
+static const uint64_t PINSlabJournalMinimumCompactionCount = 1024;
+
+/// Every object in a slab is stored as a header followed by the UTF-8 key and the serialized data.
+typedef struct {
+    uint32_t magic;
+    uint32_t keyLength;
+    uint64_t dataLength;
+} PINSlabRecordHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    uint64_t generation;    // of the journal that applies on top of this index
+} PINSlabIndexHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t generation;
+} PINSlabJournalHeader;
+
+/// One entry of the on-disk index. The key itself is only stored in the slab, and is verified on read.
+typedef struct {
+    uint64_t keyHash;
+    uint32_t slab;
+    uint32_t keyLength;
+    uint64_t offset;
+    uint64_t dataLength;
+    double accessTime;      // NSDate timeIntervalSinceReferenceDate
+} PINSlabIndexRecord;
+
+typedef NS_ENUM(uint32_t, PINSlabJournalOperation) {
+    PINSlabJournalOperationSet = 1,
+    PINSlabJournalOperationRemove = 2,
+};
+
+/// The journal is appended to between index writes. Replaying it in order over the index gives the current index.
+typedef struct {
+    uint32_t operation;
+    uint32_t reserved;
+    PINSlabIndexRecord record;  // only keyHash is used for removals
+} PINSlabJournalRecord;
+
+static inline uint64_t PINSlabRecordLength(const PINSlabIndexRecord *record)
+{
+    return sizeof(PINSlabRecordHeader) + record->keyLength + record->dataLength;
+}
+
+/// 64-bit FNV-1a. Unlike -[NSString hash] it is stable across launches.
+static uint64_t PINSlabKeyHash(const void *bytes, size_t length)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const uint8_t *p = bytes;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static PINOperationDataCoalescingBlock PINSlabDiskTrimmingSizeCoalescingBlock = ^id(NSNumber *existingSize, NSNumber *newSize) {
+    NSComparisonResult result = [existingSize compare:newSize];
+    return (result == NSOrderedDescending) ? newSize : existingSize;
+};
+
+static PINOperationDataCoalescingBlock PINSlabDiskTrimmingDateCoalescingBlock = ^id(NSDate *existingDate, NSDate *newDate) {
+    NSComparisonResult result = [existingDate compare:newDate];
+    return (result == NSOrderedDescending) ? newDate : existingDate;
+};
+
+/**
+ A read-only mapping of a slab. NSData handed out by the cache retain the mapping,
+ so it stays valid even if the slab is remapped or deleted in the meantime.
+ */
+@interface PINSlabMapping : NSObject {
+    @package
+    const uint8_t *_bytes;
+    size_t _length;
+}
+@end
+
+@implementation PINSlabMapping
+
+- (void)dealloc
+{
+    if (_bytes) {
+        munmap((void *)_bytes, _length);
+    }
+}
+
+@end
+
+@interface PINSlab : NSObject {
+    @package
+    uint32_t _number;
+    int _fd;
+    uint64_t _length;       // bytes written
+    uint64_t _liveBytes;    // bytes referenced by the index
+    PINSlabMapping *_mapping;
+}
+@end
+
+@implementation PINSlab
+
+- (void)dealloc
+{
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+@end
+
+@interface PINSlabDiskCacheEntry : NSObject {
+    @package
+    PINSlabIndexRecord _record;
+}
+@end
+
+@implementation PINSlabDiskCacheEntry
+@end
+
+@interface PINSlabDiskCache () {
+    PINDiskCacheSerializerBlock _serializer;
+    PINDiskCacheDeserializerBlock _deserializer;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _diskStateKnownCondition;
+    BOOL _diskStateKnown;
+
+    NSMutableDictionary<NSNumber *, PINSlabDiskCacheEntry *> *_entries;
+    NSMutableDictionary<NSNumber *, PINSlab *> *_slabs;
+    PINSlab *_currentSlab;
+    BOOL _indexDirty;
+    BOOL _indexFlushScheduled;
+    BOOL _loadingIndex;
+
+    // Changes since the last flush, by key hash: the entry to write, or NSNull for a removal.
+    NSMutableDictionary<NSNumber *, id> *_journalChanges;
+    BOOL _needsIndexWrite;
+    uint64_t _journalGeneration;
+    uint64_t _journalRecordCount;
+    // Orders index and journal writes, which happen outside of _mutex. Taken after _mutex, never before.
+    pthread_mutex_t _indexWriteMutex;
+    int _journalFD;
+}
+
+@property (copy, nonatomic) NSString *name;
+@property (assign) NSUInteger byteCount;
+@property (strong, nonatomic) NSURL *cacheURL;
+@property (strong, nonatomic) PINOperationQueue *operationQueue;
+
+@end
+
+@implementation PINSlabDiskCache
+
+@synthesize byteLimit = _byteLimit;
+@synthesize ageLimit = _ageLimit;
+
+#pragma mark - Initialization -
+
+- (void)dealloc
+{
+    __unused int result = pthread_mutex_destroy(&_mutex);
+    NSCAssert(result == 0, @"Failed to destroy lock in PINSlabDiskCache %p. Code: %d", (void *)self, result);
+    pthread_cond_destroy(&_diskStateKnownCondition);
+    pthread_mutex_destroy(&_indexWriteMutex);
+    if (_journalFD >= 0) {
+        close(_journalFD);
+    }
+}
+
+- (instancetype)init
+{
+    @throw [NSException exceptionWithName:@"Must initialize with a name" reason:@"PINSlabDiskCache must be initialized with a name. Call initWithName: instead." userInfo:nil];
+    return [self initWithName:@""];
+}
+
+- (instancetype)initWithName:(NSString *)name
+{
+    return [self initWithName:name
+                     rootPath:[NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0]
+                     slabSize:0
+                   serializer:nil
+                 deserializer:nil
+               operationQueue:[PINOperationQueue sharedOperationQueue]];
+}
+
+- (instancetype)initWithName:(NSString *)name
+                    rootPath:(NSString *)rootPath
+                    slabSize:(NSUInteger)slabSize
+                  serializer:(PINDiskCacheSerializerBlock)serializer
+                deserializer:(PINDiskCacheDeserializerBlock)deserializer
+              operationQueue:(PINOperationQueue *)operationQueue
+{
+    if (!name)
+        return nil;
+
+    NSAssert(((!serializer && !deserializer) || (serializer && deserializer)),
+             @"PINSlabDiskCache must be initialized with a serializer AND deserializer.");
+
+    if (self = [super init]) {
+        __unused int result = pthread_mutex_init(&_mutex, NULL);
+        NSAssert(result == 0, @"Failed to init lock in PINSlabDiskCache %@. Code: %d", self, result);
+        pthread_cond_init(&_diskStateKnownCondition, NULL);
+        pthread_mutex_init(&_indexWriteMutex, NULL);
+        _journalFD = -1;
+
+        _name = [name copy];
+        _operationQueue = operationQueue;
+        _slabSize = slabSize ?: PINSlabDiskCacheDefaultSlabSize;
+
+        // 50 MB by default
+        _byteLimit = 50 * 1024 * 1024;
+        // 30 days by default
+        _ageLimit = 60 * 60 * 24 * 30;
+
+        _entries = [[NSMutableDictionary alloc] init];
+        _slabs = [[NSMutableDictionary alloc] init];
+        _journalChanges = [[NSMutableDictionary alloc] init];
+
+        _cacheURL = [PINDiskCache cacheURLWithRootPath:rootPath prefix:PINSlabDiskCachePrefix name:_name];
+
+        if (serializer) {
+            _serializer = [serializer copy];
+        } else {
+            _serializer = ^NSData*(id<NSCoding> object, NSString *key){
+                return [NSKeyedArchiver archivedDataWithRootObject:object];
+            };
+        }
+
+        if (deserializer) {
+            _deserializer = [deserializer copy];
+        } else {
+            _deserializer = ^id(NSData * data, NSString *key){
+                return [NSKeyedUnarchiver unarchiveObjectWithData:data];
+            };
+        }
+
+        // Loading the index is a single read, but don't block init on disk I/O. Like PINDiskCache, this must *not*
+        // be done on _operationQueue because other operations added may hold the lock and fill up the queue.
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [self initializeDiskProperties];
+        });
+    }
+    return self;
+}
+
+- (NSString *)description
+{
+    return [[NSString alloc] initWithFormat:@"%@.%@.%p", PINSlabDiskCachePrefix, _name, (void *)self];
+}
+
+#pragma mark - Private Methods -
+
+- (NSURL *)indexURL
+{
+    return [_cacheURL URLByAppendingPathComponent:PINSlabDiskCacheIndexFileName isDirectory:NO];
+}
+
+- (NSURL *)journalURL
+{
+    return [_cacheURL URLByAppendingPathComponent:PINSlabDiskCacheJournalFileName isDirectory:NO];
+}
+
+- (NSURL *)URLForSlabNumber:(uint32_t)number
+{
+    NSString *fileName = [[NSString alloc] initWithFormat:@"%@%u", PINSlabDiskCacheSlabFilePrefix, number];
+    return [_cacheURL URLByAppendingPathComponent:fileName isDirectory:NO];
+}
+
+- (void)initializeDiskProperties
+{
+    [self lock];
+        NSError *error = nil;
+        [[NSFileManager defaultManager] createDirectoryAtURL:_cacheURL withIntermediateDirectories:YES attributes:nil error:&error];
+        PINSlabDiskCacheError(error);
+
+        if (![self _locked_loadIndex]) {
+            [self _locked_rebuildIndexFromSlabs];
+        }
+
+        _diskStateKnown = YES;
+        pthread_cond_broadcast(&_diskStateKnownCondition);
+
+        BOOL needsTrim = (_byteLimit > 0 && _byteCount > _byteLimit);
+    [self unlock];
+
+    if (needsTrim) {
+        [self trimToSizeByDateAsync:self.byteLimit completion:nil];
+    }
+}
+
+- (PINSlab *)_locked_openSlab:(uint32_t)number create:(BOOL)create
+{
+    PINSlab *slab = _slabs[@(number)];
+    if (slab) {
+        return slab;
+    }
+
+    int fd = open([[self URLForSlabNumber:number] fileSystemRepresentation], O_RDWR | (create ? O_CREAT : 0), 0644);
+    if (fd == -1) {
+        if (create) {
+            PINSlabDiskCachePOSIXError(fd);
+        }
+        return nil;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        PINSlabDiskCachePOSIXError(-1);
+        close(fd);
+        return nil;
+    }
+
+    slab = [[PINSlab alloc] init];
+    slab->_number = number;
+    slab->_fd = fd;
+    slab->_length = st.st_size;
+    _slabs[@(number)] = slab;
+    return slab;
+}
+
+- (BOOL)_locked_loadIndex
+{
+    NSData *indexData = [[NSData alloc] initWithContentsOfURL:[self indexURL] options:NSDataReadingMappedIfSafe error:nil];
+    if (indexData.length < sizeof(PINSlabIndexHeader)) {
+        return NO;
+    }
+
+    const PINSlabIndexHeader *header = indexData.bytes;
+    if (header->magic != PINSlabIndexMagic || header->version != PINSlabIndexVersion
+        || indexData.length != sizeof(PINSlabIndexHeader) + header->count * sizeof(PINSlabIndexRecord)) {
+        return NO;
+    }
+
+    const PINSlabIndexRecord *records = (const PINSlabIndexRecord *)(header + 1);
+    _loadingIndex = YES;
+    for (uint64_t i = 0; i < header->count; i++) {
+        [self _locked_loadRecord:&records[i]];
+    }
+    _journalGeneration = header->generation;
+    [self _locked_replayJournal];
+    _loadingIndex = NO;
+
+    [self _locked_adoptCurrentSlab];
+    [self _locked_deleteEmptySlabs];
+    return YES;
+}
+
+- (void)_locked_loadRecord:(const PINSlabIndexRecord *)record
+{
+    PINSlab *slab = [self _locked_openSlab:record->slab create:NO];
+    // Skip records pointing past the end of their slab, e.g. if the slab write didn't make it to disk.
+    if (slab == nil || record->offset + PINSlabRecordLength(record) > slab->_length) {
+        return;
+    }
+
+    PINSlabDiskCacheEntry *entry = [[PINSlabDiskCacheEntry alloc] init];
+    entry->_record = *record;
+    [self _locked_addEntry:entry];
+}
+
+/**
+ Applies the journal written since the index. A journal of another generation predates the index (the index was
+ written, but the journal wasn't reset) and is ignored. A torn record at the end is ignored as well.
+ */
+- (void)_locked_replayJournal
+{
+    NSData *journalData = [[NSData alloc] initWithContentsOfURL:[self journalURL] options:NSDataReadingMappedIfSafe error:nil];
+    const PINSlabJournalHeader *header = journalData.bytes;
+    if (journalData.length < sizeof(PINSlabJournalHeader) || header->magic != PINSlabJournalMagic
+        || header->version != PINSlabJournalVersion || header->generation != _journalGeneration) {
+        // Start a journal of the index's generation before appending to it.
+        _needsIndexWrite = YES;
+        return;
+    }
+
+    uint64_t count = (journalData.length - sizeof(PINSlabJournalHeader)) / sizeof(PINSlabJournalRecord);
+    const PINSlabJournalRecord *records = (const PINSlabJournalRecord *)(header + 1);
+    for (uint64_t i = 0; i < count; i++) {
+        const PINSlabJournalRecord *record = &records[i];
+        if (record->operation == PINSlabJournalOperationSet) {
+            [self _locked_loadRecord:&record->record];
+        } else if (record->operation == PINSlabJournalOperationRemove) {
+            PINSlabDiskCacheEntry *entry = _entries[@(record->record.keyHash)];
+            if (entry) {
+                [self _locked_removeEntry:entry];
+            }
+        }
+    }
+    _journalRecordCount = count;
+    if (journalData.length != sizeof(PINSlabJournalHeader) + count * sizeof(PINSlabJournalRecord)) {
+        _needsIndexWrite = YES;
+        return;
+    }
+
+    // Nothing is written before the disk state is known, so the journal can be opened without _indexWriteMutex.
+    _journalFD = open([[self journalURL] fileSystemRepresentation], O_WRONLY | O_APPEND);
+    PINSlabDiskCachePOSIXError(_journalFD);
+}
+
+/**
+ Only used if the index is missing or unreadable. Walks the records of every slab, which are self-describing.
+ */
+- (void)_locked_rebuildIndexFromSlabs
+{
+    NSError *error = nil;
+    NSArray<NSURL *> *files = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:_cacheURL
+                                                            includingPropertiesForKeys:@[ NSURLContentModificationDateKey ]
+                                                                               options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                                                 error:&error];
+    PINSlabDiskCacheError(error);
+
+    // Slabs are numbered in the order they were started, so scanning them in that order lets later records win.
+    NSMutableDictionary<NSNumber *, NSURL *> *slabURLs = [[NSMutableDictionary alloc] init];
+    for (NSURL *fileURL in files) {
+        NSString *fileName = fileURL.lastPathComponent;
+        if (![fileName hasPrefix:PINSlabDiskCacheSlabFilePrefix]) {
+            continue;
+        }
+        uint32_t number = (uint32_t)[[fileName substringFromIndex:PINSlabDiskCacheSlabFilePrefix.length] integerValue];
+        slabURLs[@(number)] = fileURL;
+    }
+    NSArray<NSNumber *> *numbers = [slabURLs.allKeys sortedArrayUsingSelector:@selector(compare:)];
+
+    // Replaced records may empty a slab before all of its records have been scanned, so hold off deleting until the end.
+    _loadingIndex = YES;
+    for (NSNumber *slabNumber in numbers) {
+        uint32_t number = slabNumber.unsignedIntValue;
+        PINSlab *slab = [self _locked_openSlab:number create:NO];
+        if (slab == nil) {
+            continue;
+        }
+        PINSlabMapping *mapping = [self _locked_mappingForSlab:slab length:slab->_length];
+        if (mapping == nil) {
+            continue;
+        }
+
+        NSDate *modificationDate = nil;
+        [slabURLs[slabNumber] getResourceValue:&modificationDate forKey:NSURLContentModificationDateKey error:nil];
+        double accessTime = modificationDate ? modificationDate.timeIntervalSinceReferenceDate : [NSDate timeIntervalSinceReferenceDate];
+
+        uint64_t offset = 0;
+        while (offset + sizeof(PINSlabRecordHeader) <= slab->_length) {
+            PINSlabRecordHeader header;
+            memcpy(&header, mapping->_bytes + offset, sizeof(header));
+            if (header.magic != PINSlabRecordMagic) {
+                break;
+            }
+
+            PINSlabIndexRecord record = {
+                .slab = number,
+                .keyLength = header.keyLength,
+                .offset = offset,
+                .dataLength = header.dataLength,
+                .accessTime = accessTime,
+            };
+            if (offset + PINSlabRecordLength(&record) > slab->_length) {
+                break;
+            }
+            record.keyHash = PINSlabKeyHash(mapping->_bytes + offset + sizeof(header), header.keyLength);
+
+            // Later records for the same key win, since slabs are append-only.
+            PINSlabDiskCacheEntry *entry = [[PINSlabDiskCacheEntry alloc] init];
+            entry->_record = record;
+            [self _locked_addEntry:entry];
+
+            offset += PINSlabRecordLength(&record);
+        }
+    }
+    _loadingIndex = NO;
+
+    [self _locked_adoptCurrentSlab];
+    [self _locked_deleteEmptySlabs];
+    _needsIndexWrite = YES;
+    [self _locked_scheduleIndexFlush];
+}
+
+/// Continues appending to the newest slab found on disk.
+- (void)_locked_adoptCurrentSlab
+{
+    for (PINSlab *slab in _slabs.allValues) {
+        if (_currentSlab == nil || slab->_number > _currentSlab->_number) {
+            _currentSlab = slab;
+        }
+    }
+}
+
+/// Deletes slabs left without live records once the index has been loaded.
+- (void)_locked_deleteEmptySlabs
+{
+    for (PINSlab *slab in _slabs.allValues) {
+        if (slab->_liveBytes == 0 && slab != _currentSlab) {
+            [self _locked_deleteSlab:slab];
+        }
+    }
+}
+
+/// Adds an entry to the index, replacing any entry for the same key.
+- (void)_locked_addEntry:(PINSlabDiskCacheEntry *)entry
+{
+    NSNumber *hashKey = @(entry->_record.keyHash);
+    PINSlabDiskCacheEntry *existing = _entries[hashKey];
+    if (existing) {
+        [self _locked_removeEntry:existing];
+    }
+
+    _entries[hashKey] = entry;
+    uint64_t recordLength = PINSlabRecordLength(&entry->_record);
+    PINSlab *slab = _slabs[@(entry->_record.slab)];
+    slab->_liveBytes += recordLength;
+    _byteCount += recordLength;
+    [self _locked_journalEntry:entry];
+}
+
+/// Drops an entry from the index. Its bytes stay in the slab until it is compacted, unless the slab is now empty.
+- (void)_locked_removeEntry:(PINSlabDiskCacheEntry *)entry
+{
+    [_entries removeObjectForKey:@(entry->_record.keyHash)];
+    if (!_loadingIndex) {
+        _journalChanges[@(entry->_record.keyHash)] = [NSNull null];
+    }
+    uint64_t recordLength = PINSlabRecordLength(&entry->_record);
+    PINSlab *slab = _slabs[@(entry->_record.slab)];
+    slab->_liveBytes -= recordLength;
+    _byteCount -= recordLength;
+
+    if (slab->_liveBytes == 0 && slab != _currentSlab && !_loadingIndex) {
+        [self _locked_deleteSlab:slab];
+    }
+}
+
+- (void)_locked_deleteSlab:(PINSlab *)slab
+{
+    [_slabs removeObjectForKey:@(slab->_number)];
+    __unused int result = unlink([[self URLForSlabNumber:slab->_number] fileSystemRepresentation]);
+    PINSlabDiskCachePOSIXError(result);
+}
+
+/**
+ Returns a mapping of the slab that covers at least `length` bytes. Slabs are mapped at their full size up front,
+ since appends made through the file descriptor show up in a shared mapping, so a slab is normally mapped once.
+ Only a slab that outgrows that (an oversized record) is remapped, at least doubling each time.
+ */
+- (PINSlabMapping *)_locked_mappingForSlab:(PINSlab *)slab length:(uint64_t)length
+{
+    if (slab == nil || length == 0) {
+        return nil;
+    }
+    if (slab->_mapping && slab->_mapping->_length >= length) {
+        return slab->_mapping;
+    }
+
+    // Pages past the end of the file are never touched, because callers only read bytes that have been written.
+    uint64_t mappingLength = MAX(MAX((uint64_t)_slabSize, slab->_length), length);
+    if (slab->_mapping) {
+        mappingLength = MAX(mappingLength, 2 * (uint64_t)slab->_mapping->_length);
+    }
+    void *bytes = mmap(NULL, (size_t)mappingLength, PROT_READ, MAP_SHARED, slab->_fd, 0);
+    if (bytes == MAP_FAILED) {
+        PINSlabDiskCachePOSIXError(-1);
+        return nil;
+    }
+
+    PINSlabMapping *mapping = [[PINSlabMapping alloc] init];
+    mapping->_bytes = bytes;
+    mapping->_length = (size_t)mappingLength;
+    slab->_mapping = mapping;
+    return mapping;
+}
+
+/// Appends a record to the current slab, starting a new slab if it is full.
+- (BOOL)_locked_appendRecordWithKey:(const void *)keyBytes
+                          keyLength:(uint32_t)keyLength
+                               data:(const void *)dataBytes
+                         dataLength:(uint64_t)dataLength
+                             record:(PINSlabIndexRecord *)outRecord
+{
+    uint64_t recordLength = sizeof(PINSlabRecordHeader) + keyLength + dataLength;
+    if (_currentSlab == nil || (_currentSlab->_length > 0 && _currentSlab->_length + recordLength > _slabSize)) {
+        uint32_t number = _currentSlab ? _currentSlab->_number + 1 : 0;
+        _currentSlab = [self _locked_openSlab:number create:YES];
+        if (_currentSlab == nil) {
+            return NO;
+        }
+    }
+
+    PINSlabRecordHeader header = { .magic = PINSlabRecordMagic, .keyLength = keyLength, .dataLength = dataLength };
+    struct iovec iov[3] = {
+        { .iov_base = &header, .iov_len = sizeof(header) },
+        { .iov_base = (void *)keyBytes, .iov_len = keyLength },
+        { .iov_base = (void *)dataBytes, .iov_len = (size_t)dataLength },
+    };
+
+    // The file descriptor is only used under the lock, so seeking and writing is safe.
+    if (lseek(_currentSlab->_fd, (off_t)_currentSlab->_length, SEEK_SET) == -1) {
+        PINSlabDiskCachePOSIXError(-1);
+        return NO;
+    }
+    ssize_t written = writev(_currentSlab->_fd, iov, 3);
+    if (written != (ssize_t)recordLength) {
+        PINSlabDiskCachePOSIXError(written);
+        // Cut off a partial record so that the slab stays walkable.
+        ftruncate(_currentSlab->_fd, (off_t)_currentSlab->_length);
+        return NO;
+    }
+
+    outRecord->keyHash = PINSlabKeyHash(keyBytes, keyLength);
+    outRecord->slab = _currentSlab->_number;
+    outRecord->keyLength = keyLength;
+    outRecord->offset = _currentSlab->_length;
+    outRecord->dataLength = dataLength;
+    outRecord->accessTime = [NSDate timeIntervalSinceReferenceDate];
+    _currentSlab->_length += recordLength;
+    return YES;
+}
+
+/// Records that the entry has to be written with the next flush, e.g. because its access time changed.
+- (void)_locked_journalEntry:(PINSlabDiskCacheEntry *)entry
+{
+    if (!_loadingIndex) {
+        _journalChanges[@(entry->_record.keyHash)] = entry;
+    }
+}
+
+- (void)_locked_scheduleIndexFlush
+{
+    _indexDirty = YES;
+    if (_indexFlushScheduled) {
+        return;
+    }
+    _indexFlushScheduled = YES;
+
+    // Coalesce index writes, including access time updates from reads, into one write every few seconds.
+    dispatch_time_t time = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(PINSlabDiskCacheIndexFlushDelay * NSEC_PER_SEC));
+    dispatch_after(time, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^(void) {
+        [self.operationQueue scheduleOperation:^{
+            [self synchronize];
+        } withPriority:PINOperationQueuePriorityLow];
+    });
+}
+
+/// A full index of the current entries, for the next journal generation.
+- (NSData *)_locked_indexData
+{
+    NSUInteger count = _entries.count;
+    NSMutableData *indexData = [[NSMutableData alloc] initWithLength:sizeof(PINSlabIndexHeader) + count * sizeof(PINSlabIndexRecord)];
+    PINSlabIndexHeader *header = indexData.mutableBytes;
+    header->magic = PINSlabIndexMagic;
+    header->version = PINSlabIndexVersion;
+    header->count = count;
+    header->generation = ++_journalGeneration;
+
+    PINSlabIndexRecord *records = (PINSlabIndexRecord *)(header + 1);
+    NSUInteger i = 0;
+    for (PINSlabDiskCacheEntry *entry in _entries.objectEnumerator) {
+        records[i++] = entry->_record;
+    }
+
+    [_journalChanges removeAllObjects];
+    _journalRecordCount = 0;
+    _needsIndexWrite = NO;
+    _indexDirty = NO;
+    return indexData;
+}
+
+/// The journal records of the changes since the last flush.
+- (NSData *)_locked_journalData
+{
+    NSMutableData *journalData = [[NSMutableData alloc] initWithLength:_journalChanges.count * sizeof(PINSlabJournalRecord)];
+    PINSlabJournalRecord *records = journalData.mutableBytes;
+    __block NSUInteger i = 0;
+    [_journalChanges enumerateKeysAndObjectsUsingBlock:^(NSNumber *keyHash, id change, BOOL *stop) {
+        PINSlabJournalRecord *record = &records[i++];
+        if (change == [NSNull null]) {
+            record->operation = PINSlabJournalOperationRemove;
+            record->record.keyHash = keyHash.unsignedLongLongValue;
+        } else {
+            record->operation = PINSlabJournalOperationSet;
+            record->record = ((PINSlabDiskCacheEntry *)change)->_record;
+        }
+    }];
+
+    _journalRecordCount += _journalChanges.count;
+    [_journalChanges removeAllObjects];
+    _indexDirty = NO;
+    return journalData;
+}
+
+/**
+ Replaces the index, then starts an empty journal of the index's generation. Called with _indexWriteMutex held.
+ If the journal can't be reset, it is closed, so that nothing is appended to a journal the index doesn't use.
+ */
+- (BOOL)_indexWriteLocked_writeIndexData:(NSData *)indexData
+{
+    if (_journalFD >= 0) {
+        close(_journalFD);
+        _journalFD = -1;
+    }
+
+    NSError *error = nil;
+    if (![indexData writeToURL:[self indexURL] options:NSDataWritingAtomic error:&error]) {
+        PINSlabDiskCacheError(error);
+        return NO;
+    }
+
+    int fd = open([[self journalURL] fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd == -1) {
+        PINSlabDiskCachePOSIXError(fd);
+        return YES;
+    }
+    PINSlabJournalHeader header = {
+        .magic = PINSlabJournalMagic,
+        .version = PINSlabJournalVersion,
+        .generation = ((const PINSlabIndexHeader *)indexData.bytes)->generation,
+    };
+    if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+        PINSlabDiskCachePOSIXError(-1);
+        close(fd);
+        return YES;
+    }
+    _journalFD = fd;
+    return YES;
+}
+
+/// Appends to the journal. Called with _indexWriteMutex held. Fails if there is no journal to append to.
+- (BOOL)_indexWriteLocked_appendJournalData:(NSData *)journalData
+{
+    if (_journalFD < 0) {
+        return NO;
+    }
+    ssize_t written = write(_journalFD, journalData.bytes, journalData.length);
+    if (written != (ssize_t)journalData.length) {
+        PINSlabDiskCachePOSIXError(written);
+        return NO;
+    }
+    return YES;
+}
+
+/**
+ Writes the whole index while holding the lock, for changes that must be on disk before slabs are deleted.
+ Returns NO if the index couldn't be written; it is then written again with the next flush.
+ */
+- (BOOL)_locked_writeIndex
+{
+    NSData *indexData = [self _locked_indexData];
+    pthread_mutex_lock(&_indexWriteMutex);
+        BOOL written = [self _indexWriteLocked_writeIndexData:indexData];
+    pthread_mutex_unlock(&_indexWriteMutex);
+
+    if (!written) {
+        _needsIndexWrite = YES;
+        [self _locked_scheduleIndexFlush];
+    }
+    return written;
+}
+
+/**
+ Rewrites the live records of slabs that are at least half dead into the current slab, then deletes them.
+ The index is written before the old slabs are deleted, so a crash in between never loses live objects.
+ If the index can't be written, the old slabs are kept, and deleted by a later compaction.
+ */
+- (void)_locked_compact
+{
+    NSMutableArray<PINSlab *> *victims = [[NSMutableArray alloc] init];
+    for (PINSlab *slab in _slabs.allValues) {
+        if (slab != _currentSlab && slab->_liveBytes * 2 <= slab->_length) {
+            [victims addObject:slab];
+        }
+    }
+    if (victims.count == 0) {
+        return;
+    }
+
+    NSMutableSet<NSNumber *> *victimNumbers = [[NSMutableSet alloc] init];
+    for (PINSlab *slab in victims) {
+        [victimNumbers addObject:@(slab->_number)];
+    }
+
+    for (PINSlabDiskCacheEntry *entry in [_entries.allValues copy]) {
+        if (![victimNumbers containsObject:@(entry->_record.slab)]) {
+            continue;
+        }
+
+        PINSlab *slab = _slabs[@(entry->_record.slab)];
+        PINSlabMapping *mapping = [self _locked_mappingForSlab:slab length:entry->_record.offset + PINSlabRecordLength(&entry->_record)];
+        const uint8_t *recordBytes = mapping ? mapping->_bytes + entry->_record.offset + sizeof(PINSlabRecordHeader) : NULL;
+
+        PINSlabIndexRecord record;
+        if (recordBytes && [self _locked_appendRecordWithKey:recordBytes
+                                                keyLength:entry->_record.keyLength
+                                                     data:recordBytes + entry->_record.keyLength
+                                               dataLength:entry->_record.dataLength
+                                                   record:&record]) {
+            record.accessTime = entry->_record.accessTime;
+            PINSlabDiskCacheEntry *movedEntry = [[PINSlabDiskCacheEntry alloc] init];
+            movedEntry->_record = record;
+            // Move the bytes over to the new slab without letting the old slab be deleted from under us.
+            uint64_t recordLength = PINSlabRecordLength(&record);
+            slab->_liveBytes -= recordLength;
+            _slabs[@(record.slab)]->_liveBytes += recordLength;
+            _entries[@(record.keyHash)] = movedEntry;
+            [self _locked_journalEntry:movedEntry];
+        } else {
+            [self _locked_removeEntry:entry];
+        }
+    }
+
+    if (![self _locked_writeIndex]) {
+        return;
+    }
+
+    for (PINSlab *slab in victims) {
+        if (_slabs[@(slab->_number)] == slab) {
+            [self _locked_deleteSlab:slab];
+        }
+    }
+}
+
+- (void)_locked_trimToSizeByDate:(NSUInteger)trimByteCount
+{
+    if (_byteCount <= trimByteCount) {
+        return;
+    }
+
+    NSArray<PINSlabDiskCacheEntry *> *entriesByDate = [_entries.allValues sortedArrayUsingComparator:^NSComparisonResult(PINSlabDiskCacheEntry *obj1, PINSlabDiskCacheEntry *obj2) {
+        if (obj1->_record.accessTime < obj2->_record.accessTime) {
+            return NSOrderedAscending;
+        }
+        return obj1->_record.accessTime > obj2->_record.accessTime ? NSOrderedDescending : NSOrderedSame;
+    }];
+
+    for (PINSlabDiskCacheEntry *entry in entriesByDate) { // oldest objects first
+        [self _locked_removeEntry:entry];
+        if (_byteCount <= trimByteCount)
+            break;
+    }
+
+    [self _locked_compact];
+    [self _locked_scheduleIndexFlush];
+}
+
+- (void)_locked_trimToDate:(NSDate *)trimDate
+{
+    NSTimeInterval trimTime = trimDate.timeIntervalSinceReferenceDate;
+    for (PINSlabDiskCacheEntry *entry in [_entries.allValues copy]) {
+        if (entry->_record.accessTime < trimTime) {
+            [self _locked_removeEntry:entry];
+        }
+    }
+
+    [self _locked_compact];
+    [self _locked_scheduleIndexFlush];
+}
+
+- (void)trimToAgeLimitRecursively
+{
+    [self lock];
+        NSTimeInterval ageLimit = _ageLimit;
+    [self unlock];
+    if (ageLimit == 0.0)
+        return;
+
+    NSDate *date = [[NSDate alloc] initWithTimeIntervalSinceNow:-ageLimit];
+    [self trimToDate:date];
+
+    dispatch_time_t time = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(ageLimit * NSEC_PER_SEC));
+    dispatch_after(time, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(void) {
+        [self.operationQueue scheduleOperation:^{
+            [self trimToAgeLimitRecursively];
+        } withPriority:PINOperationQueuePriorityLow];
+    });
+}
+
+#pragma mark - Public Asynchronous Methods -
+
+- (void)containsObjectForKeyAsync:(NSString *)key completion:(PINCacheObjectContainmentBlock)block
+{
+    if (!key || !block)
+        return;
+
+    [self.operationQueue scheduleOperation:^{
+        block([self containsObjectForKey:key]);
+    } withPriority:PINOperationQueuePriorityLow];
+}
+
+- (void)objectForKeyAsync:(NSString *)key completion:(PINCacheObjectBlock)block
+{
+    [self.operationQueue scheduleOperation:^{
+        id object = [self objectForKey:key];
+
+        if (block) {
+            block(self, key, object);
+        }
+    } withPriority:PINOperationQueuePriorityLow];
+}
+
+- (void)setObjectAsync:(id)object forKey:(NSString *)key completion:(PINCacheObjectBlock)block
+{
+    [self.operationQueue scheduleOperation:^{
+        [self setObject:object forKey:key];
+
+        if (block) {
+            block(self, key, object);
+        }
+    } withPriority:PINOperationQueuePriorityLow];
+}
+
+- (void)setObjectAsync:(id)object forKey:(NSString *)key withCost:(NSUInteger)cost completion:(PINCacheObjectBlock)block
+{
+    [self setObjectAsync:object forKey:key completion:block];
+}
+
+- (void)removeObjectForKeyAsync:(NSString *)key completion:(PINCacheObjectBlock)block
+{
+    [self.operationQueue scheduleOperation:^{
+        [self removeObjectForKey:key];
+
+        if (block) {
+            block(self, key, nil);
+        }
+    } withPriority:PINOperationQueuePriorityLow];
+}
+
+- (void)trimToDateAsync:(NSDate *)trimDate completion:(PINCacheBlock)block
+{
+    PINOperationBlock operation = ^(id data){
+        [self trimToDate:(NSDate *)data];
+    };
+
+    dispatch_block_t completion = nil;
+    if (block) {
+        completion = ^{
+            block(self);
+        };
+    }
+
+    [self.operationQueue scheduleOperation:operation
+                              withPriority:PINOperationQueuePriorityLow
+                                identifier:PINSlabDiskCacheOperationIdentifierTrimToDate
+                            coalescingData:trimDate
+                       dataCoalescingBlock:PINSlabDiskTrimmingDateCoalescingBlock
+                                completion:completion];
+}
+
+- (void)trimToSizeByDateAsync:(NSUInteger)trimByteCount completion:(PINCacheBlock)block
+{
+    PINOperationBlock operation = ^(id data){
+        [self trimToSizeByDate:((NSNumber *)data).unsignedIntegerValue];
+    };
+
+    dispatch_block_t completion = nil;
+    if (block) {
+        completion = ^{
+            block(self);
+        };
+    }
+
+    [self.operationQueue scheduleOperation:operation
+                              withPriority:PINOperationQueuePriorityLow
+                                identifier:PINSlabDiskCacheOperationIdentifierTrimToSizeByDate
+                            coalescingData:[NSNumber numberWithUnsignedInteger:trimByteCount]
+                       dataCoalescingBlock:PINSlabDiskTrimmingSizeCoalescingBlock
+                                completion:completion];
+}
+
+- (void)compactAsync:(PINCacheBlock)block
+{
+    [self.operationQueue scheduleOperation:^{
+        [self compact];
+
+        if (block) {
+            block(self);
+        }
+    } withPriority:PINOperationQueuePriorityLow];
+}
+
+- (void)removeAllObjectsAsync:(PINCacheBlock)block
+{
+    [self.operationQueue scheduleOperation:^{
+        [self removeAllObjects];
+
+        if (block) {
+            block(self);
+        }
+    } withPriority:PINOperationQueuePriorityLow];
+}
+
+#pragma mark - Public Synchronous Methods -
+
+- (BOOL)containsObjectForKey:(NSString *)key
+{
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+    if (keyData.length == 0)
+        return NO;
+
+    [self lockAndWaitForKnownState];
+        BOOL contains = _entries[@(PINSlabKeyHash(keyData.bytes, keyData.length))] != nil;
+    [self unlock];
+    return contains;
+}
+
+- (id)objectForKey:(NSString *)key
+{
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+    if (keyData.length == 0)
+        return nil;
+
+    NSData *objectData = nil;
+    [self lockAndWaitForKnownState];
+        PINSlabDiskCacheEntry *entry = _entries[@(PINSlabKeyHash(keyData.bytes, keyData.length))];
+        if (entry) {
+            PINSlabIndexRecord record = entry->_record;
+            PINSlabMapping *mapping = [self _locked_mappingForSlab:_slabs[@(record.slab)] length:record.offset + PINSlabRecordLength(&record)];
+            const uint8_t *recordBytes = mapping ? mapping->_bytes + record.offset : NULL;
+
+            // The index only stores the key hash, so make sure this record really is for our key.
+            PINSlabRecordHeader header;
+            if (recordBytes) {
+                memcpy(&header, recordBytes, sizeof(header));
+            }
+            if (recordBytes && header.magic == PINSlabRecordMagic && header.keyLength == keyData.length
+                && memcmp(recordBytes + sizeof(header), keyData.bytes, keyData.length) == 0) {
+                // Hand out the mapped bytes directly; the data keeps the mapping alive.
+                objectData = [[NSData alloc] initWithBytesNoCopy:(void *)(recordBytes + sizeof(header) + header.keyLength)
+                                                          length:(NSUInteger)header.dataLength
+                                                     deallocator:^(void *bytes, NSUInteger length) {
+                                                         (void)mapping;
+                                                     }];
+                // Access times are updated in memory, and journaled with the next index flush.
+                entry->_record.accessTime = [NSDate timeIntervalSinceReferenceDate];
+                [self _locked_journalEntry:entry];
+                [self _locked_scheduleIndexFlush];
+            }
+        }
+    [self unlock];
+
+    if (objectData == nil)
+        return nil;
+
+    id object = nil;
+    @try {
+        object = _deserializer(objectData, key);
+    }
+    @catch (NSException *exception) {
+        [self removeObjectForKey:key];
+        PINSlabDiskCacheException(exception);
+    }
+    return object;
+}
+
+- (id)objectForKeyedSubscript:(NSString *)key
+{
+    return [self objectForKey:key];
+}
+
+- (void)setObject:(id)object forKey:(NSString *)key
+{
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+    if (keyData.length == 0 || !object)
+        return;
+
+    // Remain unlocked here so that we're not locked while serializing.
+    NSData *data = _serializer(object, key);
+
+    NSUInteger byteLimit = self.byteLimit;
+    if (byteLimit > 0 && data.length > byteLimit) {
+        // The cache isn't large enough to fit this object (even if all others were evicted).
+        return;
+    }
+
+    [self lockAndWaitForKnownState];
+        PINSlabIndexRecord record;
+        if ([self _locked_appendRecordWithKey:keyData.bytes
+                                    keyLength:(uint32_t)keyData.length
+                                         data:data.bytes
+                                   dataLength:data.length
+                                       record:&record]) {
+            PINSlabDiskCacheEntry *entry = [[PINSlabDiskCacheEntry alloc] init];
+            entry->_record = record;
+            [self _locked_addEntry:entry];
+            [self _locked_scheduleIndexFlush];
+        }
+        BOOL needsTrim = (_byteLimit > 0 && _byteCount > _byteLimit);
+    [self unlock];
+
+    if (needsTrim) {
+        [self trimToSizeByDateAsync:byteLimit completion:nil];
+    }
+}
+
+- (void)setObject:(id)object forKey:(NSString *)key withCost:(NSUInteger)cost
+{
+    [self setObject:object forKey:key];
+}
+
+- (void)setObject:(id)object forKeyedSubscript:(NSString *)key
+{
+    if (object == nil) {
+        [self removeObjectForKey:key];
+    } else {
+        [self setObject:object forKey:key];
+    }
+}
+
+- (void)removeObjectForKey:(NSString *)key
+{
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+    if (keyData.length == 0)
+        return;
+
+    [self lockAndWaitForKnownState];
+        PINSlabDiskCacheEntry *entry = _entries[@(PINSlabKeyHash(keyData.bytes, keyData.length))];
+        if (entry) {
+            [self _locked_removeEntry:entry];
+            [self _locked_scheduleIndexFlush];
+        }
+    [self unlock];
+}
+
+- (void)trimToDate:(NSDate *)trimDate
+{
+    if (!trimDate)
+        return;
+
+    if ([trimDate isEqualToDate:[NSDate distantPast]]) {
+        [self removeAllObjects];
+        return;
+    }
+
+    [self lockAndWaitForKnownState];
+        [self _locked_trimToDate:trimDate];
+    [self unlock];
+}
+
+- (void)trimToSizeByDate:(NSUInteger)trimByteCount
+{
+    if (trimByteCount == 0) {
+        [self removeAllObjects];
+        return;
+    }
+
+    [self lockAndWaitForKnownState];
+        [self _locked_trimToSizeByDate:trimByteCount];
+    [self unlock];
+}
+
+- (void)compact
+{
+    [self lockAndWaitForKnownState];
+        [self _locked_compact];
+    [self unlock];
+}
+
+- (void)synchronize
+{
+    [self lockAndWaitForKnownState];
+        _indexFlushScheduled = NO;
+        if (!_indexDirty) {
+            [self unlock];
+            return;
+        }
+
+        // Only the changed records are appended to the journal. Once the journal outgrows the index, the
+        // index is rewritten instead, which also empties the journal.
+        uint64_t journalLimit = MAX((uint64_t)_entries.count, PINSlabJournalMinimumCompactionCount);
+        BOOL writeIndex = _needsIndexWrite || _journalRecordCount + _journalChanges.count > journalLimit;
+        NSData *data = writeIndex ? [self _locked_indexData] : [self _locked_journalData];
+
+        // Write outside of the lock. Taking the write lock first keeps the writes in the order they were made.
+        pthread_mutex_lock(&_indexWriteMutex);
+    [self unlock];
+
+    BOOL written = writeIndex ? [self _indexWriteLocked_writeIndexData:data] : [self _indexWriteLocked_appendJournalData:data];
+    pthread_mutex_unlock(&_indexWriteMutex);
+
+    if (!written) {
+        // The changes were taken out of the journal, so write them as part of the whole index next time.
+        [self lock];
+            _needsIndexWrite = YES;
+            [self _locked_scheduleIndexFlush];
+        [self unlock];
+    }
+}
+
+- (void)removeAllObjects
+{
+    [self lockAndWaitForKnownState];
+        [_entries removeAllObjects];
+        for (PINSlab *slab in [_slabs.allValues copy]) {
+            [self _locked_deleteSlab:slab];
+        }
+        _currentSlab = nil;
+        _byteCount = 0;
+
+        [self _locked_writeIndex];
+    [self unlock];
+}
+
+#pragma mark - Public Thread Safe Accessors -
+
+- (NSUInteger)byteLimit
+{
+    NSUInteger byteLimit;
+
+    [self lock];
+        byteLimit = _byteLimit;
+    [self unlock];
+
+    return byteLimit;
+}
+
+- (void)setByteLimit:(NSUInteger)byteLimit
+{
+    [self.operationQueue scheduleOperation:^{
+        [self lock];
+            self->_byteLimit = byteLimit;
+        [self unlock];
+
+        if (byteLimit > 0)
+            [self trimToSizeByDate:byteLimit];
+    } withPriority:PINOperationQueuePriorityHigh];
+}
+
+- (NSTimeInterval)ageLimit
+{
+    NSTimeInterval ageLimit;
+
+    [self lock];
+        ageLimit = _ageLimit;
+    [self unlock];
+
+    return ageLimit;
+}
+
+- (void)setAgeLimit:(NSTimeInterval)ageLimit
+{
+    [self.operationQueue scheduleOperation:^{
+        [self lock];
+            self->_ageLimit = ageLimit;
+        [self unlock];
+
+        [self trimToAgeLimitRecursively];
+    } withPriority:PINOperationQueuePriorityHigh];
+}
+
+- (void)lockAndWaitForKnownState
+{
+    [self lock];
+
+    // spinlock if the disk state isn't known
+    while (_diskStateKnown == NO) {
+        pthread_cond_wait(&_diskStateKnownCondition, &_mutex);
+    }
+}
+
+- (void)lock
+{
+    __unused int result = pthread_mutex_lock(&_mutex);
+    NSAssert(result == 0, @"Failed to lock PINSlabDiskCache %@. Code: %d", self, result);
+}
+
+- (void)unlock
+{
+    __unused int result = pthread_mutex_unlock(&_mutex);
+    NSAssert(result == 0, @"Failed to unlock PINSlabDiskCache %@. Code: %d", self, result);
+}
+
+@end
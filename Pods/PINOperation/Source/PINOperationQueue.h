@@ -88,6 +88,15 @@ PINOP_SUBCLASSING_RESTRICTED
  */
 @property (assign) NSUInteger maxConcurrentOperations;
 
+/**
+ * How long an operation can wait before it runs ahead of operations with a higher priority.
+ *
+ * @discussion Keeps a steady stream of high priority operations from starving low priority ones. Defaults to 0,
+ * which disables aging. Has no effect on a serial queue, which runs operations in FIFO order.
+ *
+ */
+@property (assign) NSTimeInterval priorityAgingInterval;
+
 /**
  * Marks the operation as cancelled
  */
@@ -8,66 +8,245 @@
 
 #import "PINOperationQueue.h"
 #import <pthread.h>
+#import <stdatomic.h>
+#import <mach/mach_time.h>
 
-@class PINOperation;
+#pragma mark - Ring buffers
 
-@interface NSNumber (PINOperationQueue) <PINOperationReference>
+//Operations that don't fit into a ring wait in its spill list, so scheduling never blocks on a busy consumer.
+static const NSUInteger PINOperationRingCapacity = 256;
 
-@end
+typedef struct {
+  void *item;
+  NSUInteger tag;
+  NSUInteger ticket;
+} PINOperationRingEntry;
 
-@interface PINOperationQueue () {
-  pthread_mutex_t _lock;
-  //increments with every operation to allow cancelation
-  NSUInteger _operationReferenceCount;
-  NSUInteger _maxConcurrentOperations;
-  
-  dispatch_group_t _group;
-  
-  dispatch_queue_t _serialQueue;
-  BOOL _serialQueueBusy;
-  
-  dispatch_semaphore_t _concurrentSemaphore;
-  dispatch_queue_t _concurrentQueue;
-  dispatch_queue_t _semaphoreQueue;
-  
-  NSMutableOrderedSet<PINOperation *> *_queuedOperations;
-  NSMutableOrderedSet<PINOperation *> *_lowPriorityOperations;
-  NSMutableOrderedSet<PINOperation *> *_defaultPriorityOperations;
-  NSMutableOrderedSet<PINOperation *> *_highPriorityOperations;
-  
-  NSMapTable<id<PINOperationReference>, PINOperation *> *_referenceToOperations;
-  NSMapTable<NSString *, PINOperation *> *_identifierToOperations;
+typedef struct {
+  _Atomic(NSUInteger) sequence;
+  PINOperationRingEntry entry;
+} PINOperationRingSlot;
+
+/**
+ A bounded multi producer, single consumer queue: producers claim a slot by advancing tail atomically and
+ publish it through the slot's sequence number. Only one thread at a time may peek or drop.
+ Entries of the ring and the spill list are merged by ticket, which keeps the order of each producer.
+ */
+typedef struct {
+  PINOperationRingSlot *slots;
+  NSUInteger mask;
+  _Atomic(NSUInteger) tail;
+  _Atomic(NSUInteger) head;
+  _Atomic(NSUInteger) tickets;
+
+  pthread_mutex_t spillLock;
+  _Atomic(NSUInteger) spillCount;
+  PINOperationRingEntry *spill;
+  NSUInteger spillCapacity;
+  NSUInteger spillHead;
+} PINOperationRing;
+
+static void PINOperationRingInit(PINOperationRing *ring, NSUInteger capacity)
+{
+  ring->slots = calloc(capacity, sizeof(PINOperationRingSlot));
+  ring->mask = capacity - 1;
+  for (NSUInteger idx = 0; idx < capacity; idx++) {
+    atomic_init(&ring->slots[idx].sequence, idx);
+  }
+  atomic_init(&ring->tail, 0);
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tickets, 0);
+
+  pthread_mutex_init(&ring->spillLock, NULL);
+  atomic_init(&ring->spillCount, 0);
+  ring->spill = NULL;
+  ring->spillCapacity = 0;
+  ring->spillHead = 0;
 }
 
-@end
+static void PINOperationRingPush(PINOperationRing *ring, void *item, NSUInteger tag)
+{
+  PINOperationRingEntry entry = {item, tag, atomic_fetch_add_explicit(&ring->tickets, 1, memory_order_relaxed)};
+
+  NSUInteger position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  while (YES) {
+    PINOperationRingSlot *slot = &ring->slots[position & ring->mask];
+    NSUInteger sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    NSInteger difference = (NSInteger)sequence - (NSInteger)position;
+    if (difference == 0) {
+      if (atomic_compare_exchange_weak_explicit(&ring->tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+        slot->entry = entry;
+        atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+        return;
+      }
+    } else if (difference < 0) {
+      //full
+      break;
+    } else {
+      position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    }
+  }
+
+  pthread_mutex_lock(&ring->spillLock);
+    NSUInteger count = atomic_load_explicit(&ring->spillCount, memory_order_relaxed);
+    if (count == ring->spillCapacity) {
+      NSUInteger capacity = MAX(ring->spillCapacity * 2, PINOperationRingCapacity);
+      PINOperationRingEntry *spill = malloc(capacity * sizeof(PINOperationRingEntry));
+      for (NSUInteger idx = 0; idx < count; idx++) {
+        spill[idx] = ring->spill[(ring->spillHead + idx) % ring->spillCapacity];
+      }
+      free(ring->spill);
+      ring->spill = spill;
+      ring->spillCapacity = capacity;
+      ring->spillHead = 0;
+    }
+    ring->spill[(ring->spillHead + count) % ring->spillCapacity] = entry;
+    atomic_store_explicit(&ring->spillCount, count + 1, memory_order_release);
+  pthread_mutex_unlock(&ring->spillLock);
+}
+
+typedef NS_ENUM(NSUInteger, PINOperationRingSlotState) {
+  PINOperationRingSlotStateEmpty,
+  PINOperationRingSlotStatePublished,
+  //claimed by a producer which didn't publish it yet, and will schedule again once it did
+  PINOperationRingSlotStatePending,
+};
 
-@interface PINOperation : NSObject
+static PINOperationRingSlotState PINOperationRingPeekSlot(PINOperationRing *ring, PINOperationRingEntry *entry)
+{
+  NSUInteger head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  PINOperationRingSlot *slot = &ring->slots[head & ring->mask];
+  if (atomic_load_explicit(&slot->sequence, memory_order_acquire) == head + 1) {
+    *entry = slot->entry;
+    return PINOperationRingSlotStatePublished;
+  }
+  return atomic_load_explicit(&ring->tail, memory_order_relaxed) != head ? PINOperationRingSlotStatePending : PINOperationRingSlotStateEmpty;
+}
+
+//Consumer only. Returns the oldest entry without removing it.
+static BOOL PINOperationRingPeek(PINOperationRing *ring, PINOperationRingEntry *entry, BOOL *fromSpill)
+{
+  PINOperationRingSlotState state = PINOperationRingPeekSlot(ring, entry);
+  if (state == PINOperationRingSlotStatePending) {
+    return NO;
+  }
+  *fromSpill = NO;
+  if (atomic_load_explicit(&ring->spillCount, memory_order_acquire) == 0) {
+    return state == PINOperationRingSlotStatePublished;
+  }
+
+  PINOperationRingEntry spilled;
+  BOOL spillFound = NO;
+  pthread_mutex_lock(&ring->spillLock);
+    if (atomic_load_explicit(&ring->spillCount, memory_order_relaxed) > 0) {
+      spilled = ring->spill[ring->spillHead];
+      spillFound = YES;
+    }
+  pthread_mutex_unlock(&ring->spillLock);
+  if (spillFound == NO) {
+    return state == PINOperationRingSlotStatePublished;
+  }
+
+  //anything a producer put into the ring before the spilled entry is visible now, look again
+  if (state == PINOperationRingSlotStateEmpty) {
+    state = PINOperationRingPeekSlot(ring, entry);
+    if (state == PINOperationRingSlotStatePending) {
+      return NO;
+    }
+  }
+  if (state == PINOperationRingSlotStateEmpty || (NSInteger)(spilled.ticket - entry->ticket) < 0) {
+    *entry = spilled;
+    *fromSpill = YES;
+  }
+  return YES;
+}
+
+//Consumer only. Removes the entry returned by the last peek.
+static void PINOperationRingDrop(PINOperationRing *ring, BOOL fromSpill)
+{
+  if (fromSpill) {
+    pthread_mutex_lock(&ring->spillLock);
+      ring->spillHead = (ring->spillHead + 1) % ring->spillCapacity;
+      atomic_fetch_sub_explicit(&ring->spillCount, 1, memory_order_release);
+    pthread_mutex_unlock(&ring->spillLock);
+    return;
+  }
+
+  NSUInteger head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  PINOperationRingSlot *slot = &ring->slots[head & ring->mask];
+  atomic_store_explicit(&slot->sequence, head + ring->mask + 1, memory_order_release);
+  atomic_store_explicit(&ring->head, head + 1, memory_order_relaxed);
+}
+
+//Pending slots count as empty, see PINOperationRingSlotStatePending.
+static BOOL PINOperationRingIsEmpty(PINOperationRing *ring)
+{
+  NSUInteger head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  PINOperationRingSlot *slot = &ring->slots[head & ring->mask];
+  return atomic_load_explicit(&slot->sequence, memory_order_acquire) != head + 1
+      && atomic_load_explicit(&ring->spillCount, memory_order_acquire) == 0;
+}
+
+static void PINOperationRingDestroy(PINOperationRing *ring, void (*releaseItem)(void *item))
+{
+  PINOperationRingEntry entry;
+  BOOL fromSpill;
+  while (PINOperationRingPeek(ring, &entry, &fromSpill)) {
+    PINOperationRingDrop(ring, fromSpill);
+    releaseItem(entry.item);
+  }
+  free(ring->slots);
+  free(ring->spill);
+  pthread_mutex_destroy(&ring->spillLock);
+}
+
+#pragma mark - Operations
+
+typedef NS_ENUM(NSUInteger, PINOperationState) {
+  PINOperationStateQueued,
+  PINOperationStateClaimed,
+  PINOperationStateCancelled,
+};
+
+@interface PINOperation : NSObject <PINOperationReference>
+{
+@public
+  _Atomic(NSUInteger) _state;
+  _Atomic(NSUInteger) _priority;
+  uint64_t _enqueueTime;
+}
 
 @property (nonatomic, strong) PINOperationBlock block;
-@property (nonatomic, strong) id <PINOperationReference> reference;
-@property (nonatomic, assign) PINOperationQueuePriority priority;
-@property (nonatomic, strong) NSMutableArray<dispatch_block_t> *completions;
 @property (nonatomic, strong) NSString *identifier;
 @property (nonatomic, strong) id data;
 
-+ (instancetype)operationWithBlock:(PINOperationBlock)block reference:(id <PINOperationReference>)reference priority:(PINOperationQueuePriority)priority identifier:(nullable NSString *)identifier data:(nullable id)data completion:(nullable dispatch_block_t)completion;
++ (instancetype)operationWithBlock:(PINOperationBlock)block priority:(PINOperationQueuePriority)priority identifier:(nullable NSString *)identifier data:(nullable id)data completion:(nullable dispatch_block_t)completion;
 
 - (void)addCompletion:(nullable dispatch_block_t)completion;
+- (BOOL)transitionFromState:(PINOperationState)fromState toState:(PINOperationState)toState;
+- (void)run;
+- (void)clear;
 
 @end
 
 @implementation PINOperation
+{
+  //almost every operation has at most one completion
+  dispatch_block_t _completion;
+  NSMutableArray<dispatch_block_t> *_additionalCompletions;
+}
 
-+ (instancetype)operationWithBlock:(PINOperationBlock)block reference:(id<PINOperationReference>)reference priority:(PINOperationQueuePriority)priority identifier:(NSString *)identifier data:(id)data completion:(dispatch_block_t)completion
++ (instancetype)operationWithBlock:(PINOperationBlock)block priority:(PINOperationQueuePriority)priority identifier:(NSString *)identifier data:(id)data completion:(dispatch_block_t)completion
 {
+  NSAssert(priority <= PINOperationQueuePriorityHigh, @"Invalid priority set");
   PINOperation *operation = [[self alloc] init];
   operation.block = block;
-  operation.reference = reference;
-  operation.priority = priority;
+  atomic_init(&operation->_state, PINOperationStateQueued);
+  atomic_init(&operation->_priority, MIN(priority, PINOperationQueuePriorityHigh));
   operation.identifier = identifier;
   operation.data = data;
   [operation addCompletion:completion];
-  
+
   return operation;
 }
 
@@ -76,10 +255,80 @@
   if (completion == nil) {
     return;
   }
-  if (_completions == nil) {
-    _completions = [NSMutableArray array];
+  if (_completion == nil) {
+    _completion = completion;
+    return;
+  }
+  if (_additionalCompletions == nil) {
+    _additionalCompletions = [NSMutableArray array];
+  }
+  [_additionalCompletions addObject:completion];
+}
+
+- (BOOL)transitionFromState:(PINOperationState)fromState toState:(PINOperationState)toState
+{
+  NSUInteger expected = fromState;
+  return atomic_compare_exchange_strong(&_state, &expected, toState);
+}
+
+- (void)run
+{
+  _block(_data);
+  if (_completion) {
+    _completion();
+  }
+  for (dispatch_block_t completion in _additionalCompletions) {
+    completion();
   }
-  [_completions addObject:completion];
+  [self clear];
+}
+
+//References outlive operations, don't let them keep blocks and data alive.
+- (void)clear
+{
+  _block = nil;
+  _data = nil;
+  _completion = nil;
+  _additionalCompletions = nil;
+}
+
+@end
+
+static void PINOperationRelease(void *item)
+{
+  CFRelease(item);
+}
+
+#pragma mark - Queue
+
+@interface PINOperationQueue () {
+  pthread_mutex_t _lock;
+  //read without the lock when scheduling, the lock only orders setters
+  _Atomic(NSUInteger) _maxConcurrentOperations;
+
+  dispatch_group_t _group;
+
+  dispatch_queue_t _serialQueue;
+  atomic_bool _serialQueueBusy;
+
+  dispatch_semaphore_t _concurrentSemaphore;
+  dispatch_queue_t _concurrentQueue;
+  dispatch_queue_t _semaphoreQueue;
+  //schedules by priority not yet handled by the semaphore queue, which is only sent a block when this leaves zero
+  _Atomic(NSUInteger) _pendingPrioritySchedules;
+
+  //every operation is in both the queue order ring and the ring of its priority, and runs from whichever
+  //reaches it first. Entries of claimed, cancelled or reprioritized operations are skipped when reached.
+  PINOperationRing _queuedOperations;
+  pthread_mutex_t _queuedOperationsConsumerLock;
+  PINOperationRing _priorityOperations[PINOperationQueuePriorityHigh + 1];
+  //only concurrent queues run operations by priority, serial ones leave the priority rings out
+  atomic_bool _usesPriorityRings;
+  _Atomic(uint64_t) _priorityAgingTime;
+
+  //only guards operations with an identifier, against coalescing while they are claimed
+  pthread_mutex_t _coalescingLock;
+  NSMutableDictionary<NSString *, PINOperation *> *_identifierToOperations;
 }
 
 @end
@@ -95,38 +344,44 @@
 {
   if (self = [super init]) {
     NSAssert(maxConcurrentOperations > 0, @"Max concurrent operations must be greater than 0.");
-    _maxConcurrentOperations = maxConcurrentOperations;
-    _operationReferenceCount = 0;
-    
-    pthread_mutexattr_t attr;
-    pthread_mutexattr_init(&attr);
-    //mutex must be recursive to allow scheduling of operations from within operations
-    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
-    pthread_mutex_init(&_lock, &attr);
-    
+    atomic_init(&_maxConcurrentOperations, maxConcurrentOperations);
+
+    pthread_mutex_init(&_lock, NULL);
+    pthread_mutex_init(&_coalescingLock, NULL);
+    pthread_mutex_init(&_queuedOperationsConsumerLock, NULL);
+
     _group = dispatch_group_create();
-    
+
     _serialQueue = dispatch_queue_create("PINOperationQueue Serial Queue", DISPATCH_QUEUE_SERIAL);
-    
+    atomic_init(&_serialQueueBusy, NO);
+
     _concurrentQueue = concurrentQueue;
-    
+
     //Create a queue with max - 1 because this plus the serial queue add up to max.
-    _concurrentSemaphore = dispatch_semaphore_create(_maxConcurrentOperations - 1);
+    _concurrentSemaphore = dispatch_semaphore_create(maxConcurrentOperations - 1);
     _semaphoreQueue = dispatch_queue_create("PINOperationQueue Serial Semaphore Queue", DISPATCH_QUEUE_SERIAL);
-    
-    _queuedOperations = [[NSMutableOrderedSet alloc] init];
-    _lowPriorityOperations = [[NSMutableOrderedSet alloc] init];
-    _defaultPriorityOperations = [[NSMutableOrderedSet alloc] init];
-    _highPriorityOperations = [[NSMutableOrderedSet alloc] init];
-    
-    _referenceToOperations = [NSMapTable weakToWeakObjectsMapTable];
-    _identifierToOperations = [NSMapTable weakToWeakObjectsMapTable];
+    atomic_init(&_pendingPrioritySchedules, 0);
+
+    PINOperationRingInit(&_queuedOperations, PINOperationRingCapacity);
+    for (NSUInteger priority = PINOperationQueuePriorityLow; priority <= PINOperationQueuePriorityHigh; priority++) {
+      PINOperationRingInit(&_priorityOperations[priority], PINOperationRingCapacity);
+    }
+    atomic_init(&_usesPriorityRings, maxConcurrentOperations > 1);
+    atomic_init(&_priorityAgingTime, 0);
+
+    _identifierToOperations = [[NSMutableDictionary alloc] init];
   }
   return self;
 }
 
 - (void)dealloc
 {
+  PINOperationRingDestroy(&_queuedOperations, PINOperationRelease);
+  for (NSUInteger priority = PINOperationQueuePriorityLow; priority <= PINOperationQueuePriorityHigh; priority++) {
+    PINOperationRingDestroy(&_priorityOperations[priority], PINOperationRelease);
+  }
+  pthread_mutex_destroy(&_coalescingLock);
+  pthread_mutex_destroy(&_queuedOperationsConsumerLock);
   pthread_mutex_destroy(&_lock);
 }
 
@@ -140,14 +395,6 @@
     return sharedOperationQueue;
 }
 
-- (id <PINOperationReference>)nextOperationReference
-{
-  [self lock];
-    id <PINOperationReference> reference = [NSNumber numberWithUnsignedInteger:++_operationReferenceCount];
-  [self unlock];
-  return reference;
-}
-
 // Deprecated
 - (id <PINOperationReference>)addOperation:(dispatch_block_t)block
 {
@@ -168,18 +415,15 @@
 - (id <PINOperationReference>)scheduleOperation:(dispatch_block_t)block withPriority:(PINOperationQueuePriority)priority
 {
   PINOperation *operation = [PINOperation operationWithBlock:^(id data) { block(); }
-                                                   reference:[self nextOperationReference]
                                                     priority:priority
                                                   identifier:nil
                                                         data:nil
                                                   completion:nil];
-  [self lock];
-    [self locked_addOperation:operation];
-  [self unlock];
-  
+  [self addOperation:operation];
+
   [self scheduleNextOperations:NO];
-  
-  return operation.reference;
+
+  return operation;
 }
 
 // Deprecated
@@ -205,89 +449,109 @@
                            dataCoalescingBlock:(PINOperationDataCoalescingBlock)dataCoalescingBlock
                                     completion:(dispatch_block_t)completion
 {
-  id<PINOperationReference> reference = nil;
-  BOOL isNewOperation = NO;
-  
-  [self lock];
-    PINOperation *operation = nil;
-    if (identifier != nil && (operation = [_identifierToOperations objectForKey:identifier]) != nil) {
+  if (identifier == nil) {
+    PINOperation *operation = [PINOperation operationWithBlock:block
+                                                      priority:priority
+                                                    identifier:nil
+                                                          data:coalescingData
+                                                    completion:completion];
+    [self addOperation:operation];
+    [self scheduleNextOperations:NO];
+    return operation;
+  }
+
+  pthread_mutex_lock(&_coalescingLock);
+    // Operations leave the table when they are claimed or cancelled, so this one is still queued.
+    PINOperation *operation = _identifierToOperations[identifier];
+    BOOL isNewOperation = (operation == nil);
+    if (isNewOperation == NO) {
       // There is an exisiting operation with the provided identifier, let's coalesce these operations
       if (dataCoalescingBlock != nil) {
         operation.data = dataCoalescingBlock(operation.data, coalescingData);
       }
-      
+
       [operation addCompletion:completion];
     } else {
-      isNewOperation = YES;
       operation = [PINOperation operationWithBlock:block
-                                         reference:[self nextOperationReference]
                                           priority:priority
                                         identifier:identifier
                                               data:coalescingData
                                         completion:completion];
-      [self locked_addOperation:operation];
+      _identifierToOperations[identifier] = operation;
+      [self addOperation:operation];
     }
-    reference = operation.reference;
-  [self unlock];
-  
+  pthread_mutex_unlock(&_coalescingLock);
+
   if (isNewOperation) {
     [self scheduleNextOperations:NO];
   }
-  
-  return reference;
+
+  return operation;
 }
 
-- (void)locked_addOperation:(PINOperation *)operation
+- (void)addOperation:(PINOperation *)operation
 {
-  NSMutableOrderedSet *queue = [self operationQueueWithPriority:operation.priority];
-  
   dispatch_group_enter(_group);
-  [queue addObject:operation];
-  [_queuedOperations addObject:operation];
-  [_referenceToOperations setObject:operation forKey:operation.reference];
-  if (operation.identifier != nil) {
-    [_identifierToOperations setObject:operation forKey:operation.identifier];
+  operation->_enqueueTime = mach_absolute_time();
+
+  NSUInteger priority = atomic_load(&operation->_priority);
+  PINOperationRingPush(&_queuedOperations, (__bridge_retained void *)operation, 0);
+  if (atomic_load(&_usesPriorityRings)) {
+    PINOperationRingPush(&_priorityOperations[priority], (__bridge_retained void *)operation, priority);
   }
 }
 
 - (void)cancelAllOperations
 {
-  [self lock];
-    for (PINOperation *operation in [[_referenceToOperations copy] objectEnumerator]) {
-      [self locked_cancelOperation:operation.reference];
+  //the queue order ring holds every queued operation
+  NSMutableArray<PINOperation *> *operations = [NSMutableArray array];
+  pthread_mutex_lock(&_queuedOperationsConsumerLock);
+    PINOperationRingEntry entry;
+    BOOL fromSpill;
+    while (PINOperationRingPeek(&_queuedOperations, &entry, &fromSpill)) {
+      PINOperationRingDrop(&_queuedOperations, fromSpill);
+      [operations addObject:(__bridge_transfer PINOperation *)entry.item];
     }
-  [self unlock];
-}
+  pthread_mutex_unlock(&_queuedOperationsConsumerLock);
 
+  for (PINOperation *operation in operations) {
+    [self cancelOperation:operation];
+  }
+}
 
 - (BOOL)cancelOperation:(id <PINOperationReference>)operationReference
 {
-  [self lock];
-    BOOL success = [self locked_cancelOperation:operationReference];
-  [self unlock];
+  if ([operationReference isKindOfClass:[PINOperation class]] == NO) {
+    return NO;
+  }
+  PINOperation *operation = (PINOperation *)operationReference;
+
+  BOOL success = [self claimOperation:operation state:PINOperationStateCancelled];
+  if (success) {
+    [operation clear];
+    dispatch_group_leave(_group);
+  }
   return success;
 }
 
 - (NSUInteger)maxConcurrentOperations
 {
-  [self lock];
-    NSUInteger maxConcurrentOperations = _maxConcurrentOperations;
-  [self unlock];
-  return maxConcurrentOperations;
+  return atomic_load(&_maxConcurrentOperations);
 }
 
 - (void)setMaxConcurrentOperations:(NSUInteger)maxConcurrentOperations
 {
   NSAssert(maxConcurrentOperations > 0, @"Max concurrent operations must be greater than 0.");
   [self lock];
-    __block NSInteger difference = maxConcurrentOperations - _maxConcurrentOperations;
-    _maxConcurrentOperations = maxConcurrentOperations;
+    __block NSInteger difference = (NSInteger)maxConcurrentOperations - (NSInteger)atomic_exchange(&_maxConcurrentOperations, maxConcurrentOperations);
+    //operations queued while serial are only in the queue order ring, and still run from the serial queue
+    atomic_store(&_usesPriorityRings, maxConcurrentOperations > 1);
   [self unlock];
-  
+
   if (difference == 0) {
     return;
   }
-  
+
   dispatch_async(_semaphoreQueue, ^{
     while (difference != 0) {
       if (difference > 0) {
@@ -301,38 +565,52 @@
   });
 }
 
+- (NSTimeInterval)priorityAgingInterval
+{
+  return [PINOperationQueue secondsFromAbsoluteTime:atomic_load(&_priorityAgingTime)];
+}
+
+- (void)setPriorityAgingInterval:(NSTimeInterval)priorityAgingInterval
+{
+  atomic_store(&_priorityAgingTime, [PINOperationQueue absoluteTimeFromSeconds:MAX(priorityAgingInterval, 0)]);
+}
+
 #pragma mark - private methods
 
-- (BOOL)locked_cancelOperation:(id <PINOperationReference>)operationReference
-{
-  BOOL success = NO;
-  PINOperation *operation = [_referenceToOperations objectForKey:operationReference];
-  if (operation) {
-    NSMutableOrderedSet *queue = [self operationQueueWithPriority:operation.priority];
-    if ([queue containsObject:operation]) {
-      success = YES;
-      [queue removeObject:operation];
-      [_queuedOperations removeObject:operation];
-      dispatch_group_leave(_group);
-    }
+/**
+ Moves a queued operation to the given state. Only one caller can succeed, and operations with an identifier leave
+ the coalescing table at the same time, so that nothing is coalesced into an operation which won't run again.
+ */
+- (BOOL)claimOperation:(PINOperation *)operation state:(PINOperationState)state
+{
+  if (operation.identifier == nil) {
+    return [operation transitionFromState:PINOperationStateQueued toState:state];
   }
+
+  pthread_mutex_lock(&_coalescingLock);
+    BOOL success = [operation transitionFromState:PINOperationStateQueued toState:state];
+    if (success && _identifierToOperations[operation.identifier] == operation) {
+      [_identifierToOperations removeObjectForKey:operation.identifier];
+    }
+  pthread_mutex_unlock(&_coalescingLock);
   return success;
 }
 
 - (void)setOperationPriority:(PINOperationQueuePriority)priority withReference:(id <PINOperationReference>)operationReference
 {
-  [self lock];
-    PINOperation *operation = [_referenceToOperations objectForKey:operationReference];
-    if (operation && operation.priority != priority) {
-      NSMutableOrderedSet *oldQueue = [self operationQueueWithPriority:operation.priority];
-      [oldQueue removeObject:operation];
-      
-      operation.priority = priority;
-      
-      NSMutableOrderedSet *queue = [self operationQueueWithPriority:priority];
-      [queue addObject:operation];
-    }
-  [self unlock];
+  if ([operationReference isKindOfClass:[PINOperation class]] == NO) {
+    return;
+  }
+  PINOperation *operation = (PINOperation *)operationReference;
+  NSAssert(priority <= PINOperationQueuePriorityHigh, @"Invalid priority set");
+  priority = MIN(priority, PINOperationQueuePriorityHigh);
+
+  if (atomic_exchange(&operation->_priority, priority) != priority &&
+      atomic_load(&operation->_state) == PINOperationStateQueued &&
+      atomic_load(&_usesPriorityRings)) {
+    //the entry in the old ring no longer matches the priority of the operation and will be skipped
+    PINOperationRingPush(&_priorityOperations[priority], (__bridge_retained void *)operation, priority);
+  }
 }
 
 /**
@@ -341,120 +619,206 @@
  */
 - (void)scheduleNextOperations:(BOOL)onlyCheckSerial
 {
-  [self lock];
-  
-    //get next available operation in order, ignoring priority and run it on the serial queue
-    if (_serialQueueBusy == NO) {
-      PINOperation *operation = [self locked_nextOperationByQueue];
-      if (operation) {
-        _serialQueueBusy = YES;
-        dispatch_async(_serialQueue, ^{
-          operation.block(operation.data);
-          for (dispatch_block_t completion in operation.completions) {
-            completion();
-          }
-          dispatch_group_leave(self->_group);
-          
-          [self lock];
-            self->_serialQueueBusy = NO;
-          [self unlock];
-          
-          //see if there are any other operations
-          [self scheduleNextOperations:YES];
-        });
-      }
+  //get next available operation in order, ignoring priority and run it on the serial queue
+  while ([self acquireSerialQueue]) {
+    PINOperation *operation = [self nextOperationByQueue];
+    if (operation) {
+      dispatch_async(_serialQueue, ^{
+        [operation run];
+        dispatch_group_leave(self->_group);
+
+        atomic_store(&self->_serialQueueBusy, NO);
+
+        //see if there are any other operations
+        [self scheduleNextOperations:YES];
+      });
+      break;
     }
-  
-  NSInteger maxConcurrentOperations = _maxConcurrentOperations;
-  
-  [self unlock];
-  
+
+    atomic_store(&_serialQueueBusy, NO);
+    //an operation added after the ring was found empty may have missed the busy flag
+    if (PINOperationRingIsEmpty(&_queuedOperations)) {
+      break;
+    }
+  }
+
   if (onlyCheckSerial) {
     return;
   }
 
   //if only one concurrent operation is set, let's just use the serial queue for executing it
-  if (maxConcurrentOperations < 2) {
-    return;
-  }
-  
-  dispatch_async(_semaphoreQueue, ^{
-    dispatch_semaphore_wait(self->_concurrentSemaphore, DISPATCH_TIME_FOREVER);
-    [self lock];
-      PINOperation *operation = [self locked_nextOperationByPriority];
-    [self unlock];
-  
-    if (operation) {
-      dispatch_async(self->_concurrentQueue, ^{
-        operation.block(operation.data);
-        for (dispatch_block_t completion in operation.completions) {
-          completion();
-        }
-        dispatch_group_leave(self->_group);
-        dispatch_semaphore_signal(self->_concurrentSemaphore);
+  if (atomic_load(&_maxConcurrentOperations) < 2) {
+    //entries made before the queue became serial are released once their operations ran
+    if ([self hasPriorityEntries]) {
+      dispatch_async(_semaphoreQueue, ^{
+        [self dropStalePriorityEntries];
       });
-    } else {
-      dispatch_semaphore_signal(self->_concurrentSemaphore);
     }
-  });
+    return;
+  }
+
+  //a block already on its way to the semaphore queue also handles this schedule
+  if (atomic_fetch_add(&_pendingPrioritySchedules, 1) == 0) {
+    dispatch_async(_semaphoreQueue, ^{
+      [self runPendingOperationsByPriority];
+    });
+  }
 }
 
-- (NSMutableOrderedSet *)operationQueueWithPriority:(PINOperationQueuePriority)priority
+//Call on the semaphore queue
+- (void)runPendingOperationsByPriority
 {
-  switch (priority) {
-    case PINOperationQueuePriorityLow:
-      return _lowPriorityOperations;
-      
-    case PINOperationQueuePriorityDefault:
-      return _defaultPriorityOperations;
-      
-    case PINOperationQueuePriorityHigh:
-      return _highPriorityOperations;
-          
-    default:
-      NSAssert(NO, @"Invalid priority set");
-      return _defaultPriorityOperations;
+  NSUInteger pending = atomic_load(&_pendingPrioritySchedules);
+  while (pending > 0) {
+    for (NSUInteger handled = 0; handled < pending; handled++) {
+      dispatch_semaphore_wait(_concurrentSemaphore, DISPATCH_TIME_FOREVER);
+      PINOperation *operation = [self nextOperationByPriority];
+
+      if (operation) {
+        dispatch_async(_concurrentQueue, ^{
+          [operation run];
+          dispatch_group_leave(self->_group);
+          dispatch_semaphore_signal(self->_concurrentSemaphore);
+        });
+      } else {
+        dispatch_semaphore_signal(_concurrentSemaphore);
+        //operations are queued before they are counted, so the rest of the counted schedules would find none either
+        break;
+      }
+    }
+    //leave once no schedule arrived meanwhile, the next one sends a new block
+    pending = atomic_fetch_sub(&_pendingPrioritySchedules, pending) - pending;
   }
 }
 
-//Call with lock held
-- (PINOperation *)locked_nextOperationByPriority
+- (BOOL)acquireSerialQueue
+{
+  bool expected = NO;
+  return atomic_compare_exchange_strong(&_serialQueueBusy, &expected, YES);
+}
+
+/**
+ Returns the oldest operation of the ring which is still queued with the priority the entry was made for,
+ dropping the entries before it.
+ */
+- (PINOperation *)peekOperationInRing:(PINOperationRing *)ring fromSpill:(BOOL *)fromSpill
 {
-  PINOperation *operation = [_highPriorityOperations firstObject];
-  if (operation == nil) {
-    operation = [_defaultPriorityOperations firstObject];
+  PINOperationRingEntry entry;
+  while (PINOperationRingPeek(ring, &entry, fromSpill)) {
+    PINOperation *operation = (__bridge PINOperation *)entry.item;
+    if (atomic_load(&operation->_state) == PINOperationStateQueued &&
+        (ring == &_queuedOperations || atomic_load(&operation->_priority) == entry.tag)) {
+      return operation;
+    }
+    PINOperationRingDrop(ring, *fromSpill);
+    CFRelease(entry.item);
   }
-  if (operation == nil) {
-    operation = [_lowPriorityOperations firstObject];
+  return nil;
+}
+
+- (BOOL)hasPriorityEntries
+{
+  for (NSUInteger priority = PINOperationQueuePriorityLow; priority <= PINOperationQueuePriorityHigh; priority++) {
+    if (!PINOperationRingIsEmpty(&_priorityOperations[priority])) {
+      return YES;
+    }
   }
-  if (operation) {
-    [self locked_removeOperation:operation];
+  return NO;
+}
+
+//Call on the semaphore queue
+- (void)dropStalePriorityEntries
+{
+  for (NSUInteger priority = PINOperationQueuePriorityLow; priority <= PINOperationQueuePriorityHigh; priority++) {
+    BOOL fromSpill;
+    [self peekOperationInRing:&_priorityOperations[priority] fromSpill:&fromSpill];
   }
-  return operation;
 }
 
-//Call with lock held
-- (PINOperation *)locked_nextOperationByQueue
+//Call while holding the serial queue
+- (PINOperation *)nextOperationByQueue
 {
-  PINOperation *operation = [_queuedOperations firstObject];
-  [self locked_removeOperation:operation];
+  PINOperation *operation = nil;
+  BOOL fromSpill;
+  pthread_mutex_lock(&_queuedOperationsConsumerLock);
+    while ((operation = [self peekOperationInRing:&_queuedOperations fromSpill:&fromSpill]) != nil) {
+      PINOperationRingDrop(&_queuedOperations, fromSpill);
+      CFRelease((__bridge CFTypeRef)operation);
+      if ([self claimOperation:operation state:PINOperationStateClaimed]) {
+        break;
+      }
+    }
+  pthread_mutex_unlock(&_queuedOperationsConsumerLock);
   return operation;
 }
 
+//Call on the semaphore queue
+- (PINOperation *)nextOperationByPriority
+{
+  uint64_t agingTime = atomic_load(&_priorityAgingTime);
+  uint64_t now = mach_absolute_time();
+
+  while (YES) {
+    PINOperation *operation = nil;
+    PINOperationRing *ring = NULL;
+    BOOL fromSpill = NO;
+
+    for (NSInteger priority = PINOperationQueuePriorityHigh; priority >= (NSInteger)PINOperationQueuePriorityLow; priority--) {
+      BOOL candidateFromSpill;
+      PINOperation *candidate = [self peekOperationInRing:&_priorityOperations[priority] fromSpill:&candidateFromSpill];
+      if (candidate == nil) {
+        continue;
+      }
+      //the highest priority goes first, unless an operation of a lower one waited longer than the aging interval
+      BOOL aged = agingTime > 0 && now > candidate->_enqueueTime && now - candidate->_enqueueTime >= agingTime;
+      if (operation == nil || (aged && candidate->_enqueueTime < operation->_enqueueTime)) {
+        operation = candidate;
+        ring = &_priorityOperations[priority];
+        fromSpill = candidateFromSpill;
+      }
+      if (agingTime == 0) {
+        break;
+      }
+    }
+
+    if (operation == nil) {
+      return nil;
+    }
+
+    PINOperationRingDrop(ring, fromSpill);
+    CFRelease((__bridge CFTypeRef)operation);
+    if ([self claimOperation:operation state:PINOperationStateClaimed]) {
+      return operation;
+    }
+  }
+}
+
 - (void)waitUntilAllOperationsAreFinished
 {
   [self scheduleNextOperations:NO];
   dispatch_group_wait(_group, DISPATCH_TIME_FOREVER);
 }
 
-//Call with lock held
-- (void)locked_removeOperation:(PINOperation *)operation
++ (uint64_t)absoluteTimeFromSeconds:(NSTimeInterval)seconds
 {
-  if (operation) {
-    NSMutableOrderedSet *priorityQueue = [self operationQueueWithPriority:operation.priority];
-    [priorityQueue removeObject:operation];
-    [_queuedOperations removeObject:operation];
-  }
+  mach_timebase_info_data_t timebase = [self timebase];
+  return (uint64_t)(seconds * NSEC_PER_SEC * timebase.denom / timebase.numer);
+}
+
++ (NSTimeInterval)secondsFromAbsoluteTime:(uint64_t)absoluteTime
+{
+  mach_timebase_info_data_t timebase = [self timebase];
+  return (NSTimeInterval)absoluteTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
++ (mach_timebase_info_data_t)timebase
+{
+  static mach_timebase_info_data_t timebase;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    mach_timebase_info(&timebase);
+  });
+  return timebase;
 }
 
 - (void)lock
@@ -28,6 +28,16 @@
 @end
 #endif
 
+/**
+ How an image is going to be fit into the size it is decoded for.
+ */
+typedef NS_ENUM(NSUInteger, PINImageDecodeContentMode) {
+    /** Decode at the largest size that fits within the target size. */
+    PINImageDecodeContentModeAspectFit,
+    /** Decode at the smallest size that covers the target size. */
+    PINImageDecodeContentModeAspectFill,
+};
+
 NSData * __nullable PINImageJPEGRepresentation(PINImage * __nonnull image, CGFloat compressionQuality);
 NSData * __nullable PINImagePNGRepresentation(PINImage * __nonnull image);
 
@@ -35,6 +45,16 @@ NSData * __nullable PINImagePNGRepresentation(PINImage * __nonnull image);
 
 + (nullable PINImage *)pin_decodedImageWithData:(nonnull NSData *)data;
 + (nullable PINImage *)pin_decodedImageWithData:(nonnull NSData *)data skipDecodeIfPossible:(BOOL)skipDecodeIfPossible;
+/**
+ Decodes the image at the size it is going to be displayed at rather than at full resolution. JPEGs are scaled
+ while decoding, other formats are decoded once and scaled down by ImageIO, without the full size bitmap being kept.
+ The result keeps the aspect ratio of the original, is never larger than it, and is already decompressed.
+
+ @param data The encoded image.
+ @param targetPixelSize The size in pixels the image is going to be displayed at. CGSizeZero decodes at full size.
+ @param contentMode How the image is going to be fit into targetPixelSize.
+ */
++ (nullable PINImage *)pin_decodedImageWithData:(nonnull NSData *)data targetPixelSize:(CGSize)targetPixelSize contentMode:(PINImageDecodeContentMode)contentMode;
 + (nullable PINImage *)pin_decodedImageWithCGImageRef:(nonnull CGImageRef)imageRef;
 #if PIN_TARGET_IOS
 + (nullable PINImage *)pin_decodedImageWithCGImageRef:(nonnull CGImageRef)imageRef orientation:(UIImageOrientation) orientation;
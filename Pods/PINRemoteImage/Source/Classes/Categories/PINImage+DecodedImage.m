@@ -119,6 +119,69 @@ NSData * __nullable PINImagePNGRepresentation(PINImage * __nonnull image) {
     return decodedImage;
 }
 
++ (PINImage *)pin_decodedImageWithData:(NSData *)data targetPixelSize:(CGSize)targetPixelSize contentMode:(PINImageDecodeContentMode)contentMode
+{
+    if (data == nil) {
+        return nil;
+    }
+    
+    if (targetPixelSize.width <= 0 || targetPixelSize.height <= 0 || [data pin_isGIF]) {
+        return [self pin_decodedImageWithData:data];
+    }
+#if PIN_WEBP
+    if ([data pin_isWebP]) {
+        return [self pin_decodedImageWithData:data];
+    }
+#endif
+    
+    PINImage *decodedImage = nil;
+    
+    CGImageSourceRef imageSourceRef = CGImageSourceCreateWithData((CFDataRef)data, NULL);
+    
+    if (imageSourceRef) {
+        NSDictionary *properties = (NSDictionary *)CFBridgingRelease(CGImageSourceCopyPropertiesAtIndex(imageSourceRef, 0, NULL));
+        CGFloat width = [properties[(NSString *)kCGImagePropertyPixelWidth] doubleValue];
+        CGFloat height = [properties[(NSString *)kCGImagePropertyPixelHeight] doubleValue];
+        NSInteger exifOrientation = [properties[(NSString *)kCGImagePropertyOrientation] integerValue];
+        if (exifOrientation >= 5 && exifOrientation <= 8) {
+            //the thumbnail is rotated upright, so compare the rotated size
+            CGFloat swap = width;
+            width = height;
+            height = swap;
+        }
+        
+        CGFloat scale = 1.0;
+        if (width > 0 && height > 0) {
+            CGFloat widthScale = targetPixelSize.width / width;
+            CGFloat heightScale = targetPixelSize.height / height;
+            scale = (contentMode == PINImageDecodeContentModeAspectFill) ? MAX(widthScale, heightScale) : MIN(widthScale, heightScale);
+        }
+        
+        if (scale < 1.0) {
+            //ImageIO sizes thumbnails by their longest side. Thumbnails embedded in the file are too small to be used.
+            NSDictionary *options = @{(NSString *)kCGImageSourceCreateThumbnailFromImageAlways : (NSNumber *)kCFBooleanTrue,
+                                      (NSString *)kCGImageSourceCreateThumbnailWithTransform : (NSNumber *)kCFBooleanTrue,
+                                      (NSString *)kCGImageSourceShouldCacheImmediately : (NSNumber *)kCFBooleanTrue,
+                                      (NSString *)kCGImageSourceThumbnailMaxPixelSize : @(ceil(MAX(width, height) * scale))};
+            CGImageRef imageRef = CGImageSourceCreateThumbnailAtIndex(imageSourceRef, 0, (CFDictionaryRef)options);
+            if (imageRef) {
+#if PIN_TARGET_IOS
+                decodedImage = [PINImage imageWithCGImage:imageRef scale:1.0 orientation:UIImageOrientationUp];
+#elif PIN_TARGET_MAC
+                CGSize imageSize = CGSizeMake(CGImageGetWidth(imageRef), CGImageGetHeight(imageRef));
+                decodedImage = [[NSImage alloc] initWithCGImage:imageRef size:imageSize];
+#endif
+                CGImageRelease(imageRef);
+            }
+        }
+        
+        CFRelease(imageSourceRef);
+    }
+    
+    //the image is already small enough, or ImageIO couldn't make a thumbnail of it
+    return decodedImage ?: [self pin_decodedImageWithData:data];
+}
+
 + (PINImage *)pin_decodedImageWithCGImageRef:(CGImageRef)imageRef
 {
 #if PIN_TARGET_IOS
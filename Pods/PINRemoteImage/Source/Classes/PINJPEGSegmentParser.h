@@ -0,0 +1,54 @@
+//
+//  PINJPEGSegmentParser.h
+//  PINRemoteImage
+//
+
+#import <Foundation/Foundation.h>
+
+typedef NS_ENUM(NSUInteger, PINJPEGSegmentType) {
+    /** An application segment, APP0 through APP15, such as JFIF or EXIF. */
+    PINJPEGSegmentTypeAPPn,
+    /** Start of scan. Progressive JPEGs have one per scan. */
+    PINJPEGSegmentTypeSOS,
+    /** End of image. Nothing after it is parsed. */
+    PINJPEGSegmentTypeEOI,
+};
+
+/**
+ Called for every reported marker.
+
+ @param type The kind of segment the marker starts.
+ @param marker The marker byte following 0xFF, e.g. 0xDA for SOS.
+ @param offset The offset of the marker's 0xFF byte from the start of the image.
+ */
+typedef void (^PINJPEGSegmentHandler)(PINJPEGSegmentType type, uint8_t marker, NSUInteger offset);
+
+/**
+ Finds the markers of a JPEG while it downloads, one chunk of data at a time.
+
+ Every byte is looked at no more than once across calls, and the data is neither kept nor copied. Segment payloads
+ are skipped using their length, so markers inside e.g. an embedded EXIF thumbnail aren't reported, and entropy
+ coded data is searched for 0xFF 16 bytes at a time with SSE2 or NEON when available.
+ */
+@interface PINJPEGSegmentParser : NSObject
+
+/** The number of bytes parsed so far. */
+@property (nonatomic, readonly) NSUInteger parsedLength;
+
+/** YES once the data turned out not to be a JPEG. Further data is ignored. */
+@property (nonatomic, readonly, getter=isInvalid) BOOL invalid;
+
+/** YES once the end of image was found. Further data is ignored. */
+@property (nonatomic, readonly, getter=isFinished) BOOL finished;
+
+/**
+ Parses the next bytes of the image.
+ */
+- (void)parseBytes:(nonnull const uint8_t *)bytes length:(NSUInteger)length handler:(nullable PINJPEGSegmentHandler)handler;
+
+/**
+ Parses the next bytes of the image, region by region if the data isn't contiguous.
+ */
+- (void)parseData:(nonnull NSData *)data handler:(nullable PINJPEGSegmentHandler)handler;
+
+@end
@@ -0,0 +1,258 @@
+//
+//  PINJPEGSegmentParser.m
+//  PINRemoteImage
+//
+
+#import "PINJPEGSegmentParser.h"
+
+#if defined(__SSE2__)
+#import <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#import <arm_neon.h>
+#endif
+
+typedef NS_ENUM(uint8_t, PINJPEGParserState) {
+    PINJPEGParserStateStart,            // Expecting the 0xFF of SOI.
+    PINJPEGParserStateStartMarker,      // Expecting the 0xD8 of SOI.
+    PINJPEGParserStateMarkerPrefix,     // Expecting the 0xFF of the next marker.
+    PINJPEGParserStateMarker,           // Expecting a marker byte, or more 0xFF fill bytes.
+    PINJPEGParserStateLengthHigh,
+    PINJPEGParserStateLengthLow,
+    PINJPEGParserStateSegment,          // Skipping a segment payload.
+    PINJPEGParserStateEntropy,          // Searching entropy coded data for 0xFF.
+    PINJPEGParserStateEntropyMarker,    // Expecting the byte after a 0xFF in entropy coded data.
+    PINJPEGParserStateFinished,
+    PINJPEGParserStateInvalid,
+};
+
+typedef struct {
+    PINJPEGParserState state;
+    uint8_t marker;             // The marker of the segment being parsed.
+    uint8_t lengthHigh;
+    NSUInteger remaining;       // Bytes left in the segment payload.
+    NSUInteger markerOffset;    // Offset of the 0xFF of the last marker.
+    NSUInteger offset;          // Bytes parsed so far.
+} PINJPEGParserContext;
+
+typedef struct {
+    BOOL found;
+    PINJPEGSegmentType type;
+    uint8_t marker;
+    NSUInteger offset;
+} PINJPEGParserEvent;
+
+#pragma mark - Scanning
+
+/**
+ Returns the first 0xFF in [bytes, end), or end.
+ */
+static inline const uint8_t *PINJPEGFindFF(const uint8_t *bytes, const uint8_t *end)
+{
+#if defined(__SSE2__)
+    const __m128i ff = _mm_set1_epi8((char)0xFF);
+    while (end - bytes >= 16) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)bytes), ff));
+        if (mask != 0) {
+            return bytes + __builtin_ctz(mask);
+        }
+        bytes += 16;
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint8x16_t ff = vdupq_n_u8(0xFF);
+    while (end - bytes >= 16) {
+        uint8x16_t matches = vceqq_u8(vld1q_u8(bytes), ff);
+        // Narrow every matching byte to a nibble, there is no movemask on NEON.
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+        if (mask != 0) {
+            return bytes + (__builtin_ctzll(mask) >> 2);
+        }
+        bytes += 16;
+    }
+#endif
+    const uint8_t *found = memchr(bytes, 0xFF, end - bytes);
+    return found ? found : end;
+}
+
+/**
+ Handles the marker byte following a 0xFF outside of entropy coded data.
+ */
+static inline void PINJPEGParserHandleMarker(PINJPEGParserContext *context, uint8_t marker, PINJPEGParserEvent *event)
+{
+    context->marker = marker;
+    if (marker == 0xD9) {
+        // EOI
+        context->state = PINJPEGParserStateFinished;
+        *event = (PINJPEGParserEvent){YES, PINJPEGSegmentTypeEOI, marker, context->markerOffset};
+    } else if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+        // SOI, TEM and RSTn have no payload.
+        context->state = PINJPEGParserStateMarkerPrefix;
+    } else if (marker == 0x00) {
+        context->state = PINJPEGParserStateInvalid;
+    } else {
+        context->state = PINJPEGParserStateLengthHigh;
+        if (marker == 0xDA) {
+            *event = (PINJPEGParserEvent){YES, PINJPEGSegmentTypeSOS, marker, context->markerOffset};
+        } else if (marker >= 0xE0 && marker <= 0xEF) {
+            *event = (PINJPEGParserEvent){YES, PINJPEGSegmentTypeAPPn, marker, context->markerOffset};
+        }
+    }
+}
+
+static inline void PINJPEGParserEndSegment(PINJPEGParserContext *context)
+{
+    // The entropy coded data of a scan directly follows the SOS header.
+    context->state = (context->marker == 0xDA) ? PINJPEGParserStateEntropy : PINJPEGParserStateMarkerPrefix;
+}
+
+/**
+ Parses [bytes, end) until the end or until a marker to report is found, which is stored in event.
+ Returns the first byte that wasn't parsed.
+ */
+static const uint8_t *PINJPEGParserParse(PINJPEGParserContext *context, const uint8_t *bytes, const uint8_t *end, PINJPEGParserEvent *event)
+{
+    const uint8_t *start = bytes;
+    event->found = NO;
+
+    while (bytes < end && event->found == NO) {
+        switch (context->state) {
+            case PINJPEGParserStateStart:
+                context->state = (*bytes++ == 0xFF) ? PINJPEGParserStateStartMarker : PINJPEGParserStateInvalid;
+                break;
+            case PINJPEGParserStateStartMarker:
+                context->state = (*bytes++ == 0xD8) ? PINJPEGParserStateMarkerPrefix : PINJPEGParserStateInvalid;
+                break;
+            case PINJPEGParserStateMarkerPrefix: {
+                // Decoders skip stray bytes between segments, so do we.
+                const uint8_t *ff = PINJPEGFindFF(bytes, end);
+                if (ff < end) {
+                    context->markerOffset = context->offset + (ff - start);
+                    context->state = PINJPEGParserStateMarker;
+                    bytes = ff + 1;
+                } else {
+                    bytes = end;
+                }
+                break;
+            }
+            case PINJPEGParserStateMarker: {
+                uint8_t marker = *bytes;
+                if (marker == 0xFF) {
+                    context->markerOffset = context->offset + (bytes - start);
+                } else {
+                    PINJPEGParserHandleMarker(context, marker, event);
+                }
+                bytes++;
+                break;
+            }
+            case PINJPEGParserStateLengthHigh:
+                context->lengthHigh = *bytes++;
+                context->state = PINJPEGParserStateLengthLow;
+                break;
+            case PINJPEGParserStateLengthLow: {
+                NSUInteger length = ((NSUInteger)context->lengthHigh << 8) | *bytes++;
+                if (length < 2) {
+                    context->state = PINJPEGParserStateInvalid;
+                } else if (length == 2) {
+                    PINJPEGParserEndSegment(context);
+                } else {
+                    context->remaining = length - 2;
+                    context->state = PINJPEGParserStateSegment;
+                }
+                break;
+            }
+            case PINJPEGParserStateSegment: {
+                NSUInteger skipped = MIN(context->remaining, (NSUInteger)(end - bytes));
+                bytes += skipped;
+                context->remaining -= skipped;
+                if (context->remaining == 0) {
+                    PINJPEGParserEndSegment(context);
+                }
+                break;
+            }
+            case PINJPEGParserStateEntropy: {
+                const uint8_t *ff = PINJPEGFindFF(bytes, end);
+                if (ff < end) {
+                    context->markerOffset = context->offset + (ff - start);
+                    context->state = PINJPEGParserStateEntropyMarker;
+                    bytes = ff + 1;
+                } else {
+                    bytes = end;
+                }
+                break;
+            }
+            case PINJPEGParserStateEntropyMarker: {
+                uint8_t marker = *bytes;
+                if (marker == 0x00 || (marker >= 0xD0 && marker <= 0xD7)) {
+                    // A stuffed 0xFF data byte, or a restart marker inside the scan.
+                    context->state = PINJPEGParserStateEntropy;
+                } else if (marker == 0xFF) {
+                    context->markerOffset = context->offset + (bytes - start);
+                } else {
+                    PINJPEGParserHandleMarker(context, marker, event);
+                }
+                bytes++;
+                break;
+            }
+            case PINJPEGParserStateFinished:
+            case PINJPEGParserStateInvalid:
+                bytes = end;
+                break;
+        }
+    }
+
+    context->offset += bytes - start;
+    return bytes;
+}
+
+@interface PINJPEGSegmentParser ()
+{
+    PINJPEGParserContext _context;
+}
+
+@end
+
+@implementation PINJPEGSegmentParser
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _context.state = PINJPEGParserStateStart;
+    }
+    return self;
+}
+
+- (NSUInteger)parsedLength
+{
+    return _context.offset;
+}
+
+- (BOOL)isInvalid
+{
+    return _context.state == PINJPEGParserStateInvalid;
+}
+
+- (BOOL)isFinished
+{
+    return _context.state == PINJPEGParserStateFinished;
+}
+
+- (void)parseBytes:(const uint8_t *)bytes length:(NSUInteger)length handler:(PINJPEGSegmentHandler)handler
+{
+    const uint8_t *end = bytes + length;
+    PINJPEGParserEvent event;
+    while (bytes < end) {
+        bytes = PINJPEGParserParse(&_context, bytes, end, &event);
+        if (event.found && handler) {
+            handler(event.type, event.marker, event.offset);
+        }
+    }
+}
+
+- (void)parseData:(NSData *)data handler:(PINJPEGSegmentHandler)handler
+{
+    // Unlike -bytes, this doesn't flatten data that arrived in several regions.
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        [self parseBytes:bytes length:byteRange.length handler:handler];
+    }];
+}
+
+@end
@@ -13,6 +13,7 @@
 
 #import "PINRemoteImage.h"
 #import "PINImage+DecodedImage.h"
+#import "PINJPEGSegmentParser.h"
 #import "PINRemoteImageDownloadTask.h"
 #import "PINSpeedRecorder.h"
 
@@ -26,7 +27,7 @@
 @property (nonatomic, assign) BOOL isProgressiveJPEG;
 @property (nonatomic, assign) NSUInteger currentThreshold;
 @property (nonatomic, assign) NSUInteger startingBytes;
-@property (nonatomic, assign) NSUInteger scannedByte;
+@property (nonatomic, strong) PINJPEGSegmentParser *segmentParser;
 @property (nonatomic, assign) NSInteger sosCount;
 @property (nonatomic, strong) PINRemoteLock *lock;
 #if DEBUG
@@ -53,7 +54,7 @@
         self.progressThresholds = @[@0.00, @0.35, @0.65];
         self.estimatedRemainingTimeThreshold = -1;
         self.sosCount = 0;
-        self.scannedByte = 0;
+        self.segmentParser = [[PINJPEGSegmentParser alloc] init];
 #if DEBUG
         self.scanTime = 0;
 #endif
@@ -149,17 +150,16 @@
         }
         [self.mutableData appendData:data];
         
-        while ([self l_hasCompletedFirstScan] == NO && self.scannedByte < self.mutableData.length) {
+        if ([self l_hasCompletedFirstScan] == NO) {
     #if DEBUG
             CFTimeInterval start = CACurrentMediaTime();
     #endif
-            NSUInteger startByte = self.scannedByte;
-            if (startByte > 0) {
-                startByte--;
-            }
-            if ([self l_scanForSOSinData:self.mutableData startByte:startByte scannedByte:&_scannedByte]) {
-                self.sosCount++;
-            }
+            //only the new bytes are scanned, the parser picks up where the last append left off
+            [self.segmentParser parseData:data handler:^(PINJPEGSegmentType type, uint8_t marker, NSUInteger offset) {
+                if (type == PINJPEGSegmentTypeSOS) {
+                    self.sosCount++;
+                }
+            }];
     #if DEBUG
             CFTimeInterval total = CACurrentMediaTime() - start;
             self.scanTime += total;
@@ -273,31 +273,6 @@
 
 #pragma mark - private
 
-- (BOOL)l_scanForSOSinData:(NSData *)data startByte:(NSUInteger)startByte scannedByte:(NSUInteger *)scannedByte
-{
-    //check if we have a complete scan
-    Byte scanMarker[2];
-    //SOS marker
-    scanMarker[0] = 0xFF;
-    scanMarker[1] = 0xDA;
-    
-    //scan one byte back in case we only got half the SOS on the last data append
-    NSRange scanRange;
-    scanRange.location = startByte;
-    scanRange.length = data.length - scanRange.location;
-    NSRange sosRange = [data rangeOfData:[NSData dataWithBytes:scanMarker length:2] options:0 range:scanRange];
-    if (sosRange.location != NSNotFound) {
-        if (scannedByte) {
-            *scannedByte = NSMaxRange(sosRange);
-        }
-        return YES;
-    }
-    if (scannedByte) {
-        *scannedByte = NSMaxRange(scanRange);
-    }
-    return NO;
-}
-
 - (BOOL)l_hasCompletedFirstScan
 {
     return self.sosCount >= 2;
@@ -18,6 +18,7 @@
 #import "PINRemoteImageMacros.h"
 
 #import "PINRemoteImageManagerResult.h"
+#import "PINImage+DecodedImage.h"
 
 @protocol PINRemoteImageManagerAlternateRepresentationProvider;
 @protocol PINRemoteImageCaching;
@@ -436,6 +437,27 @@ typedef void(^PINRemoteImageManagerProgressDownload)(int64_t completedBytes, int
                          progressDownload:(nullable PINRemoteImageManagerProgressDownload)progressDownload
                                completion:(nullable PINRemoteImageManagerImageCompletion)completion;
 
+/**
+ Download or retrieve from cache the image found at the url, decoded at the size it is going to be displayed at instead of at full resolution. This saves the memory and decoding time of the full size bitmap for images much larger than where they are displayed. Decoded images are cached apart from full size ones, see cacheKeyForURL:targetSize:contentMode:. All completions are called on an arbitrary callback queue unless called on the main thread and the result is in the memory cache (this is an optimization to allow synchronous results for the UI when an object is cached in memory).
+ 
+ Images are always decoded before being returned, PINRemoteImageManagerDownloadOptionsSkipDecode is ignored. Animated images and WebP are returned at full size.
+ 
+ @param url NSURL where the image to download resides.
+ @param options PINRemoteImageManagerDownloadOptions options with which to fetch the image.
+ @param targetSize The size in pixels the image is going to be displayed at. The returned image keeps its aspect ratio and is never larger than the original. Pass CGSizeZero to decode at full size.
+ @param contentMode How the image is going to be fit into targetSize.
+ @param progressDownload PINRemoteImageManagerDownloadProgress block which will be called to update progress in bytes of the image download. NOTE: For performance reasons, this block is not called on the main thread every time, if you need to update your UI ensure that you dispatch to the main thread first.
+ @param completion PINRemoteImageManagerImageCompletion block to call when image has been fetched from the cache or downloaded.
+ 
+ @return An NSUUID which uniquely identifies this request. To be used for canceling requests and verifying that the callback is for the request you expect (see categories for example).
+ */
+- (nullable NSUUID *)downloadImageWithURL:(nonnull NSURL *)url
+                                  options:(PINRemoteImageManagerDownloadOptions)options
+                               targetSize:(CGSize)targetSize
+                              contentMode:(PINImageDecodeContentMode)contentMode
+                         progressDownload:(nullable PINRemoteImageManagerProgressDownload)progressDownload
+                               completion:(nullable PINRemoteImageManagerImageCompletion)completion;
+
 /**
  Download or retrieve from cache one of the images found at the urls in the passed in array based on current network performance. URLs should be sorted from lowest quality image URL to highest. All completions are called on an arbitrary callback queue unless called on the main thread and the result is in the memory cache (this is an optimization to allow synchronous results for the UI when an object is cached in memory).
  
@@ -499,6 +521,18 @@ typedef void(^PINRemoteImageManagerProgressDownload)(int64_t completedBytes, int
  */
 - (nonnull NSString *)cacheKeyForURL:(nonnull NSURL *)url processorKey:(nullable NSString *)processorKey;
 
+/**
+ Returns the cacheKey of an image decoded for a target size.
+ @see downloadImageWithURL:options:targetSize:contentMode:progressDownload:completion:
+ 
+ @param url NSURL that was used to download image
+ @param targetSize The size in pixels the image was decoded for. Returns the key of the full size image for CGSizeZero.
+ @param contentMode How the image was fit into targetSize.
+ 
+ @return returns an NSString which is the key used for caching.
+ */
+- (nonnull NSString *)cacheKeyForURL:(nonnull NSURL *)url targetSize:(CGSize)targetSize contentMode:(PINImageDecodeContentMode)contentMode;
+
 /**
  @see imageFromCacheWithURL:processorKey:options:completion:
  @deprecated
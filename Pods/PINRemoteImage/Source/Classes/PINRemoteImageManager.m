@@ -78,6 +78,10 @@ float dataTaskPriorityWithImageManagerPriority(PINRemoteImageManagerPriority pri
     }
 }
 
+static inline BOOL PINRemoteImageIsTargetSize(CGSize targetSize) {
+    return targetSize.width > 0 && targetSize.height > 0;
+}
+
 NSString * const PINRemoteImageManagerErrorDomain = @"PINRemoteImageManagerErrorDomain";
 NSString * const PINRemoteImageCacheKey = @"cacheKey";
 NSString * const PINRemoteImageCacheKeyResumePrefix = @"R-";
@@ -533,6 +537,26 @@ static dispatch_once_t sharedDispatchToken;
                         inputUUID:nil];
 }
 
+- (NSUUID *)downloadImageWithURL:(NSURL *)url
+                         options:(PINRemoteImageManagerDownloadOptions)options
+                      targetSize:(CGSize)targetSize
+                     contentMode:(PINImageDecodeContentMode)contentMode
+                progressDownload:(PINRemoteImageManagerProgressDownload)progressDownload
+                      completion:(PINRemoteImageManagerImageCompletion)completion
+{
+    return [self downloadImageWithURL:url
+                              options:options
+                             priority:PINRemoteImageManagerPriorityDefault
+                           targetSize:targetSize
+                          contentMode:contentMode
+                         processorKey:nil
+                            processor:nil
+                        progressImage:nil
+                     progressDownload:progressDownload
+                           completion:completion
+                            inputUUID:nil];
+}
+
 - (NSUUID *)downloadImageWithURL:(NSURL *)url
                          options:(PINRemoteImageManagerDownloadOptions)options
                         priority:(PINRemoteImageManagerPriority)priority
@@ -542,17 +566,47 @@ static dispatch_once_t sharedDispatchToken;
                 progressDownload:(PINRemoteImageManagerProgressDownload)progressDownload
                       completion:(PINRemoteImageManagerImageCompletion)completion
                        inputUUID:(NSUUID *)UUID
+{
+    return [self downloadImageWithURL:url
+                              options:options
+                             priority:priority
+                           targetSize:CGSizeZero
+                          contentMode:PINImageDecodeContentModeAspectFit
+                         processorKey:processorKey
+                            processor:processor
+                        progressImage:progressImage
+                     progressDownload:progressDownload
+                           completion:completion
+                            inputUUID:UUID];
+}
+
+- (NSUUID *)downloadImageWithURL:(NSURL *)url
+                         options:(PINRemoteImageManagerDownloadOptions)options
+                        priority:(PINRemoteImageManagerPriority)priority
+                      targetSize:(CGSize)targetSize
+                     contentMode:(PINImageDecodeContentMode)contentMode
+                    processorKey:(NSString *)processorKey
+                       processor:(PINRemoteImageManagerImageProcessor)processor
+                   progressImage:(PINRemoteImageManagerImageCompletion)progressImage
+                progressDownload:(PINRemoteImageManagerProgressDownload)progressDownload
+                      completion:(PINRemoteImageManagerImageCompletion)completion
+                       inputUUID:(NSUUID *)UUID
 {
     NSAssert((processor != nil && processorKey.length > 0) || (processor == nil && processorKey == nil), @"processor must not be nil and processorKey length must be greater than zero OR processor must be nil and processorKey must be nil");
+    NSAssert(processor == nil || PINRemoteImageIsTargetSize(targetSize) == NO, @"Processed images are always decoded at full size");
     
     Class taskClass;
     if (processor && processorKey.length > 0) {
         taskClass = [PINRemoteImageProcessorTask class];
+        targetSize = CGSizeZero;
+    } else if (PINRemoteImageIsTargetSize(targetSize)) {
+        //like processed images, sized images are derived from the download of the original
+        taskClass = [PINRemoteImageProcessorTask class];
     } else {
         taskClass = [PINRemoteImageDownloadTask class];
     }
     
-    NSString *key = [self cacheKeyForURL:url processorKey:processorKey];
+    NSString *key = PINRemoteImageIsTargetSize(targetSize) ? [self cacheKeyForURL:url targetSize:targetSize contentMode:contentMode] : [self cacheKeyForURL:url processorKey:processorKey];
 
     if (url == nil) {
         [self earlyReturnWithOptions:options url:nil key:key object:nil completion:completion];
@@ -573,7 +627,7 @@ static dispatch_once_t sharedDispatchToken;
         //If so, special case this to avoid flashing the UI
         id object = [self.cache objectFromMemoryForKey:key];
         if (object) {
-            if ([self earlyReturnWithOptions:options url:url key:key object:object completion:completion]) {
+            if ([self earlyReturnWithOptions:options url:url key:key targetSize:targetSize contentMode:contentMode object:object completion:completion]) {
                 return nil;
             }
         }
@@ -582,7 +636,7 @@ static dispatch_once_t sharedDispatchToken;
     if ([url.scheme isEqualToString:@"data"]) {
         NSData *data = [NSData dataWithContentsOfURL:url];
         if (data) {
-            if ([self earlyReturnWithOptions:options url:url key:key object:data completion:completion]) {
+            if ([self earlyReturnWithOptions:options url:url key:key targetSize:targetSize contentMode:contentMode object:data completion:completion]) {
                 return nil;
             }
         }
@@ -619,7 +673,7 @@ static dispatch_once_t sharedDispatchToken;
         if (taskExisted == NO) {
             [self.concurrentOperationQueue scheduleOperation:^
              {
-                 [self objectForKey:key options:options completion:^(BOOL found, BOOL valid, PINImage *image, id alternativeRepresentation) {
+                 [self objectForURL:url processorKey:nil key:key options:options targetSize:targetSize contentMode:contentMode completion:^(BOOL found, BOOL valid, PINImage *image, id alternativeRepresentation) {
                      if (found) {
                          if (valid) {
                              [self callCompletionsWithKey:key image:image alternativeRepresentation:alternativeRepresentation cached:YES response:nil error:nil finalized:YES];
@@ -637,6 +691,8 @@ static dispatch_once_t sharedDispatchToken;
                              [self downloadImageWithURL:url
                                                 options:options | PINRemoteImageManagerDownloadOptionsSkipEarlyCheck
                                                priority:priority
+                                             targetSize:targetSize
+                                            contentMode:contentMode
                                            processorKey:processorKey
                                               processor:processor
                                           progressImage:(PINRemoteImageManagerImageCompletion)progressImage
@@ -645,7 +701,16 @@ static dispatch_once_t sharedDispatchToken;
                                               inputUUID:UUID];
                          }
                      } else {
-                         if ([taskClass isSubclassOfClass:[PINRemoteImageProcessorTask class]]) {
+                         if (PINRemoteImageIsTargetSize(targetSize)) {
+                             //continue decoding
+                             [self downloadImageWithURL:url
+                                                options:options
+                                               priority:priority
+                                                    key:key
+                                             targetSize:targetSize
+                                            contentMode:contentMode
+                                                   UUID:UUID];
+                         } else if ([taskClass isSubclassOfClass:[PINRemoteImageProcessorTask class]]) {
                              //continue processing
                              [self downloadImageWithURL:url
                                                 options:options
@@ -741,6 +806,53 @@ static dispatch_once_t sharedDispatchToken;
     [self unlock];
 }
 
+- (void)downloadImageWithURL:(NSURL *)url
+                     options:(PINRemoteImageManagerDownloadOptions)options
+                    priority:(PINRemoteImageManagerPriority)priority
+                         key:(NSString *)key
+                  targetSize:(CGSize)targetSize
+                 contentMode:(PINImageDecodeContentMode)contentMode
+                        UUID:(NSUUID *)UUID
+{
+    PINRemoteImageProcessorTask *task = nil;
+    [self lock];
+        task = [self.tasks objectForKey:key];
+        //check decoding task still exists and download hasn't been started for another task
+        if (task == nil || task.downloadTaskUUID != nil) {
+            [self unlock];
+            return;
+        }
+        
+        //the original is downloaded and stored on disk once, whatever the target size.
+        //skip its full size decode, only the sized image is decoded.
+        __weak typeof(self) weakSelf = self;
+        NSUUID *downloadTaskUUID = [self downloadImageWithURL:url
+                                                      options:options | PINRemoteImageManagerDownloadOptionsSkipEarlyCheck | PINRemoteImageManagerDownloadOptionsSkipDecode
+                                                   completion:^(PINRemoteImageManagerResult *result)
+        {
+            typeof(self) strongSelf = weakSelf;
+            [strongSelf.concurrentOperationQueue scheduleOperation:^
+            {
+                PINImage *image = nil;
+                id alternativeRepresentation = nil;
+                NSError *error = result.error;
+                if (error == nil) {
+                    NSData *data = [strongSelf dataForURL:url];
+                    //only the decoded image is kept, in memory
+                    if (data == nil || [strongSelf materializeAndCacheObject:data cacheInDisk:nil additionalCost:0 url:url key:key options:options targetSize:targetSize contentMode:contentMode outImage:&image outAltRep:&alternativeRepresentation] == NO) {
+                        error = [NSError errorWithDomain:PINRemoteImageManagerErrorDomain
+                                                    code:PINRemoteImageManagerErrorFailedToDecodeImage
+                                                userInfo:nil];
+                    }
+                }
+                
+                [strongSelf callCompletionsWithKey:key image:image alternativeRepresentation:alternativeRepresentation cached:NO response:result.response error:error finalized:YES];
+            } withPriority:operationPriorityWithImageManagerPriority(priority)];
+        }];
+        task.downloadTaskUUID = downloadTaskUUID;
+    [self unlock];
+}
+
 - (void)downloadImageWithURL:(NSURL *)url
                      options:(PINRemoteImageManagerDownloadOptions)options
                     priority:(PINRemoteImageManagerPriority)priority
@@ -807,6 +919,17 @@ static dispatch_once_t sharedDispatchToken;
 }
 
 - (BOOL)earlyReturnWithOptions:(PINRemoteImageManagerDownloadOptions)options url:(NSURL *)url key:(NSString *)key object:(id)object completion:(PINRemoteImageManagerImageCompletion)completion
+{
+    return [self earlyReturnWithOptions:options url:url key:key targetSize:CGSizeZero contentMode:PINImageDecodeContentModeAspectFit object:object completion:completion];
+}
+
+- (BOOL)earlyReturnWithOptions:(PINRemoteImageManagerDownloadOptions)options
+                           url:(NSURL *)url
+                           key:(NSString *)key
+                    targetSize:(CGSize)targetSize
+                   contentMode:(PINImageDecodeContentMode)contentMode
+                        object:(id)object
+                    completion:(PINRemoteImageManagerImageCompletion)completion
 {
     PINImage *image = nil;
     id alternativeRepresentation = nil;
@@ -816,7 +939,7 @@ static dispatch_once_t sharedDispatchToken;
 
     if (url != nil && object != nil) {
         resultType = PINRemoteImageResultTypeMemoryCache;
-        [self materializeAndCacheObject:object url:url key:key options:options outImage:&image outAltRep:&alternativeRepresentation];
+        [self materializeAndCacheObject:object cacheInDisk:nil additionalCost:0 url:url key:key options:options targetSize:targetSize contentMode:contentMode outImage:&image outAltRep:&alternativeRepresentation];
     }
     
     if (completion && ((image || alternativeRepresentation) || (url == nil))) {
@@ -1245,14 +1368,29 @@ static dispatch_once_t sharedDispatchToken;
     return [self materializeAndCacheObject:object cacheInDisk:nil additionalCost:0 url:url key:key options:options outImage:outImage outAltRep:outAlternateRepresentation];
 }
 
+- (BOOL)materializeAndCacheObject:(id)object
+                      cacheInDisk:(NSData *)diskData
+                   additionalCost:(NSUInteger)additionalCost
+                              url:(NSURL *)url
+                              key:(NSString *)key
+                          options:(PINRemoteImageManagerDownloadOptions)options
+                         outImage:(PINImage **)outImage
+                        outAltRep:(id *)outAlternateRepresentation
+{
+    return [self materializeAndCacheObject:object cacheInDisk:diskData additionalCost:additionalCost url:url key:key options:options targetSize:CGSizeZero contentMode:PINImageDecodeContentModeAspectFit outImage:outImage outAltRep:outAlternateRepresentation];
+}
+
 //takes the object from the cache and returns an image or animated image.
 //if it's a non-alternative representation and skipDecode is not set it also decompresses the image.
+//with a target size the image is always decoded, at that size.
 - (BOOL)materializeAndCacheObject:(id)object
                       cacheInDisk:(NSData *)diskData
                    additionalCost:(NSUInteger)additionalCost
                               url:(NSURL *)url
                               key:(NSString *)key
                           options:(PINRemoteImageManagerDownloadOptions)options
+                       targetSize:(CGSize)targetSize
+                      contentMode:(PINImageDecodeContentMode)contentMode
                          outImage:(PINImage **)outImage
                         outAltRep:(id *)outAlternateRepresentation
 {
@@ -1261,7 +1399,8 @@ static dispatch_once_t sharedDispatchToken;
         return NO;
     }
     BOOL alternateRepresentationsAllowed = (PINRemoteImageManagerDisallowAlternateRepresentations & options) == 0;
-    BOOL skipDecode = (options & PINRemoteImageManagerDownloadOptionsSkipDecode) != 0;
+    BOOL decodeToTargetSize = PINRemoteImageIsTargetSize(targetSize);
+    BOOL skipDecode = (options & PINRemoteImageManagerDownloadOptionsSkipDecode) != 0 && decodeToTargetSize == NO;
     __block id alternateRepresentation = nil;
     __block PINImage *image = nil;
     __block NSData *data = nil;
@@ -1304,7 +1443,11 @@ static dispatch_once_t sharedDispatchToken;
             image = container.image;
         }];
         if (image == nil && container.data) {
-            image = [PINImage pin_decodedImageWithData:container.data skipDecodeIfPossible:skipDecode];
+            if (decodeToTargetSize) {
+                image = [PINImage pin_decodedImageWithData:container.data targetPixelSize:targetSize contentMode:contentMode];
+            } else {
+                image = [PINImage pin_decodedImageWithData:container.data skipDecodeIfPossible:skipDecode];
+            }
             
             if (url != nil) {
                 image = [PINImage pin_scaledImageForImage:image withKey:key];
@@ -1321,6 +1464,10 @@ static dispatch_once_t sharedDispatchToken;
     
     if (updateMemoryCache) {
         [container.lock lockWithBlock:^{
+            //the original's bytes stay cached under the original's key only
+            if (decodeToTargetSize && container.image) {
+                container.data = nil;
+            }
             NSUInteger cacheCost = additionalCost;
             cacheCost += [container.data length];
             CGImageRef imageRef = container.image.CGImage;
@@ -1357,6 +1504,39 @@ static dispatch_once_t sharedDispatchToken;
     return [self cacheKeyForURL:url processorKey:processorKey resume:NO];
 }
 
+//the original's bytes, from the memory container of a download or from disk.
+- (NSData *)dataForURL:(NSURL *)url
+{
+    NSString *key = [self cacheKeyForURL:url processorKey:nil];
+    __block NSData *data = nil;
+    id object = [self.cache objectFromMemoryForKey:key];
+    if ([object isKindOfClass:[PINRemoteImageMemoryContainer class]]) {
+        PINRemoteImageMemoryContainer *container = (PINRemoteImageMemoryContainer *)object;
+        [container.lock lockWithBlock:^{
+            data = container.data;
+        }];
+    }
+    if (data == nil) {
+        object = [self.cache objectFromDiskForKey:key];
+        if ([object isKindOfClass:[NSData class]]) {
+            data = (NSData *)object;
+        }
+    }
+    return data;
+}
+
+- (NSString *)cacheKeyForURL:(NSURL *)url targetSize:(CGSize)targetSize contentMode:(PINImageDecodeContentMode)contentMode
+{
+    if (PINRemoteImageIsTargetSize(targetSize) == NO) {
+        return [self cacheKeyForURL:url processorKey:nil];
+    }
+    //shares the format of processed images, which are cached apart from the original as well
+    NSString *sizeKey = [NSString stringWithFormat:@"PINDecodedSize-%.0fx%.0f-%@",
+                         ceil(targetSize.width), ceil(targetSize.height),
+                         contentMode == PINImageDecodeContentModeAspectFill ? @"fill" : @"fit"];
+    return [self cacheKeyForURL:url processorKey:sizeKey];
+}
+
 - (NSString *)cacheKeyForURL:(NSURL *)url processorKey:(NSString *)processorKey resume:(BOOL)resume
 {
     NSString *cacheKey = [url absoluteString];
@@ -1394,12 +1574,18 @@ static dispatch_once_t sharedDispatchToken;
     return cacheKey;
 }
 
-- (void)objectForKey:(NSString *)key options:(PINRemoteImageManagerDownloadOptions)options completion:(void (^)(BOOL found, BOOL valid, PINImage *image, id alternativeRepresentation))completion
+- (void)objectForURL:(NSURL *)url processorKey:(NSString *)processorKey key:(NSString *)key options:(PINRemoteImageManagerDownloadOptions)options completion:(void (^)(BOOL found, BOOL valid, PINImage *image, id alternativeRepresentation))completion
 {
-    return [self objectForURL:nil processorKey:nil key:key options:options completion:completion];
+    return [self objectForURL:url processorKey:processorKey key:key options:options targetSize:CGSizeZero contentMode:PINImageDecodeContentModeAspectFit completion:completion];
 }
 
-- (void)objectForURL:(NSURL *)url processorKey:(NSString *)processorKey key:(NSString *)key options:(PINRemoteImageManagerDownloadOptions)options completion:(void (^)(BOOL found, BOOL valid, PINImage *image, id alternativeRepresentation))completion
+- (void)objectForURL:(NSURL *)url
+        processorKey:(NSString *)processorKey
+                 key:(NSString *)key
+             options:(PINRemoteImageManagerDownloadOptions)options
+          targetSize:(CGSize)targetSize
+         contentMode:(PINImageDecodeContentMode)contentMode
+          completion:(void (^)(BOOL found, BOOL valid, PINImage *image, id alternativeRepresentation))completion
 {
     if ((options & PINRemoteImageManagerDownloadOptionsIgnoreCache) != 0) {
         completion(NO, YES, nil, nil);
@@ -1412,17 +1598,26 @@ static dispatch_once_t sharedDispatchToken;
     }
   
     key = key ?: [self cacheKeyForURL:url processorKey:processorKey];
+    //sized images are only kept in memory, on disk they are decoded again from the original
+    NSString *diskKey = (PINRemoteImageIsTargetSize(targetSize) && url != nil) ? [self cacheKeyForURL:url processorKey:nil] : key;
 
     void (^materialize)(id object) = ^(id object) {
         PINImage *image = nil;
         id alternativeRepresentation = nil;
         BOOL valid = [self materializeAndCacheObject:object
+                                         cacheInDisk:nil
+                                      additionalCost:0
                                                  url:nil
                                                  key:key
                                              options:options
+                                          targetSize:targetSize
+                                         contentMode:contentMode
                                             outImage:&image
                                            outAltRep:&alternativeRepresentation];
         
+        if (valid == NO && diskKey != key) {
+            [self.cache removeObjectForKey:diskKey completion:nil];
+        }
         completion(YES, valid, image, alternativeRepresentation);
     };
     
@@ -1430,7 +1625,7 @@ static dispatch_once_t sharedDispatchToken;
     if (container) {
         materialize(container);
     } else {
-        [self.cache objectFromDiskForKey:key completion:^(id<PINRemoteImageCaching> _Nonnull cache,
+        [self.cache objectFromDiskForKey:diskKey completion:^(id<PINRemoteImageCaching> _Nonnull cache,
                                                          NSString *_Nonnull key,
                                                          id _Nullable object) {
           if (object) {
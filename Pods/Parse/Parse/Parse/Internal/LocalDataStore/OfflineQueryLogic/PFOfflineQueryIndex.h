@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import <Parse/PFConstants.h>
+
+#import "PFMacros.h"
+
+@class BFTask<__covariant BFGenericType>;
+@class PFQueryState;
+@class PFSQLiteDatabase;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The part of a query's constraints and sort keys that `PFOfflineQueryIndex` could express in SQL.
+ All clauses refer to the `ParseObjects` table aliased as `A`.
+
+ The SQL only narrows down candidates, it never excludes an object that the in-memory matcher would accept,
+ so the matcher still has to run on every candidate.
+ */
+@interface PFOfflineQuerySQLFilter : NSObject
+
+/**
+ YES if no constraint or sort key could be compiled.
+ */
+@property (nonatomic, assign, readonly, getter=isEmpty) BOOL empty;
+
+/**
+ YES if every sort key was compiled, so candidates come back sorted by the compiled keys.
+ They are only in the order of the query if `orderCheck` returns no rows.
+ */
+@property (nonatomic, assign, readonly, getter=isOrdered) BOOL ordered;
+
+/**
+ Extra result columns for the sort keys, each starting with a comma, and their arguments.
+ */
+@property (nonatomic, copy, readonly) NSString *columns;
+@property (nonatomic, copy, readonly) NSArray *columnArguments;
+
+/**
+ Conditions to AND into the WHERE clause, each starting with `AND`, and their arguments.
+ They exclude unindexed objects, see `unindexedCondition`.
+ */
+@property (nonatomic, copy, readonly) NSString *conditions;
+@property (nonatomic, copy, readonly) NSArray *conditionArguments;
+
+/**
+ A condition that only selects the objects the index can't describe, such as objects with
+ unsaved operations. Those always have to be matched in memory.
+ */
+@property (nonatomic, copy, readonly) NSString *unindexedCondition;
+@property (nonatomic, copy, readonly) NSArray *unindexedConditionArguments;
+
+/**
+ An `ORDER BY` clause over `columns`, or an empty string.
+ */
+@property (nonatomic, copy, readonly) NSString *orderClause;
+
+/**
+ A query that returns a row if a stored value of a sort key may sort differently in SQLite than in memory,
+ and its arguments. nil if there are no compiled sort keys.
+ */
+@property (nonatomic, copy, readonly) NSString *orderCheck;
+@property (nonatomic, copy, readonly) NSArray *orderCheckArguments;
+
+@end
+
+/**
+ `PFOfflineQueryIndex` maintains a table with one row per top-level scalar value of every object in the
+ offline store (one row per element for arrays of scalars), indexed by class name, key and value,
+ and compiles equality, comparison, `$in` and `objectId` constraints and sort keys into SQL over it.
+ */
+@interface PFOfflineQueryIndex : NSObject
+
+/**
+ Statements that create the index table, its indexes, and the trigger that clears the rows of deleted objects.
+ */
++ (NSArray<NSString *> *)schemaStatements;
+
+/**
+ Builds the index for the objects that are already in the store, if it wasn't built yet.
+ */
++ (BFTask<PFVoid> *)buildIndexIfNeededAsyncInDatabase:(PFSQLiteDatabase *)database;
+
+/**
+ Replaces the indexed values of an object with the ones in the given REST dictionary.
+ */
++ (BFTask<PFVoid> *)updateIndexAsyncForObjectWithUUID:(NSString *)uuid
+                                            className:(NSString *)className
+                                       RESTDictionary:(NSDictionary *)dictionary
+                                             database:(PFSQLiteDatabase *)database;
+
+/**
+ Compiles the supported subset of the given query.
+ */
++ (PFOfflineQuerySQLFilter *)filterForQueryState:(PFQueryState *)queryState;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,391 @@
+/**
+ * Copyright (c) 2015-present, Parse, LLC.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#import "PFOfflineQueryIndex.h"
+
+#import <Bolts/BFTask.h>
+
+#import "PFDateFormatter.h"
+#import "PFJSONSerialization.h"
+#import "PFObjectConstants.h"
+#import "PFQueryConstants.h"
+#import "PFQueryState.h"
+#import "PFSQLiteDatabase.h"
+#import "PFSQLiteDatabaseResult.h"
+
+static NSString *const PFOfflineQueryIndexTableOfFields = @"ParseObjectFields";
+static NSString *const PFOfflineQueryIndexKeyOfUUID = @"uuid";
+static NSString *const PFOfflineQueryIndexKeyOfClassName = @"className";
+static NSString *const PFOfflineQueryIndexKeyOfKey = @"key";
+static NSString *const PFOfflineQueryIndexKeyOfValue = @"value";
+
+static NSString *const PFOfflineQueryIndexTableOfObjects = @"ParseObjects";
+static NSString *const PFOfflineQueryIndexKeyOfObjectId = @"objectId";
+static NSString *const PFOfflineQueryIndexKeyOfJSON = @"json";
+
+/**
+ The key of the single row stored for an object whose JSON doesn't describe its values,
+ i.e. one that has unsaved operations.
+ */
+static NSString *const PFOfflineQueryIndexKeyOfUnindexedObject = @"*";
+
+/**
+ Stored in `PRAGMA user_version` once the index was built for the objects that were already stored.
+ Bump it when the indexed values change.
+ */
+static int const PFOfflineQueryIndexVersion = 1;
+
+/**
+ Matches the strings `PFDateFormatter` makes of dates, which sort in SQLite the way the dates do.
+ */
+static NSString *const PFOfflineQueryIndexDatePattern = @"[0-9][0-9][0-9][0-9]-[0-9][0-9]-[0-9][0-9]T[0-9][0-9]:[0-9][0-9]:[0-9][0-9].[0-9][0-9][0-9]Z";
+
+///--------------------------------------
+#pragma mark - PFOfflineQuerySQLFilter
+///--------------------------------------
+
+@interface PFOfflineQuerySQLFilter ()
+
+@property (nonatomic, assign, readwrite, getter=isEmpty) BOOL empty;
+@property (nonatomic, assign, readwrite, getter=isOrdered) BOOL ordered;
+@property (nonatomic, copy, readwrite) NSString *columns;
+@property (nonatomic, copy, readwrite) NSArray *columnArguments;
+@property (nonatomic, copy, readwrite) NSString *conditions;
+@property (nonatomic, copy, readwrite) NSArray *conditionArguments;
+@property (nonatomic, copy, readwrite) NSString *unindexedCondition;
+@property (nonatomic, copy, readwrite) NSArray *unindexedConditionArguments;
+@property (nonatomic, copy, readwrite) NSString *orderClause;
+@property (nonatomic, copy, readwrite) NSString *orderCheck;
+@property (nonatomic, copy, readwrite) NSArray *orderCheckArguments;
+
+@end
+
+@implementation PFOfflineQuerySQLFilter
+@end
+
+///--------------------------------------
+#pragma mark - PFOfflineQueryIndex
+///--------------------------------------
+
+@implementation PFOfflineQueryIndex
+
+///--------------------------------------
+#pragma mark - Schema
+///--------------------------------------
+
++ (NSArray<NSString *> *)schemaStatements {
+    // `value` has no declared type, so values keep the type they were bound with.
+    return @[ [NSString stringWithFormat:@"CREATE TABLE IF NOT EXISTS %@ ("
+               @"%@ TEXT NOT NULL, "
+               @"%@ TEXT NOT NULL, "
+               @"%@ TEXT NOT NULL, "
+               @"%@);",
+               PFOfflineQueryIndexTableOfFields,
+               PFOfflineQueryIndexKeyOfUUID,
+               PFOfflineQueryIndexKeyOfClassName,
+               PFOfflineQueryIndexKeyOfKey,
+               PFOfflineQueryIndexKeyOfValue],
+              [NSString stringWithFormat:@"CREATE INDEX IF NOT EXISTS %@_%@_%@_%@ ON %@(%@, %@, %@);",
+               PFOfflineQueryIndexTableOfFields,
+               PFOfflineQueryIndexKeyOfClassName, PFOfflineQueryIndexKeyOfKey, PFOfflineQueryIndexKeyOfValue,
+               PFOfflineQueryIndexTableOfFields,
+               PFOfflineQueryIndexKeyOfClassName, PFOfflineQueryIndexKeyOfKey, PFOfflineQueryIndexKeyOfValue],
+              [NSString stringWithFormat:@"CREATE INDEX IF NOT EXISTS %@_%@_%@ ON %@(%@, %@);",
+               PFOfflineQueryIndexTableOfFields,
+               PFOfflineQueryIndexKeyOfUUID, PFOfflineQueryIndexKeyOfKey,
+               PFOfflineQueryIndexTableOfFields,
+               PFOfflineQueryIndexKeyOfUUID, PFOfflineQueryIndexKeyOfKey],
+              [NSString stringWithFormat:@"CREATE TRIGGER IF NOT EXISTS %@_delete AFTER DELETE ON %@ "
+               @"BEGIN DELETE FROM %@ WHERE %@ = OLD.%@; END;",
+               PFOfflineQueryIndexTableOfFields, PFOfflineQueryIndexTableOfObjects,
+               PFOfflineQueryIndexTableOfFields, PFOfflineQueryIndexKeyOfUUID, PFOfflineQueryIndexKeyOfUUID] ];
+}
+
+///--------------------------------------
+#pragma mark - Index
+///--------------------------------------
+
++ (BFTask<PFVoid> *)buildIndexIfNeededAsyncInDatabase:(PFSQLiteDatabase *)database {
+    return [[database executeQueryAsync:@"PRAGMA user_version;" withArgumentsInArray:nil block:^id(PFSQLiteDatabaseResult *result) {
+        return @([result next] ? [result intForColumnIndex:0] : 0);
+    }] continueWithSuccessBlock:^id(BFTask<NSNumber *> *task) {
+        if (task.result.intValue >= PFOfflineQueryIndexVersion) {
+            return nil;
+        }
+
+        NSString *deleteSQL = [NSString stringWithFormat:@"DELETE FROM %@;", PFOfflineQueryIndexTableOfFields];
+        NSString *query = [NSString stringWithFormat:@"SELECT %@, %@, %@ FROM %@ WHERE %@ IS NOT NULL;",
+                           PFOfflineQueryIndexKeyOfUUID, PFOfflineQueryIndexKeyOfClassName, PFOfflineQueryIndexKeyOfJSON,
+                           PFOfflineQueryIndexTableOfObjects, PFOfflineQueryIndexKeyOfJSON];
+        return [[[[database executeSQLAsync:deleteSQL withArgumentsInArray:nil] continueWithSuccessBlock:^id(BFTask *_) {
+            return [database executeQueryAsync:query withArgumentsInArray:nil block:^id(PFSQLiteDatabaseResult *result) {
+                NSMutableArray<NSArray *> *rows = [NSMutableArray array];
+                while ([result next]) {
+                    NSString *uuid = [result stringForColumnIndex:0];
+                    NSString *className = [result stringForColumnIndex:1];
+                    NSDictionary *dictionary = [PFJSONSerialization JSONObjectFromString:[result stringForColumnIndex:2]];
+                    if ([dictionary isKindOfClass:[NSDictionary class]]) {
+                        [rows addObjectsFromArray:[self _rowsForObjectWithUUID:uuid
+                                                                     className:className
+                                                                RESTDictionary:dictionary]];
+                    }
+                }
+                return rows;
+            }];
+        }] continueWithSuccessBlock:^id(BFTask<NSArray<NSArray *> *> *task) {
+            return [self _insertRowsAsync:task.result database:database];
+        }] continueWithSuccessBlock:^id(BFTask *_) {
+            NSString *sql = [NSString stringWithFormat:@"PRAGMA user_version = %d;", PFOfflineQueryIndexVersion];
+            return [database executeSQLAsync:sql withArgumentsInArray:nil];
+        }];
+    }];
+}
+
++ (BFTask<PFVoid> *)updateIndexAsyncForObjectWithUUID:(NSString *)uuid
+                                            className:(NSString *)className
+                                       RESTDictionary:(NSDictionary *)dictionary
+                                             database:(PFSQLiteDatabase *)database {
+    NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ = ?;",
+                     PFOfflineQueryIndexTableOfFields, PFOfflineQueryIndexKeyOfUUID];
+    return [[database executeSQLAsync:sql withArgumentsInArray:@[ uuid ]] continueWithSuccessBlock:^id(BFTask *_) {
+        NSArray<NSArray *> *rows = [self _rowsForObjectWithUUID:uuid className:className RESTDictionary:dictionary];
+        return [self _insertRowsAsync:rows database:database];
+    }];
+}
+
++ (BFTask<PFVoid> *)_insertRowsAsync:(NSArray<NSArray *> *)rows database:(PFSQLiteDatabase *)database {
+    if (rows.count == 0) {
+        return [BFTask taskWithResult:nil];
+    }
+    NSString *sql = [NSString stringWithFormat:@"INSERT INTO %@(%@, %@, %@, %@) VALUES %%@;",
+                     PFOfflineQueryIndexTableOfFields,
+                     PFOfflineQueryIndexKeyOfUUID, PFOfflineQueryIndexKeyOfClassName,
+                     PFOfflineQueryIndexKeyOfKey, PFOfflineQueryIndexKeyOfValue];
+    return [database executeSQLAsync:sql withArgumentRows:rows];
+}
+
+/**
+ @return Rows of (uuid, className, key, value) for every indexable value of the object.
+ */
++ (NSArray<NSArray *> *)_rowsForObjectWithUUID:(NSString *)uuid
+                                     className:(NSString *)className
+                                RESTDictionary:(NSDictionary *)dictionary {
+    // Values with unsaved operations only exist once the operations are applied in memory.
+    for (NSDictionary *operationSet in dictionary[PFObjectOperationsRESTKey]) {
+        for (NSString *key in operationSet) {
+            if (![key hasPrefix:@"__"]) {
+                return @[ @[ uuid, className, PFOfflineQueryIndexKeyOfUnindexedObject, [NSNull null] ] ];
+            }
+        }
+    }
+
+    NSMutableArray<NSArray *> *rows = [NSMutableArray array];
+    [dictionary enumerateKeysAndObjectsUsingBlock:^(NSString *key, id obj, BOOL *stop) {
+        if (![self _isIndexableKey:key] ||
+            [key isEqualToString:PFObjectClassNameRESTKey] ||
+            [key isEqualToString:PFObjectIsDeletingEventuallyRESTKey]) {
+            return;
+        }
+        // Equality on arrays means containment, so every element gets a row.
+        NSArray *values = [obj isKindOfClass:[NSArray class]] ? obj : @[ obj ];
+        for (id value in values) {
+            id indexValue = [self _indexValueForRESTValue:value];
+            if (indexValue) {
+                [rows addObject:@[ uuid, className, key, indexValue ]];
+            }
+        }
+    }];
+    return rows;
+}
+
++ (BOOL)_isIndexableKey:(NSString *)key {
+    return [key rangeOfString:@"^[A-Za-z][A-Za-z0-9_]*$" options:NSRegularExpressionSearch].location != NSNotFound;
+}
+
++ (id)_indexValueForRESTValue:(id)value {
+    if ([value isKindOfClass:[NSString class]] || [value isKindOfClass:[NSNumber class]]) {
+        return value;
+    }
+    if ([value isKindOfClass:[NSDictionary class]] && [value[@"__type"] isEqual:@"Date"]) {
+        id iso = value[@"iso"];
+        return [iso isKindOfClass:[NSString class]] ? iso : nil;
+    }
+    return nil;
+}
+
+/**
+ @return The indexed representation of a constraint, or nil if constraints of its type aren't compiled.
+ */
++ (id)_indexValueForConstraint:(id)constraint {
+    if ([constraint isKindOfClass:[NSString class]] || [constraint isKindOfClass:[NSNumber class]]) {
+        return constraint;
+    }
+    if ([constraint isKindOfClass:[NSDate class]]) {
+        // Dates are matched by their precise string, the same way `PFOfflineQueryLogic` compares them.
+        return [[PFDateFormatter sharedFormatter] preciseStringFromDate:constraint];
+    }
+    return nil;
+}
+
+///--------------------------------------
+#pragma mark - Query
+///--------------------------------------
+
++ (PFOfflineQuerySQLFilter *)filterForQueryState:(PFQueryState *)queryState {
+    NSString *className = queryState.parseClassName;
+    NSMutableString *conditions = [NSMutableString string];
+    NSMutableArray *conditionArguments = [NSMutableArray array];
+
+    // Anything that can't be compiled is left to the in-memory matcher.
+    [queryState.conditions enumerateKeysAndObjectsUsingBlock:^(NSString *key, id constraints, BOOL *stop) {
+        if (![self _isIndexableKey:key]) {
+            return;
+        }
+
+        NSDictionary *keyConstraints = constraints;
+        if (![constraints isKindOfClass:[NSDictionary class]]) {
+            keyConstraints = @{ @"$eq" : constraints };
+        }
+        [keyConstraints enumerateKeysAndObjectsUsingBlock:^(NSString *operator, id constraint, BOOL *stop) {
+            NSArray *values = nil;
+            NSString *comparison = nil;
+            if ([operator isEqualToString:@"$eq"]) {
+                id value = [self _indexValueForConstraint:constraint];
+                values = value ? @[ value ] : nil;
+                comparison = @"= ?";
+            } else if ([operator isEqualToString:PFQueryKeyContainedIn] && [constraint isKindOfClass:[NSArray class]]) {
+                NSMutableArray *mutableValues = [NSMutableArray arrayWithCapacity:[constraint count]];
+                for (id item in constraint) {
+                    id value = [self _indexValueForConstraint:item];
+                    if (!value) {
+                        return;
+                    }
+                    [mutableValues addObject:value];
+                }
+                NSMutableArray<NSString *> *placeholders = [NSMutableArray arrayWithCapacity:mutableValues.count];
+                for (NSUInteger i = 0; i < mutableValues.count; i++) {
+                    [placeholders addObject:@"?"];
+                }
+                values = mutableValues;
+                comparison = [NSString stringWithFormat:@"IN (%@)", [placeholders componentsJoinedByString:@", "]];
+            } else if (![constraint isKindOfClass:[NSString class]]) {
+                // Strings are only compared for equality, `-compare:` and SQLite's collation may disagree on order.
+                id value = [self _indexValueForConstraint:constraint];
+                values = value ? @[ value ] : nil;
+                if ([operator isEqualToString:PFQueryKeyLessThan]) {
+                    comparison = @"< ?";
+                } else if ([operator isEqualToString:PFQueryKeyLessThanEqualTo]) {
+                    comparison = @"<= ?";
+                } else if ([operator isEqualToString:PFQueryKeyGreaterThan]) {
+                    comparison = @"> ?";
+                } else if ([operator isEqualToString:PFQueryKeyGreaterThanOrEqualTo]) {
+                    comparison = @">= ?";
+                }
+            }
+            if (values.count == 0 || comparison == nil) {
+                return;
+            }
+
+            if ([key isEqualToString:PFOfflineQueryIndexKeyOfObjectId]) {
+                // Covered by the UNIQUE(className, objectId) index of `ParseObjects`.
+                [conditions appendFormat:@" AND A.%@ %@", PFOfflineQueryIndexKeyOfObjectId, comparison];
+            } else {
+                [conditions appendFormat:@" AND A.%@ IN (SELECT %@ FROM %@ WHERE %@ = ? AND %@ = ? AND %@ %@)",
+                 PFOfflineQueryIndexKeyOfUUID,
+                 PFOfflineQueryIndexKeyOfUUID, PFOfflineQueryIndexTableOfFields,
+                 PFOfflineQueryIndexKeyOfClassName, PFOfflineQueryIndexKeyOfKey, PFOfflineQueryIndexKeyOfValue,
+                 comparison];
+                [conditionArguments addObject:className];
+                [conditionArguments addObject:key];
+            }
+            [conditionArguments addObjectsFromArray:values];
+        }];
+    }];
+
+    NSMutableString *columns = [NSMutableString string];
+    NSMutableArray *columnArguments = [NSMutableArray array];
+    NSMutableArray<NSString *> *orderTerms = [NSMutableArray array];
+    NSMutableArray<NSString *> *orderKeys = [NSMutableArray array];
+    BOOL ordered = YES;
+    for (NSString *sortKey in queryState.sortKeys) {
+        BOOL descending = [sortKey hasPrefix:@"-"];
+        NSString *key = descending ? [sortKey substringFromIndex:1] : sortKey;
+        if ([key isEqualToString:@"_created_at"]) {
+            key = PFObjectCreatedAtRESTKey;
+        } else if ([key isEqualToString:@"_updated_at"]) {
+            key = PFObjectUpdatedAtRESTKey;
+        }
+        if (![self _isIndexableKey:key]) {
+            ordered = NO;
+            break;
+        }
+
+        // `PFOfflineQueryLogic` sorts missing values last, and first when descending.
+        NSString *column = [NSString stringWithFormat:@"s%lu", (unsigned long)orderTerms.count / 2];
+        [columns appendFormat:@", (SELECT %@ FROM %@ WHERE %@ = A.%@ AND %@ = ?) AS %@",
+         PFOfflineQueryIndexKeyOfValue, PFOfflineQueryIndexTableOfFields,
+         PFOfflineQueryIndexKeyOfUUID, PFOfflineQueryIndexKeyOfUUID, PFOfflineQueryIndexKeyOfKey, column];
+        [columnArguments addObject:key];
+        [orderKeys addObject:key];
+        [orderTerms addObject:[NSString stringWithFormat:@"%@ IS NULL%@", column, descending ? @" DESC" : @""]];
+        [orderTerms addObject:[NSString stringWithFormat:@"%@%@", column, descending ? @" DESC" : @""]];
+    }
+    // $nearSphere sorts by distance.
+    for (id constraints in queryState.conditions.allValues) {
+        if ([constraints isKindOfClass:[NSDictionary class]] && constraints[PFQueryKeyNearSphere]) {
+            ordered = NO;
+        }
+    }
+    if (!ordered) {
+        [columns setString:@""];
+        [columnArguments removeAllObjects];
+        [orderTerms removeAllObjects];
+        [orderKeys removeAllObjects];
+    }
+
+    PFOfflineQuerySQLFilter *filter = [[PFOfflineQuerySQLFilter alloc] init];
+    filter.empty = (conditions.length == 0 && orderTerms.count == 0);
+    filter.ordered = ordered;
+    filter.columns = columns;
+    filter.columnArguments = columnArguments;
+
+    NSString *unindexedObjects = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@ = ? AND %@ = ?",
+                                  PFOfflineQueryIndexKeyOfUUID, PFOfflineQueryIndexTableOfFields,
+                                  PFOfflineQueryIndexKeyOfClassName, PFOfflineQueryIndexKeyOfKey];
+    NSArray *unindexedArguments = @[ className, PFOfflineQueryIndexKeyOfUnindexedObject ];
+    filter.conditions = [NSString stringWithFormat:@" AND A.%@ NOT IN (%@)%@",
+                         PFOfflineQueryIndexKeyOfUUID, unindexedObjects, conditions];
+    filter.conditionArguments = [unindexedArguments arrayByAddingObjectsFromArray:conditionArguments];
+    filter.unindexedCondition = [NSString stringWithFormat:@"A.%@ IN (%@)", PFOfflineQueryIndexKeyOfUUID, unindexedObjects];
+    filter.unindexedConditionArguments = unindexedArguments;
+    filter.orderClause = (orderTerms.count > 0 ?
+                          [NSString stringWithFormat:@" ORDER BY %@", [orderTerms componentsJoinedByString:@", "]] :
+                          @"");
+
+    // SQLite only sorts the way `PFOfflineQueryLogic` does when every value of a sort key is a number,
+    // or every value is a date, and no object has several values (an array).
+    if (orderKeys.count > 0) {
+        NSMutableArray<NSString *> *placeholders = [NSMutableArray arrayWithCapacity:orderKeys.count];
+        for (NSUInteger i = 0; i < orderKeys.count; i++) {
+            [placeholders addObject:@"?"];
+        }
+        filter.orderCheck = [NSString stringWithFormat:
+                             @"SELECT 1 FROM %1$@ WHERE %2$@ = ? AND %3$@ IN (%4$@) GROUP BY %3$@ HAVING "
+                             @"SUM(NOT (typeof(%5$@) IN ('integer', 'real') OR (typeof(%5$@) = 'text' AND %5$@ GLOB '%6$@'))) > 0 "
+                             @"OR (SUM(typeof(%5$@) = 'text') > 0 AND SUM(typeof(%5$@) != 'text') > 0) "
+                             @"OR COUNT(*) > COUNT(DISTINCT %7$@) LIMIT 1;",
+                             PFOfflineQueryIndexTableOfFields, PFOfflineQueryIndexKeyOfClassName, PFOfflineQueryIndexKeyOfKey,
+                             [placeholders componentsJoinedByString:@","], PFOfflineQueryIndexKeyOfValue,
+                             PFOfflineQueryIndexDatePattern, PFOfflineQueryIndexKeyOfUUID];
+        filter.orderCheckArguments = [@[ className ] arrayByAddingObjectsFromArray:orderKeys];
+    }
+    return filter;
+}
+
+@end
@@ -20,6 +20,7 @@
 #import "PFFileManager.h"
 #import "PFJSONSerialization.h"
 #import "PFObjectPrivate.h"
+#import "PFOfflineQueryIndex.h"
 #import "PFOfflineQueryLogic.h"
 #import "PFPin.h"
 #import "PFQueryPrivate.h"
@@ -44,8 +45,6 @@ static NSString *const PFOfflineStoreKeyOfUUID = @"uuid";
 static NSString *const PFOfflineStoreTableOfDependencies = @"Dependencies";
 static NSString *const PFOfflineStoreKeyOfKey = @"key";
 
-static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
-
 @interface PFOfflineStore ()
 
 @property (nonatomic, assign, readwrite) PFOfflineStoreOptions options;
@@ -352,20 +351,35 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
     }] continueWithSuccessBlock:^id(BFTask *task) {
         return [self getOrCreateUUIDAsyncForObject:object database:database];
     }] continueWithSuccessBlock:^id(BFTask *task) {
-        NSString *uuid = task.result;
+        NSString *key = task.result;
 
-        NSMutableArray<BFTask<PFVoid> *>*tasks = [NSMutableArray array];
+        NSMutableArray<BFTask<NSString *> *> *tasks = [NSMutableArray array];
         for (PFObject *object in objectsInTree) {
-            [tasks addObject:[self saveObjectLocallyAsync:object key:uuid database:database]];
+            [tasks addObject:[self _saveObjectDataLocallyAsync:object database:database]];
         }
 
-        return [BFTask taskForCompletionOfAllTasks:tasks];
+        // Link all saved objects to the key with a single reused statement.
+        return [[BFTask taskForCompletionOfAllTasks:tasks] continueWithSuccessBlock:^id(BFTask *_) {
+            NSMutableArray<NSArray *> *dependencies = [NSMutableArray arrayWithCapacity:tasks.count];
+            for (BFTask<NSString *> *task in tasks) {
+                if (task.result) {
+                    [dependencies addObject:@[ key, task.result ]];
+                }
+            }
+            NSString *sql = [NSString stringWithFormat:@"INSERT OR IGNORE INTO %@(%@, %@) VALUES (?, ?)",
+                             PFOfflineStoreTableOfDependencies, PFOfflineStoreKeyOfKey,
+                             PFOfflineStoreKeyOfUUID];
+            return [database executeSQLAsync:sql withArgumentsInArrays:dependencies];
+        }];
     }];
 }
 
-- (BFTask<PFVoid> *)saveObjectLocallyAsync:(PFObject *)object
-                                       key:(NSString *)key
-                                  database:(PFSQLiteDatabase *)database {
+/**
+ Writes the object into its row, without linking it to any key.
+
+ @return `BFTask` that resolves to the UUID of the object, or `nil` if there was nothing to save.
+ */
+- (BFTask<NSString *> *)_saveObjectDataLocallyAsync:(PFObject *)object database:(PFSQLiteDatabase *)database {
     if (object.objectId != nil && !object.dataAvailable &&
         ![object _hasChanges] && ![object _hasOutstandingOperations]) {
         return [BFTask taskWithResult:nil];
@@ -409,12 +423,14 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
         NSString *sql = [NSString stringWithFormat:@"UPDATE %@ SET %@ WHERE %@ = ?",
                          PFOfflineStoreTableOfObjects, updateFields,
                          PFOfflineStoreKeyOfUUID];
-        return [database executeSQLAsync:sql withArgumentsInArray:queryParams];
+        return [[database executeSQLAsync:sql withArgumentsInArray:queryParams] continueWithSuccessBlock:^id(BFTask *task) {
+            return [PFOfflineQueryIndex updateIndexAsyncForObjectWithUUID:uuid
+                                                                className:className
+                                                           RESTDictionary:encoded
+                                                                 database:database];
+        }];
     }] continueWithSuccessBlock:^id(BFTask *task) {
-        NSString *sql = [NSString stringWithFormat:@"INSERT OR IGNORE INTO %@(%@, %@) VALUES (?, ?)",
-                         PFOfflineStoreTableOfDependencies, PFOfflineStoreKeyOfKey,
-                         PFOfflineStoreKeyOfUUID];
-        return [database executeSQLAsync:sql withArgumentsInArray:@[key, uuid]];
+        return uuid;
     }];
 }
 
@@ -467,8 +483,9 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
     BFTask *queryTask = nil;
     BOOL includeIsDeletingEventually = queryState.shouldIncludeDeletingEventually;
 
+    // The FROM and WHERE clauses that select every object of the class (in the pin).
     __block NSString *queryString = nil;
-    __block NSArray<NSString *> *queryArguments = nil;
+    __block NSArray *queryArguments = nil;
 
     if (!pin) {
         NSString *isDeletingEventuallyQuery = @"";
@@ -476,8 +493,7 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
             isDeletingEventuallyQuery = [NSString stringWithFormat:@"AND %@ = 0",
                                          PFOfflineStoreKeyOfIsDeletingEventually];
         }
-        queryString = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@ = ? %@;",
-                       PFOfflineStoreKeyOfUUID,
+        queryString = [NSString stringWithFormat:@"FROM %@ A WHERE %@ = ? %@",
                        PFOfflineStoreTableOfObjects,
                        PFOfflineStoreKeyOfClassName,
                        isDeletingEventuallyQuery];
@@ -496,9 +512,9 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
                 isDeletingEventuallyQuery = [NSString stringWithFormat:@"AND %@ = 0",
                                              PFOfflineStoreKeyOfIsDeletingEventually];
             }
-            queryString = [NSString stringWithFormat:@"SELECT A.%@ FROM %@ A "
-                           @"INNER JOIN %@ B ON A.%@ = B.%@ WHERE %@ = ? AND %@ = ? %@;",
-                           PFOfflineStoreKeyOfUUID, PFOfflineStoreTableOfObjects,
+            queryString = [NSString stringWithFormat:@"FROM %@ A "
+                           @"INNER JOIN %@ B ON A.%@ = B.%@ WHERE %@ = ? AND %@ = ? %@",
+                           PFOfflineStoreTableOfObjects,
                            PFOfflineStoreTableOfDependencies, PFOfflineStoreKeyOfUUID,
                            PFOfflineStoreKeyOfUUID, PFOfflineStoreKeyOfClassName,
                            PFOfflineStoreKeyOfKey, isDeletingEventuallyQuery];
@@ -508,46 +524,105 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
         }];
     }
 
-    @weakify(self);
-    return [[queryTask continueWithSuccessBlock:^id(BFTask *task) {
-        return [[database executeQueryAsync:queryString withArgumentsInArray:queryArguments block:^id(PFSQLiteDatabaseResult *result) {
-            NSMutableArray<NSString *> *uuids = [NSMutableArray array];
-            while ([result next]) {
-                NSString *uuid = [result stringForColumnIndex:0];
-                [uuids addObject:uuid];
+    // Push the constraints and sort keys the index understands down to SQLite, so that only candidates get decoded
+    // and matched. Objects the index can't describe, and objects with changes that are only in memory, are always
+    // matched, separately.
+    PFOfflineQuerySQLFilter *filter = [PFOfflineQueryIndex filterForQueryState:queryState];
+    NSArray<NSString *> *unsavedUUIDs = @[];
+    if (!filter.empty) {
+        unsavedUUIDs = [self _UUIDsOfObjectsWithUnsavedChangesForClassName:queryState.parseClassName];
+        // Rather match every object than go over the number of variables SQLite allows in a statement.
+        if (unsavedUUIDs.count + 4 > PFSQLiteDatabaseMaximumVariablesCount ||
+            filter.columnArguments.count + filter.conditionArguments.count + 2 > PFSQLiteDatabaseMaximumVariablesCount) {
+            filter = nil;
+        }
+    }
+    BOOL usesIndex = (filter != nil && !filter.empty);
+
+    // When candidates come in the query's order, matching can stop once the requested page is complete.
+    // That needs the stored values of the sort keys to sort the same way in SQLite, which is checked first.
+    __block NSUInteger maximumCandidateResultCount = NSUIntegerMax;
+    BOOL cutsOffCandidates = (filter.ordered && !isCount && queryState.limit >= 0);
+    if (cutsOffCandidates && filter.orderCheck) {
+        queryTask = [[queryTask continueWithSuccessBlock:^id(BFTask *task) {
+            return [database executeQueryAsync:filter.orderCheck
+                          withArgumentsInArray:filter.orderCheckArguments
+                                         block:^id(PFSQLiteDatabaseResult *result) {
+                                             return @(![result next]);
+                                         }];
+        }] continueWithSuccessBlock:^id(BFTask<NSNumber *> *task) {
+            if (task.result.boolValue) {
+                maximumCandidateResultCount = queryState.skip + queryState.limit;
             }
-            return uuids;
-        }] continueWithSuccessBlock:^id(BFTask<NSArray<NSString *> *> *task) {
-            @strongify(self);
-            PFConstraintMatcherBlock matcherBlock = [self.offlineQueryLogic createMatcherForQueryState:queryState user:user];
-
-            BFTask *checkAllTask = [BFTask taskWithResult:nil];
-            NSArray<NSArray<NSString *> *> *uuidBatches = [PFInternalUtils arrayBySplittingArray:task.result
-                                                                 withMaximumComponentsPerSegment:64];
-            for (NSArray <NSString *> *uuids in uuidBatches) {
-                checkAllTask = [[checkAllTask continueWithSuccessBlock:^id(BFTask *_) {
-                    return [self _getObjectPointersAsyncWithUUIDs:uuids fromDatabase:database];
-                }] continueWithSuccessBlock:^id(BFTask<NSArray<PFObject *> *> *task) {
-                    BFTask *checkBatchTask = [BFTask taskWithResult:nil];
-                    for (PFObject *object in task.result) {
-                        checkBatchTask = [[[checkBatchTask continueWithSuccessBlock:^id(BFTask *_) {
-                            return [self fetchObjectLocallyAsync:object database:database];
-                        }] continueWithSuccessBlock:^id(BFTask *_) {
-                            if (!object.dataAvailable) {
-                                return nil;
-                            }
-                            return matcherBlock(object, database);
-                        }] continueWithSuccessBlock:^id(BFTask *task) {
-                            if ([task.result boolValue]) {
-                                [mutableResults addObject:object];
-                            }
-                            return nil;
-                        }];
-                    }
-                    return checkBatchTask;
-                }];
+            return nil;
+        }];
+    } else if (cutsOffCandidates) {
+        maximumCandidateResultCount = queryState.skip + queryState.limit;
+    }
+
+    PFConstraintMatcherBlock matcherBlock = [self.offlineQueryLogic createMatcherForQueryState:queryState user:user];
+    __block NSSet<NSString *> *alwaysMatchedUUIDs = nil;
+
+    @weakify(self);
+    return [[[[queryTask continueWithSuccessBlock:^id(BFTask *task) {
+        @strongify(self);
+        if (!usesIndex) {
+            return @[];
+        }
+        NSMutableString *condition = [filter.unindexedCondition mutableCopy];
+        NSMutableArray *arguments = [queryArguments mutableCopy];
+        [arguments addObjectsFromArray:filter.unindexedConditionArguments];
+        if (unsavedUUIDs.count > 0) {
+            NSMutableArray<NSString *> *placeholders = [NSMutableArray arrayWithCapacity:unsavedUUIDs.count];
+            for (NSUInteger i = 0; i < unsavedUUIDs.count; i++) {
+                [placeholders addObject:@"?"];
             }
-            return checkAllTask;
+            [condition appendFormat:@" OR A.%@ IN (%@)",
+             PFOfflineStoreKeyOfUUID, [placeholders componentsJoinedByString:@","]];
+            [arguments addObjectsFromArray:unsavedUUIDs];
+        }
+        NSString *query = [NSString stringWithFormat:@"SELECT A.%@ %@ AND (%@);",
+                           PFOfflineStoreKeyOfUUID, queryString, condition];
+        return [self _UUIDsAsyncForQuery:query arguments:arguments database:database];
+    }] continueWithSuccessBlock:^id(BFTask<NSArray<NSString *> *> *task) {
+        @strongify(self);
+        alwaysMatchedUUIDs = [NSSet setWithArray:task.result];
+        return [self _matchObjectsAsyncWithUUIDs:task.result
+                                    matcherBlock:matcherBlock
+                                         results:mutableResults
+                              maximumResultCount:NSUIntegerMax
+                                        database:database];
+    }] continueWithSuccessBlock:^id(BFTask *task) {
+        @strongify(self);
+        NSString *query = nil;
+        NSMutableArray *arguments = [NSMutableArray array];
+        if (usesIndex) {
+            query = [NSString stringWithFormat:@"SELECT A.%@%@ %@%@%@;",
+                     PFOfflineStoreKeyOfUUID, filter.columns, queryString, filter.conditions, filter.orderClause];
+            [arguments addObjectsFromArray:filter.columnArguments];
+            [arguments addObjectsFromArray:queryArguments];
+            [arguments addObjectsFromArray:filter.conditionArguments];
+        } else {
+            query = [NSString stringWithFormat:@"SELECT A.%@ %@;", PFOfflineStoreKeyOfUUID, queryString];
+            [arguments addObjectsFromArray:queryArguments];
+        }
+
+        NSMutableArray<PFObject *> *candidateResults = [NSMutableArray array];
+        return [[[self _UUIDsAsyncForQuery:query
+                                 arguments:arguments
+                                  database:database] continueWithSuccessBlock:^id(BFTask<NSArray<NSString *> *> *task) {
+            NSMutableArray<NSString *> *uuids = [task.result mutableCopy];
+            [uuids filterUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(NSString *uuid, NSDictionary *bindings) {
+                return ![alwaysMatchedUUIDs containsObject:uuid];
+            }]];
+            return [self _matchObjectsAsyncWithUUIDs:uuids
+                                        matcherBlock:matcherBlock
+                                             results:candidateResults
+                                  maximumResultCount:maximumCandidateResultCount
+                                            database:database];
+        }] continueWithSuccessBlock:^id(BFTask *task) {
+            [mutableResults addObjectsFromArray:candidateResults];
+            return nil;
         }];
     }] continueWithSuccessBlock:^id(BFTask *_) {
         @strongify(self);
@@ -573,6 +648,80 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
     }];
 }
 
+- (BFTask<NSArray<NSString *> *> *)_UUIDsAsyncForQuery:(NSString *)query
+                                             arguments:(NSArray *)arguments
+                                              database:(PFSQLiteDatabase *)database {
+    return [database executeQueryAsync:query withArgumentsInArray:arguments block:^id(PFSQLiteDatabaseResult *result) {
+        NSMutableArray<NSString *> *uuids = [NSMutableArray array];
+        while ([result next]) {
+            NSString *uuid = [result stringForColumnIndex:0];
+            [uuids addObject:uuid];
+        }
+        return uuids;
+    }];
+}
+
+/**
+ Fetches the objects with the given UUIDs in order and adds the ones that match to `results`,
+ until `results` holds `maximumResultCount` objects.
+ */
+- (BFTask<PFVoid> *)_matchObjectsAsyncWithUUIDs:(NSArray<NSString *> *)uuids
+                                   matcherBlock:(PFConstraintMatcherBlock)matcherBlock
+                                        results:(NSMutableArray<PFObject *> *)results
+                             maximumResultCount:(NSUInteger)maximumResultCount
+                                       database:(PFSQLiteDatabase *)database {
+    BFTask *checkAllTask = [BFTask taskWithResult:nil];
+    NSArray<NSArray<NSString *> *> *uuidBatches = [PFInternalUtils arrayBySplittingArray:uuids
+                                                         withMaximumComponentsPerSegment:64];
+    for (NSArray <NSString *> *uuids in uuidBatches) {
+        checkAllTask = [[checkAllTask continueWithSuccessBlock:^id(BFTask *_) {
+            if (results.count >= maximumResultCount) {
+                return @[];
+            }
+            return [self _getObjectPointersAsyncWithUUIDs:uuids fromDatabase:database];
+        }] continueWithSuccessBlock:^id(BFTask<NSArray<PFObject *> *> *task) {
+            BFTask *checkBatchTask = [BFTask taskWithResult:nil];
+            for (PFObject *object in task.result) {
+                checkBatchTask = [[[checkBatchTask continueWithSuccessBlock:^id(BFTask *_) {
+                    if (results.count >= maximumResultCount) {
+                        return nil;
+                    }
+                    return [self fetchObjectLocallyAsync:object database:database];
+                }] continueWithSuccessBlock:^id(BFTask *_) {
+                    if (results.count >= maximumResultCount || !object.dataAvailable) {
+                        return nil;
+                    }
+                    return matcherBlock(object, database);
+                }] continueWithSuccessBlock:^id(BFTask *task) {
+                    if ([task.result boolValue]) {
+                        [results addObject:object];
+                    }
+                    return nil;
+                }];
+            }
+            return checkBatchTask;
+        }];
+    }
+    return checkAllTask;
+}
+
+/**
+ @return The UUIDs of the objects of the given class that are in memory and have changes that aren't stored yet.
+ */
+- (NSArray<NSString *> *)_UUIDsOfObjectsWithUnsavedChangesForClassName:(NSString *)className {
+    NSMutableArray<NSString *> *uuids = [NSMutableArray array];
+    @synchronized(self.lock) {
+        for (NSString *uuid in self.UUIDToObjectMap) {
+            PFObject *object = [self.UUIDToObjectMap objectForKey:uuid];
+            if ([object.parseClassName isEqualToString:className] &&
+                ([object _hasChanges] || [object _hasOutstandingOperations])) {
+                [uuids addObject:uuid];
+            }
+        }
+    }
+    return uuids;
+}
+
 ///--------------------------------------
 #pragma mark - Update
 ///--------------------------------------
@@ -650,7 +799,12 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
         NSString *sql = [NSString stringWithFormat:@"UPDATE %@ SET %@ WHERE %@ = ?",
                          PFOfflineStoreTableOfObjects, updateParams, PFOfflineStoreKeyOfUUID];
 
-        return [database executeSQLAsync:sql withArgumentsInArray:updateArguments];
+        return [[database executeSQLAsync:sql withArgumentsInArray:updateArguments] continueWithSuccessBlock:^id(BFTask *task) {
+            return [PFOfflineQueryIndex updateIndexAsyncForObjectWithUUID:uuid
+                                                                className:className
+                                                           RESTDictionary:dataDictionary
+                                                                 database:database];
+        }];
     }];
 }
 
@@ -819,25 +973,13 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
         return [BFTask taskWithResult:nil];
     }
 
-    if (uuids.count > PFOfflineStoreMaximumSQLVariablesCount) {
-        NSRange range = NSMakeRange(0, PFOfflineStoreMaximumSQLVariablesCount);
-        return [[self _deleteObjectsWithUUIDs:[uuids subarrayWithRange:range]
-                                     database:database] continueWithSuccessBlock:^id(BFTask *task) {
-            unsigned long includedCount = uuids.count - PFOfflineStoreMaximumSQLVariablesCount;
-            NSRange range = NSMakeRange(PFOfflineStoreMaximumSQLVariablesCount, includedCount);
-            return [self _deleteObjectsWithUUIDs:[uuids subarrayWithRange:range] database:database];
-        }];
-    }
-
-    NSMutableArray<NSString *> *placeholders = [NSMutableArray array];
-    for (int i = 0; i < uuids.count; ++i) {
-        [placeholders addObject:@"?"];
+    NSMutableArray<NSArray *> *rows = [NSMutableArray arrayWithCapacity:uuids.count];
+    for (NSString *uuid in uuids) {
+        [rows addObject:@[ uuid ]];
     }
-    NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ IN (%@);",
-                     PFOfflineStoreTableOfObjects,
-                     PFOfflineStoreKeyOfUUID,
-                     [placeholders componentsJoinedByString:@","]];
-    return [database executeSQLAsync:sql withArgumentsInArray:uuids];
+    NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ IN (%%@);",
+                     PFOfflineStoreTableOfObjects, PFOfflineStoreKeyOfUUID];
+    return [database executeSQLAsync:sql withArgumentRows:rows];
 }
 
 ///--------------------------------------
@@ -939,15 +1081,18 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
             }
         }
     }
-    NSString *queryString = [NSString stringWithFormat:@"SELECT %@, %@, %@ FROM %@ WHERE %@ IN ('%@');",
+    NSMutableArray<NSArray *> *rows = [NSMutableArray arrayWithCapacity:missingUUIDs.count];
+    for (NSString *uuid in missingUUIDs) {
+        [rows addObject:@[ uuid ]];
+    }
+    NSString *queryString = [NSString stringWithFormat:@"SELECT %@, %@, %@ FROM %@ WHERE %@ IN (%%@);",
                              PFOfflineStoreKeyOfUUID,
                              PFOfflineStoreKeyOfObjectId,
                              PFOfflineStoreKeyOfClassName,
                              PFOfflineStoreTableOfObjects,
-                             PFOfflineStoreKeyOfUUID,
-                             [missingUUIDs componentsJoinedByString:@"','"]];
-    NSMutableArray<BFTask<PFObject *> *> *fetchPointersTasks = [NSMutableArray arrayWithCapacity:missingUUIDs.count];
-    return [[database executeQueryAsync:queryString withArgumentsInArray:nil block:^id(PFSQLiteDatabaseResult *result) {
+                             PFOfflineStoreKeyOfUUID];
+    return [[database executeQueryAsync:queryString withArgumentRows:rows block:^id(PFSQLiteDatabaseResult *result) {
+        NSMutableArray<BFTask<PFObject *> *> *fetchPointersTasks = [NSMutableArray array];
         while ([result next]) {
             NSString *uuid = [result stringForColumnIndex:0];
             NSString *objectId = [result stringForColumnIndex:1];
@@ -957,10 +1102,10 @@ static int const PFOfflineStoreMaximumSQLVariablesCount = 999;
             }];
             [fetchPointersTasks addObject:task];
         }
-        return [BFTask taskForCompletionOfAllTasks:fetchPointersTasks];
-    }] continueWithSuccessBlock:^id(BFTask *_) {
-        for (BFTask <PFObject *>*task in fetchPointersTasks) {
-            [objects addObject:task.result];
+        return [BFTask taskForCompletionOfAllTasksWithResults:fetchPointersTasks];
+    }] continueWithSuccessBlock:^id(BFTask<NSArray<NSArray<PFObject *> *> *> *task) {
+        for (NSArray<PFObject *> *chunkObjects in task.result) {
+            [objects addObjectsFromArray:chunkObjects];
         }
         return objects;
     }];
@@ -1085,10 +1230,20 @@ void PFOfflineStoreReplaceExisingObject() {}
 + (BFTask<PFVoid> *)_initializeTablesInBackgroundWithDatabaseController:(PFSQLiteDatabaseController *)databaseController {
     return [[databaseController openDatabaseWithNameAsync:PFOfflineStoreDatabaseName] continueWithBlock:^id(BFTask *task) {
         PFSQLiteDatabase *database = task.result;
-        return [[[[[database beginTransactionAsync] continueWithSuccessBlock:^id(BFTask *task) {
+        return [[[[[[database beginTransactionAsync] continueWithSuccessBlock:^id(BFTask *task) {
             return [database executeSQLAsync:[self PFOfflineStoreParseObjectsTableSchema] withArgumentsInArray:nil];
         }] continueWithSuccessBlock:^id(BFTask *task) {
             return [database executeSQLAsync:[self PFOfflineStoreDependenciesTableSchema] withArgumentsInArray:nil];
+        }] continueWithSuccessBlock:^id(BFTask *task) {
+            BFTask *indexTask = [BFTask taskWithResult:nil];
+            for (NSString *statement in [PFOfflineQueryIndex schemaStatements]) {
+                indexTask = [indexTask continueWithSuccessBlock:^id(BFTask *task) {
+                    return [database executeSQLAsync:statement withArgumentsInArray:nil];
+                }];
+            }
+            return [indexTask continueWithSuccessBlock:^id(BFTask *task) {
+                return [PFOfflineQueryIndex buildIndexIfNeededAsyncInDatabase:database];
+            }];
         }] continueWithSuccessBlock:^id(BFTask *task) {
             return [database commitAsync];
         }] continueWithBlock:^id(BFTask *task) {
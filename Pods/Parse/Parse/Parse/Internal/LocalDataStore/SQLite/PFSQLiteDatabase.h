@@ -39,6 +39,11 @@ extern int const PFSQLiteDatabaseDatabaseAlreadyOpened;
  */
 extern int const PFSQLiteDatabaseDatabaseAlreadyClosed;
 
+/**
+ Maximum number of variables in a single statement, see `SQLITE_MAX_VARIABLE_NUMBER`.
+ */
+extern int const PFSQLiteDatabaseMaximumVariablesCount;
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface PFSQLiteDatabase : NSObject
@@ -112,6 +117,29 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BFTask *)executeSQLAsync:(NSString *)sql withArgumentsInArray:(nullable NSArray *)args;
 
+/**
+ Runs a single SQL statement which doesn't return result once for every array of arguments,
+ reusing the same prepared statement. Stops at the first failure.
+ */
+- (BFTask *)executeSQLAsync:(NSString *)sql withArgumentsInArrays:(NSArray<NSArray *> *)argumentsArrays;
+
+/**
+ Runs a SQL statement which doesn't return result for the rows of arguments, in as few statements as
+ `PFSQLiteDatabaseMaximumVariablesCount` allows. `%@` in `sqlFormat` is replaced by the placeholders for the rows,
+ `?, ?` for rows of a single argument, and `(?, ?), (?, ?)` otherwise. All rows must have the same number of arguments.
+ */
+- (BFTask *)executeSQLAsync:(NSString *)sqlFormat withArgumentRows:(NSArray<NSArray *> *)rows;
+
+/**
+ Same as `executeSQLAsync:withArgumentRows:`, but for a SQL statement which returns result (SELECT).
+ The block is called with the result of every chunk, and has to read it before returning.
+ The task resolves to an array with what the block returned for every chunk, in order, where tasks are replaced
+ by their results and `nil` by `NSNull`.
+ */
+- (BFTask *)executeQueryAsync:(NSString *)queryFormat
+             withArgumentRows:(NSArray<NSArray *> *)rows
+                        block:(PFSQLiteDatabaseQueryBlock)block;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -37,11 +37,20 @@ int const PFSQLiteDatabaseInvalidSQL = 2;
 int const PFSQLiteDatabaseDatabaseAlreadyOpened = 3;
 int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
 
+int const PFSQLiteDatabaseMaximumVariablesCount = 999;
+
+/**
+ Prepared statements kept around for reuse. The least recently used one is dropped beyond that,
+ since queries with variable-length argument lists would otherwise grow the cache without bound.
+ */
+static NSUInteger const PFSQLiteDatabaseMaximumCachedStatementsCount = 64;
+
 @interface PFSQLiteDatabase () {
     BFTaskCompletionSource *_databaseClosedTaskCompletionSource;
     dispatch_queue_t _databaseQueue;
     BFExecutor *_databaseExecutor;
-    NSMutableDictionary *_cachedStatements;
+    NSMutableDictionary<NSString *, PFSQLiteStatement *> *_cachedStatements;
+    NSMutableOrderedSet<NSString *> *_cachedStatementQueries; // Least recently used first.
 }
 
 /**
@@ -80,6 +89,7 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
     }];
 
     _cachedStatements = [[NSMutableDictionary alloc] init];
+    _cachedStatementQueries = [[NSMutableOrderedSet alloc] init];
 
     return self;
 }
@@ -181,6 +191,11 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
 - (BFTask<PFSQLiteDatabaseResult *> *)_executeQueryAsync:(NSString *)sql withArgumentsInArray:(NSArray *)args cachingEnabled:(BOOL)enableCaching {
     int resultCode = 0;
     PFSQLiteStatement *statement = enableCaching ? [self _cachedStatementForQuery:sql] : nil;
+    if (statement.inUse) {
+        // A result of the same query is still open, so this one gets its own statement.
+        statement = nil;
+        enableCaching = NO;
+    }
     if (!statement) {
         sqlite3_stmt *sqliteStatement = nil;
         resultCode = sqlite3_prepare_v2(self.database, sql.UTF8String, -1, &sqliteStatement, 0);
@@ -216,6 +231,7 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
         [self _bindObject:args[idx] toColumn:(idx + 1) inStatement:statement];
     }
 
+    statement.inUse = YES;
     PFSQLiteDatabaseResult *result = [[PFSQLiteDatabaseResult alloc] initWithStatement:statement queue:_databaseQueue];
     return [BFTask taskWithResult:result];
 }
@@ -228,7 +244,7 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
 
 - (BFTask *)executeQueryAsync:(NSString *)query withArgumentsInArray:(nullable NSArray *)args block:(PFSQLiteDatabaseQueryBlock)block {
     return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
-        BFTask<PFSQLiteDatabaseResult *> *task = [self _executeQueryAsync:query withArgumentsInArray:args cachingEnabled:NO];
+        BFTask<PFSQLiteDatabaseResult *> *task = [self _executeQueryAsync:query withArgumentsInArray:args cachingEnabled:YES];
         return [[task continueImmediatelyWithSuccessBlock:^id(BFTask<PFSQLiteDatabaseResult *> *task) {
             return block(task.result);
         }] continueImmediatelyWithBlock:^id(BFTask *resultTask) {
@@ -240,32 +256,129 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
 
 - (BFTask *)executeSQLAsync:(NSString *)sql withArgumentsInArray:(NSArray *)args {
     return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
-        return [[self _executeQueryAsync:sql
-                    withArgumentsInArray:args
-                          cachingEnabled:NO] continueWithExecutor:[BFExecutor immediateExecutor] withSuccessBlock:^id(BFTask *task) {
-            PFSQLiteDatabaseResult *databaseResult = task.result;
-            int sqliteResultCode = [databaseResult step];
-            [databaseResult close];
-
-            switch (sqliteResultCode) {
-                case SQLITE_DONE: {
-                    return nil;
-                }
-                case SQLITE_ROW: {
-                    NSError *error = [self _errorWithErrorCode:PFSQLiteDatabaseInvalidSQL
-                                                  errorMessage:@"Cannot SELECT on executeSQLAsync."
-                                                               @"Please use executeQueryAsync."
-                                                        domain:NSStringFromClass([self class])];
-                    return [BFTask taskWithError:error];
-                }
-                default: {
-                    return [BFTask taskWithError:[self _errorWithErrorCode:sqliteResultCode]];
-                }
+        return [self _executeSQL:sql withArgumentsInArray:args];
+    }];
+}
+
+- (BFTask *)executeSQLAsync:(NSString *)sql withArgumentsInArrays:(NSArray<NSArray *> *)argumentsArrays {
+    return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
+        // Every row goes through the same cached statement, reset and rebound in between.
+        for (NSArray *args in argumentsArrays) {
+            BFTask *task = [self _executeSQL:sql withArgumentsInArray:args];
+            if (task.faulted) {
+                return task;
             }
+        }
+        return nil;
+    }];
+}
+
+- (BFTask *)executeSQLAsync:(NSString *)sqlFormat withArgumentRows:(NSArray<NSArray *> *)rows {
+    return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
+        __block BFTask *task = nil;
+        [self _enumerateChunksOfQuery:sqlFormat argumentRows:rows usingBlock:^BOOL(NSString *sql, NSArray *args) {
+            task = [self _executeSQL:sql withArgumentsInArray:args];
+            return !task.faulted;
+        }];
+        return task;
+    }];
+}
+
+- (BFTask *)executeQueryAsync:(NSString *)queryFormat
+             withArgumentRows:(NSArray<NSArray *> *)rows
+                        block:(PFSQLiteDatabaseQueryBlock)block {
+    return [BFTask taskFromExecutor:_databaseExecutor withBlock:^id {
+        NSMutableArray<BFTask *> *tasks = [NSMutableArray array];
+        [self _enumerateChunksOfQuery:queryFormat argumentRows:rows usingBlock:^BOOL(NSString *query, NSArray *args) {
+            BFTask<PFSQLiteDatabaseResult *> *resultTask = [self _executeQueryAsync:query
+                                                               withArgumentsInArray:args
+                                                                     cachingEnabled:YES];
+            id blockResult = resultTask.faulted ? resultTask : block(resultTask.result);
+            [resultTask.result close];
+
+            BFTask *task = ([blockResult isKindOfClass:[BFTask class]] ? blockResult : [BFTask taskWithResult:blockResult]);
+            [tasks addObject:task];
+            return !task.faulted;
         }];
+        return [BFTask taskForCompletionOfAllTasksWithResults:tasks];
     }];
 }
 
+/**
+ Runs a single statement which doesn't return result on the database queue.
+ */
+- (BFTask *)_executeSQL:(NSString *)sql withArgumentsInArray:(NSArray *)args {
+    return [[self _executeQueryAsync:sql
+                withArgumentsInArray:args
+                      cachingEnabled:YES] continueWithExecutor:[BFExecutor immediateExecutor] withSuccessBlock:^id(BFTask *task) {
+        PFSQLiteDatabaseResult *databaseResult = task.result;
+        int sqliteResultCode = [databaseResult step];
+        [databaseResult close];
+
+        switch (sqliteResultCode) {
+            case SQLITE_DONE: {
+                return nil;
+            }
+            case SQLITE_ROW: {
+                NSError *error = [self _errorWithErrorCode:PFSQLiteDatabaseInvalidSQL
+                                              errorMessage:@"Cannot SELECT on executeSQLAsync."
+                                                           @"Please use executeQueryAsync."
+                                                    domain:NSStringFromClass([self class])];
+                return [BFTask taskWithError:error];
+            }
+            default: {
+                return [BFTask taskWithError:[self _errorWithErrorCode:sqliteResultCode]];
+            }
+        }
+    }];
+}
+
+/**
+ Splits the rows into chunks that fit into `PFSQLiteDatabaseMaximumVariablesCount` variables and calls the block
+ with the query for every chunk, where `%@` is replaced by the placeholders of its rows, until the block returns `NO`.
+ All chunks except the last one have the same size, so at most two distinct queries are prepared.
+ */
+- (void)_enumerateChunksOfQuery:(NSString *)queryFormat
+                   argumentRows:(NSArray<NSArray *> *)rows
+                     usingBlock:(BOOL (^)(NSString *query, NSArray *args))block {
+    NSUInteger rowWidth = MAX(rows.firstObject.count, 1);
+    NSUInteger rowsPerChunk = MAX(PFSQLiteDatabaseMaximumVariablesCount / rowWidth, 1);
+
+    NSMutableArray<NSString *> *rowPlaceholders = [NSMutableArray arrayWithCapacity:rowWidth];
+    for (NSUInteger i = 0; i < rowWidth; i++) {
+        [rowPlaceholders addObject:@"?"];
+    }
+    NSString *rowPlaceholder = [rowPlaceholders componentsJoinedByString:@", "];
+    if (rowWidth > 1) {
+        rowPlaceholder = [NSString stringWithFormat:@"(%@)", rowPlaceholder];
+    }
+
+    NSString *fullChunkQuery = nil;
+    for (NSUInteger location = 0; location < rows.count; location += rowsPerChunk) {
+        NSRange range = NSMakeRange(location, MIN(rowsPerChunk, rows.count - location));
+        NSMutableArray *args = [NSMutableArray arrayWithCapacity:range.length * rowWidth];
+        for (NSArray *row in [rows subarrayWithRange:range]) {
+            [args addObjectsFromArray:row];
+        }
+
+        NSString *query = (range.length == rowsPerChunk ? fullChunkQuery : nil);
+        if (!query) {
+            NSMutableArray<NSString *> *placeholders = [NSMutableArray arrayWithCapacity:range.length];
+            for (NSUInteger i = 0; i < range.length; i++) {
+                [placeholders addObject:rowPlaceholder];
+            }
+            query = [NSString stringWithFormat:queryFormat, [placeholders componentsJoinedByString:@", "]];
+            if (range.length == rowsPerChunk) {
+                fullChunkQuery = query;
+            }
+        }
+
+        if (!block(query, args)) {
+            return;
+        }
+    }
+}
+
 /**
  bindObject will bind any object supported by PFSQLiteDatabase to query statement.
  Note: sqlite3 query index binding is one-based, while querying result is zero-based.
@@ -300,18 +413,42 @@ int const PFSQLiteDatabaseDatabaseAlreadyClosed = 4;
 
 - (void)_clearCachedStatements {
     for (PFSQLiteStatement *statement in _cachedStatements.allValues) {
+        statement.cached = NO;
         [statement close];
     }
 
     [_cachedStatements removeAllObjects];
+    [_cachedStatementQueries removeAllObjects];
 }
 
 - (PFSQLiteStatement *)_cachedStatementForQuery:(NSString *)query {
-    return _cachedStatements[query];
+    PFSQLiteStatement *statement = _cachedStatements[query];
+    if (statement) {
+        // Move to the most recently used end.
+        [_cachedStatementQueries removeObject:query];
+        [_cachedStatementQueries addObject:query];
+    }
+    return statement;
 }
 
 - (void)_cacheStatement:(PFSQLiteStatement *)statement forQuery:(NSString *)query {
+    statement.cached = YES;
     _cachedStatements[query] = statement;
+    [_cachedStatementQueries removeObject:query];
+    [_cachedStatementQueries addObject:query];
+
+    while (_cachedStatementQueries.count > PFSQLiteDatabaseMaximumCachedStatementsCount) {
+        NSString *evictedQuery = _cachedStatementQueries.firstObject;
+        PFSQLiteStatement *evictedStatement = _cachedStatements[evictedQuery];
+        [_cachedStatementQueries removeObjectAtIndex:0];
+        [_cachedStatements removeObjectForKey:evictedQuery];
+
+        // A statement with an open result is finalized when that result is closed.
+        evictedStatement.cached = NO;
+        if (!evictedStatement.inUse) {
+            [evictedStatement close];
+        }
+    }
 }
 
 ///--------------------------------------
@@ -45,7 +45,22 @@
 }
 
 - (BOOL)close {
-    return [self.statement close];
+    return PFThreadSafetyPerform(_databaseQueue, ^BOOL{
+        PFSQLiteStatement *statement = self->_statement;
+        if (!statement) {
+            return YES;
+        }
+        // Detach, so that closing twice can't reset the statement under its next user.
+        self->_statement = nil;
+        statement.inUse = NO;
+
+        // Cached statements stay prepared for the next query, unless they were evicted meanwhile.
+        if (statement.cached) {
+            BOOL result = [statement reset];
+            return [statement clearBindings] && result;
+        }
+        return [statement close];
+    });
 }
 
 - (int)intForColumn:(NSString *)columnName {
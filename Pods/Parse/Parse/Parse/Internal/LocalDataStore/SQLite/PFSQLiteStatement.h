@@ -21,10 +21,22 @@ typedef struct sqlite3_stmt sqlite3_stmt;
 @property (nullable, nonatomic, assign, readonly) sqlite3_stmt *sqliteStatement;
 @property (nonatomic, strong, readonly) dispatch_queue_t databaseQueue;
 
+/**
+ Whether the statement is owned by the statement cache of its database.
+ Cached statements are reset instead of finalized when their result is closed.
+ */
+@property (nonatomic, assign, getter=isCached) BOOL cached;
+
+/**
+ Whether a `PFSQLiteDatabaseResult` is currently stepping through the statement.
+ */
+@property (nonatomic, assign, getter=isInUse) BOOL inUse;
+
 - (instancetype)initWithStatement:(sqlite3_stmt *)stmt queue:(dispatch_queue_t)databaseQueue;
 
 - (BOOL)close;
 - (BOOL)reset;
+- (BOOL)clearBindings;
 
 @end
 
@@ -53,4 +53,14 @@
     });
 }
 
+- (BOOL)clearBindings {
+    return PFThreadSafetyPerform(_databaseQueue, ^BOOL{
+        if (!self->_sqliteStatement) {
+            return YES;
+        }
+
+        return (sqlite3_clear_bindings(self->_sqliteStatement) == SQLITE_OK);
+    });
+}
+
 @end
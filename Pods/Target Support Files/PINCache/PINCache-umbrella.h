@@ -16,6 +16,7 @@
 #import "PINCaching.h"
 #import "PINDiskCache.h"
 #import "PINMemoryCache.h"
+#import "PINSlabDiskCache.h"
 
 FOUNDATION_EXPORT double PINCacheVersionNumber;
 FOUNDATION_EXPORT const unsigned char PINCacheVersionString[];
@@ -24,6 +24,7 @@
 #import "PINImageView+PINRemoteImage.h"
 #import "PINAlternateRepresentationProvider.h"
 #import "PINGIFAnimatedImageManager.h"
+#import "PINJPEGSegmentParser.h"
 #import "PINProgressiveImage.h"
 #import "PINRemoteImage.h"
 #import "PINRemoteImageBasicCache.h"
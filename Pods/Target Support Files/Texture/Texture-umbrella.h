@@ -68,6 +68,7 @@
 #import "UIResponder+AsyncDisplayKit.h"
 #import "_ASTransitionContext.h"
 #import "ASAbstractLayoutController.h"
+#import "ASAdaptiveRangeTuner.h"
 #import "ASBasicImageDownloader.h"
 #import "ASBatchContext.h"
 #import "ASBatchFetchingDelegate.h"
@@ -154,6 +155,7 @@
 #import "ASEqualityHelpers.h"
 #import "ASLog.h"
 #import "ASSignpost.h"
+#import "ASTraceRecorder.h"
 #import "AsyncDisplayKit+Debug.h"
 #import "AsyncDisplayKit+Tips.h"
 #import "ASTextNodeTypes.h"
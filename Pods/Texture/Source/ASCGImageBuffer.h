@@ -16,6 +16,16 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/// Counters of the pool of recycled buffers.
+typedef struct {
+  /// Buffers that were taken from the pool.
+  NSUInteger hits;
+  /// Buffers that had to be mapped because the pool had none of their size.
+  NSUInteger misses;
+  /// Bytes held by the pool for reuse.
+  NSUInteger bytesResident;
+} ASCGImageBufferPoolStatistics;
+
 AS_SUBCLASSING_RESTRICTED
 @interface ASCGImageBuffer : NSObject
 
@@ -27,6 +37,16 @@ AS_SUBCLASSING_RESTRICTED
 /// Don't do any drawing or call any methods after calling this.
 - (CGDataProviderRef)createDataProviderAndInvalidate;
 
+/**
+ * With ASExperimentalImageBufferPool, buffers larger than a page are recycled once the
+ * context or image using them goes away, instead of being unmapped. These are the counters
+ * of that pool since launch.
+ */
++ (ASCGImageBufferPoolStatistics)poolStatistics;
+
+/// Releases the buffers held by the pool. Done on memory warnings and when entering the background.
++ (void)trimPool;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -12,10 +12,98 @@
 
 #import "ASCGImageBuffer.h"
 
+#import <pthread.h>
 #import <sys/mman.h>
 #import <mach/mach_init.h>
 #import <mach/vm_map.h>
 #import <mach/vm_statistics.h>
+#import <UIKit/UIApplication.h>
+
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+
+#pragma mark - Pool
+
+/// Buffers given back while the pool holds this many bytes are unmapped instead.
+static const size_t kASCGImageBufferPoolByteLimit = 32 * 1024 * 1024;
+
+static pthread_mutex_t __poolLock = PTHREAD_MUTEX_INITIALIZER;
+/// Capacity -> the first free buffer of that capacity. Free buffers are chained through their first bytes.
+static CFMutableDictionaryRef __poolFreeLists;
+static ASCGImageBufferPoolStatistics __poolStatistics;
+
+/**
+ * Rounds the length up to pages, and large page counts up to their top four bits, so that
+ * slightly different sizes share buffers. Wastes less than an eighth of the buffer, and the
+ * unused pages of a new buffer are never touched.
+ */
+static size_t ASCGImageBufferCapacityForLength(size_t length)
+{
+  size_t pages = (length + vm_page_size - 1) / vm_page_size;
+  if (pages > 8) {
+    size_t granularity = (size_t)1 << (flsl(pages) - 4);
+    pages = (pages + granularity - 1) & ~(granularity - 1);
+  }
+  return pages * vm_page_size;
+}
+
+static void ASCGImageBufferPoolObserveMemoryPressure()
+{
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    for (NSString *name in @[UIApplicationDidReceiveMemoryWarningNotification, UIApplicationDidEnterBackgroundNotification]) {
+      [center addObserverForName:name object:nil queue:nil usingBlock:^(NSNotification * _Nonnull note) {
+        [ASCGImageBuffer trimPool];
+      }];
+    }
+  });
+}
+
+/// Returns a read-write buffer of the given capacity with undefined contents, or NULL.
+static void *ASCGImageBufferPoolTake(size_t capacity)
+{
+  ASCGImageBufferPoolObserveMemoryPressure();
+  
+  void *buffer = NULL;
+  pthread_mutex_lock(&__poolLock);
+  if (__poolFreeLists != NULL) {
+    buffer = (void *)CFDictionaryGetValue(__poolFreeLists, (const void *)capacity);
+  }
+  if (buffer != NULL) {
+    void *next = *(void **)buffer;
+    if (next != NULL) {
+      CFDictionarySetValue(__poolFreeLists, (const void *)capacity, next);
+    } else {
+      CFDictionaryRemoveValue(__poolFreeLists, (const void *)capacity);
+    }
+    __poolStatistics.hits++;
+    __poolStatistics.bytesResident -= capacity;
+  } else {
+    __poolStatistics.misses++;
+  }
+  pthread_mutex_unlock(&__poolLock);
+  return buffer;
+}
+
+/// Takes a read-write buffer, unless the pool is full.
+static BOOL ASCGImageBufferPoolPut(void *buffer, size_t capacity)
+{
+  pthread_mutex_lock(&__poolLock);
+  BOOL accepted = (__poolStatistics.bytesResident + capacity <= kASCGImageBufferPoolByteLimit);
+  if (accepted) {
+    if (__poolFreeLists == NULL) {
+      // Integer keys and raw pointer values.
+      __poolFreeLists = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+    }
+    *(void **)buffer = (void *)CFDictionaryGetValue(__poolFreeLists, (const void *)capacity);
+    CFDictionarySetValue(__poolFreeLists, (const void *)capacity, buffer);
+    __poolStatistics.bytesResident += capacity;
+  }
+  pthread_mutex_unlock(&__poolLock);
+  return accepted;
+}
+
+#pragma mark - ASCGImageBuffer
 
 /**
  * The behavior of this class is modeled on the private function
@@ -29,19 +117,35 @@
 @implementation ASCGImageBuffer {
   BOOL _createdData;
   BOOL _isVM;
+  BOOL _isPooled;
   NSUInteger _length;
+  NSUInteger _capacity;
 }
 
 - (instancetype)initWithLength:(NSUInteger)length
 {
   if (self = [super init]) {
     _length = length;
+    _capacity = length;
     _isVM = (length >= vm_page_size);
     if (_isVM) {
-      _mutableBytes = mmap(NULL, length, PROT_WRITE | PROT_READ, MAP_ANONYMOUS | MAP_PRIVATE, VM_MAKE_TAG(VM_MEMORY_COREGRAPHICS_DATA), 0);
+      _isPooled = ASActivateExperimentalFeature(ASExperimentalImageBufferPool);
+      if (_isPooled) {
+        _capacity = ASCGImageBufferCapacityForLength(length);
+        _mutableBytes = ASCGImageBufferPoolTake(_capacity);
+        if (_mutableBytes != NULL) {
+          // Still cheaper than faulting in fresh zero pages, and unmapping them afterwards.
+          memset(_mutableBytes, 0, length);
+        }
+      }
+      if (_mutableBytes == NULL) {
+        _mutableBytes = mmap(NULL, _capacity, PROT_WRITE | PROT_READ, MAP_ANONYMOUS | MAP_PRIVATE, VM_MAKE_TAG(VM_MEMORY_COREGRAPHICS_DATA), 0);
+      }
       if (_mutableBytes == MAP_FAILED) {
         NSAssert(NO, @"Failed to map for CG image data.");
         _isVM = NO;
+        _isPooled = NO;
+        _capacity = length;
       }
     }
     
@@ -56,7 +160,7 @@
 - (void)dealloc
 {
   if (!_createdData) {
-    [ASCGImageBuffer deallocateBuffer:_mutableBytes length:_length isVM:_isVM];
+    [ASCGImageBuffer deallocateBuffer:_mutableBytes length:_capacity isVM:_isVM isPooled:_isPooled];
   }
 }
 
@@ -67,20 +171,30 @@
   
   // Mark the pages as read-only.
   if (_isVM) {
-    __unused kern_return_t result = vm_protect(mach_task_self(), (vm_address_t)_mutableBytes, _length, true, VM_PROT_READ);
+    __unused kern_return_t result = vm_protect(mach_task_self(), (vm_address_t)_mutableBytes, _capacity, true, VM_PROT_READ);
     NSAssert(result == noErr, @"Error marking buffer as read-only: %@", [NSError errorWithDomain:NSMachErrorDomain code:result userInfo:nil]);
   }
   
-  // Wrap in an NSData
+  // Wrap in an NSData. Its length is the one drawn into, the capacity is what was mapped.
   BOOL isVM = _isVM;
+  BOOL isPooled = _isPooled;
+  NSUInteger capacity = _capacity;
   NSData *d = [[NSData alloc] initWithBytesNoCopy:_mutableBytes length:_length deallocator:^(void * _Nonnull bytes, NSUInteger length) {
-    [ASCGImageBuffer deallocateBuffer:bytes length:length isVM:isVM];
+    [ASCGImageBuffer deallocateBuffer:bytes length:capacity isVM:isVM isPooled:isPooled];
   }];
   return CGDataProviderCreateWithCFData((__bridge CFDataRef)d);
 }
 
-+ (void)deallocateBuffer:(void *)buf length:(NSUInteger)length isVM:(BOOL)isVM
++ (void)deallocateBuffer:(void *)buf length:(NSUInteger)length isVM:(BOOL)isVM isPooled:(BOOL)isPooled
 {
+  if (isPooled) {
+    // The pages are read-only if an image was made from them.
+    kern_return_t result = vm_protect(mach_task_self(), (vm_address_t)buf, length, false, VM_PROT_READ | VM_PROT_WRITE);
+    if (result == KERN_SUCCESS && ASCGImageBufferPoolPut(buf, length)) {
+      return;
+    }
+  }
+  
   if (isVM) {
     __unused kern_return_t result = vm_deallocate(mach_task_self(), (vm_address_t)buf, length);
     NSAssert(result == noErr, @"Failed to unmap cg image buffer: %@", [NSError errorWithDomain:NSMachErrorDomain code:result userInfo:nil]);
@@ -89,4 +203,43 @@
   }
 }
 
++ (ASCGImageBufferPoolStatistics)poolStatistics
+{
+  pthread_mutex_lock(&__poolLock);
+  ASCGImageBufferPoolStatistics statistics = __poolStatistics;
+  pthread_mutex_unlock(&__poolLock);
+  return statistics;
+}
+
++ (void)trimPool
+{
+  pthread_mutex_lock(&__poolLock);
+  CFMutableDictionaryRef freeLists = __poolFreeLists;
+  __poolFreeLists = NULL;
+  __poolStatistics.bytesResident = 0;
+  pthread_mutex_unlock(&__poolLock);
+  
+  if (freeLists == NULL) {
+    return;
+  }
+  
+  CFIndex count = CFDictionaryGetCount(freeLists);
+  if (count == 0) {
+    CFRelease(freeLists);
+    return;
+  }
+  const void *capacities[count];
+  const void *heads[count];
+  CFDictionaryGetKeysAndValues(freeLists, capacities, heads);
+  for (CFIndex i = 0; i < count; i++) {
+    void *buffer = (void *)heads[i];
+    while (buffer != NULL) {
+      void *next = *(void **)buffer;
+      [self deallocateBuffer:buffer length:(size_t)capacities[i] isVM:YES isPooled:NO];
+      buffer = next;
+    }
+  }
+  CFRelease(freeLists);
+}
+
 @end
@@ -59,6 +59,16 @@ typedef struct {
   NSInteger layoutComputationNumberOfPasses;
 } ASDisplayNodePerformanceMeasurements;
 
+/**
+ * Counters of the layout memo cache shared by all nodes, since launch.
+ */
+typedef struct {
+  /// Layouts that were rebound from a layout of another node.
+  NSUInteger hits;
+  /// Layouts that were calculated by nodes with a layoutContentHash.
+  NSUInteger misses;
+} ASDisplayNodeLayoutMemoStatistics;
+
 @interface ASDisplayNode (Beta)
 
 /**
@@ -92,6 +102,22 @@ typedef struct {
  */
 @property (readonly) ASDisplayNodePerformanceMeasurements performanceMeasurements;
 
+/**
+ * @abstract A hash of everything the layout of this node and its subnodes depends on, such as the text lengths and
+ * image aspect ratios of the model it displays. Defaults to 0, which opts out of layout memoization.
+ *
+ * @discussion Nodes of the same class with the same non-zero hash share their layouts: the layout calculated by one
+ * node for a size range is rebound to the subnodes of the next, which then aren't measured again. Subnodes are matched
+ * up by the order they appear in the layout spec, so equal hashes must produce layout specs of the same shape.
+ * Only nodes that provide a layoutSpecBlock or implement layoutSpecThatFits: are memoized.
+ */
+@property NSUInteger layoutContentHash;
+
+/**
+ * @abstract Returns the counters of the layout memo cache shared by all nodes.
+ */
++ (ASDisplayNodeLayoutMemoStatistics)layoutMemoStatistics;
+
 #if ASEVENTLOG_ENABLE
 /*
  * @abstract The primitive event tracing object. You shouldn't directly use it to log event. Use the ASDisplayNodeLogEvent macro instead.
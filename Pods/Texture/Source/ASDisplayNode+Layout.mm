@@ -17,13 +17,19 @@
 
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h>
+#import <AsyncDisplayKit/ASDisplayNode+Beta.h>
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
+#import <AsyncDisplayKit/ASHashing.h>
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/ASLayout.h>
 #import <AsyncDisplayKit/ASLayoutElementStylePrivate.h>
+#import <AsyncDisplayKit/ASLayoutPrivate.h>
 #import <AsyncDisplayKit/ASLog.h>
 
+#import <atomic>
+#import <vector>
+
 #pragma mark - ASDisplayNode (ASLayoutElement)
 
 @implementation ASDisplayNode (ASLayoutElement)
@@ -205,11 +211,225 @@ ASLayoutElementStyleExtensibilityForwarding
 
 @end
 
+#pragma mark -
+#pragma mark - Layout Memoization
+
+/**
+ * Identifies the layouts that nodes of the same class with the same contents calculate for a size range.
+ */
+@interface ASLayoutMemoKey : NSObject
+{
+@package
+  Class _nodeClass;
+  NSUInteger _contentHash;
+  ASSizeRange _constrainedSize;
+  ASPrimitiveTraitCollection _traitCollection;
+}
+@end
+
+@implementation ASLayoutMemoKey
+
+- (BOOL)isEqual:(id)object
+{
+  if (self == object) {
+    return YES;
+  }
+  ASLayoutMemoKey *other = ASDynamicCast(object, ASLayoutMemoKey);
+  return other != nil
+    && _nodeClass == other->_nodeClass
+    && _contentHash == other->_contentHash
+    && ASSizeRangeEqualToSizeRange(_constrainedSize, other->_constrainedSize)
+    && ASPrimitiveTraitCollectionIsEqualToASPrimitiveTraitCollection(_traitCollection, other->_traitCollection);
+}
+
+- (NSUInteger)hash
+{
+  struct {
+    void *nodeClass;
+    NSUInteger contentHash;
+    ASSizeRange constrainedSize;
+  } data = {
+    (__bridge void *)_nodeClass,
+    _contentHash,
+    _constrainedSize
+  };
+  return ASHashBytes(&data, sizeof(data));
+}
+
+@end
+
+/**
+ * The frame of a node in a flattened layout, along with what it needs to be laid out again on its own.
+ */
+struct ASLayoutSkeletonEntry {
+  /// The position of the node among the display nodes of the layout spec, in depth-first order.
+  NSUInteger index;
+  Class nodeClass;
+  CGRect frame;
+  ASSizeRange constrainedSize;
+  CGSize parentSize;
+  /// Whether the node positions subnodes of its own, which then need to be laid out too.
+  BOOL hasSublayouts;
+};
+
+/**
+ * A flattened layout that refers to nodes by their position in the layout spec, so it can be rebound to the
+ * nodes of any layout spec of the same shape.
+ */
+@interface ASLayoutSkeleton : NSObject
+{
+@package
+  CGSize _size;
+  NSUInteger _nodeCount;
+  std::vector<ASLayoutSkeletonEntry> _entries;
+}
+@end
+
+@implementation ASLayoutSkeleton
+@end
+
+static NSCache<ASLayoutMemoKey *, ASLayoutSkeleton *> *ASLayoutMemoCache()
+{
+  static NSCache *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = [[NSCache alloc] init];
+    cache.countLimit = 2000;
+  });
+  return cache;
+}
+
+static std::atomic<NSUInteger> layoutMemoHits;
+static std::atomic<NSUInteger> layoutMemoMisses;
+
+static void ASLayoutMemoCollectNodes(id<ASLayoutElement> layoutElement, NSMutableArray<ASDisplayNode *> *nodes)
+{
+  if (layoutElement.layoutElementType == ASLayoutElementTypeDisplayNode) {
+    // Subnodes of the node are part of its own layout.
+    [nodes addObject:(ASDisplayNode *)layoutElement];
+    return;
+  }
+  for (id<ASLayoutElement> sublayoutElement in layoutElement.sublayoutElements) {
+    ASLayoutMemoCollectNodes(sublayoutElement, nodes);
+  }
+}
+
 #pragma mark -
 #pragma mark - ASDisplayNode (ASLayoutInternal)
 
 @implementation ASDisplayNode (ASLayoutInternal)
 
++ (ASDisplayNodeLayoutMemoStatistics)layoutMemoStatistics
+{
+  return (ASDisplayNodeLayoutMemoStatistics){ layoutMemoHits.load(), layoutMemoMisses.load() };
+}
+
+- (ASLayoutMemoKey *)_locked_layoutMemoKeyForConstrainedSize:(ASSizeRange)constrainedSize
+{
+  ASLayoutMemoKey *key = [[ASLayoutMemoKey alloc] init];
+  key->_nodeClass = [self class];
+  key->_contentHash = _layoutContentHash;
+  key->_constrainedSize = constrainedSize;
+  key->_traitCollection = _primitiveTraitCollection.load();
+  return key;
+}
+
+- (ASLayout *)_locked_memoizedLayoutThatFits:(ASSizeRange)constrainedSize layoutElement:(id<ASLayoutElement>)layoutElement
+{
+  if (_layoutContentHash == 0 || [ASDisplayNode shouldStoreUnflattenedLayouts]) {
+    return nil;
+  }
+
+  ASLayoutSkeleton *skeleton = [ASLayoutMemoCache() objectForKey:[self _locked_layoutMemoKeyForConstrainedSize:constrainedSize]];
+  if (skeleton == nil) {
+    return nil;
+  }
+
+  NSMutableArray<ASDisplayNode *> *nodes = [NSMutableArray array];
+  ASLayoutMemoCollectNodes(layoutElement, nodes);
+  if (nodes.count != skeleton->_nodeCount) {
+    ASDisplayNodeFailAssert(@"Node %@ returned a layout spec of a different shape than another node with layoutContentHash %lu.", self, (unsigned long)_layoutContentHash);
+    return nil;
+  }
+
+  NSMutableArray<ASLayout *> *sublayouts = [NSMutableArray arrayWithCapacity:skeleton->_entries.size()];
+  for (const ASLayoutSkeletonEntry &entry : skeleton->_entries) {
+    ASDisplayNode *node = nodes[entry.index];
+    if ([node class] != entry.nodeClass) {
+      return nil;
+    }
+
+    if (entry.hasSublayouts) {
+      // The subnodes of the node need a layout too, which it may in turn rebind from its own memo.
+      ASLayout *nodeLayout = [node layoutThatFits:entry.constrainedSize parentSize:entry.parentSize];
+      if (CGSizeEqualToSize(nodeLayout.size, entry.frame.size) == NO) {
+        return nil;
+      }
+    } else {
+      // Leave the node the layout it would have calculated, so it isn't measured once it gets its frame.
+      ASDN::MutexLocker l(node->__instanceLock__);
+      NSUInteger version = node->_layoutVersion;
+      if (node->_calculatedDisplayNodeLayout->isValid(entry.constrainedSize, entry.parentSize, version) == NO
+          && (node->_pendingDisplayNodeLayout == nullptr || node->_pendingDisplayNodeLayout->isValid(entry.constrainedSize, entry.parentSize, version) == NO)) {
+        ASLayout *nodeLayout = [ASLayout layoutWithLayoutElement:node size:entry.frame.size];
+        node->_pendingDisplayNodeLayout = std::make_shared<ASDisplayNodeLayout>(nodeLayout, entry.constrainedSize, entry.parentSize, version);
+      }
+    }
+
+    [sublayouts addObject:[ASLayout layoutWithLayoutElement:node size:entry.frame.size position:entry.frame.origin sublayouts:nil]];
+  }
+
+  layoutMemoHits++;
+  ASLayout *layout = [ASLayout layoutWithLayoutElement:self size:skeleton->_size sublayouts:sublayouts];
+  // Already flattened, this only makes the layout retain its nodes like any other flattened layout.
+  return [layout filteredNodeLayoutTree];
+}
+
+- (void)_locked_memoizeLayout:(ASLayout *)layout constrainedSize:(ASSizeRange)constrainedSize layoutElement:(id<ASLayoutElement>)layoutElement
+{
+  if (_layoutContentHash == 0) {
+    return;
+  }
+  layoutMemoMisses++;
+
+  NSMutableArray<ASDisplayNode *> *nodes = [NSMutableArray array];
+  ASLayoutMemoCollectNodes(layoutElement, nodes);
+
+  ASLayoutSkeleton *skeleton = [[ASLayoutSkeleton alloc] init];
+  skeleton->_size = layout.size;
+  skeleton->_nodeCount = nodes.count;
+  skeleton->_entries.reserve(layout.sublayouts.count);
+
+  for (ASLayout *sublayout in layout.sublayouts) {
+    ASDisplayNode *node = ASDynamicCast(sublayout.layoutElement, ASDisplayNode);
+    NSUInteger index = (node != nil) ? [nodes indexOfObjectIdenticalTo:node] : NSNotFound;
+    if (index == NSNotFound) {
+      return;
+    }
+
+    // Find the layout the node calculated for itself, to learn what it was measured with.
+    ASDN::MutexLocker l(node->__instanceLock__);
+    std::shared_ptr<ASDisplayNodeLayout> nodeLayout = node->_pendingDisplayNodeLayout;
+    if (nodeLayout == nullptr || CGSizeEqualToSize(nodeLayout->layout.size, sublayout.size) == NO) {
+      nodeLayout = node->_calculatedDisplayNodeLayout;
+    }
+    if (nodeLayout->layout == nil || CGSizeEqualToSize(nodeLayout->layout.size, sublayout.size) == NO) {
+      return;
+    }
+
+    skeleton->_entries.push_back({
+      .index = index,
+      .nodeClass = [node class],
+      .frame = sublayout.frame,
+      .constrainedSize = nodeLayout->constrainedSize,
+      .parentSize = nodeLayout->parentSize,
+      .hasSublayouts = (nodeLayout->layout.sublayouts.count > 0),
+    });
+  }
+
+  [ASLayoutMemoCache() setObject:skeleton forKey:[self _locked_layoutMemoKeyForConstrainedSize:constrainedSize]];
+}
+
 /**
  * @abstract Informs the root node that the intrinsic size of the receiver is no longer valid.
  *
@@ -450,6 +670,19 @@ ASLayoutElementStyleExtensibilityForwarding
     layout = _calculatedDisplayNodeLayout->layout;
   }
   
+  // Flattened layouts carry their frames in a contiguous buffer, so they are applied in a single pass.
+  if (const ASLayoutFlatBuffer *flatBuffer = layout.flatBuffer) {
+    const size_t count = flatBuffer->frames.size();
+    for (size_t i = 0; i < count; i++) {
+      ASDisplayNode *node = (ASDisplayNode *)flatBuffer->elements[i];
+      // The layout may still contain nodes that are about to be inserted by a layout transition.
+      if (node.supernode == self) {
+        node.frame = flatBuffer->frames[i];
+      }
+    }
+    return;
+  }
+  
   for (ASDisplayNode *node in self.subnodes) {
     CGRect frame = [layout frameForElement:node];
     if (CGRectIsNull(frame)) {
@@ -474,6 +474,28 @@ extern NSInteger const ASDefaultDrawingPriority;
  */
 @property NSInteger drawingPriority;
 
+/**
+ * @abstract Whether the node draws its contents as a grid of tiles instead of a single bitmap.
+ *
+ * @discussion Meant for very tall nodes that draw with +drawRect:withParameters:isCancelled:isRasterizing:.
+ * Each tile is drawn by a separate operation of the display transaction, tiles in the visible rect first, so
+ * no single operation has to allocate or fill a backing store for the whole node. Like UIView's -drawRect:, the
+ * rect passed to +drawRect:withParameters:isCancelled:isRasterizing: is only the tile being drawn, so take the
+ * node's full bounds from the draw parameters. Tiles far from the visible rect are dropped on memory warnings
+ * and redrawn as they come near the screen again.
+ *
+ * Nodes that use +displayWithParameters:isCancelled:, rasterize their subtree, use precomposited corner rounding
+ * or fit in a single tile are displayed as usual. Defaults to NO.
+ */
+@property BOOL displaysInTiles;
+
+/**
+ * @abstract The size of each tile in points when displaysInTiles is enabled.
+ *
+ * @discussion Defaults to 512x512.
+ */
+@property CGSize displayTileSize;
+
 /** @name Hit Testing */
 
 
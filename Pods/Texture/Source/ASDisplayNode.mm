@@ -273,6 +273,7 @@ static ASDisplayNodeMethodOverrides GetASDisplayNodeMethodOverrides(Class c)
 
   _contentsScaleForDisplay = ASScreenScale();
   _drawingPriority = ASDefaultDrawingPriority;
+  _displayTileSize = CGSizeMake(512, 512);
   
   _primitiveTraitCollection = ASPrimitiveTraitCollectionMakeDefault();
   
@@ -1277,6 +1278,13 @@ static ASDisplayNodeMethodOverrides GetASDisplayNodeMethodOverrides(Class c)
     _layoutComputationNumberOfPasses++;
   }
 
+  // Reuse the layout of another node with the same contents if there is one
+  ASLayout *memoizedLayout = [self _locked_memoizedLayoutThatFits:constrainedSize layoutElement:layoutElement];
+  if (memoizedLayout != nil) {
+    ASDisplayNodeLogEvent(self, @"memoizedLayout: %@", memoizedLayout);
+    return memoizedLayout;
+  }
+
   // Layout element layout creation
   ASLayout *layout = ({
     ASDN::SumScopeTimer t(_layoutComputationTotalTime, measureLayoutComputation);
@@ -1296,6 +1304,7 @@ static ASDisplayNodeMethodOverrides GetASDisplayNodeMethodOverrides(Class c)
   // Otherwise, flatten it right away.
   if (! [ASDisplayNode shouldStoreUnflattenedLayouts]) {
     layout = [layout filteredNodeLayoutTree];
+    [self _locked_memoizeLayout:layout constrainedSize:constrainedSize layoutElement:layoutElement];
   }
   
   return layout;
@@ -1526,6 +1535,10 @@ NSString * const ASRenderingEngineDidDisplayNodesScheduledBeforeTimestamp = @"AS
                                                           userInfo:@{ASRenderingEngineDidDisplayNodesScheduledBeforeTimestamp: @(timestamp)}];
       }
     }];
+    // Display as many nodes per run loop turn as fit in the budget, rather than one. The batch is
+    // bounded so a long queue isn't popped and put back whole on every turn.
+    renderQueue.batchSize = 64;
+    renderQueue.timeBudget = ASRunLoopQueueMainThreadTimeBudget;
   });
 
   as_log_verbose(ASDisplayLog(), "%s %@", sel_getName(_cmd), node);
@@ -3283,6 +3296,7 @@ ASDISPLAYNODE_INLINE BOOL subtreeIsRasterized(ASDisplayNode *node) {
   ASDisplayNodeAssertMainThread();
   ASDisplayNodeAssertLockUnownedByCurrentThread(__instanceLock__);
   [_interfaceStateDelegate didEnterVisibleState];
+  [self _setTilesMonitorVisibleRect:YES];
 #if AS_ENABLE_TIPS
   [ASTipsController.shared nodeDidAppear:self];
 #endif
@@ -3294,6 +3308,7 @@ ASDISPLAYNODE_INLINE BOOL subtreeIsRasterized(ASDisplayNode *node) {
   ASDisplayNodeAssertMainThread();
   ASDisplayNodeAssertLockUnownedByCurrentThread(__instanceLock__);
   [_interfaceStateDelegate didExitVisibleState];
+  [self _setTilesMonitorVisibleRect:NO];
 }
 
 - (BOOL)isInDisplayState
@@ -3382,6 +3397,7 @@ ASDISPLAYNODE_INLINE BOOL subtreeIsRasterized(ASDisplayNode *node) {
   if (_flags.canClearContentsOfLayer) {
     // No-op if these haven't been created yet, as that guarantees they don't have contents that needs to be released.
     _layer.contents = nil;
+    [self _clearTiles];
   }
   
   _placeholderLayer.contents = nil;
@@ -3589,6 +3605,18 @@ ASDISPLAYNODE_INLINE BOOL subtreeIsRasterized(ASDisplayNode *node) {
   return measurements;
 }
 
+- (void)setLayoutContentHash:(NSUInteger)layoutContentHash
+{
+  ASDN::MutexLocker l(__instanceLock__);
+  _layoutContentHash = layoutContentHash;
+}
+
+- (NSUInteger)layoutContentHash
+{
+  ASDN::MutexLocker l(__instanceLock__);
+  return _layoutContentHash;
+}
+
 #pragma mark - Accessibility
 
 - (void)setIsAccessibilityContainer:(BOOL)isAccessibilityContainer
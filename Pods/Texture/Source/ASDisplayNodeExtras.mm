@@ -33,6 +33,7 @@ extern void ASPerformMainThreadDeallocation(id _Nullable __strong * _Nonnull obj
   dispatch_once(&onceToken, ^{
     queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:YES handler:nil];
     queue.batchSize = 10;
+    queue.timeBudget = ASRunLoopQueueMainThreadTimeBudget;
   });
 
   if (objectPtr != NULL && *objectPtr != nil) {
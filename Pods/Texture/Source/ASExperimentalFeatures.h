@@ -27,6 +27,11 @@ typedef NS_OPTIONS(NSUInteger, ASExperimentalFeatures) {
   ASExperimentalLayerDefaults = 1 << 4,                     // exp_infer_layer_defaults
   ASExperimentalNetworkImageQueue = 1 << 5,                 // exp_network_image_queue
   ASExperimentalDeallocQueue = 1 << 6,                      // exp_dealloc_queue_v2
+  ASExperimentalWorkStealingTransactionQueue = 1 << 7,      // exp_work_stealing_transaction_queue
+  ASExperimentalConcurrentWideStacks = 1 << 8,              // exp_concurrent_wide_stacks
+  ASExperimentalImageBufferPool = 1 << 9,                   // exp_image_buffer_pool
+  ASExperimentalAdaptiveRangeTuning = 1 << 10,              // exp_adaptive_range_tuning
+  ASExperimentalParagraphTextLayout = 1 << 11,              // exp_paragraph_text_layout
   ASExperimentalFeatureAll = 0xFFFFFFFF
 };
 
@@ -20,7 +20,12 @@ NSArray<NSString *> *ASExperimentalFeaturesGetNames(ASExperimentalFeatures flags
                                       @"exp_unfair_lock",
                                       @"exp_infer_layer_defaults",
                                       @"exp_network_image_queue",
-                                      @"exp_dealloc_queue_v2"]));
+                                      @"exp_dealloc_queue_v2",
+                                      @"exp_work_stealing_transaction_queue",
+                                      @"exp_concurrent_wide_stacks",
+                                      @"exp_image_buffer_pool",
+                                      @"exp_adaptive_range_tuning",
+                                      @"exp_paragraph_text_layout"]));
   
   if (flags == ASExperimentalFeatureAll) {
     return allNames;
@@ -31,6 +31,18 @@ NS_ASSUME_NONNULL_BEGIN
  */
 typedef UIImage * _Nullable (^asimagenode_modification_block_t)(UIImage *image);
 
+/**
+ * Counters of the cache of rendered contents shared by all image nodes, since launch.
+ */
+typedef struct {
+  /// Contents that were found in the cache.
+  NSUInteger hits;
+  /// Contents that were rendered.
+  NSUInteger misses;
+  /// Contents that another node was rendering at the same time, which were waited for instead of rendered again.
+  NSUInteger coalesced;
+} ASImageNodeContentsCacheStatistics;
+
 
 /**
  * @abstract Draws images.
@@ -130,6 +142,11 @@ typedef UIImage * _Nullable (^asimagenode_modification_block_t)(UIImage *image);
  */
 - (void)setNeedsDisplayWithCompletion:(nullable void (^)(BOOL canceled))displayCompletionBlock;
 
+/**
+ * @abstract Returns the counters of the contents cache shared by all image nodes.
+ */
++ (ASImageNodeContentsCacheStatistics)contentsCacheStatistics;
+
 #if TARGET_OS_TV
 /** 
  * A bool to track if the current appearance of the node
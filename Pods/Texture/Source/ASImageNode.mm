@@ -18,6 +18,7 @@
 #import <AsyncDisplayKit/ASImageNode.h>
 
 #import <tgmath.h>
+#import <atomic>
 
 #import <AsyncDisplayKit/_ASDisplayLayer.h>
 #import <AsyncDisplayKit/ASAssert.h>
@@ -70,6 +71,41 @@ typedef void (^ASImageNodeDrawParametersBlock)(ASWeakMapEntry *entry);
 
 @end
 
+/**
+ * Contents being rendered by one node, which other nodes with an equal key wait for.
+ */
+@interface ASImageNodeContentsRendering : NSObject {
+@package
+  // Entered while rendering.
+  dispatch_group_t _group;
+  // Set before leaving the group. nil if the rendering was cancelled.
+  ASWeakMapEntry *_entry;
+}
+
+@end
+
+@implementation ASImageNodeContentsRendering
+
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _group = dispatch_group_create();
+  }
+  return self;
+}
+
+@end
+
+static const NSUInteger kImageDrawLockCount = 16;
+// Allocated on the heap to prevent destruction at app exit, like cacheLock below.
+static ASDN::StaticMutex *imageDrawLocks = new ASDN::StaticMutex[kImageDrawLockCount];
+
+static ASDN::StaticMutex& ASImageNodeDrawLockForImage(UIImage *image)
+{
+  uintptr_t address = (uintptr_t)image.CGImage;
+  return imageDrawLocks[((address >> 4) ^ (address >> 12)) % kImageDrawLockCount];
+}
+
 /**
  * Contains all data that is needed to generate the content bitmap.
  */
@@ -438,31 +474,81 @@ typedef void (^ASImageNodeDrawParametersBlock)(ASWeakMapEntry *entry);
 }
 
 static ASWeakMap<ASImageNodeContentsKey *, UIImage *> *cache = nil;
+// Contents being rendered, which nodes with an equal key wait for rather than render them too.
+static NSMapTable<ASImageNodeContentsKey *, ASImageNodeContentsRendering *> *renderings = nil;
 // Allocate cacheLock on the heap to prevent destruction at app exit (https://github.com/TextureGroup/Texture/issues/136)
 static ASDN::StaticMutex& cacheLock = *new ASDN::StaticMutex;
 
+static std::atomic<NSUInteger> cacheHits;
+static std::atomic<NSUInteger> cacheMisses;
+static std::atomic<NSUInteger> cacheCoalesced;
+
++ (ASImageNodeContentsCacheStatistics)contentsCacheStatistics
+{
+  return (ASImageNodeContentsCacheStatistics){ cacheHits.load(), cacheMisses.load(), cacheCoalesced.load() };
+}
+
 + (ASWeakMapEntry *)contentsForkey:(ASImageNodeContentsKey *)key drawParameters:(id)drawParameters isCancelled:(asdisplaynode_iscancelled_block_t)isCancelled
 {
-  {
-    ASDN::StaticMutexLocker l(cacheLock);
-    if (!cache) {
-      cache = [[ASWeakMap alloc] init];
+  // Blocking the main thread on a background render could invert priorities, so it renders by itself.
+  BOOL canWait = !ASDisplayNodeThreadIsMain();
+  
+  while (YES) {
+    ASImageNodeContentsRendering *rendering = nil;
+    BOOL isRenderer = NO;
+    {
+      ASDN::StaticMutexLocker l(cacheLock);
+      if (!cache) {
+        cache = [[ASWeakMap alloc] init];
+        renderings = [NSMapTable strongToStrongObjectsMapTable];
+      }
+      ASWeakMapEntry *entry = [cache entryForKey:key];
+      if (entry != nil) {
+        cacheHits++;
+        return entry;
+      }
+      
+      if (canWait) {
+        rendering = [renderings objectForKey:key];
+      }
+      if (rendering == nil) {
+        rendering = [[ASImageNodeContentsRendering alloc] init];
+        dispatch_group_enter(rendering->_group);
+        [renderings setObject:rendering forKey:key];
+        isRenderer = YES;
+      }
     }
-    ASWeakMapEntry *entry = [cache entryForKey:key];
-    if (entry != nil) {
+    
+    if (isRenderer) {
+      // cache miss
+      cacheMisses++;
+      UIImage *contents = [self createContentsForkey:key drawParameters:drawParameters isCancelled:isCancelled];
+      
+      ASWeakMapEntry *entry = nil;
+      {
+        ASDN::StaticMutexLocker l(cacheLock);
+        if (contents != nil) { // If nil, we were cancelled
+          entry = [cache setObject:contents forKey:key];
+        }
+        rendering->_entry = entry;
+        if ([renderings objectForKey:key] == rendering) {
+          [renderings removeObjectForKey:key];
+        }
+      }
+      dispatch_group_leave(rendering->_group);
       return entry;
     }
-  }
-
-  // cache miss
-  UIImage *contents = [self createContentsForkey:key drawParameters:drawParameters isCancelled:isCancelled];
-  if (contents == nil) { // If nil, we were cancelled
-    return nil;
-  }
-
-  {
-    ASDN::StaticMutexLocker l(cacheLock);
-    return [cache setObject:contents forKey:key];
+    
+    dispatch_group_wait(rendering->_group, DISPATCH_TIME_FOREVER);
+    if (rendering->_entry != nil) {
+      cacheCoalesced++;
+      return rendering->_entry;
+    }
+    
+    // The node rendering the contents was cancelled, try again unless we were cancelled too.
+    if (isCancelled()) {
+      return nil;
+    }
   }
 }
 
@@ -500,17 +586,17 @@ static ASDN::StaticMutex& cacheLock = *new ASDN::StaticMutex;
   // as well as iOS games, and a small number of ASDK apps that provide the same image reference
   // to many separate ASImageNodes.  A workaround is to set .displaysAsynchronously = NO for the nodes
   // that may get the same pointer for a given UI asset image, etc.
-  // FIXME: We should replace @synchronized here, probably using a global, locked NSMutableSet, and
-  // only if the object already exists in the set we should create a semaphore to signal waiting threads
-  // upon removal of the object from the set when the operation completes.
-  // Another option is to have ASDisplayNode+AsyncDisplay coordinate these cases, and share the decoded buffer.
+  // Nodes with equal keys share one rendering (see +contentsForkey:drawParameters:isCancelled:), and draws of
+  // the same CGImageRef at different sizes are serialized by a lock striped by image, so that different images
+  // still draw in parallel.
   // Details tracked in https://github.com/facebook/AsyncDisplayKit/issues/1068
   
   UIImage *image = key.image;
   BOOL canUseCopy = (contextIsClean || ASImageAlphaInfoIsOpaque(CGImageGetAlphaInfo(image.CGImage)));
   CGBlendMode blendMode = canUseCopy ? kCGBlendModeCopy : kCGBlendModeNormal;
   
-  @synchronized(image) {
+  {
+    ASDN::StaticMutexLocker l(ASImageNodeDrawLockForImage(image));
     [image drawInRect:key.imageDrawRect blendMode:blendMode alpha:1];
   }
   
@@ -112,6 +112,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property BOOL shouldCacheImage;
 
+/**
+ * If the downloader supports it, set this property to YES to have images decoded at the size of the node's bounds
+ * in pixels, rather than at their full resolution, for the ScaleAspectFill, ScaleAspectFit and ScaleToFill content
+ * modes. Saves memory and decoding time when images are much larger than the node. The bounds are read when the
+ * download starts: images aren't downloaded again if the node grows, and are decoded at full size if the node hasn't
+ * been laid out yet. Defaults to NO.
+ */
+@property BOOL shouldDownsampleImageToBounds;
+
 /**
  * If the downloader implements progressive image rendering and this value is YES progressive renders of the
  * image will be displayed as the image downloads. Regardless of this properties value, progress renders will
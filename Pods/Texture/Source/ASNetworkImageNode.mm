@@ -16,6 +16,7 @@
 //
 
 #import <AsyncDisplayKit/ASNetworkImageNode.h>
+#import <AsyncDisplayKit/ASAdaptiveRangeTuner.h>
 
 #import <AsyncDisplayKit/ASAvailability.h>
 #import <AsyncDisplayKit/ASBasicImageDownloader.h>
@@ -31,6 +32,7 @@
 #import <AsyncDisplayKit/ASNetworkImageLoadInfo+Private.h>
 
 #import <atomic>
+#import <tgmath.h>
 
 #if AS_PIN_REMOTE_IMAGE
 #import <AsyncDisplayKit/ASPINRemoteImageDownloader.h>
@@ -71,6 +73,7 @@
     unsigned int downloaderImplementsSetPriority:1;
     unsigned int downloaderImplementsAnimatedImage:1;
     unsigned int downloaderImplementsCancelWithResume:1;
+    unsigned int downloaderImplementsDownloadWithTargetSize:1;
   } _downloaderFlags;
 
   // Immutable and set on init only. We don't need to lock in this case.
@@ -99,6 +102,7 @@
   _downloaderFlags.downloaderImplementsSetPriority = [downloader respondsToSelector:@selector(setPriority:withDownloadIdentifier:)];
   _downloaderFlags.downloaderImplementsAnimatedImage = [downloader respondsToSelector:@selector(animatedImageWithData:)];
   _downloaderFlags.downloaderImplementsCancelWithResume = [downloader respondsToSelector:@selector(cancelImageDownloadWithResumePossibilityForIdentifier:)];
+  _downloaderFlags.downloaderImplementsDownloadWithTargetSize = [downloader respondsToSelector:@selector(downloadImageWithURL:targetSize:contentMode:callbackQueue:downloadProgress:completion:)];
 
   _cacheFlags.cacheSupportsClearing = [cache respondsToSelector:@selector(clearFetchedImageFromCacheWithURL:)];
   _cacheFlags.cacheSupportsSynchronousFetch = [cache respondsToSelector:@selector(synchronouslyFetchedCachedImageWithURL:)];
@@ -549,7 +553,26 @@
   _cacheSentinel++;
 }
 
-- (void)_downloadImageWithCompletion:(void (^)(id <ASImageContainerProtocol> imageContainer, NSError*, id downloadIdentifier, id userInfo))finished
+/**
+ * The pixel size to downsample the image to, or CGSizeZero for the full image. contentMode is a view property,
+ * so call this on the main thread and hand the results to the download.
+ */
+- (CGSize)_downloadTargetSizeWithContentMode:(UIViewContentMode *)contentMode
+{
+  ASDisplayNodeAssertMainThread();
+  *contentMode = self.contentMode;
+
+  if (!ASLockedSelf(_shouldDownsampleImageToBounds && _downloaderFlags.downloaderImplementsDownloadWithTargetSize)) {
+    return CGSizeZero;
+  }
+  CGSize boundsSize = self.threadSafeBounds.size;
+  CGFloat contentsScale = self.contentsScaleForDisplay;
+  return CGSizeMake(std::ceil(boundsSize.width * contentsScale), std::ceil(boundsSize.height * contentsScale));
+}
+
+- (void)_downloadImageWithTargetSize:(CGSize)targetSize
+                         contentMode:(UIViewContentMode)contentMode
+                          completion:(void (^)(id <ASImageContainerProtocol> imageContainer, NSError*, id downloadIdentifier, id userInfo))finished
 {
   ASPerformBlockOnBackgroundThread(^{
     NSURL *url;
@@ -564,15 +587,25 @@
       url = _URL;
     }
 
-
-    downloadIdentifier = [_downloader downloadImageWithURL:url
-                                             callbackQueue:[self callbackQueue]
-                                          downloadProgress:NULL
-                                                completion:^(id <ASImageContainerProtocol> _Nullable imageContainer, NSError * _Nullable error, id  _Nullable downloadIdentifier, id _Nullable userInfo) {
-                                                  if (finished != NULL) {
-                                                    finished(imageContainer, error, downloadIdentifier, userInfo);
-                                                  }
-                                                }];
+    ASImageDownloaderCompletion completion = ^(id <ASImageContainerProtocol> _Nullable imageContainer, NSError * _Nullable error, id  _Nullable downloadIdentifier, id _Nullable userInfo) {
+      if (finished != NULL) {
+        finished(imageContainer, error, downloadIdentifier, userInfo);
+      }
+    };
+
+    if (targetSize.width > 0 && targetSize.height > 0) {
+      downloadIdentifier = [_downloader downloadImageWithURL:url
+                                                  targetSize:targetSize
+                                                 contentMode:contentMode
+                                               callbackQueue:[self callbackQueue]
+                                            downloadProgress:NULL
+                                                  completion:completion];
+    } else {
+      downloadIdentifier = [_downloader downloadImageWithURL:url
+                                               callbackQueue:[self callbackQueue]
+                                            downloadProgress:NULL
+                                                  completion:completion];
+    }
     as_log_verbose(ASImageLoadingLog(), "Downloading image for %@ url: %@", self, url);
   
     {
@@ -592,7 +625,7 @@
         as_log_verbose(ASImageLoadingLog(), "Canceling image download no resume for %@ id: %@", self, downloadIdentifier);
         [_downloader cancelImageDownloadForIdentifier:downloadIdentifier];
       }
-      [self _downloadImageWithCompletion:finished];
+      [self _downloadImageWithTargetSize:targetSize contentMode:contentMode completion:finished];
       return;
     }
     
@@ -674,6 +707,10 @@
       });
     } else {
       __weak __typeof__(self) weakSelf = self;
+      // Only set if preload latencies are recorded.
+      CFTimeInterval loadStartTime = ASActivateExperimentalFeature(ASExperimentalAdaptiveRangeTuning) ? CACurrentMediaTime() : 0;
+      UIViewContentMode contentMode;
+      CGSize targetSize = [self _downloadTargetSizeWithContentMode:&contentMode];
       auto finished = ^(id <ASImageContainerProtocol>imageContainer, NSError *error, id downloadIdentifier, ASNetworkImageSourceType imageSource, id userInfo) {
         ASPerformBlockOnBackgroundThread(^{
           __typeof__(self) strongSelf = weakSelf;
@@ -710,6 +747,9 @@
               [strongSelf _locked__setImage:newImage];
             }
             strongSelf->_imageLoaded = YES;
+            if (loadStartTime > 0) {
+              [ASAdaptiveRangeTuner recordPreloadLatency:CACurrentMediaTime() - loadStartTime];
+            }
           }
           
           strongSelf->_downloadIdentifier = nil;
@@ -758,7 +798,7 @@
           }
           
           if ([imageContainer asdk_image] == nil && _downloader != nil) {
-            [self _downloadImageWithCompletion:^(id<ASImageContainerProtocol> imageContainer, NSError *error, id downloadIdentifier, id userInfo) {
+            [self _downloadImageWithTargetSize:targetSize contentMode:contentMode completion:^(id<ASImageContainerProtocol> imageContainer, NSError *error, id downloadIdentifier, id userInfo) {
               finished(imageContainer, error, downloadIdentifier, ASNetworkImageSourceDownload, userInfo);
             }];
           } else {
@@ -770,7 +810,7 @@
                      callbackQueue:[self callbackQueue]
                         completion:completion];
       } else {
-        [self _downloadImageWithCompletion:^(id<ASImageContainerProtocol> imageContainer, NSError *error, id downloadIdentifier, id userInfo) {
+        [self _downloadImageWithTargetSize:targetSize contentMode:contentMode completion:^(id<ASImageContainerProtocol> imageContainer, NSError *error, id downloadIdentifier, id userInfo) {
           finished(imageContainer, error, downloadIdentifier, ASNetworkImageSourceDownload, userInfo);
         }];
       }
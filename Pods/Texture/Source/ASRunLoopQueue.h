@@ -27,6 +27,9 @@ NS_ASSUME_NONNULL_BEGIN
 @interface ASAbstractRunLoopQueue : NSObject
 @end
 
+/// Half a 60 Hz frame: a time budget for main thread queues that leaves the rest of the frame to UIKit.
+extern NSTimeInterval const ASRunLoopQueueMainThreadTimeBudget;
+
 AS_SUBCLASSING_RESTRICTED
 @interface ASRunLoopQueue<ObjectType> : ASAbstractRunLoopQueue <NSLocking>
 
@@ -53,6 +56,22 @@ AS_SUBCLASSING_RESTRICTED
 @property (nonatomic) NSUInteger batchSize;           // Default == 1.
 @property (nonatomic) BOOL ensureExclusiveMembership; // Default == YES.  Set-like behavior.
 
+/**
+ * The longest time the handler may run for in one run loop turn. Default == 0, no limit.
+ *
+ * @discussion Objects left over when the budget runs out stay at the front of the queue and are
+ * processed on the next turn. Combine with a large @c batchSize to process as much as fits in the budget.
+ * Without a handler, the budget limits how long the queue spends releasing objects.
+ */
+@property (nonatomic) NSTimeInterval timeBudget;
+
+/**
+ * Enqueuing never blocks. The lock is only held by the queue while it releases processed objects,
+ * so holding it while enqueuing guarantees the queue doesn't release an object before you do.
+ */
+- (void)lock;
+- (void)unlock;
+
 @end
 
 AS_SUBCLASSING_RESTRICTED
@@ -23,8 +23,11 @@
 #import <AsyncDisplayKit/ASThread.h>
 #import <AsyncDisplayKit/ASSignpost.h>
 #import <QuartzCore/QuartzCore.h>
+#import <atomic>
 #import <cstdlib>
 #import <deque>
+#import <unordered_map>
+#import <unordered_set>
 #import <vector>
 
 #define ASRunLoopQueueLoggingEnabled 0
@@ -251,7 +254,6 @@ static void runLoopSourceCallback(void *info) {
 
 @end
 
-#if AS_KDEBUG_ENABLE
 /**
  * This is real, private CA API. Valid as of iOS 10.
  */
@@ -265,7 +267,6 @@ typedef enum {
 + (void)addCommitHandler:(void(^)(void))block forPhase:(CATransactionPhase)phase;
 + (int)currentState;
 @end
-#endif
 
 #pragma mark - ASAbstractRunLoopQueue
 
@@ -290,9 +291,22 @@ typedef enum {
 {
   [self registerCATransactionObservers];
 }
+#endif
+
+// Whether observers are registered for the next CATransaction commit. Main thread only.
+static BOOL catransactionObserversRegistered;
 
+/**
+ * Registers observers for the layout and commit phases of the next CATransaction, which register again
+ * once it has committed, for as long as kdebug signposts are emitted or the trace recorder is enabled.
+ */
 + (void)registerCATransactionObservers
 {
+  ASDisplayNodeAssertMainThread();
+  if (catransactionObserversRegistered) {
+    return;
+  }
+
   static BOOL privateCAMethodsExist;
   static dispatch_block_t preLayoutHandler;
   static dispatch_block_t preCommitHandler;
@@ -314,10 +328,13 @@ typedef enum {
     };
     postCommitHandler = ^{
       ASSignpostEndCustom(ASSignpostCATransactionCommit, 0, [CATransaction currentState], ASSignpostColorDefault);
-      // Can't add new observers inside an observer. rdar://problem/31253952
-      dispatch_async(dispatch_get_main_queue(), ^{
-        [self registerCATransactionObservers];
-      });
+      catransactionObserversRegistered = NO;
+      if (AS_KDEBUG_ENABLE || ASTraceRecorderIsEnabled()) {
+        // Can't add new observers inside an observer. rdar://problem/31253952
+        dispatch_async(dispatch_get_main_queue(), ^{
+          [self registerCATransactionObservers];
+        });
+      }
     };
   });
 
@@ -325,21 +342,171 @@ typedef enum {
     [CATransaction addCommitHandler:preLayoutHandler forPhase:kCATransactionPhasePreLayout];
     [CATransaction addCommitHandler:preCommitHandler forPhase:kCATransactionPhasePreCommit];
     [CATransaction addCommitHandler:postCommitHandler forPhase:kCATransactionPhasePostCommit];
+    catransactionObserversRegistered = YES;
   }
 }
 
-#endif // AS_KDEBUG_ENABLE
-
 @end
 
+#pragma mark - ASRunLoopQueueNode
+
+namespace {
+
+/**
+ * One enqueued object. Nodes are allocated by the enqueuing thread and freed by the thread that drives the queue.
+ * Exactly one of strongObject and weakObject is set, depending on whether the queue retains its objects.
+ */
+struct ASRunLoopQueueNode {
+  ASRunLoopQueueNode *next;
+  id strongObject;
+  __weak id weakObject;
+  // The address of the object at enqueue time, used for membership checks after a weak object is gone.
+  const void *key;
+
+  ASRunLoopQueueNode(id object, BOOL retainsObject) : next(NULL), key((__bridge const void *)object) {
+    if (retainsObject) {
+      strongObject = object;
+    } else {
+      weakObject = object;
+    }
+  }
+
+  id object() const
+  {
+    return strongObject ?: weakObject;
+  }
+};
+
+/**
+ * An intrusive multi-producer, single-consumer list of nodes.
+ *
+ * Producers push onto a lock-free stack. The consumer takes the whole stack with one atomic exchange and reverses
+ * it, so a single pass drains everything enqueued since the last one, in FIFO order, without a lock.
+ */
+class ASRunLoopQueueIncomingList {
+public:
+  ASRunLoopQueueIncomingList() : _head(NULL) {}
+
+  ~ASRunLoopQueueIncomingList()
+  {
+    ASRunLoopQueueNode *node = _head.exchange(NULL, std::memory_order_acquire);
+    while (node != NULL) {
+      ASRunLoopQueueNode *next = node->next;
+      delete node;
+      node = next;
+    }
+  }
+
+  /// Safe to call from any thread. Returns true if the list was empty.
+  bool push(ASRunLoopQueueNode *node)
+  {
+    ASRunLoopQueueNode *head = _head.load(std::memory_order_relaxed);
+    do {
+      node->next = head;
+    } while (!_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    return head == NULL;
+  }
+
+  /// Consumer only. Returns the oldest node, linked in enqueue order, or NULL.
+  ASRunLoopQueueNode *popAll()
+  {
+    ASRunLoopQueueNode *node = _head.exchange(NULL, std::memory_order_acquire);
+    ASRunLoopQueueNode *reversed = NULL;
+    while (node != NULL) {
+      ASRunLoopQueueNode *next = node->next;
+      node->next = reversed;
+      reversed = node;
+      node = next;
+    }
+    return reversed;
+  }
+
+  bool isEmpty() const
+  {
+    return _head.load(std::memory_order_acquire) == NULL;
+  }
+
+private:
+  std::atomic<ASRunLoopQueueNode *> _head;
+};
+
+/**
+ * The nodes the consumer has taken from its incoming list but not processed yet. Only touched by the consumer,
+ * so membership checks are a hash lookup instead of a scan under a lock shared with producers.
+ */
+class ASRunLoopQueuePendingList {
+public:
+  ~ASRunLoopQueuePendingList()
+  {
+    for (ASRunLoopQueueNode *node : _nodes) {
+      delete node;
+    }
+  }
+
+  /**
+   * Appends the node. If exclusive is true and a live node for the same object is already pending, the node
+   * is not appended and false is returned; the caller owns it.
+   */
+  bool append(ASRunLoopQueueNode *node, bool exclusive)
+  {
+    if (exclusive) {
+      auto result = _index.emplace(node->key, node);
+      if (!result.second) {
+        // A weak node whose object is gone may share its address with a new object. Only live nodes count.
+        if (result.first->second->object() != nil) {
+          return false;
+        }
+        result.first->second = node;
+      }
+    }
+    _nodes.push_back(node);
+    return true;
+  }
+
+  ASRunLoopQueueNode *popFront()
+  {
+    ASRunLoopQueueNode *node = _nodes.front();
+    _nodes.pop_front();
+    auto it = _index.find(node->key);
+    if (it != _index.end() && it->second == node) {
+      _index.erase(it);
+    }
+    return node;
+  }
+
+  /// Puts back nodes that were popped but not processed, so they keep their place at the front.
+  void pushFront(ASRunLoopQueueNode *node, bool exclusive)
+  {
+    if (exclusive) {
+      _index[node->key] = node;
+    }
+    _nodes.push_front(node);
+  }
+
+  bool isEmpty() const
+  {
+    return _nodes.empty();
+  }
+
+private:
+  std::deque<ASRunLoopQueueNode *> _nodes;
+  std::unordered_map<const void *, ASRunLoopQueueNode *> _index;
+};
+
+} // namespace
+
 #pragma mark - ASRunLoopQueue
 
 @interface ASRunLoopQueue () {
   CFRunLoopRef _runLoop;
   CFRunLoopSourceRef _runLoopSource;
   CFRunLoopObserverRef _runLoopObserver;
-  NSPointerArray *_internalQueue; // Use NSPointerArray so we can decide __strong or __weak per-instance.
-  ASDN::RecursiveMutex _internalQueueLock;
+  BOOL _retainsObjects;
+  ASRunLoopQueueIncomingList _incoming; // Written by any thread.
+  ASRunLoopQueuePendingList _pending;   // Only touched on the run loop's thread.
+  std::atomic<NSUInteger> _count;
+  // Held while processed objects are released. See -lock.
+  ASDN::RecursiveMutex _releaseLock;
 
   // In order to not pollute the top-level activities, each queue has 1 root activity.
   os_activity_t _rootActivity;
@@ -353,14 +520,16 @@ typedef enum {
 
 @end
 
+NSTimeInterval const ASRunLoopQueueMainThreadTimeBudget = 1.0 / 120.0;
+
 @implementation ASRunLoopQueue
 
 - (instancetype)initWithRunLoop:(CFRunLoopRef)runloop retainObjects:(BOOL)retainsObjects handler:(void (^)(id _Nullable, BOOL))handlerBlock
 {
   if (self = [super init]) {
     _runLoop = runloop;
-    NSPointerFunctionsOptions options = retainsObjects ? NSPointerFunctionsStrongMemory : NSPointerFunctionsWeakMemory;
-    _internalQueue = [[NSPointerArray alloc] initWithOptions:options];
+    _retainsObjects = retainsObjects;
+    _count = 0;
     _queueConsumer = handlerBlock;
     _batchSize = 1;
     _ensureExclusiveMembership = YES;
@@ -419,85 +588,90 @@ typedef enum {
 #if ASRunLoopQueueLoggingEnabled
 - (void)checkRunLoop
 {
-    NSLog(@"<%@> - Jobs: %ld", self, _internalQueue.size());
+    NSLog(@"<%@> - Jobs: %lu", self, (unsigned long)_count.load());
 }
 #endif
 
 - (void)processQueue
 {
-  BOOL hasExecutionBlock = (_queueConsumer != nil);
+  BOOL exclusive = _ensureExclusiveMembership;
 
-  // If we have an execution block, this vector will be populated, otherwise remains empty.
-  // This is to avoid needlessly retaining/releasing the objects if we don't have a block.
-  std::vector<id> itemsToProcess;
-
-  BOOL isQueueDrained = NO;
-  {
-    ASDN::MutexLocker l(_internalQueueLock);
-
-    NSInteger internalQueueCount = _internalQueue.count;
-    // Early-exit if the queue is empty.
-    if (internalQueueCount == 0) {
-      return;
+  // Move everything enqueued since the last pass behind the objects that are still pending.
+  for (ASRunLoopQueueNode *node = _incoming.popAll(); node != NULL; ) {
+    ASRunLoopQueueNode *next = node->next;
+    if (!_pending.append(node, exclusive)) {
+      delete node;
+      _count.fetch_sub(1, std::memory_order_relaxed);
     }
+    node = next;
+  }
 
-    ASSignpostStart(ASSignpostRunLoopQueueBatch);
-
-    // Snatch the next batch of items.
-    NSInteger maxCountToProcess = MIN(internalQueueCount, self.batchSize);
-
-    /**
-     * For each item in the next batch, if it's non-nil then NULL it out
-     * and if we have an execution block then add it in.
-     * This could be written a bunch of different ways but
-     * this particular one nicely balances readability, safety, and efficiency.
-     */
-    NSInteger foundItemCount = 0;
-    for (NSInteger i = 0; i < internalQueueCount && foundItemCount < maxCountToProcess; i++) {
-      /**
-       * It is safe to use unsafe_unretained here. If the queue is weak, the
-       * object will be added to the autorelease pool. If the queue is strong,
-       * it will retain the object until we transfer it (retain it) in itemsToProcess.
-       */
-      __unsafe_unretained id ptr = (__bridge id)[_internalQueue pointerAtIndex:i];
-      if (ptr != nil) {
-        foundItemCount++;
-        if (hasExecutionBlock) {
-          itemsToProcess.push_back(ptr);
-        }
-        [_internalQueue replacePointerAtIndex:i withPointer:NULL];
-      }
-    }
+  // Early-exit if the queue is empty.
+  if (_pending.isEmpty()) {
+    return;
+  }
 
-    if (foundItemCount == 0) {
-      // If _internalQueue holds weak references, and all of them just become NULL, then the array
-      // is never marked as needsCompletion, and compact will return early, not removing the NULL's.
-      // Inserting a NULL here ensures the compaction will take place.
-      // See http://www.openradar.me/15396578 and https://stackoverflow.com/a/40274426/1136669
-      [_internalQueue addPointer:NULL];
-    }
+  ASSignpostStart(ASSignpostRunLoopQueueBatch);
 
-    [_internalQueue compact];
-    if (_internalQueue.count == 0) {
-      isQueueDrained = YES;
+  // Snatch the next batch of items, skipping weak objects that have gone away.
+  // The vector keeps the objects alive while the handler runs.
+  std::vector<ASRunLoopQueueNode *> batch;
+  std::vector<id> itemsToProcess;
+  NSUInteger skippedItemCount = 0;
+  while (batch.size() < _batchSize && !_pending.isEmpty()) {
+    ASRunLoopQueueNode *node = _pending.popFront();
+    id object = node->object();
+    if (object == nil) {
+      delete node;
+      skippedItemCount++;
+    } else {
+      batch.push_back(node);
+      itemsToProcess.push_back(object);
     }
   }
+  BOOL isQueueDrained = _pending.isEmpty() && _incoming.isEmpty();
 
-  // itemsToProcess will be empty if _queueConsumer == nil so no need to check again.
-  auto count = itemsToProcess.size();
-  if (count > 0) {
+  // Stop early if the time budget runs out, leaving the rest of the batch at the front of the queue.
+  CFTimeInterval deadline = _timeBudget > 0 ? CACurrentMediaTime() + _timeBudget : 0;
+  size_t processedCount = batch.size();
+  if (_queueConsumer != nil && processedCount > 0) {
     as_activity_scope_verbose(as_activity_create("Process run loop queue batch", _rootActivity, OS_ACTIVITY_FLAG_DEFAULT));
-    auto itemsEnd = itemsToProcess.cend();
-    for (auto iterator = itemsToProcess.begin(); iterator < itemsEnd; iterator++) {
-      __unsafe_unretained id value = *iterator;
-      _queueConsumer(value, isQueueDrained && iterator == itemsEnd - 1);
+    for (size_t i = 0; i < batch.size(); i++) {
+      __unsafe_unretained id value = itemsToProcess[i];
+      _queueConsumer(value, isQueueDrained && i == batch.size() - 1);
       as_log_verbose(ASDisplayLog(), "processed %@", value);
+      if (deadline > 0 && i + 1 < batch.size() && CACurrentMediaTime() >= deadline) {
+        processedCount = i + 1;
+        isQueueDrained = NO;
+        break;
+      }
     }
-    if (count > 1) {
-      as_log_verbose(ASDisplayLog(), "processed %lu items", (unsigned long)count);
+    if (processedCount > 1) {
+      as_log_verbose(ASDisplayLog(), "processed %lu items", (unsigned long)processedCount);
     }
   }
 
+  {
+    // Release the processed objects under the lock, see -lock.
+    // Without a handler releasing is the work, so that is what the budget limits.
+    ASDN::MutexLocker l(_releaseLock);
+    BOOL releaseWithinBudget = (_queueConsumer == nil && deadline > 0);
+    for (size_t i = 0; i < processedCount; i++) {
+      itemsToProcess[i] = nil;
+      delete batch[i];
+      if (releaseWithinBudget && i + 1 < processedCount && CACurrentMediaTime() >= deadline) {
+        processedCount = i + 1;
+        isQueueDrained = NO;
+        break;
+      }
+    }
+    itemsToProcess.clear();
+  }
+  for (size_t i = batch.size(); i > processedCount; i--) {
+    _pending.pushFront(batch[i - 1], exclusive);
+  }
+  _count.fetch_sub(processedCount + skippedItemCount, std::memory_order_relaxed);
+
   // If the queue is not fully drained yet force another run loop to process next batch of items
   if (!isQueueDrained) {
     CFRunLoopSourceSignal(_runLoopSource);
@@ -512,24 +686,11 @@ typedef enum {
   if (!object) {
     return;
   }
-  
-  ASDN::MutexLocker l(_internalQueueLock);
-
-  // Check if the object exists.
-  BOOL foundObject = NO;
-    
-  if (_ensureExclusiveMembership) {
-    for (id currentObject in _internalQueue) {
-      if (currentObject == object) {
-        foundObject = YES;
-        break;
-      }
-    }
-  }
-
-  if (!foundObject) {
-    [_internalQueue addPointer:(__bridge void *)object];
 
+  // Membership is checked when the run loop picks the object up, so enqueuing never takes a lock.
+  _count.fetch_add(1, std::memory_order_relaxed);
+  if (_incoming.push(new ASRunLoopQueueNode(object, _retainsObjects))) {
+    // Only the first object since the last pass needs to wake the run loop.
     CFRunLoopSourceSignal(_runLoopSource);
     CFRunLoopWakeUp(_runLoop);
   }
@@ -537,20 +698,19 @@ typedef enum {
 
 - (BOOL)isEmpty
 {
-  ASDN::MutexLocker l(_internalQueueLock);
-  return _internalQueue.count == 0;
+  return _count.load(std::memory_order_relaxed) == 0;
 }
 
 #pragma mark - NSLocking
 
 - (void)lock
 {
-  _internalQueueLock.lock();
+  _releaseLock.lock();
 }
 
 - (void)unlock
 {
-  _internalQueueLock.unlock();
+  _releaseLock.unlock();
 }
 
 @end
@@ -562,9 +722,9 @@ typedef enum {
   CFRunLoopSourceRef _runLoopSource;
   CFRunLoopObserverRef _preTransactionObserver;
   CFRunLoopObserverRef _postTransactionObserver;
-  NSPointerArray *_internalQueue;
-  ASDN::RecursiveMutex _internalQueueLock;
-  BOOL _CATransactionCommitInProgress;
+  ASRunLoopQueueIncomingList _incoming; // Written by any thread.
+  std::atomic<NSUInteger> _count;
+  std::atomic<bool> _CATransactionCommitInProgress;
 
   // In order to not pollute the top-level activities, each queue has 1 root activity.
   os_activity_t _rootActivity;
@@ -599,8 +759,8 @@ static int const kASASCATransactionQueuePostOrder = 3000000;
 {
   if (self = [super init]) {
     _runLoop = CFRunLoopGetMain();
-    NSPointerFunctionsOptions options = NSPointerFunctionsStrongMemory;
-    _internalQueue = [[NSPointerArray alloc] initWithOptions:options];
+    _count = 0;
+    _CATransactionCommitInProgress = false;
 
     // We don't want to pollute the top-level app activities with run loop batches, so we create one top-level
     // activity per queue, and each batch activity joins that one instead.
@@ -618,8 +778,7 @@ static int const kASASCATransactionQueuePostOrder = 3000000;
       [weakSelf processQueue];
     };
     void (^postHandlerBlock) (CFRunLoopObserverRef observer, CFRunLoopActivity activity) = ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
-      ASDN::MutexLocker l(_internalQueueLock);
-      _CATransactionCommitInProgress = NO;
+      weakSelf->_CATransactionCommitInProgress = false;
     };
     _preTransactionObserver = CFRunLoopObserverCreateWithHandler(NULL, kCFRunLoopBeforeWaiting, true, kASASCATransactionQueueOrder, handlerBlock);
     _postTransactionObserver = CFRunLoopObserverCreateWithHandler(NULL, kCFRunLoopBeforeWaiting, true, kASASCATransactionQueuePostOrder, postHandlerBlock);
@@ -666,69 +825,45 @@ static int const kASASCATransactionQueuePostOrder = 3000000;
 #if ASRunLoopQueueLoggingEnabled
 - (void)checkRunLoop
 {
-  NSLog(@"<%@> - Jobs: %ld", self, _internalQueue.size());
+  NSLog(@"<%@> - Jobs: %lu", self, (unsigned long)_count.load());
 }
 #endif
 
 - (void)processQueue
 {
-  // If we have an execution block, this vector will be populated, otherwise remains empty.
-  // This is to avoid needlessly retaining/releasing the objects if we don't have a block.
-  std::vector<id> itemsToProcess;
-
-  {
-    ASDN::MutexLocker l(_internalQueueLock);
-
-    // Mark the queue will end coalescing shortly until after CATransactionCommit.
-    // This will give the queue a chance to apply any further interfaceState changes/enqueue
-    // immediately within current runloop instead of pushing the work to next runloop cycle.
-    _CATransactionCommitInProgress = YES;
-
-    NSInteger internalQueueCount = _internalQueue.count;
-    // Early-exit if the queue is empty.
-    if (internalQueueCount == 0) {
-      return;
-    }
-
-    ASSignpostStart(ASSignpostRunLoopQueueBatch);
-
-    /**
-     * For each item in the next batch, if it's non-nil then NULL it out
-     * and if we have an execution block then add it in.
-     * This could be written a bunch of different ways but
-     * this particular one nicely balances readability, safety, and efficiency.
-     */
-    NSInteger foundItemCount = 0;
-    for (NSInteger i = 0; i < internalQueueCount && foundItemCount < internalQueueCount; i++) {
-      /**
-       * It is safe to use unsafe_unretained here. If the queue is weak, the
-       * object will be added to the autorelease pool. If the queue is strong,
-       * it will retain the object until we transfer it (retain it) in itemsToProcess.
-       */
-      __unsafe_unretained id ptr = (__bridge id)[_internalQueue pointerAtIndex:i];
-      if (ptr != nil) {
-        foundItemCount++;
-        itemsToProcess.push_back(ptr);
-        [_internalQueue replacePointerAtIndex:i withPointer:NULL];
-      }
-    }
+  // Mark the queue will end coalescing shortly until after CATransactionCommit.
+  // This will give the queue a chance to apply any further interfaceState changes/enqueue
+  // immediately within current runloop instead of pushing the work to next runloop cycle.
+  _CATransactionCommitInProgress = true;
 
-    [_internalQueue compact];
+  ASRunLoopQueueNode *node = _incoming.popAll();
+  // Early-exit if the queue is empty.
+  if (node == NULL) {
+    return;
   }
 
-  // itemsToProcess will be empty if _queueConsumer == nil so no need to check again.
-  auto count = itemsToProcess.size();
-  if (count > 0) {
-    as_activity_scope_verbose(as_activity_create("Process run loop queue batch", _rootActivity, OS_ACTIVITY_FLAG_DEFAULT));
-    auto itemsEnd = itemsToProcess.cend();
-    for (auto iterator = itemsToProcess.begin(); iterator < itemsEnd; iterator++) {
-      __unsafe_unretained id value = *iterator;
+  ASSignpostStart(ASSignpostRunLoopQueueBatch);
+
+  // Each object is only prepared once per commit, no matter how many times it was enqueued.
+  std::unordered_set<const void *> processedObjects;
+  NSUInteger count = 0;
+  NSUInteger nodeCount = 0;
+  as_activity_scope_verbose(as_activity_create("Process run loop queue batch", _rootActivity, OS_ACTIVITY_FLAG_DEFAULT));
+  while (node != NULL) {
+    ASRunLoopQueueNode *next = node->next;
+    if (processedObjects.insert(node->key).second) {
+      __unsafe_unretained id value = node->strongObject;
       [value prepareForCATransactionCommit];
       as_log_verbose(ASDisplayLog(), "processed %@", value);
+      count++;
     }
-    if (count > 1) {
-      as_log_verbose(ASDisplayLog(), "processed %lu items", (unsigned long)count);
-    }
+    delete node;
+    nodeCount++;
+    node = next;
+  }
+  _count.fetch_sub(nodeCount, std::memory_order_relaxed);
+  if (count > 1) {
+    as_log_verbose(ASDisplayLog(), "processed %lu items", (unsigned long)count);
   }
 
   ASSignpostEnd(ASSignpostRunLoopQueueBatch);
@@ -745,21 +880,9 @@ static int const kASASCATransactionQueuePostOrder = 3000000;
     return;
   }
 
-  ASDN::MutexLocker l(_internalQueueLock);
-
-  // Check if the object exists.
-  BOOL foundObject = NO;
-
-  for (id currentObject in _internalQueue) {
-    if (currentObject == object) {
-      foundObject = YES;
-      break;
-    }
-  }
-
-  if (!foundObject) {
-    [_internalQueue addPointer:(__bridge void *)object];
-
+  // Duplicates are skipped when the queue is processed, so enqueuing never takes a lock.
+  _count.fetch_add(1, std::memory_order_relaxed);
+  if (_incoming.push(new ASRunLoopQueueNode(object, YES))) {
     CFRunLoopSourceSignal(_runLoopSource);
     CFRunLoopWakeUp(_runLoop);
   }
@@ -767,8 +890,7 @@ static int const kASASCATransactionQueuePostOrder = 3000000;
 
 - (BOOL)isEmpty
 {
-  ASDN::MutexLocker l(_internalQueueLock);
-  return _internalQueue.count == 0;
+  return _count.load(std::memory_order_relaxed) == 0;
 }
 
 - (BOOL)isEnabled
@@ -15,6 +15,17 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * Counters for the layout cache shared by all text nodes. Hits, misses and evictions are cumulative.
+ */
+typedef struct {
+  NSUInteger hits;
+  NSUInteger misses;
+  NSUInteger evictions;
+  NSUInteger count;     // Number of cached layouts.
+  NSUInteger totalCost; // Glyphs across all cached layouts.
+} ASTextNode2LayoutCacheStats;
+
 /**
  @abstract Draws interactive rich text.
  @discussion Backed by the code in TextExperiment folder, on top of CoreText.
@@ -211,6 +222,17 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (void)enableDebugging;
 
+/**
+ * A snapshot of the shared layout cache counters.
+ */
++ (ASTextNode2LayoutCacheStats)layoutCacheStats;
+
+/**
+ * The maximum total number of glyphs kept in the shared layout cache. Least recently used layouts are
+ * evicted beyond it. The cache is also purged on memory warnings.
+ */
+@property (class) NSUInteger layoutCacheCostLimit;
+
 @end
 
 @interface ASTextNode2 (Unavailable)
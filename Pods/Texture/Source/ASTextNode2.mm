@@ -14,7 +14,10 @@
 #import <AsyncDisplayKit/ASTextNode.h>  // Definition of ASTextNodeDelegate
 
 #import <tgmath.h>
-#import <deque>
+#import <atomic>
+#import <list>
+#import <memory>
+#import <unordered_map>
 
 #import <AsyncDisplayKit/_ASDisplayLayer.h>
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
@@ -33,14 +36,238 @@
 #import <AsyncDisplayKit/ASTextLayout.h>
 #import <AsyncDisplayKit/ASThread.h>
 
-@interface ASTextCacheValue : NSObject {
-  @package
-  ASDN::Mutex _m;
-  std::deque<std::tuple<CGSize, ASTextLayout *>> _layouts;
+/**
+ * Returns whether a layout computed for the given constrained size can be reused for the container.
+ */
+static BOOL ASTextLayoutIsCompatible(ASTextLayout *layout, CGSize constrainedSize, ASTextContainer *container)
+{
+  CGRect containerBounds = (CGRect){ .size = container.size };
+  CGSize layoutSize = layout.textBoundingSize;
+  // 1. CoreText can return frames that are narrower than the constrained width, for obvious reasons.
+  // 2. CoreText can return frames that are slightly wider than the constrained width, for some reason.
+  //    We have to trust that somehow it's OK to try and draw within our size constraint, despite the return value.
+  // 3. Thus, those two values (constrained width & returned width) form a range, where
+  //    intermediate values in that range will be snapped. Thus, we can use a given layout as long as our
+  //    width is in that range, between the min and max of those two values.
+  CGRect minRect = CGRectMake(0, 0, MIN(layoutSize.width, constrainedSize.width), MIN(layoutSize.height, constrainedSize.height));
+  if (!CGRectContainsRect(containerBounds, minRect)) {
+    return NO;
+  }
+  CGRect maxRect = CGRectMake(0, 0, MAX(layoutSize.width, constrainedSize.width), MAX(layoutSize.height, constrainedSize.height));
+  if (!CGRectContainsRect(maxRect, containerBounds)) {
+    return NO;
+  }
+  if (!CGSizeEqualToSize(container.size, constrainedSize)) {
+    return NO;
+  }
+
+  // Now check container params.
+  ASTextContainer *otherContainer = layout.container;
+  if (!UIEdgeInsetsEqualToEdgeInsets(container.insets, otherContainer.insets)) {
+    return NO;
+  }
+  if (!ASObjectIsEqual(container.exclusionPaths, otherContainer.exclusionPaths)) {
+    return NO;
+  }
+  if (container.maximumNumberOfRows != otherContainer.maximumNumberOfRows) {
+    return NO;
+  }
+  if (container.truncationType != otherContainer.truncationType) {
+    return NO;
+  }
+  if (!ASObjectIsEqual(container.truncationToken, otherContainer.truncationToken)) {
+    return NO;
+  }
+  return YES;
+}
+
+/**
+ * The cost of a layout in the cache is its glyph count.
+ */
+static NSUInteger ASTextLayoutCacheCost(ASTextLayout *layout)
+{
+  NSUInteger glyphCount = 0;
+  for (ASTextLine *line in layout.lines) {
+    glyphCount += CTLineGetGlyphCount(line.CTLine);
+  }
+  return MAX(glyphCount, (NSUInteger)1);
+}
+
+/**
+ * One stripe of the text layout cache. Holds an LRU list of layouts, indexed by the hash of their text.
+ * The cache is split into several of these so that text nodes laying out on different threads rarely
+ * contend for the same lock.
+ */
+class ASTextLayoutCacheShard {
+public:
+  ASTextLayout *find(ASTextContainer *container, NSAttributedString *text, NSUInteger textHash, bool recordStats = true)
+  {
+    ASDN::MutexLocker l(_mutex);
+    ASTextLayout *layout = _find(container, text, textHash);
+    if (!recordStats) {
+      return layout;
+    }
+    if (layout) {
+      _hits++;
+    } else {
+      _misses++;
+    }
+    return layout;
+  }
+
+  /**
+   * Returns a lock shared by all threads that lay out equal text at the same time, so that one of them
+   * computes the layout while the others wait for it to land in the cache. Pair with releaseFlight().
+   */
+  std::shared_ptr<ASDN::Mutex> acquireFlight(NSAttributedString *text, NSUInteger textHash)
+  {
+    ASDN::MutexLocker l(_mutex);
+    auto range = _flights.equal_range(textHash);
+    for (auto it = range.first; it != range.second; it++) {
+      if (it->second.text == text || [it->second.text isEqualToAttributedString:text]) {
+        it->second.waiters++;
+        return it->second.mutex;
+      }
+    }
+    return _flights.emplace(textHash, Flight{text, std::make_shared<ASDN::Mutex>(), 1})->second.mutex;
+  }
+
+  void releaseFlight(const std::shared_ptr<ASDN::Mutex> &mutex, NSUInteger textHash)
+  {
+    ASDN::MutexLocker l(_mutex);
+    auto range = _flights.equal_range(textHash);
+    for (auto it = range.first; it != range.second; it++) {
+      if (it->second.mutex == mutex) {
+        if (--it->second.waiters == 0) {
+          _flights.erase(it);
+        }
+        break;
+      }
+    }
+  }
+
+  /**
+   * Inserts the layout and returns it, unless another thread has inserted a compatible layout in the meantime,
+   * in which case that one is returned and the new one is dropped.
+   */
+  ASTextLayout *insert(ASTextContainer *container, NSAttributedString *text, NSUInteger textHash, ASTextLayout *layout, NSUInteger costLimit)
+  {
+    NSUInteger cost = ASTextLayoutCacheCost(layout);
+    ASDN::MutexLocker l(_mutex);
+    if (ASTextLayout *existing = _find(container, text, textHash)) {
+      return existing;
+    }
+
+    _entries.push_front({text, textHash, container.size, layout, cost});
+    _index.emplace(textHash, _entries.begin());
+    _totalCost += cost;
+
+    // Evict least recently used layouts until we fit, but always keep the one we just added.
+    while (_totalCost > costLimit && _entries.size() > 1) {
+      _evict(--_entries.end());
+    }
+    return layout;
+  }
+
+  void removeAll()
+  {
+    ASDN::MutexLocker l(_mutex);
+    _evictions += _entries.size();
+    _index.clear();
+    _entries.clear();
+    _totalCost = 0;
+  }
+
+  void addStats(ASTextNode2LayoutCacheStats &stats)
+  {
+    ASDN::MutexLocker l(_mutex);
+    stats.hits += _hits;
+    stats.misses += _misses;
+    stats.evictions += _evictions;
+    stats.count += _entries.size();
+    stats.totalCost += _totalCost;
+  }
+
+private:
+  struct Entry {
+    NSAttributedString *text;
+    NSUInteger textHash;
+    CGSize constrainedSize;
+    ASTextLayout *layout;
+    NSUInteger cost;
+  };
+  typedef std::list<Entry>::iterator EntryIterator;
+
+  struct Flight {
+    NSAttributedString *text;
+    std::shared_ptr<ASDN::Mutex> mutex;
+    NSUInteger waiters;
+  };
+
+  // Assumes locked mutex. Moves the hit to the front of the list.
+  ASTextLayout *_find(ASTextContainer *container, NSAttributedString *text, NSUInteger textHash)
+  {
+    auto range = _index.equal_range(textHash);
+    for (auto it = range.first; it != range.second; it++) {
+      EntryIterator entry = it->second;
+      if (!ASTextLayoutIsCompatible(entry->layout, entry->constrainedSize, container)) {
+        continue;
+      }
+      if (entry->text != text && ![entry->text isEqualToAttributedString:text]) {
+        continue;
+      }
+      _entries.splice(_entries.begin(), _entries, entry);
+      return entry->layout;
+    }
+    return nil;
+  }
+
+  // Assumes locked mutex.
+  void _evict(EntryIterator entry)
+  {
+    auto range = _index.equal_range(entry->textHash);
+    for (auto it = range.first; it != range.second; it++) {
+      if (it->second == entry) {
+        _index.erase(it);
+        break;
+      }
+    }
+    _totalCost -= entry->cost;
+    _entries.erase(entry);
+    _evictions++;
+  }
+
+  ASDN::Mutex _mutex;
+  std::list<Entry> _entries; // Most recently used first.
+  std::unordered_multimap<NSUInteger, EntryIterator> _index;
+  std::unordered_multimap<NSUInteger, Flight> _flights; // Layouts being computed, by text hash.
+  NSUInteger _totalCost = 0;
+  NSUInteger _hits = 0;
+  NSUInteger _misses = 0;
+  NSUInteger _evictions = 0;
+};
+
+static const NSUInteger ASTextLayoutCacheShardCount = 16;
+
+// The default cost limit, in glyphs, shared across all shards.
+static std::atomic<NSUInteger> ASTextLayoutCacheCostLimit(500000);
+
+static ASTextLayoutCacheShard *ASTextLayoutCacheGetShards()
+{
+  // Allocate the shards on the heap to prevent destruction at app exit (https://github.com/TextureGroup/Texture/issues/136)
+  static ASTextLayoutCacheShard *shards;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    shards = new ASTextLayoutCacheShard[ASTextLayoutCacheShardCount];
+    // The NSCache we used to use got purged under memory pressure. Keep doing that.
+    [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification object:nil queue:nil usingBlock:^(NSNotification * _Nonnull note) {
+      for (NSUInteger i = 0; i < ASTextLayoutCacheShardCount; i++) {
+        shards[i].removeAll();
+      }
+    }];
+  });
+  return shards;
 }
-@end
-@implementation ASTextCacheValue
-@end
 
 /**
  * If set, we will record all values set to attributedText into an array
@@ -384,87 +611,49 @@ static NSArray *DefaultLinkAttributeNames = @[ NSLinkAttributeName ];
                                            text:(NSAttributedString *)text NS_RETURNS_RETAINED
 
 {
-  // Allocate layoutCacheLock on the heap to prevent destruction at app exit (https://github.com/TextureGroup/Texture/issues/136)
-  static ASDN::StaticMutex& layoutCacheLock = *new ASDN::StaticMutex;
-  static NSCache<NSAttributedString *, ASTextCacheValue *> *textLayoutCache;
-  static dispatch_once_t onceToken;
-  dispatch_once(&onceToken, ^{
-    textLayoutCache = [[NSCache alloc] init];
-  });
-
-  layoutCacheLock.lock();
-
-  ASTextCacheValue *cacheValue = [textLayoutCache objectForKey:text];
-  if (cacheValue == nil) {
-    cacheValue = [[ASTextCacheValue alloc] init];
-    [textLayoutCache setObject:cacheValue forKey:[text copy]];
+  NSUInteger textHash = text.hash;
+  ASTextLayoutCacheShard &shard = ASTextLayoutCacheGetShards()[textHash % ASTextLayoutCacheShardCount];
+  if (ASTextLayout *layout = shard.find(container, text, textHash)) {
+    return layout;
   }
 
-  // Lock the cache item for the rest of the method. Only after acquiring can we release the NSCache.
-  ASDN::MutexLocker lock(cacheValue->_m);
-  layoutCacheLock.unlock();
-
-  CGRect containerBounds = (CGRect){ .size = container.size };
+  // Cache Miss. Compute the text layout outside of the shard lock, but only once for equal text:
+  // threads that miss on the same text at the same time wait for the first one, then look again.
+  std::shared_ptr<ASDN::Mutex> flight = shard.acquireFlight(text, textHash);
+  ASTextLayout *layout;
   {
-    for (auto &t : cacheValue->_layouts) {
-      CGSize constrainedSize = std::get<0>(t);
-      ASTextLayout *layout = std::get<1>(t);
-
-      CGSize layoutSize = layout.textBoundingSize;
-      // 1. CoreText can return frames that are narrower than the constrained width, for obvious reasons.
-      // 2. CoreText can return frames that are slightly wider than the constrained width, for some reason.
-      //    We have to trust that somehow it's OK to try and draw within our size constraint, despite the return value.
-      // 3. Thus, those two values (constrained width & returned width) form a range, where
-      //    intermediate values in that range will be snapped. Thus, we can use a given layout as long as our
-      //    width is in that range, between the min and max of those two values.
-      CGRect minRect = CGRectMake(0, 0, MIN(layoutSize.width, constrainedSize.width), MIN(layoutSize.height, constrainedSize.height));
-      if (!CGRectContainsRect(containerBounds, minRect)) {
-        continue;
-      }
-      CGRect maxRect = CGRectMake(0, 0, MAX(layoutSize.width, constrainedSize.width), MAX(layoutSize.height, constrainedSize.height));
-      if (!CGRectContainsRect(maxRect, containerBounds)) {
-        continue;
-      }
-      if (!CGSizeEqualToSize(container.size, constrainedSize)) {
-        continue;
-      }
-
-      // Now check container params.
-      ASTextContainer *otherContainer = layout.container;
-      if (!UIEdgeInsetsEqualToEdgeInsets(container.insets, otherContainer.insets)) {
-        continue;
-      }
-      if (!ASObjectIsEqual(container.exclusionPaths, otherContainer.exclusionPaths)) {
-        continue;
-      }
-      if (container.maximumNumberOfRows != otherContainer.maximumNumberOfRows) {
-        continue;
-      }
-      if (container.truncationType != otherContainer.truncationType) {
-        continue;
-      }
-      if (!ASObjectIsEqual(container.truncationToken, otherContainer.truncationToken)) {
-        continue;
-      }
-      // TODO: When we get a cache hit, move this entry to the front (LRU).
-      return layout;
+    ASDN::MutexLocker l(*flight);
+    layout = shard.find(container, text, textHash, false);
+    if (layout == nil) {
+      layout = [ASTextLayout layoutWithContainer:container text:text];
+
+      // Store the result in the cache. If another thread raced us to it, use their layout instead.
+      NSUInteger shardCostLimit = ASTextLayoutCacheCostLimit.load() / ASTextLayoutCacheShardCount;
+      layout = shard.insert(container, [text copy], textHash, layout, shardCostLimit);
     }
   }
+  shard.releaseFlight(flight, textHash);
+  return layout;
+}
 
-  // Cache Miss. Compute the text layout.
-  ASTextLayout *layout = [ASTextLayout layoutWithContainer:container text:text];
-
-  // Store the result in the cache.
-  {
-    // This is a critical section. However we also must hold the lock until this point, in case
-    // another thread requests this cache item while a layout is being calculated, so they don't race.
-    cacheValue->_layouts.push_front(std::make_tuple(container.size, layout));
-    if (cacheValue->_layouts.size() > 3) {
-      cacheValue->_layouts.pop_back();
-    }
++ (ASTextNode2LayoutCacheStats)layoutCacheStats
+{
+  ASTextNode2LayoutCacheStats stats = {};
+  ASTextLayoutCacheShard *shards = ASTextLayoutCacheGetShards();
+  for (NSUInteger i = 0; i < ASTextLayoutCacheShardCount; i++) {
+    shards[i].addStats(stats);
   }
+  return stats;
+}
 
-  return layout;
++ (NSUInteger)layoutCacheCostLimit
+{
+  return ASTextLayoutCacheCostLimit.load();
+}
+
++ (void)setLayoutCacheCostLimit:(NSUInteger)layoutCacheCostLimit
+{
+  ASTextLayoutCacheCostLimit.store(layoutCacheCostLimit);
 }
 
 + (void)drawRect:(CGRect)bounds withParameters:(NSDictionary *)layoutDict isCancelled:(asdisplaynode_iscancelled_block_t)isCancelledBlock isRasterizing:(BOOL)isRasterizing
@@ -10,6 +10,8 @@
 //      http://www.apache.org/licenses/LICENSE-2.0
 //
 
+#import <AsyncDisplayKit/ASTraceRecorder.h>
+
 /// The signposts we use. Signposts are grouped by color. The SystemTrace.tracetemplate file
 /// should be kept up-to-date with these values.
 typedef NS_ENUM(uint32_t, ASSignpostName) {
@@ -73,26 +75,40 @@ static inline ASSignpostColor ASSignpostGetColor(ASSignpostName name, ASSignpost
 #endif
 
 // Currently we'll reserve arg3.
-#define ASSignpost(name, identifier, arg2, color) \
+#define ASSignpostKdebug(name, identifier, arg2, color) \
 AS_AT_LEAST_IOS10 ? kdebug_signpost(name, (uintptr_t)identifier, (uintptr_t)arg2, 0, ASSignpostGetColor(name, color)) \
 : syscall(SYS_kdebug_trace, APPSDBG_CODE(DBG_MACH_CHUD, name) | DBG_FUNC_NONE, (uintptr_t)identifier, (uintptr_t)arg2, 0, ASSignpostGetColor(name, color));
 
-#define ASSignpostStartCustom(name, identifier, arg2) \
+#define ASSignpostStartKdebug(name, identifier, arg2) \
 AS_AT_LEAST_IOS10 ? kdebug_signpost_start(name, (uintptr_t)identifier, (uintptr_t)arg2, 0, 0) \
 : syscall(SYS_kdebug_trace, APPSDBG_CODE(DBG_MACH_CHUD, name) | DBG_FUNC_START, (uintptr_t)identifier, (uintptr_t)arg2, 0, 0);
-#define ASSignpostStart(name) ASSignpostStartCustom(name, self, 0)
 
-#define ASSignpostEndCustom(name, identifier, arg2, color) \
+#define ASSignpostEndKdebug(name, identifier, arg2, color) \
 AS_AT_LEAST_IOS10 ? kdebug_signpost_end(name, (uintptr_t)identifier, (uintptr_t)arg2, 0, ASSignpostGetColor(name, color)) \
 : syscall(SYS_kdebug_trace, APPSDBG_CODE(DBG_MACH_CHUD, name) | DBG_FUNC_END, (uintptr_t)identifier, (uintptr_t)arg2, 0, ASSignpostGetColor(name, color));
-#define ASSignpostEnd(name) ASSignpostEndCustom(name, self, 0, ASSignpostColorDefault)
 
 #else
 
-#define ASSignpost(name, identifier, arg2, color)
-#define ASSignpostStartCustom(name, identifier, arg2)
-#define ASSignpostStart(name)
-#define ASSignpostEndCustom(name, identifier, arg2, color)
-#define ASSignpostEnd(name)
+#define ASSignpostKdebug(name, identifier, arg2, color)
+#define ASSignpostStartKdebug(name, identifier, arg2)
+#define ASSignpostEndKdebug(name, identifier, arg2, color)
 
 #endif
+
+// The trace recorder is compiled into all builds. While it is disabled, it does not evaluate the arguments.
+#define ASSignpost(name, identifier, arg2, color) do { \
+  if (ASTraceRecorderIsEnabled()) { ASTraceRecorderMark(name, (uintptr_t)arg2, color); } \
+  ASSignpostKdebug(name, identifier, arg2, color) \
+} while (0)
+
+#define ASSignpostStartCustom(name, identifier, arg2) do { \
+  if (ASTraceRecorderIsEnabled()) { ASTraceRecorderBegin(name, (uintptr_t)identifier, (uintptr_t)arg2); } \
+  ASSignpostStartKdebug(name, identifier, arg2) \
+} while (0)
+#define ASSignpostStart(name) ASSignpostStartCustom(name, self, 0)
+
+#define ASSignpostEndCustom(name, identifier, arg2, color) do { \
+  if (ASTraceRecorderIsEnabled()) { ASTraceRecorderEnd(name, (uintptr_t)identifier, (uintptr_t)arg2, color); } \
+  ASSignpostEndKdebug(name, identifier, arg2, color) \
+} while (0)
+#define ASSignpostEnd(name) ASSignpostEndCustom(name, self, 0, ASSignpostColorDefault)
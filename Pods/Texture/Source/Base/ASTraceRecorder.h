@@ -0,0 +1,81 @@
+//
+//  ASTraceRecorder.h
+//  Texture
+//
+//  Copyright (c) 2017-present, Pinterest, Inc.  All rights reserved.
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <Foundation/Foundation.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+ASDISPLAYNODE_EXTERN_C_BEGIN
+
+/**
+ * One interval recorded by the trace recorder. Instantaneous events have equal begin and end times.
+ */
+typedef struct {
+  /// The ASSignpostName of the interval.
+  uint32_t name;
+  /// The ASSignpostColor the interval ended with.
+  uint32_t color;
+  /// The system-wide ID of the thread the interval ended on.
+  uint64_t thread;
+  /// Uptime in nanoseconds.
+  uint64_t beginTime;
+  uint64_t endTime;
+  /// The arguments the interval began and ended with, e.g. the number of objects of a dealloc queue drain.
+  uint64_t beginArg;
+  uint64_t endArg;
+} ASTraceRecord;
+
+/**
+ * The trace recorder keeps the latest intervals marked by the ASSignpost macros in memory, in all builds,
+ * so they can be inspected outside of Instruments, e.g. after a scripted scroll session on a test device.
+ *
+ * Each thread records into its own ring buffer of 2048 records without taking locks. When a buffer is full,
+ * its oldest records are overwritten. Intervals must begin and end on the same thread, and intervals that
+ * begin more than 16 levels deep are dropped.
+ *
+ * Recording is disabled by default. While disabled, the signpost macros only cost a load and a branch.
+ */
+void ASTraceRecorderSetEnabled(BOOL enabled);
+
+/**
+ * Discards all recorded intervals.
+ */
+void ASTraceRecorderReset(void);
+
+/**
+ * Returns the recorded intervals of all threads in the Chrome trace event format, which chrome://tracing
+ * and Perfetto can open.
+ */
+NSData *ASTraceRecorderCopyChromeTrace(void);
+
+/**
+ * Returns the recorded intervals of all threads in a compact binary format: the bytes "ASTR", then the
+ * format version, the size of a record and the number of records as 32-bit integers, then the ASTraceRecord
+ * structs, all in the byte order of the device.
+ */
+NSData *ASTraceRecorderCopyBinaryTrace(void);
+
+// Called by the ASSignpost macros. Check ASTraceRecorderIsEnabled() first.
+void ASTraceRecorderBegin(uint32_t name, uintptr_t identifier, uintptr_t arg);
+void ASTraceRecorderEnd(uint32_t name, uintptr_t identifier, uintptr_t arg, uintptr_t color);
+void ASTraceRecorderMark(uint32_t name, uintptr_t arg, uintptr_t color);
+
+extern BOOL _ASTraceRecorderEnabled;
+
+ASDISPLAYNODE_INLINE BOOL ASTraceRecorderIsEnabled(void) {
+  return __atomic_load_n(&_ASTraceRecorderEnabled, __ATOMIC_RELAXED);
+}
+
+ASDISPLAYNODE_EXTERN_C_END
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,278 @@
+//
+//  ASTraceRecorder.mm
+//  Texture
+//
+//  Copyright (c) 2017-present, Pinterest, Inc.  All rights reserved.
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASTraceRecorder.h>
+
+#import <AsyncDisplayKit/ASRunLoopQueue.h>
+#import <AsyncDisplayKit/ASSignpost.h>
+#import <AsyncDisplayKit/ASThread.h>
+
+#import <mach/mach_time.h>
+#import <pthread.h>
+#import <unistd.h>
+
+#import <algorithm>
+#import <atomic>
+#import <string>
+#import <vector>
+
+// Must be a power of two.
+static const uint64_t kRingCapacity = 2048;
+static const NSUInteger kMaximumDepth = 16;
+static const uint32_t kBinaryTraceVersion = 1;
+
+BOOL _ASTraceRecorderEnabled = NO;
+
+static mach_timebase_info_data_t timebase;
+
+@interface ASAbstractRunLoopQueue (ASTraceRecorder)
++ (void)registerCATransactionObservers;
+@end
+
+typedef struct {
+  uint32_t name;
+  uintptr_t identifier;
+  uint64_t beginTime;
+  uint64_t beginArg;
+} ASTracePendingInterval;
+
+/**
+ * Written only by the thread it belongs to. Readers copy the records and drop the ones the writer may have
+ * overwritten in the meantime.
+ */
+struct ASTraceThreadBuffer {
+  ASTraceRecord records[kRingCapacity];
+  std::atomic<uint64_t> writeCount;
+  // Positions below this were discarded by ASTraceRecorderReset().
+  std::atomic<uint64_t> discardCount;
+
+  ASTracePendingInterval pending[kMaximumDepth];
+  NSUInteger depth;
+  uint64_t thread;
+  // Protected by buffersLock. Buffers of exited threads are kept for their records and reused by new threads.
+  bool inUse;
+};
+
+static ASDN::StaticMutex& buffersLock = *new ASDN::StaticMutex;
+static std::vector<ASTraceThreadBuffer *>& buffers = *new std::vector<ASTraceThreadBuffer *>;
+static pthread_key_t threadExitKey;
+static _Thread_local ASTraceThreadBuffer *tls_buffer;
+
+static void ASTraceRecorderThreadDidExit(void *buffer)
+{
+  ASDN::StaticMutexLocker l(buffersLock);
+  static_cast<ASTraceThreadBuffer *>(buffer)->inUse = false;
+}
+
+static ASTraceThreadBuffer *ASTraceRecorderGetThreadBuffer()
+{
+  if (tls_buffer != NULL) {
+    return tls_buffer;
+  }
+
+  ASTraceThreadBuffer *buffer = NULL;
+  {
+    ASDN::StaticMutexLocker l(buffersLock);
+    for (ASTraceThreadBuffer *b : buffers) {
+      if (!b->inUse) {
+        buffer = b;
+        break;
+      }
+    }
+    if (buffer == NULL) {
+      buffer = new ASTraceThreadBuffer();
+      buffers.push_back(buffer);
+    }
+    buffer->inUse = true;
+  }
+
+  buffer->depth = 0;
+  pthread_threadid_np(NULL, &buffer->thread);
+  pthread_setspecific(threadExitKey, buffer);
+  tls_buffer = buffer;
+  return buffer;
+}
+
+ASDISPLAYNODE_INLINE uint64_t ASTraceRecorderNow()
+{
+  return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+
+static void ASTraceRecorderAppend(ASTraceThreadBuffer *buffer, const ASTraceRecord &record)
+{
+  uint64_t position = buffer->writeCount.load(std::memory_order_relaxed);
+  buffer->records[position & (kRingCapacity - 1)] = record;
+  buffer->writeCount.store(position + 1, std::memory_order_release);
+}
+
+void ASTraceRecorderSetEnabled(BOOL enabled)
+{
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    mach_timebase_info(&timebase);
+    pthread_key_create(&threadExitKey, ASTraceRecorderThreadDidExit);
+  });
+  __atomic_store_n(&_ASTraceRecorderEnabled, enabled, __ATOMIC_RELEASE);
+
+  if (enabled) {
+    // Record the layout and commit phases of CATransactions, which are only observed while recording.
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [ASAbstractRunLoopQueue registerCATransactionObservers];
+    });
+  }
+}
+
+void ASTraceRecorderBegin(uint32_t name, uintptr_t identifier, uintptr_t arg)
+{
+  ASTraceThreadBuffer *buffer = ASTraceRecorderGetThreadBuffer();
+  if (buffer->depth == kMaximumDepth) {
+    // Drop the oldest interval, which is most likely one whose end was skipped.
+    std::move(buffer->pending + 1, buffer->pending + kMaximumDepth, buffer->pending);
+    buffer->depth--;
+  }
+  buffer->pending[buffer->depth++] = { name, identifier, ASTraceRecorderNow(), arg };
+}
+
+void ASTraceRecorderEnd(uint32_t name, uintptr_t identifier, uintptr_t arg, uintptr_t color)
+{
+  ASTraceThreadBuffer *buffer = ASTraceRecorderGetThreadBuffer();
+  // Search from the top, so that intervals whose end was skipped, e.g. by an early return, are dropped.
+  NSUInteger i = buffer->depth;
+  while (i > 0 && (buffer->pending[i - 1].name != name || buffer->pending[i - 1].identifier != identifier)) {
+    i--;
+  }
+  if (i == 0) {
+    // Began before recording was enabled, on another thread, or was dropped.
+    return;
+  }
+
+  const ASTracePendingInterval &interval = buffer->pending[i - 1];
+  ASTraceRecord record = {
+    name, (uint32_t)ASSignpostGetColor((ASSignpostName)name, (ASSignpostColor)color), buffer->thread,
+    interval.beginTime, ASTraceRecorderNow(), interval.beginArg, arg
+  };
+  buffer->depth = i - 1;
+  ASTraceRecorderAppend(buffer, record);
+}
+
+void ASTraceRecorderMark(uint32_t name, uintptr_t arg, uintptr_t color)
+{
+  ASTraceThreadBuffer *buffer = ASTraceRecorderGetThreadBuffer();
+  uint64_t now = ASTraceRecorderNow();
+  ASTraceRecord record = {
+    name, (uint32_t)ASSignpostGetColor((ASSignpostName)name, (ASSignpostColor)color), buffer->thread,
+    now, now, arg, arg
+  };
+  ASTraceRecorderAppend(buffer, record);
+}
+
+void ASTraceRecorderReset()
+{
+  ASDN::StaticMutexLocker l(buffersLock);
+  for (ASTraceThreadBuffer *buffer : buffers) {
+    buffer->discardCount.store(buffer->writeCount.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
+
+/// Copies the records of all threads, sorted by begin time.
+static std::vector<ASTraceRecord> ASTraceRecorderCopyRecords()
+{
+  std::vector<ASTraceRecord> records;
+  ASDN::StaticMutexLocker l(buffersLock);
+  for (ASTraceThreadBuffer *buffer : buffers) {
+    uint64_t end = buffer->writeCount.load(std::memory_order_acquire);
+    uint64_t start = std::max(end > kRingCapacity ? end - kRingCapacity : 0, buffer->discardCount.load(std::memory_order_relaxed));
+    size_t offset = records.size();
+    for (uint64_t position = start; position < end; position++) {
+      records.push_back(buffer->records[position & (kRingCapacity - 1)]);
+    }
+
+    // The writer may have reused the slots of the oldest records while they were copied, and may be
+    // writing the slot after the last one it published.
+    uint64_t after = buffer->writeCount.load(std::memory_order_acquire);
+    if (after + 1 > start + kRingCapacity) {
+      uint64_t overwritten = std::min(after + 1 - kRingCapacity - start, end - start);
+      records.erase(records.begin() + offset, records.begin() + offset + overwritten);
+    }
+  }
+  std::sort(records.begin(), records.end(), [](const ASTraceRecord &a, const ASTraceRecord &b) {
+    return a.beginTime < b.beginTime;
+  });
+  return records;
+}
+
+static const char *ASTraceRecorderNameString(uint32_t name)
+{
+  switch ((ASSignpostName)name) {
+    case ASSignpostDataControllerBatch:
+      return "DataControllerBatch";
+    case ASSignpostRangeControllerUpdate:
+      return "RangeControllerUpdate";
+    case ASSignpostCollectionUpdate:
+      return "CollectionUpdate";
+    case ASSignpostLayerDisplay:
+      return "LayerDisplay";
+    case ASSignpostRunLoopQueueBatch:
+      return "RunLoopQueueBatch";
+    case ASSignpostCalculateLayout:
+      return "CalculateLayout";
+    case ASSignpostDeallocQueueDrain:
+      return "DeallocQueueDrain";
+    case ASSignpostCATransactionLayout:
+      return "CATransactionLayout";
+    case ASSignpostCATransactionCommit:
+      return "CATransactionCommit";
+  }
+  return NULL;
+}
+
+NSData *ASTraceRecorderCopyChromeTrace()
+{
+  std::vector<ASTraceRecord> records = ASTraceRecorderCopyRecords();
+  const int pid = getpid();
+  const char *colorNames[] = { "Blue", "Green", "Purple", "Orange", "Red" };
+
+  std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  char event[384];
+  for (size_t i = 0; i < records.size(); i++) {
+    const ASTraceRecord &record = records[i];
+    const char *name = ASTraceRecorderNameString(record.name);
+    char unknownName[24];
+    if (name == NULL) {
+      snprintf(unknownName, sizeof(unknownName), "ASSignpost%u", record.name);
+      name = unknownName;
+    }
+    const char *color = record.color < ASSignpostColorDefault ? colorNames[record.color] : "Default";
+    // Timestamps are in microseconds.
+    snprintf(event, sizeof(event),
+             "%s{\"name\":\"%s\",\"cat\":\"Texture\",\"ph\":\"X\",\"pid\":%d,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f,"
+             "\"args\":{\"beginArg\":%llu,\"endArg\":%llu,\"color\":\"%s\"}}",
+             i == 0 ? "" : ",", name, pid, (unsigned long long)record.thread,
+             record.beginTime / 1000.0, (record.endTime - record.beginTime) / 1000.0,
+             (unsigned long long)record.beginArg, (unsigned long long)record.endArg, color);
+    json += event;
+  }
+  json += "]}";
+  return [NSData dataWithBytes:json.data() length:json.size()];
+}
+
+NSData *ASTraceRecorderCopyBinaryTrace()
+{
+  std::vector<ASTraceRecord> records = ASTraceRecorderCopyRecords();
+  const uint32_t header[] = { kBinaryTraceVersion, (uint32_t)sizeof(ASTraceRecord), (uint32_t)records.size() };
+
+  NSMutableData *data = [NSMutableData dataWithCapacity:4 + sizeof(header) + records.size() * sizeof(ASTraceRecord)];
+  [data appendBytes:"ASTR" length:4];
+  [data appendBytes:header length:sizeof(header)];
+  [data appendBytes:records.data() length:records.size() * sizeof(ASTraceRecord)];
+  return data;
+}
@@ -20,6 +20,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class ASAdaptiveRangeTuner;
+
 ASDISPLAYNODE_EXTERN_C_BEGIN
 
 FOUNDATION_EXPORT ASDirectionalScreenfulBuffer ASDirectionalScreenfulBufferHorizontal(ASScrollDirection scrollDirection, ASRangeTuningParameters rangeTuningParameters);
@@ -32,6 +34,20 @@ ASDISPLAYNODE_EXTERN_C_END
 
 @interface ASAbstractLayoutController : NSObject <ASLayoutController>
 
+/**
+ * Sizes the ranges of the full range mode from the scrolling if the exp_adaptive_range_tuning experiment is enabled.
+ */
+@property (nonatomic, readonly, nullable) ASAdaptiveRangeTuner *adaptiveTuner;
+
+/**
+ * For subclasses. Returns the tuning parameters to expand the visible bounds by, which differ from the configured
+ * ones in the full range mode if there is an adaptive tuner.
+ */
+- (ASRangeTuningParameters)tuningParametersForRangeMode:(ASLayoutRangeMode)rangeMode
+                                              rangeType:(ASLayoutRangeType)rangeType
+                                                 bounds:(CGRect)bounds
+                                   scrollableDirections:(ASScrollDirection)scrollableDirections;
+
 @end
 
 @interface ASAbstractLayoutController (Unavailable)
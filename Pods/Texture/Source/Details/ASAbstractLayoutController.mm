@@ -17,7 +17,9 @@
 
 #import <AsyncDisplayKit/ASAbstractLayoutController.h>
 
+#import <AsyncDisplayKit/ASAdaptiveRangeTuner.h>
 #import <AsyncDisplayKit/ASAssert.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 
 #include <vector>
 
@@ -145,6 +147,10 @@ extern CGRect CGRectExpandToRangeWithScrollableDirections(CGRect rect, ASRangeTu
     .trailingBufferScreenfuls = 0
   };
   
+  if (ASActivateExperimentalFeature(ASExperimentalAdaptiveRangeTuning)) {
+    _adaptiveTuner = [[ASAdaptiveRangeTuner alloc] init];
+  }
+  
   return self;
 }
 
@@ -172,6 +178,24 @@ extern CGRect CGRectExpandToRangeWithScrollableDirections(CGRect rect, ASRangeTu
   _tuningParameters[rangeMode][rangeType] = tuningParameters;
 }
 
+- (ASRangeTuningParameters)tuningParametersForRangeMode:(ASLayoutRangeMode)rangeMode
+                                              rangeType:(ASLayoutRangeType)rangeType
+                                                 bounds:(CGRect)bounds
+                                   scrollableDirections:(ASScrollDirection)scrollableDirections
+{
+  ASRangeTuningParameters tuningParameters = [self tuningParametersForRangeMode:rangeMode rangeType:rangeType];
+  if (_adaptiveTuner == nil) {
+    return tuningParameters;
+  }
+  
+  // Sample every range update, including those in other modes, to keep the velocity current.
+  [_adaptiveTuner recordViewportBounds:bounds scrollableDirections:scrollableDirections timestamp:CACurrentMediaTime()];
+  if (rangeMode != ASLayoutRangeModeFull) {
+    return tuningParameters;
+  }
+  return [_adaptiveTuner tuningParametersForBaseTuningParameters:tuningParameters rangeType:rangeType];
+}
+
 #pragma mark - Abstract Index Path Range Support
 
 - (NSHashTable<ASCollectionElement *> *)elementsForScrolling:(ASScrollDirection)scrollDirection rangeMode:(ASLayoutRangeMode)rangeMode rangeType:(ASLayoutRangeType)rangeType map:(ASElementMap *)map
@@ -0,0 +1,83 @@
+//
+//  ASAdaptiveRangeTuner.h
+//  Texture
+//
+//  Copyright (c) 2017-present, Pinterest, Inc.  All rights reserved.
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <QuartzCore/QuartzCore.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASLayoutRangeType.h>
+#import <AsyncDisplayKit/ASScrollDirection.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The inputs and the outcome of the latest decision of an adaptive range tuner.
+ */
+typedef struct {
+  /// Smoothed scroll velocity, in screenfuls per second.
+  CGFloat scrollVelocity;
+  /// Smoothed time from the start of a display transaction until its contents are ready.
+  CFTimeInterval displayLatency;
+  /// Smoothed time from the start of a network image load until its image is ready.
+  CFTimeInterval preloadLatency;
+  /// Fraction of the memory available to the app that is still free, from 0 to 1.
+  CGFloat memoryHeadroom;
+  ASRangeTuningParameters displayTuningParameters;
+  ASRangeTuningParameters preloadTuningParameters;
+} ASAdaptiveRangeTuningStatistics;
+
+/**
+ * Sizes the display and preload ranges of the full range mode from how fast the user scrolls, how long
+ * nodes take to display and preload, and how much memory is left.
+ *
+ * The ranges grow ahead of the scroll direction far enough to cover what scrolls into view while a node is
+ * being displayed or preloaded, up to four times the configured ranges when memory allows. They shrink below
+ * the configured ranges while the user reads slowly, and behind the scroll direction during flings.
+ *
+ * Enabled for all layout controllers by the exp_adaptive_range_tuning experiment. All inputs carry their
+ * timestamps, so a recorded scroll trace can be replayed into a tuner to evaluate its decisions.
+ */
+AS_SUBCLASSING_RESTRICTED
+@interface ASAdaptiveRangeTuner : NSObject
+
+/**
+ * Records how long a display transaction took. Shared by all tuners.
+ */
++ (void)recordDisplayLatency:(CFTimeInterval)latency;
+
+/**
+ * Records how long a network image took to load. Shared by all tuners.
+ */
++ (void)recordPreloadLatency:(CFTimeInterval)latency;
+
+/**
+ * Records the visible bounds of the scroll view at a point in time, to derive the scroll velocity from.
+ * Samples less than a few milliseconds apart are ignored, so this can be called for every range computed.
+ */
+- (void)recordViewportBounds:(CGRect)bounds scrollableDirections:(ASScrollDirection)scrollableDirections timestamp:(CFTimeInterval)timestamp;
+
+/**
+ * Returns the tuning parameters to use instead of the configured full range mode parameters for a range type.
+ */
+- (ASRangeTuningParameters)tuningParametersForBaseTuningParameters:(ASRangeTuningParameters)baseTuningParameters rangeType:(ASLayoutRangeType)rangeType;
+
+/**
+ * The inputs and the outcome of the latest decision of the receiver.
+ */
+@property (nonatomic, readonly) ASAdaptiveRangeTuningStatistics statistics;
+
+/**
+ * The statistics of the tuner that decided most recently, e.g. the one of the scroll view the user is scrolling.
+ */
++ (ASAdaptiveRangeTuningStatistics)latestStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
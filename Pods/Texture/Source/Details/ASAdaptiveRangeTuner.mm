@@ -0,0 +1,182 @@
+//
+//  ASAdaptiveRangeTuner.mm
+//  Texture
+//
+//  Copyright (c) 2017-present, Pinterest, Inc.  All rights reserved.
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASAdaptiveRangeTuner.h>
+
+#import <AsyncDisplayKit/ASThread.h>
+
+#import <mach/mach.h>
+#if __has_include(<os/proc.h>)
+#import <os/proc.h>
+#endif
+
+#import <cmath>
+
+// Samples closer together than this come from the same range update.
+static const CFTimeInterval kMinimumSampleInterval = 1.0 / 240.0;
+// Time constant of the scroll velocity smoothing.
+static const CFTimeInterval kVelocityTimeConstant = 0.15;
+// Weight of a new latency sample.
+static const double kLatencySmoothing = 0.1;
+// How often the memory headroom is sampled.
+static const CFTimeInterval kMemorySampleInterval = 1.0;
+
+// Leading buffers cover this many times the content that scrolls into view while a node displays or preloads.
+static const CGFloat kLatencySafetyFactor = 1.5;
+// Leading buffers grow up to this many times the configured buffers.
+static const CGFloat kMaximumGrowth = 4.0;
+// Below this velocity the user is reading, and leading buffers shrink to half the configured buffers.
+static const CGFloat kReadingVelocity = 0.25;
+// Above this velocity the user is flinging, and trailing buffers shrink to half the configured buffers.
+static const CGFloat kFlingVelocity = 2.0;
+// Between these headrooms, the growth of the leading buffers is limited linearly.
+static const CGFloat kLowMemoryHeadroom = 0.1;
+static const CGFloat kHighMemoryHeadroom = 0.4;
+
+static ASDN::StaticMutex& latencyLock = *new ASDN::StaticMutex;
+static CFTimeInterval displayLatency = 0;
+static CFTimeInterval preloadLatency = 0;
+static ASAdaptiveRangeTuningStatistics latestStatistics = {};
+
+static void ASAdaptiveRangeTunerRecordLatency(CFTimeInterval *smoothedLatency, CFTimeInterval latency)
+{
+  if (latency < 0) {
+    return;
+  }
+  ASDN::StaticMutexLocker l(latencyLock);
+  *smoothedLatency = (*smoothedLatency == 0) ? latency : *smoothedLatency + kLatencySmoothing * (latency - *smoothedLatency);
+}
+
+static CGFloat ASAdaptiveRangeTunerMemoryHeadroom()
+{
+#if __has_include(<os/proc.h>)
+  if (AS_AVAILABLE_IOS_TVOS(13, 13)) {
+    size_t available = os_proc_available_memory();
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    if (available > 0 && task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) == KERN_SUCCESS) {
+      return (CGFloat)available / (CGFloat)(available + info.phys_footprint);
+    }
+  }
+#endif
+  return 1.0;
+}
+
+@implementation ASAdaptiveRangeTuner
+{
+  CGRect _previousBounds;
+  CFTimeInterval _previousTimestamp;
+  CFTimeInterval _memoryTimestamp;
+  ASAdaptiveRangeTuningStatistics _statistics;
+}
+
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _previousBounds = CGRectNull;
+    _memoryTimestamp = -kMemorySampleInterval;
+    _statistics.memoryHeadroom = 1.0;
+  }
+  return self;
+}
+
++ (void)recordDisplayLatency:(CFTimeInterval)latency
+{
+  ASAdaptiveRangeTunerRecordLatency(&displayLatency, latency);
+}
+
++ (void)recordPreloadLatency:(CFTimeInterval)latency
+{
+  ASAdaptiveRangeTunerRecordLatency(&preloadLatency, latency);
+}
+
++ (ASAdaptiveRangeTuningStatistics)latestStatistics
+{
+  ASDN::StaticMutexLocker l(latencyLock);
+  return latestStatistics;
+}
+
+- (ASAdaptiveRangeTuningStatistics)statistics
+{
+  return _statistics;
+}
+
+- (void)recordViewportBounds:(CGRect)bounds scrollableDirections:(ASScrollDirection)scrollableDirections timestamp:(CFTimeInterval)timestamp
+{
+  if (CGRectIsNull(_previousBounds) || timestamp - _previousTimestamp > 1.0) {
+    // Nothing to compare with, or the scroll view has been idle.
+    _previousBounds = bounds;
+    _previousTimestamp = timestamp;
+    _statistics.scrollVelocity = 0;
+    return;
+  }
+
+  CFTimeInterval interval = timestamp - _previousTimestamp;
+  if (interval < kMinimumSampleInterval) {
+    return;
+  }
+
+  CGFloat velocity = 0;
+  if (ASScrollDirectionContainsHorizontalDirection(scrollableDirections) && bounds.size.width > 0) {
+    velocity = MAX(velocity, std::abs(bounds.origin.x - _previousBounds.origin.x) / bounds.size.width / interval);
+  }
+  if (ASScrollDirectionContainsVerticalDirection(scrollableDirections) && bounds.size.height > 0) {
+    velocity = MAX(velocity, std::abs(bounds.origin.y - _previousBounds.origin.y) / bounds.size.height / interval);
+  }
+
+  CGFloat weight = 1.0 - std::exp(-interval / kVelocityTimeConstant);
+  _statistics.scrollVelocity += weight * (velocity - _statistics.scrollVelocity);
+  _previousBounds = bounds;
+  _previousTimestamp = timestamp;
+
+  if (timestamp - _memoryTimestamp >= kMemorySampleInterval) {
+    _statistics.memoryHeadroom = ASAdaptiveRangeTunerMemoryHeadroom();
+    _memoryTimestamp = timestamp;
+  }
+}
+
+- (ASRangeTuningParameters)tuningParametersForBaseTuningParameters:(ASRangeTuningParameters)baseTuningParameters rangeType:(ASLayoutRangeType)rangeType
+{
+  CFTimeInterval latency;
+  {
+    ASDN::StaticMutexLocker l(latencyLock);
+    _statistics.displayLatency = displayLatency;
+    _statistics.preloadLatency = preloadLatency;
+    // Preloaded nodes still need to be displayed.
+    latency = (rangeType == ASLayoutRangeTypeDisplay) ? displayLatency : preloadLatency + displayLatency;
+  }
+
+  const CGFloat velocity = _statistics.scrollVelocity;
+  const CGFloat headroom = _statistics.memoryHeadroom;
+  const CGFloat growth = 1.0 + (kMaximumGrowth - 1.0) * MIN(MAX((headroom - kLowMemoryHeadroom) / (kHighMemoryHeadroom - kLowMemoryHeadroom), 0.0), 1.0);
+
+  ASRangeTuningParameters tuningParameters = baseTuningParameters;
+  CGFloat minimumLeading = baseTuningParameters.leadingBufferScreenfuls * (velocity < kReadingVelocity ? 0.5 : 1.0);
+  CGFloat maximumLeading = baseTuningParameters.leadingBufferScreenfuls * growth;
+  tuningParameters.leadingBufferScreenfuls = MIN(MAX(velocity * latency * kLatencySafetyFactor, minimumLeading), maximumLeading);
+  if (velocity > kFlingVelocity || headroom < kLowMemoryHeadroom) {
+    tuningParameters.trailingBufferScreenfuls = baseTuningParameters.trailingBufferScreenfuls * 0.5;
+  }
+
+  if (rangeType == ASLayoutRangeTypeDisplay) {
+    _statistics.displayTuningParameters = tuningParameters;
+  } else {
+    _statistics.preloadTuningParameters = tuningParameters;
+  }
+  {
+    ASDN::StaticMutexLocker l(latencyLock);
+    latestStatistics = _statistics;
+  }
+  return tuningParameters;
+}
+
+@end
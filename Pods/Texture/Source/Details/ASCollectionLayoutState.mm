@@ -21,10 +21,11 @@
 #import <AsyncDisplayKit/ASElementMap.h>
 #import <AsyncDisplayKit/ASLayout.h>
 #import <AsyncDisplayKit/ASLayoutSpecUtilities.h>
-#import <AsyncDisplayKit/ASPageTable.h>
+#import <AsyncDisplayKit/ASPageBucketIndex.h>
 #import <AsyncDisplayKit/ASThread.h>
 
 #import <queue>
+#import <vector>
 
 @implementation NSMapTable (ASCollectionLayoutConvenience)
 
@@ -35,13 +36,27 @@
 
 @end
 
+ASDISPLAYNODE_INLINE bool ASCollectionLayoutElementIsUnmeasured(ASCollectionElement *element, UICollectionViewLayoutAttributes *attrs)
+{
+  ASCellNode *node = element.nodeIfAllocated;
+  return (node == nil || CGSizeEqualToSize(node.calculatedSize, attrs.frame.size) == NO);
+}
+
 @implementation ASCollectionLayoutState {
   ASDN::Mutex __instanceLock__;
   CGSize _contentSize;
   ASCollectionLayoutContext *_context;
   NSMapTable<ASCollectionElement *, UICollectionViewLayoutAttributes *> *_elementToLayoutAttributesTable;
-  ASPageToLayoutAttributesTable *_pageToLayoutAttributesTable;
-  ASPageToLayoutAttributesTable *_unmeasuredPageToLayoutAttributesTable;
+  NSArray<UICollectionViewLayoutAttributes *> *_allLayoutAttributes;
+  NSArray<ASCollectionElement *> *_allElements; // In the same order as _allLayoutAttributes.
+  // The index is built on first use, so that it can be taken over from an earlier state instead.
+  // Protected by __instanceLock__, as are the frames waiting to be indexed.
+  ASPageBucketIndex _index;
+  std::vector<CGRect> _unindexedFrames;
+  BOOL _indexed;
+  // Whether the element of each layout attributes still has to be measured. Protected by __instanceLock__.
+  std::vector<bool> _unmeasured;
+  NSUInteger _unmeasuredCount;
 }
 
 - (instancetype)initWithContext:(ASCollectionLayoutContext *)context
@@ -110,13 +125,91 @@ elementToLayoutAttributesTable:[NSMapTable elementToLayoutAttributesTable]];
     _context = context;
     _contentSize = contentSize;
     _elementToLayoutAttributesTable = [table copy]; // Copy the given table to make sure clients can't mutate it after this point.
-    CGSize pageSize = context.viewportSize;
-    _pageToLayoutAttributesTable = [ASPageTable pageTableWithLayoutAttributes:table.objectEnumerator contentSize:contentSize pageSize:pageSize];
-    _unmeasuredPageToLayoutAttributesTable = [ASCollectionLayoutState _unmeasuredLayoutAttributesTableFromTable:table contentSize:contentSize pageSize:pageSize];
+
+    NSUInteger count = _elementToLayoutAttributesTable.count;
+    NSMutableArray<UICollectionViewLayoutAttributes *> *allLayoutAttributes = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray<ASCollectionElement *> *allElements = [NSMutableArray arrayWithCapacity:count];
+    _unindexedFrames.reserve(count);
+    _unmeasured.reserve(count);
+    for (ASCollectionElement *element in _elementToLayoutAttributesTable) {
+      UICollectionViewLayoutAttributes *attrs = [_elementToLayoutAttributesTable objectForKey:element];
+      [allLayoutAttributes addObject:attrs];
+      [allElements addObject:element];
+      _unindexedFrames.push_back(attrs.frame);
+      bool unmeasured = ASCollectionLayoutElementIsUnmeasured(element, attrs);
+      _unmeasured.push_back(unmeasured);
+      _unmeasuredCount += unmeasured;
+    }
+    _allLayoutAttributes = allLayoutAttributes;
+    _allElements = allElements;
   }
   return self;
 }
 
+- (const ASPageBucketIndex &)_locked_index
+{
+  if (!_indexed) {
+    _index.build(std::move(_unindexedFrames), _contentSize, _context.viewportSize);
+    _indexed = YES;
+  }
+  return _index;
+}
+
+- (void)updateIndexFromLayoutState:(ASCollectionLayoutState *)layoutState
+{
+  if (layoutState == nil || layoutState == self) {
+    return;
+  }
+
+  // Lock order is always the newer state, then the older one.
+  ASDN::MutexLocker l(__instanceLock__);
+  ASDN::MutexLocker previousLock(layoutState->__instanceLock__);
+  NSUInteger count = _allLayoutAttributes.count;
+  if (_indexed || !layoutState->_indexed || count == 0 || layoutState->_allElements.count != count
+      || !CGSizeEqualToSize(layoutState->_contentSize, _contentSize)
+      || !CGSizeEqualToSize(layoutState->_context.viewportSize, _context.viewportSize)) {
+    // The pages would differ, so there's nothing to take over.
+    return;
+  }
+
+  // Put the items in the order of the earlier state, so that its index describes the same items.
+  // Equal counts and every earlier element being present mean the elements are the same.
+  NSMutableArray<UICollectionViewLayoutAttributes *> *allLayoutAttributes = [NSMutableArray arrayWithCapacity:count];
+  std::vector<CGRect> frames;
+  frames.reserve(count);
+  for (ASCollectionElement *element in layoutState->_allElements) {
+    UICollectionViewLayoutAttributes *attrs = [_elementToLayoutAttributesTable objectForKey:element];
+    if (attrs == nil) {
+      return;
+    }
+    [allLayoutAttributes addObject:attrs];
+    frames.push_back(attrs.frame);
+  }
+
+  _allLayoutAttributes = allLayoutAttributes;
+  _allElements = layoutState->_allElements;
+  for (NSUInteger i = 0; i < count; i++) {
+    _unmeasured[i] = ASCollectionLayoutElementIsUnmeasured(_allElements[i], allLayoutAttributes[i]);
+  }
+
+  // Only the span between the first and the last moved item is reindexed.
+  const std::vector<CGRect> &previousFrames = layoutState->_index.frames;
+  uint32_t first = (uint32_t)count;
+  uint32_t last = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    if (!CGRectEqualToRect(frames[i], previousFrames[i])) {
+      first = MIN(first, i);
+      last = i + 1;
+    }
+  }
+  _index = layoutState->_index;
+  if (first < last) {
+    _index.updateFrames(first, frames.data() + first, last - first);
+  }
+  _unindexedFrames.clear();
+  _indexed = YES;
+}
+
 - (ASCollectionLayoutContext *)context
 {
   return _context;
@@ -129,7 +222,8 @@ elementToLayoutAttributesTable:[NSMapTable elementToLayoutAttributesTable]];
 
 - (NSArray<UICollectionViewLayoutAttributes *> *)allLayoutAttributes
 {
-  return [_elementToLayoutAttributesTable.objectEnumerator allObjects];
+  ASDN::MutexLocker l(__instanceLock__);
+  return _allLayoutAttributes;
 }
 
 - (UICollectionViewLayoutAttributes *)layoutAttributesForItemAtIndexPath:(NSIndexPath *)indexPath
@@ -152,108 +246,39 @@ elementToLayoutAttributesTable:[NSMapTable elementToLayoutAttributesTable]];
 
 - (NSArray<UICollectionViewLayoutAttributes *> *)layoutAttributesForElementsInRect:(CGRect)rect
 {
-  CGSize pageSize = _context.viewportSize;
-  NSPointerArray *pages = ASPageCoordinatesForPagesThatIntersectRect(rect, _contentSize, pageSize);
-  if (pages.count == 0) {
+  if (CGRectIsEmpty(rect)) {
     return @[];
   }
 
-  // Use a set here because some items may span multiple pages
-  NSMutableSet<UICollectionViewLayoutAttributes *> *result = [NSMutableSet set];
-  for (id pagePtr in pages) {
-    ASPageCoordinate page = (ASPageCoordinate)pagePtr;
-    NSArray<UICollectionViewLayoutAttributes *> *allAttrs = [_pageToLayoutAttributesTable objectForPage:page];
-    if (allAttrs.count > 0) {
-      CGRect pageRect = ASPageCoordinateGetPageRect(page, pageSize);
-
-      if (CGRectContainsRect(rect, pageRect)) {
-        [result addObjectsFromArray:allAttrs];
-      } else {
-        for (UICollectionViewLayoutAttributes *attrs in allAttrs) {
-          if (CGRectIntersectsRect(rect, attrs.frame)) {
-            [result addObject:attrs];
-          }
-        }
-      }
-    }
-  }
-
-  return [result allObjects];
+  ASDN::MutexLocker l(__instanceLock__);
+  NSMutableArray<UICollectionViewLayoutAttributes *> *result = [NSMutableArray array];
+  NSArray<UICollectionViewLayoutAttributes *> *allAttrs = _allLayoutAttributes;
+  [self _locked_index].forEachItemIntersectingRect(rect, [&](uint32_t index) {
+    [result addObject:allAttrs[index]];
+  });
+  return result;
 }
 
-- (ASPageToLayoutAttributesTable *)getAndRemoveUnmeasuredLayoutAttributesPageTableInRect:(CGRect)rect
+- (NSArray<UICollectionViewLayoutAttributes *> *)getAndRemoveUnmeasuredLayoutAttributesInRect:(CGRect)rect
 {
-  CGSize pageSize = _context.viewportSize;
-  CGSize contentSize = _contentSize;
-
   ASDN::MutexLocker l(__instanceLock__);
-  if (_unmeasuredPageToLayoutAttributesTable.count == 0 || CGRectIsNull(rect) || CGRectIsEmpty(rect) || CGSizeEqualToSize(CGSizeZero, contentSize) || CGSizeEqualToSize(CGSizeZero, pageSize)) {
-    return nil;
-  }
-
-  // Step 1: Determine all the pages that intersect the specified rect
-  NSPointerArray *pagesInRect = ASPageCoordinatesForPagesThatIntersectRect(rect, contentSize, pageSize);
-  if (pagesInRect.count == 0) {
+  if (_unmeasuredCount == 0 || CGRectIsNull(rect) || CGRectIsEmpty(rect)) {
     return nil;
   }
 
-  // Step 2: Filter out attributes in these pages that intersect the specified rect.
-  ASPageToLayoutAttributesTable *result = nil;
-  for (id pagePtr in pagesInRect) {
-    ASPageCoordinate page = (ASPageCoordinate)pagePtr;
-    NSMutableArray *attrsInPage = [_unmeasuredPageToLayoutAttributesTable objectForPage:page];
-    if (attrsInPage.count == 0) {
-      continue;
-    }
-
-    NSMutableArray *intersectingAttrsInPage = nil;
-    CGRect pageRect = ASPageCoordinateGetPageRect(page, pageSize);
-    if (CGRectContainsRect(rect, pageRect)) {
-      // This page fits well within the specified rect. Simply return all of its attributes.
-      intersectingAttrsInPage = attrsInPage;
-    } else {
-      // The page intersects the specified rect. Some attributes in this page are returned, some are not.
-      for (UICollectionViewLayoutAttributes *attrs in attrsInPage) {
-        if (CGRectIntersectsRect(rect, attrs.frame)) {
-          if (intersectingAttrsInPage == nil) {
-            intersectingAttrsInPage = [NSMutableArray array];
-          }
-          [intersectingAttrsInPage addObject:attrs];
-        }
-      }
-    }
-
-    if (intersectingAttrsInPage.count > 0) {
-      if (attrsInPage.count == intersectingAttrsInPage.count) {
-        [_unmeasuredPageToLayoutAttributesTable removeObjectForPage:page];
-      } else {
-        [attrsInPage removeObjectsInArray:intersectingAttrsInPage];
-      }
+  NSMutableArray<UICollectionViewLayoutAttributes *> *result = nil;
+  NSArray<UICollectionViewLayoutAttributes *> *allAttrs = _allLayoutAttributes;
+  [self _locked_index].forEachItemIntersectingRect(rect, [&](uint32_t index) {
+    if (_unmeasured[index]) {
+      _unmeasured[index] = false;
+      _unmeasuredCount--;
       if (result == nil) {
-        result = [ASPageTable pageTableForStrongObjectPointers];
+        result = [NSMutableArray array];
       }
-      [result setObject:intersectingAttrsInPage forPage:page];
+      [result addObject:allAttrs[index]];
     }
-  }
-
+  });
   return result;
 }
 
-#pragma mark - Private methods
-
-+ (ASPageToLayoutAttributesTable *)_unmeasuredLayoutAttributesTableFromTable:(NSMapTable<ASCollectionElement *, UICollectionViewLayoutAttributes *> *)table
-                                                                 contentSize:(CGSize)contentSize
-                                                                    pageSize:(CGSize)pageSize
-{
-  NSMutableArray<UICollectionViewLayoutAttributes *> *unmeasuredAttrs = [NSMutableArray array];
-  for (ASCollectionElement *element in table) {
-    UICollectionViewLayoutAttributes *attrs = [table objectForKey:element];
-    if (element.nodeIfAllocated == nil || CGSizeEqualToSize(element.nodeIfAllocated.calculatedSize, attrs.frame.size) == NO) {
-      [unmeasuredAttrs addObject:attrs];
-    }
-  }
-
-  return [ASPageTable pageTableWithLayoutAttributes:unmeasuredAttrs contentSize:contentSize pageSize:pageSize];
-}
-
 @end
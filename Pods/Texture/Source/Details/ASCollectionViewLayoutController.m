@@ -56,7 +56,9 @@ typedef struct ASRangeGeometry ASRangeGeometry;
 
 - (NSHashTable<ASCollectionElement *> *)elementsForScrolling:(ASScrollDirection)scrollDirection rangeMode:(ASLayoutRangeMode)rangeMode rangeType:(ASLayoutRangeType)rangeType map:(ASElementMap *)map
 {
-  ASRangeTuningParameters tuningParameters = [self tuningParametersForRangeMode:rangeMode rangeType:rangeType];
+  ASRangeTuningParameters tuningParameters = [self tuningParametersForRangeMode:rangeMode rangeType:rangeType
+                                                                         bounds:_collectionView.bounds
+                                                           scrollableDirections:[_collectionView scrollableDirections]];
   CGRect rangeBounds = [self rangeBoundsWithScrollDirection:scrollDirection rangeTuningParameters:tuningParameters];
   return [self elementsWithinRangeBounds:rangeBounds map:map];
 }
@@ -67,8 +69,14 @@ typedef struct ASRangeGeometry ASRangeGeometry;
     return;
   }
   
-  ASRangeTuningParameters displayParams = [self tuningParametersForRangeMode:rangeMode rangeType:ASLayoutRangeTypeDisplay];
-  ASRangeTuningParameters preloadParams = [self tuningParametersForRangeMode:rangeMode rangeType:ASLayoutRangeTypePreload];
+  CGRect bounds = _collectionView.bounds;
+  ASScrollDirection scrollableDirections = [_collectionView scrollableDirections];
+  ASRangeTuningParameters displayParams = [self tuningParametersForRangeMode:rangeMode rangeType:ASLayoutRangeTypeDisplay
+                                                                      bounds:bounds
+                                                        scrollableDirections:scrollableDirections];
+  ASRangeTuningParameters preloadParams = [self tuningParametersForRangeMode:rangeMode rangeType:ASLayoutRangeTypePreload
+                                                                      bounds:bounds
+                                                        scrollableDirections:scrollableDirections];
   CGRect displayBounds = [self rangeBoundsWithScrollDirection:scrollDirection rangeTuningParameters:displayParams];
   CGRect preloadBounds = [self rangeBoundsWithScrollDirection:scrollDirection rangeTuningParameters:preloadParams];
   
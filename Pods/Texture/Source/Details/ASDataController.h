@@ -239,6 +239,23 @@ extern NSString * const ASCollectionInvalidUpdateException;
 
 - (void)updateWithChangeSet:(_ASHierarchyChangeSet *)changeSet;
 
+/**
+ * Diffs two snapshots of a section's items off the main thread, then applies the result as a batch update.
+ *
+ * @param updates Called on the main thread right before the changes are applied. The data source must report
+ * oldItems for the section until then, and newItems from then on.
+ *
+ * @discussion Items are compared with `isEqual:` and `hash`. Moved items are deleted and inserted again.
+ * Must be called on the main thread.
+ */
+- (void)updateItemsInSection:(NSInteger)section
+                   fromArray:(NSArray *)oldItems
+                     toArray:(NSArray *)newItems
+            animationOptions:(ASDataControllerAnimationOptions)options
+                    animated:(BOOL)animated
+                     updates:(nullable dispatch_block_t)updates
+                  completion:(nullable void (^)(BOOL finished))completion;
+
 /**
  * Re-measures all loaded nodes in the backing store.
  * 
@@ -41,6 +41,7 @@
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/ASCellNode+Internal.h>
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
+#import <AsyncDisplayKit/NSArray+Diffing.h>
 #import <AsyncDisplayKit/NSIndexSet+ASHelpers.h>
 
 //#define LOG(...) NSLog(__VA_ARGS__)
@@ -492,6 +493,36 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   }
 }
 
+- (void)updateItemsInSection:(NSInteger)section
+                   fromArray:(NSArray *)oldItems
+                     toArray:(NSArray *)newItems
+            animationOptions:(ASDataControllerAnimationOptions)options
+                    animated:(BOOL)animated
+                     updates:(dispatch_block_t)updates
+                  completion:(void (^)(BOOL))completion
+{
+  ASDisplayNodeAssertMainThread();
+
+  NSArray *oldSnapshot = [oldItems copy];
+  NSArray *newSnapshot = [newItems copy];
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    NSIndexSet *insertions, *deletions;
+    [oldSnapshot asdk_diffWithArray:newSnapshot insertions:&insertions deletions:&deletions];
+    dispatch_async(dispatch_get_main_queue(), ^{
+      // Take the old counts right before the data source changes. Any update or reload that landed
+      // during the diff has been applied by now, so these are the counts the change set applies to.
+      _ASHierarchyChangeSet *changeSet = [[_ASHierarchyChangeSet alloc] initWithOldData:[self itemCountsFromDataSource]];
+      changeSet.animated = animated;
+      [changeSet addCompletionHandler:completion];
+      [changeSet deleteItemsAtIndexes:deletions insertItemsAtIndexes:insertions inSection:section animationOptions:options];
+      if (updates) {
+        updates();
+      }
+      [self updateWithChangeSet:changeSet];
+    });
+  });
+}
+
 - (void)updateWithChangeSet:(_ASHierarchyChangeSet *)changeSet
 {
   ASDisplayNodeAssertMainThread();
@@ -117,6 +117,26 @@ typedef NS_ENUM(NSUInteger, ASImageDownloaderPriority) {
 
 @optional
 
+/**
+ @abstract Downloads an image with the given URL, decoded at the size it is going to be displayed at.
+ @param URL The URL of the image to download.
+ @param targetSize The size in pixels the image is going to be displayed at.
+ @param contentMode The content mode the image is going to be displayed with.
+ @param callbackQueue The queue to call `downloadProgressBlock` and `completion` on.
+ @param downloadProgress The block to be invoked when the download of `URL` progresses.
+ @param completion The block to be invoked when the download has completed, or has failed.
+ @discussion Implement this to avoid decoding images at a much larger size than they are displayed at. The image
+ should keep the aspect ratio of the original, and may be larger than targetSize, e.g. for content modes that don't scale.
+ @result An opaque identifier to be used in canceling the download, via `cancelImageDownloadForIdentifier:`. You must
+ retain the identifier if you wish to use it later.
+ */
+- (nullable id)downloadImageWithURL:(NSURL *)URL
+                         targetSize:(CGSize)targetSize
+                        contentMode:(UIViewContentMode)contentMode
+                      callbackQueue:(dispatch_queue_t)callbackQueue
+                   downloadProgress:(nullable ASImageDownloaderProgress)downloadProgress
+                         completion:(ASImageDownloaderCompletion)completion;
+
 /**
  @abstract Cancels an image download, however indicating resume data should be stored in case of redownload.
  @param downloadIdentifier The opaque download identifier object returned from
@@ -26,6 +26,9 @@ AS_SUBCLASSING_RESTRICTED
  *
  * If oldCount is 0, returns the empty map.
  * If deleted and inserted are empty, returns the identity map.
+ *
+ * Otherwise the map is built in one linear pass over the ranges and is backed
+ * by a contiguous array rather than a hash table.
  */
 + (ASIntegerMap *)mapForUpdateWithOldCount:(NSInteger)oldCount
                                    deleted:(nullable NSIndexSet *)deleted
@@ -64,6 +67,9 @@ AS_SUBCLASSING_RESTRICTED
 
 /**
  * Create and return a map with the inverse mapping.
+ *
+ * For maps created by +mapForUpdateWithOldCount:deleted:inserted: the inverse is
+ * built once and cached, so you should not mutate it.
  */
 - (ASIntegerMap *)inverseMap;
 
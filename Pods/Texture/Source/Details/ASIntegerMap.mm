@@ -13,19 +13,29 @@
 #import "ASIntegerMap.h"
 #import <AsyncDisplayKit/ASAssert.h>
 #import <unordered_map>
+#import <vector>
 #import <AsyncDisplayKit/NSIndexSet+ASHelpers.h>
 #import <AsyncDisplayKit/ASObjectDescriptionHelpers.h>
+#import <AsyncDisplayKit/ASThread.h>
 
 /**
  * This is just a friendly Objective-C interface to unordered_map<NSInteger, NSInteger>
+ *
+ * Maps built for an update are stored densely instead: a contiguous vector indexed by key,
+ * with NSNotFound marking holes. Keys of those maps are always [0, oldCount) so this is both
+ * smaller and much faster to build and query than the hash map.
  */
 @interface ASIntegerMap () <ASDescriptionProvider>
 @end
 
 @implementation ASIntegerMap {
   std::unordered_map<NSInteger, NSInteger> _map;
+  std::vector<NSInteger> _dense;
+  ASIntegerMap *_inverse; // Lazily built, dense maps only. Guarded by _inverseLock.
+  ASDN::Mutex _inverseLock;
   BOOL _isIdentity;
   BOOL _isEmpty;
+  BOOL _isDense;
   BOOL _immutable; // identity map and empty mape are immutable.
 }
 
@@ -65,32 +75,50 @@
     return ASIntegerMap.identityMap;
   }
 
-  ASIntegerMap *result = [[ASIntegerMap alloc] init];
-  // Start with the old indexes
-  NSMutableIndexSet *indexes = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, oldCount)];
-
-  // Descending order, shift deleted ranges left
-  [deletions enumerateRangesWithOptions:NSEnumerationReverse usingBlock:^(NSRange range, BOOL * _Nonnull stop) {
-    [indexes shiftIndexesStartingAtIndex:NSMaxRange(range) by:-range.length];
+  // Gather both sets as sorted ranges, then do a single merge pass over the old indexes.
+  // Deleted ranges are in old-index space, inserted ranges are in new-index space.
+  std::vector<NSRange> deletedRanges, insertedRanges;
+  [deletions enumerateRangesUsingBlock:^(NSRange range, BOOL * _Nonnull stop) {
+    deletedRanges.push_back(range);
   }];
-
-  // Ascending order, shift inserted ranges right
   [insertions enumerateRangesUsingBlock:^(NSRange range, BOOL * _Nonnull stop) {
-    [indexes shiftIndexesStartingAtIndex:range.location by:range.length];
+    insertedRanges.push_back(range);
   }];
 
-  __block NSInteger oldIndex = 0;
-  [indexes enumerateRangesUsingBlock:^(NSRange range, BOOL * _Nonnull stop) {
-    // Note we advance oldIndex unconditionally, not newIndex
-    for (NSInteger newIndex = range.location; newIndex < NSMaxRange(range); oldIndex++) {
-      if ([deletions containsIndex:oldIndex]) {
-        // index was deleted, do nothing, just let oldIndex advance.
-      } else {
-        // assign the next index for this item.
-        result->_map[oldIndex] = newIndex++;
-      }
+  ASIntegerMap *result = [[ASIntegerMap alloc] init];
+  result->_isDense = YES;
+  result->_dense.assign(oldCount, NSNotFound);
+  NSInteger *map = result->_dense.data();
+
+  auto deleted = deletedRanges.cbegin();
+  auto inserted = insertedRanges.cbegin();
+  NSInteger oldIndex = 0;
+  NSInteger newIndex = 0;
+  while (oldIndex < oldCount) {
+    // Skip over a deleted run. Its entries keep NSNotFound.
+    if (deleted != deletedRanges.cend() && (NSInteger)deleted->location <= oldIndex) {
+      oldIndex = MAX(oldIndex, (NSInteger)NSMaxRange(*deleted));
+      deleted++;
+      continue;
     }
-  }];
+    // Skip over an inserted run in the new indexes.
+    if (inserted != insertedRanges.cend() && (NSInteger)inserted->location <= newIndex) {
+      newIndex = MAX(newIndex, (NSInteger)NSMaxRange(*inserted));
+      inserted++;
+      continue;
+    }
+    // Everything up to the next deletion or insertion is a contiguous shifted run.
+    NSInteger runEnd = oldCount;
+    if (deleted != deletedRanges.cend()) {
+      runEnd = MIN(runEnd, (NSInteger)deleted->location);
+    }
+    if (inserted != insertedRanges.cend()) {
+      runEnd = MIN(runEnd, oldIndex + ((NSInteger)inserted->location - newIndex));
+    }
+    for (; oldIndex < runEnd; oldIndex++) {
+      map[oldIndex] = newIndex++;
+    }
+  }
   return result;
 }
 
@@ -100,6 +128,8 @@
     return key;
   } else if (_isEmpty) {
     return NSNotFound;
+  } else if (_isDense) {
+    return (key >= 0 && key < (NSInteger)_dense.size()) ? _dense[key] : NSNotFound;
   }
 
   auto result = _map.find(key);
@@ -113,15 +143,85 @@
     return;
   }
 
+  {
+    ASDN::MutexLocker l(_inverseLock);
+    _inverse = nil;
+  }
+  if (_isDense) {
+    if (key >= 0 && key < (NSInteger)_dense.size()) {
+      _dense[key] = value;
+      return;
+    }
+    [self _convertDenseToHashMap];
+  }
   _map[key] = value;
 }
 
+/**
+ * Moves the dense entries into the hash map. Used when a dense map is given an out-of-range key.
+ */
+- (void)_convertDenseToHashMap
+{
+  ASDisplayNodeAssertTrue(_isDense);
+  _map.reserve(_dense.size());
+  for (NSInteger key = 0; key < (NSInteger)_dense.size(); key++) {
+    if (_dense[key] != NSNotFound) {
+      _map[key] = _dense[key];
+    }
+  }
+  _dense.clear();
+  _dense.shrink_to_fit();
+  _isDense = NO;
+}
+
+/**
+ * Returns an equivalent unordered_map, for comparing maps of different storage kinds.
+ */
+- (std::unordered_map<NSInteger, NSInteger>)_hashMap
+{
+  if (!_isDense) {
+    return _map;
+  }
+  std::unordered_map<NSInteger, NSInteger> result;
+  for (NSInteger key = 0; key < (NSInteger)_dense.size(); key++) {
+    if (_dense[key] != NSNotFound) {
+      result[key] = _dense[key];
+    }
+  }
+  return result;
+}
+
 - (ASIntegerMap *)inverseMap
 {
   if (_isIdentity || _isEmpty) {
     return self;
   }
 
+  if (_isDense) {
+    // Maps are shared between readers once built, so the inverse may be requested concurrently.
+    ASDN::MutexLocker l(_inverseLock);
+    if (_inverse == nil) {
+      // Values of an update map are unique and bounded by the number of surviving + inserted items,
+      // so the inverse is dense too. Size it by the largest value.
+      NSInteger newCount = 0;
+      for (NSInteger value : _dense) {
+        if (value != NSNotFound) {
+          newCount = MAX(newCount, value + 1);
+        }
+      }
+      auto inverse = [[ASIntegerMap alloc] init];
+      inverse->_isDense = YES;
+      inverse->_dense.assign(newCount, NSNotFound);
+      for (NSInteger key = 0; key < (NSInteger)_dense.size(); key++) {
+        if (_dense[key] != NSNotFound) {
+          inverse->_dense[_dense[key]] = key;
+        }
+      }
+      _inverse = inverse;
+    }
+    return _inverse;
+  }
+
   auto result = [[ASIntegerMap alloc] init];
   for (auto it = _map.begin(); it != _map.end(); it++) {
     result->_map[it->second] = it->first;
@@ -139,6 +239,8 @@
 
   auto newMap = [[ASIntegerMap allocWithZone:zone] init];
   newMap->_map = _map;
+  newMap->_dense = _dense;
+  newMap->_isDense = _isDense;
   return newMap;
 }
 
@@ -155,6 +257,13 @@
   } else {
     // { 1->2 3->4 5->6 }
     NSMutableString *str = [NSMutableString string];
+    if (_isDense) {
+      for (NSInteger key = 0; key < (NSInteger)_dense.size(); key++) {
+        if (_dense[key] != NSNotFound) {
+          [str appendFormat:@" %zd->%zd", key, _dense[key]];
+        }
+      }
+    }
     for (auto it = _map.begin(); it != _map.end(); it++) {
       [str appendFormat:@" %zd->%zd", it->first, it->second];
     }
@@ -180,6 +289,11 @@
   }
 
   if (auto otherMap = ASDynamicCast(object, ASIntegerMap)) {
+    if (_isDense && otherMap->_isDense && _dense.size() == otherMap->_dense.size()) {
+      return otherMap->_dense == _dense;
+    } else if (_isDense || otherMap->_isDense) {
+      return [otherMap _hashMap] == [self _hashMap];
+    }
     return otherMap->_map == _map;
   }
   return NO;
@@ -265,6 +265,59 @@ static ASPINRemoteImageDownloader *sharedDownloader = nil;
                                                        completion:imageCompletion];
 }
 
+- (nullable id)downloadImageWithURL:(NSURL *)URL
+                         targetSize:(CGSize)targetSize
+                        contentMode:(UIViewContentMode)contentMode
+                      callbackQueue:(dispatch_queue_t)callbackQueue
+                   downloadProgress:(ASImageDownloaderProgress)downloadProgress
+                         completion:(ASImageDownloaderCompletion)completion
+{
+  PINImageDecodeContentMode decodeContentMode;
+  switch (contentMode) {
+    case UIViewContentModeScaleAspectFit:
+      decodeContentMode = PINImageDecodeContentModeAspectFit;
+      break;
+    // Scale to fill only ever shrinks an image that covers the target size.
+    case UIViewContentModeScaleToFill:
+    case UIViewContentModeScaleAspectFill:
+      decodeContentMode = PINImageDecodeContentModeAspectFill;
+      break;
+    default:
+      // The other content modes don't scale the image, so it is needed at full size.
+      return [self downloadImageWithURL:URL callbackQueue:callbackQueue downloadProgress:downloadProgress completion:completion];
+  }
+
+  PINRemoteImageManagerProgressDownload progressDownload = ^(int64_t completedBytes, int64_t totalBytes) {
+    if (downloadProgress == nil) { return; }
+
+    [ASPINRemoteImageDownloader _performWithCallbackQueue:callbackQueue work:^{
+      downloadProgress(completedBytes / (CGFloat)totalBytes);
+    }];
+  };
+
+  PINRemoteImageManagerImageCompletion imageCompletion = ^(PINRemoteImageManagerResult * _Nonnull result) {
+    [ASPINRemoteImageDownloader _performWithCallbackQueue:callbackQueue work:^{
+#if PIN_ANIMATED_AVAILABLE
+      if (result.alternativeRepresentation) {
+        completion(result.alternativeRepresentation, result.error, result.UUID, result);
+      } else {
+        completion(result.image, result.error, result.UUID, result);
+      }
+#else
+      completion(result.image, result.error, result.UUID, result);
+#endif
+    }];
+  };
+
+  // Unlike above, let PINRemoteImage check its caches: the cache lookup by URL doesn't find images decoded for a size.
+  return [[self sharedPINRemoteImageManager] downloadImageWithURL:URL
+                                                          options:PINRemoteImageManagerDownloadOptionsNone
+                                                       targetSize:targetSize
+                                                      contentMode:decodeContentMode
+                                                 progressDownload:progressDownload
+                                                       completion:imageCompletion];
+}
+
 - (void)cancelImageDownloadForIdentifier:(id)downloadIdentifier
 {
   ASDisplayNodeAssert([downloadIdentifier isKindOfClass:[NSUUID class]], @"downloadIdentifier must be NSUUID");
@@ -44,22 +44,24 @@ extern CGRect ASPageCoordinateGetPageRect(ASPageCoordinate pageCoordinate, CGSiz
   return CGRectMake(ASPageCoordinateGetX(pageCoordinate) * pageWidth, ASPageCoordinateGetY(pageCoordinate) * pageHeight, pageWidth, pageHeight);
 }
 
-extern NSPointerArray *ASPageCoordinatesForPagesThatIntersectRect(CGRect rect, CGSize contentSize, CGSize pageSize)
+/**
+ * Calls the block with the coordinate of every page that intersects the rect, without allocating.
+ * Returns NO if no page does.
+ */
+static BOOL ASPageCoordinatesEnumeratePagesThatIntersectRect(CGRect rect, CGSize contentSize, CGSize pageSize, void (NS_NOESCAPE ^block)(ASPageCoordinate page))
 {
   CGRect contentRect = CGRectMake(0.0, 0.0, contentSize.width, contentSize.height);
   // Make sure the specified rect is within contentRect
   rect = CGRectIntersection(rect, contentRect);
   if (CGRectIsNull(rect) || CGRectIsEmpty(rect)) {
-    return nil;
+    return NO;
   }
   
-  NSPointerArray *result = [NSPointerArray pointerArrayWithOptions:(NSPointerFunctionsIntegerPersonality | NSPointerFunctionsOpaqueMemory)];
-  
   ASPageCoordinate minPage = ASPageCoordinateForPageThatContainsPoint(CGPointMake(CGRectGetMinX(rect), CGRectGetMinY(rect)), pageSize);
   ASPageCoordinate maxPage = ASPageCoordinateForPageThatContainsPoint(CGPointMake(CGRectGetMaxX(rect), CGRectGetMaxY(rect)), pageSize);
   if (minPage == maxPage) {
-    [result addPointer:(void *)minPage];
-    return result;
+    block(minPage);
+    return YES;
   }
   
   NSUInteger minX = ASPageCoordinateGetX(minPage);
@@ -69,12 +71,19 @@ extern NSPointerArray *ASPageCoordinatesForPagesThatIntersectRect(CGRect rect, C
   
   for (NSUInteger x = minX; x <= maxX; x++) {
     for (NSUInteger y = minY; y <= maxY; y++) {
-      ASPageCoordinate page = ASPageCoordinateMake(x, y);
-      [result addPointer:(void *)page];
+      block(ASPageCoordinateMake(x, y));
     }
   }
-  
-  return result;
+  return YES;
+}
+
+extern NSPointerArray *ASPageCoordinatesForPagesThatIntersectRect(CGRect rect, CGSize contentSize, CGSize pageSize)
+{
+  NSPointerArray *result = [NSPointerArray pointerArrayWithOptions:(NSPointerFunctionsIntegerPersonality | NSPointerFunctionsOpaqueMemory)];
+  BOOL found = ASPageCoordinatesEnumeratePagesThatIntersectRect(rect, contentSize, pageSize, ^(ASPageCoordinate page) {
+    [result addPointer:(void *)page];
+  });
+  return found ? result : nil;
 }
 
 @implementation NSMapTable (ASPageTableMethods)
@@ -115,17 +124,14 @@ extern NSPointerArray *ASPageCoordinatesForPagesThatIntersectRect(CGRect rect, C
   ASPageToLayoutAttributesTable *result = [ASPageTable pageTableForStrongObjectPointers];
   for (UICollectionViewLayoutAttributes *attrs in layoutAttributesEnumerator) {
     // This attrs may span multiple pages. Make sure it's registered to all of them
-    NSPointerArray *pages = ASPageCoordinatesForPagesThatIntersectRect(attrs.frame, contentSize, pageSize);
-    
-    for (id pagePtr in pages) {
-      ASPageCoordinate page = (ASPageCoordinate)pagePtr;
+    ASPageCoordinatesEnumeratePagesThatIntersectRect(attrs.frame, contentSize, pageSize, ^(ASPageCoordinate page) {
       NSMutableArray<UICollectionViewLayoutAttributes *> *attrsInPage = [result objectForPage:page];
       if (attrsInPage == nil) {
         attrsInPage = [NSMutableArray array];
         [result setObject:attrsInPage forPage:page];
       }
       [attrsInPage addObject:attrs];
-    }
+    });
   }  
   return result;
 }
@@ -246,6 +246,7 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
       [newVisibleNodes addObject:element.node];
     }
     [self _setVisibleNodes:newVisibleNodes];
+    ASSignpostEnd(ASSignpostRangeControllerUpdate);
     return; // don't do anything for this update, but leave _rangeIsValid == NO to make sure we update it later
   }
 
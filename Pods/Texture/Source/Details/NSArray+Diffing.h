@@ -21,12 +21,25 @@
 
 /**
  * @abstract Compares two arrays, providing the insertion and deletion indexes needed to transform into the target array.
- * @discussion This compares the equality of each object with `isEqual:`.
- * This diffing algorithm uses a bottom-up memoized longest common subsequence solution to identify differences.
- * It runs in O(mn) complexity.
+ * @discussion This compares the equality of each object with `isEqual:` and `hash`.
+ * Objects that moved are reported as a deletion and an insertion. See -asdk_diffWithArray:insertions:deletions:moves:.
+ * For arrays of distinct objects, the objects left in place are a longest common subsequence.
+ * It runs in O(m+n) complexity, plus O(k log k) for the k matched objects.
  */
 - (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions;
 
+/**
+ * @abstract Compares two arrays, providing the insertion, deletion and move indexes needed to transform into the target array.
+ * @discussion This compares the equality of each object with `isEqual:` and `hash`, and is safe to call on any thread.
+ * This diffing algorithm is Paul Heckel's: objects are matched through a hash table, equal objects in order of appearance,
+ * and the matched objects outside the longest run that keeps its relative order are reported as moves.
+ * It runs in O(m+n) complexity, plus O(k log k) for the k matched objects.
+ *
+ * Each move is an index path with two indexes: the index in the receiver, then the index in the target array.
+ * Deletions are indexes in the receiver and insertions are indexes in the target array, as in a batch update.
+ */
+- (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions moves:(NSArray<NSIndexPath *> **)moves;
+
 /**
  * @abstract Compares two arrays, providing the insertion and deletion indexes needed to transform into the target array.
  * @discussion The `compareBlock` is used to identify the equality of the objects within the arrays.
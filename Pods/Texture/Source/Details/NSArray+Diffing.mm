@@ -0,0 +1,298 @@
+//
+//  NSArray+Diffing.mm
+//  Texture
+//
+//  Copyright (c) 2014-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the /ASDK-Licenses directory of this source tree. An additional
+//  grant of patent rights can be found in the PATENTS file in the same directory.
+//
+//  Modifications to this file made after 4/13/2017 are: Copyright (c) 2017-present,
+//  Pinterest, Inc.  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/NSArray+Diffing.h>
+#import <AsyncDisplayKit/ASAssert.h>
+
+#import <algorithm>
+#import <unordered_map>
+#import <vector>
+
+namespace {
+
+struct ASDiffKey {
+  __unsafe_unretained id object;
+  NSUInteger hash;
+};
+
+struct ASDiffKeyHash {
+  size_t operator()(const ASDiffKey &key) const { return key.hash; }
+};
+
+struct ASDiffKeyEqual {
+  bool operator()(const ASDiffKey &lhs, const ASDiffKey &rhs) const
+  {
+    return lhs.object == rhs.object || (lhs.hash == rhs.hash && [lhs.object isEqual:rhs.object]);
+  }
+};
+
+/// The old indexes of all occurrences of one object, and how many of them were matched so far.
+struct ASDiffEntry {
+  std::vector<NSInteger> oldIndexes;
+  size_t matched = 0;
+};
+
+struct ASDiffResult {
+  std::vector<NSInteger> deletions;
+  std::vector<NSInteger> insertions;
+  std::vector<std::pair<NSInteger, NSInteger>> moves;
+};
+
+/**
+ * Marks the longest run of matched new indexes whose old indexes increase, in O(k log k) with patience sorting.
+ * With distinct objects, these are exactly the objects of a longest common subsequence.
+ */
+std::vector<bool> ASDiffLongestIncreasingSubsequence(const std::vector<NSInteger> &newIndexes, const std::vector<NSInteger> &newToOld, NSInteger prefix)
+{
+  const size_t count = newIndexes.size();
+  // tails[l] is the position of the smallest old index ending an increasing run of length l + 1.
+  std::vector<size_t> tails;
+  std::vector<size_t> predecessors(count, SIZE_MAX);
+  for (size_t k = 0; k < count; k++) {
+    NSInteger oldIndex = newToOld[newIndexes[k] - prefix];
+    auto it = std::lower_bound(tails.begin(), tails.end(), oldIndex, [&](size_t position, NSInteger value) {
+      return newToOld[newIndexes[position] - prefix] < value;
+    });
+    if (it != tails.begin()) {
+      predecessors[k] = *(it - 1);
+    }
+    if (it == tails.end()) {
+      tails.push_back(k);
+    } else {
+      *it = k;
+    }
+  }
+
+  std::vector<bool> stays(count, false);
+  for (size_t k = tails.empty() ? SIZE_MAX : tails.back(); k != SIZE_MAX; k = predecessors[k]) {
+    stays[k] = true;
+  }
+  return stays;
+}
+
+/**
+ * Heckel's diff over contiguous copies of both arrays. The common prefix and suffix are skipped first,
+ * since most updates only touch a few objects in the middle.
+ */
+ASDiffResult ASDiffArrays(NSArray *oldArray, NSArray *newArray)
+{
+  const NSInteger oldCount = oldArray.count;
+  const NSInteger newCount = newArray.count;
+  std::vector<__unsafe_unretained id> oldObjects(oldCount);
+  std::vector<__unsafe_unretained id> newObjects(newCount);
+  [oldArray getObjects:oldObjects.data() range:NSMakeRange(0, oldCount)];
+  [newArray getObjects:newObjects.data() range:NSMakeRange(0, newCount)];
+
+  NSInteger prefix = 0;
+  while (prefix < oldCount && prefix < newCount && [oldObjects[prefix] isEqual:newObjects[prefix]]) {
+    prefix++;
+  }
+  NSInteger suffix = 0;
+  while (suffix < oldCount - prefix && suffix < newCount - prefix
+         && [oldObjects[oldCount - suffix - 1] isEqual:newObjects[newCount - suffix - 1]]) {
+    suffix++;
+  }
+  const NSInteger oldEnd = oldCount - suffix;
+  const NSInteger newEnd = newCount - suffix;
+
+  // Pass 1 & 2: hash every object once and record where each one occurs in the old array.
+  std::unordered_map<ASDiffKey, ASDiffEntry, ASDiffKeyHash, ASDiffKeyEqual> table;
+  table.reserve(oldEnd - prefix);
+  for (NSInteger i = prefix; i < oldEnd; i++) {
+    table[{oldObjects[i], [oldObjects[i] hash]}].oldIndexes.push_back(i);
+  }
+
+  // Pass 3: match each new object with the next unmatched occurrence of an equal old object.
+  std::vector<NSInteger> newToOld(newEnd - prefix, NSNotFound);
+  std::vector<NSInteger> oldToNew(oldEnd - prefix, NSNotFound);
+  for (NSInteger i = prefix; i < newEnd; i++) {
+    auto it = table.find({newObjects[i], [newObjects[i] hash]});
+    if (it != table.end() && it->second.matched < it->second.oldIndexes.size()) {
+      NSInteger oldIndex = it->second.oldIndexes[it->second.matched++];
+      newToOld[i - prefix] = oldIndex;
+      oldToNew[oldIndex - prefix] = i;
+    }
+  }
+
+  // Pass 4: unmatched old objects are deleted.
+  ASDiffResult result;
+  for (NSInteger i = prefix; i < oldEnd; i++) {
+    if (oldToNew[i - prefix] == NSNotFound) {
+      result.deletions.push_back(i);
+    }
+  }
+
+  // Pass 5: unmatched new objects are inserted. Matched objects whose old indexes form the longest increasing
+  // subsequence, in new order, keep their relative order and stay put. Every other matched object moved.
+  std::vector<NSInteger> matchedNewIndexes;
+  for (NSInteger i = prefix; i < newEnd; i++) {
+    if (newToOld[i - prefix] == NSNotFound) {
+      result.insertions.push_back(i);
+    } else {
+      matchedNewIndexes.push_back(i);
+    }
+  }
+  std::vector<bool> stays = ASDiffLongestIncreasingSubsequence(matchedNewIndexes, newToOld, prefix);
+  for (size_t k = 0; k < matchedNewIndexes.size(); k++) {
+    if (!stays[k]) {
+      NSInteger i = matchedNewIndexes[k];
+      result.moves.push_back({newToOld[i - prefix], i});
+    }
+  }
+  return result;
+}
+
+NSMutableIndexSet *ASIndexSetWithIndexes(const std::vector<NSInteger> &indexes)
+{
+  NSMutableIndexSet *indexSet = [NSMutableIndexSet indexSet];
+  for (NSInteger index : indexes) {
+    [indexSet addIndex:index];
+  }
+  return indexSet;
+}
+
+}
+
+@implementation NSArray (Diffing)
+
+- (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions
+{
+  ASDiffResult result = ASDiffArrays(self, array);
+
+  if (insertions) {
+    NSMutableIndexSet *insertionIndexes = ASIndexSetWithIndexes(result.insertions);
+    for (const auto &move : result.moves) {
+      [insertionIndexes addIndex:move.second];
+    }
+    *insertions = insertionIndexes;
+  }
+
+  if (deletions) {
+    NSMutableIndexSet *deletionIndexes = ASIndexSetWithIndexes(result.deletions);
+    for (const auto &move : result.moves) {
+      [deletionIndexes addIndex:move.first];
+    }
+    *deletions = deletionIndexes;
+  }
+}
+
+- (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions moves:(NSArray<NSIndexPath *> **)moves
+{
+  ASDiffResult result = ASDiffArrays(self, array);
+
+  if (insertions) {
+    *insertions = ASIndexSetWithIndexes(result.insertions);
+  }
+
+  if (deletions) {
+    *deletions = ASIndexSetWithIndexes(result.deletions);
+  }
+
+  if (moves) {
+    NSMutableArray<NSIndexPath *> *moveIndexPaths = [NSMutableArray arrayWithCapacity:result.moves.size()];
+    for (const auto &move : result.moves) {
+      const NSUInteger indexes[] = { (NSUInteger)move.first, (NSUInteger)move.second };
+      [moveIndexPaths addObject:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+    }
+    *moves = moveIndexPaths;
+  }
+}
+
+- (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions compareBlock:(BOOL (^)(id lhs, id rhs))comparison
+{
+  NSAssert(comparison != nil, @"Comparison block is required");
+  NSIndexSet *commonIndexes = [self _asdk_commonIndexesWithArray:array compareBlock:comparison];
+  
+  if (insertions) {
+    NSArray *commonObjects = [self objectsAtIndexes:commonIndexes];
+    NSMutableIndexSet *insertionIndexes = [NSMutableIndexSet indexSet];
+    for (NSInteger i = 0, j = 0; i < commonObjects.count || j < array.count;) {
+      if (i < commonObjects.count && j < array.count && comparison(commonObjects[i], array[j])) {
+        i++; j++;
+      } else {
+        [insertionIndexes addIndex:j];
+        j++;
+      }
+    }
+    *insertions = insertionIndexes;
+  }
+  
+  if (deletions) {
+    NSMutableIndexSet *deletionIndexes = [NSMutableIndexSet indexSet];
+    for (NSInteger i = 0; i < self.count; i++) {
+      if (![commonIndexes containsIndex:i]) {
+        [deletionIndexes addIndex:i];
+      }
+    }
+    *deletions = deletionIndexes;
+  }
+}
+
+- (NSIndexSet *)_asdk_commonIndexesWithArray:(NSArray *)array compareBlock:(BOOL (^)(id lhs, id rhs))comparison
+{
+  NSAssert(comparison != nil, @"Comparison block is required");
+  
+  NSInteger selfCount = self.count;
+  NSInteger arrayCount = array.count;
+  
+  // Allocate the diff map in the heap so we don't blow the stack for large arrays.
+  NSInteger **lengths = NULL;
+  lengths = (NSInteger **)malloc(sizeof(NSInteger*) * (selfCount+1));
+  if (lengths == NULL) {
+    ASDisplayNodeFailAssert(@"Failed to allocate memory for diffing");
+    return nil;
+  }
+  
+  for (NSInteger i = 0; i <= selfCount; i++) {
+    lengths[i] = (NSInteger *)malloc(sizeof(NSInteger) * (arrayCount+1));
+    if (lengths[i] == NULL) {
+      ASDisplayNodeFailAssert(@"Failed to allocate memory for diffing");
+      return nil;
+    }
+    id selfObj = i > 0 ? self[i-1] : nil;
+    for (NSInteger j = 0; j <= arrayCount; j++) {
+      if (i == 0 || j == 0) {
+        lengths[i][j] = 0;
+      } else if (comparison(selfObj, array[j-1])) {
+        lengths[i][j] = 1 + lengths[i-1][j-1];
+      } else {
+        lengths[i][j] = MAX(lengths[i-1][j], lengths[i][j-1]);
+      }
+    }
+  }
+  
+  NSMutableIndexSet *common = [NSMutableIndexSet indexSet];
+  NSInteger i = selfCount, j = arrayCount;
+  while(i > 0 && j > 0) {
+    if (comparison(self[i-1], array[j-1])) {
+      [common addIndex:(i-1)];
+      i--; j--;
+    } else if (lengths[i-1][j] > lengths[i][j-1]) {
+      i--;
+    } else {
+      j--;
+    }
+  }
+
+  for (NSInteger i = 0; i <= selfCount; i++) {
+    free(lengths[i]);
+  }
+  free(lengths);
+  return common;
+}
+
+@end
@@ -20,11 +20,16 @@
 
 #import <AsyncDisplayKit/_ASAsyncTransaction.h>
 #import <AsyncDisplayKit/_ASAsyncTransactionGroup.h>
+#import <AsyncDisplayKit/ASAdaptiveRangeTuner.h>
 #import <AsyncDisplayKit/ASAssert.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASThread.h>
+#import <atomic>
 #import <list>
 #import <map>
+#import <memory>
 #import <mutex>
+#import <vector>
 
 #ifndef __STRICT_ANSI__
   #warning "Texture must be compiled with std=c++11 to prevent layout issues. gnu++ is not supported. This is hopefully temporary."
@@ -134,6 +139,7 @@ private:
     int _pendingOperations;
     std::list<GroupNotify> _notifyList;
     std::condition_variable _condition;
+    std::mutex _mutex;
     BOOL _releaseCalled;
     ASAsyncTransactionQueue &_queue;
   };
@@ -144,25 +150,187 @@ private:
     GroupImpl *_group;
     NSInteger _priority;
   };
+  
+  // Runs scheduled operations on their dispatch queues. The group has already been entered
+  // for the operation; the executor must call leave() on it once the block has run.
+  class Executor
+  {
+  public:
+    virtual void schedule(dispatch_queue_t queue, const Operation &operation) = 0;
+    virtual ~Executor() { };
+  };
+  
+  // The original executor: one mutex around a list-based priority queue per dispatch queue.
+  class PriorityListExecutor : public Executor
+  {
+  public:
+    virtual void schedule(dispatch_queue_t queue, const Operation &operation);
+    
+  private:
+    struct DispatchEntry // entry for each dispatch queue
+    {
+      typedef std::list<Operation> OperationQueue;
+      typedef std::list<OperationQueue::iterator> OperationIteratorList; // each item points to operation queue
+      typedef std::map<NSInteger, OperationIteratorList> OperationPriorityMap; // sorted by priority
+
+      OperationQueue _operationQueue;
+      OperationPriorityMap _operationPriorityMap;
+      int _threadCount;
+        
+      Operation popNextOperation(bool respectPriority);  // assumes locked mutex
+      void pushOperation(Operation operation);           // assumes locked mutex
+    };
     
-  struct DispatchEntry // entry for each dispatch queue
+    std::map<dispatch_queue_t, DispatchEntry> _entries;
+    std::mutex _mutex;
+  };
+  
+  // Executor for a single dispatch queue that gives each drain thread its own queue of operations.
+  // Operations are distributed round-robin across the queues, and a worker that runs out of
+  // work steals from the others, so drain threads only contend when they touch the same queue.
+  // Operation nodes come from per-thread free lists, refilled in batches from a shared pool that is
+  // preallocated for the workers, so push and pop neither allocate nor take a shared lock.
+  //
+  // Priority semantics match PriorityListExecutor: the first worker takes operations in queue order,
+  // so low priority work can't starve, and every other worker pops and steals the highest priority
+  // operation first.
+  class WorkStealingExecutor : public Executor
   {
-    typedef std::list<Operation> OperationQueue;
-    typedef std::list<OperationQueue::iterator> OperationIteratorList; // each item points to operation queue
-    typedef std::map<NSInteger, OperationIteratorList> OperationPriorityMap; // sorted by priority
-
-    OperationQueue _operationQueue;
-    OperationPriorityMap _operationPriorityMap;
-    int _threadCount;
+  public:
+    WorkStealingExecutor(dispatch_queue_t queue);
+    virtual void schedule(dispatch_queue_t queue, const Operation &operation);
+    
+  private:
+    static const NSUInteger kNodesPerWorker = 256;
+    static const NSUInteger kNodesPerSlab = 512;
+    // Nodes move between a thread's free list and the shared pool this many at a time.
+    static const NSUInteger kNodeBatchSize = 64;
+    
+    struct Node
+    {
+      Operation _operation;
+      Node *_next;          // in queue order, or in a free list
+      Node *_prev;
+      Node *_priorityNext;  // among the operations of the same priority
+    };
+    
+    // Like PriorityListExecutor::DispatchEntry, but intrusive: nodes are linked in queue order and
+    // per priority, so either order pops in O(1) after finding the highest priority.
+    struct Worker
+    {
+      struct PriorityList
+      {
+        Node *_head = nullptr;
+        Node *_tail = nullptr;
+      };
+      
+      std::mutex _mutex;
+      Node *_head = nullptr;
+      Node *_tail = nullptr;
+      std::map<NSInteger, PriorityList> _priorityLists;
+      std::atomic<bool> _claimed{false};
+      
+      void push(Node *node);
+      Node *pop(bool respectPriority);
+    };
+    
+    // Shared by all executors, since nodes don't belong to a queue.
+    struct NodePool
+    {
+      std::mutex _mutex;
+      Node *_freeNodes = nullptr;
+      NSUInteger _freeCount = 0;
+      std::vector<std::unique_ptr<Node[]>> _slabs;
+      
+      void reserve(NSUInteger count);   // assumes locked mutex
+    };
+    static NodePool &nodePool();
+    
+    // A thread's free list, handed back to the pool when the thread exits.
+    struct FreeList
+    {
+      Node *_head = nullptr;
+      NSUInteger _count = 0;
       
-    Operation popNextOperation(bool respectPriority);  // assumes locked mutex
-    void pushOperation(Operation operation);           // assumes locked mutex
+      Node *detach(NSUInteger count);
+      ~FreeList();
+    };
+    static thread_local FreeList tls_freeList;
+    
+    static Node *allocNode();
+    static void recycleNode(Node *node);
+    Node *nextNode(NSUInteger workerIndex);
+    NSInteger claimWorker();
+    void drain(NSInteger workerIndex);
+    
+    dispatch_queue_t _dispatchQueue;
+    NSUInteger _workerCount;
+    std::unique_ptr<Worker[]> _workers;
+    std::atomic<NSUInteger> _nextWorker;
+    std::atomic<NSInteger> _pendingCount;
+    std::atomic<NSUInteger> _activeWorkers;
   };
   
-  std::map<dispatch_queue_t, DispatchEntry> _entries;
-  std::mutex _mutex;
+  ASAsyncTransactionQueue();
+  Executor &executorForQueue(dispatch_queue_t queue);
+  static NSUInteger maxThreadCount();
+  
+  bool _workStealing;
+  std::unique_ptr<PriorityListExecutor> _priorityListExecutor;
+  // Executors are never destroyed, so threads can cache the last one they looked up.
+  std::map<dispatch_queue_t, std::unique_ptr<WorkStealingExecutor>> _workStealingExecutors;
+  std::mutex _executorsMutex;
+  static thread_local dispatch_queue_t tls_lastQueue;
+  static thread_local WorkStealingExecutor *tls_lastExecutor;
 };
 
+thread_local dispatch_queue_t ASAsyncTransactionQueue::tls_lastQueue;
+thread_local ASAsyncTransactionQueue::WorkStealingExecutor *ASAsyncTransactionQueue::tls_lastExecutor;
+thread_local ASAsyncTransactionQueue::WorkStealingExecutor::FreeList ASAsyncTransactionQueue::WorkStealingExecutor::tls_freeList;
+
+ASAsyncTransactionQueue::ASAsyncTransactionQueue()
+  : _workStealing(ASActivateExperimentalFeature(ASExperimentalWorkStealingTransactionQueue))
+{
+  if (!_workStealing) {
+    _priorityListExecutor.reset(new PriorityListExecutor());
+  }
+}
+
+ASAsyncTransactionQueue::Executor &ASAsyncTransactionQueue::executorForQueue(dispatch_queue_t queue)
+{
+  if (!_workStealing) {
+    return *_priorityListExecutor;
+  }
+  
+  // Producers almost always schedule on the same queue, so only a change of queue takes the lock.
+  if (tls_lastQueue == queue) {
+    return *tls_lastExecutor;
+  }
+  
+  std::lock_guard<std::mutex> l(_executorsMutex);
+  auto &executor = _workStealingExecutors[queue];
+  if (executor == nullptr) {
+    executor.reset(new WorkStealingExecutor(queue));
+  }
+  tls_lastQueue = queue;
+  tls_lastExecutor = executor.get();
+  return *executor;
+}
+
+NSUInteger ASAsyncTransactionQueue::maxThreadCount()
+{
+#if ASDISPLAYNODE_DELAY_DISPLAY
+  NSUInteger maxThreads = 1;
+#else 
+  NSUInteger maxThreads = [NSProcessInfo processInfo].activeProcessorCount * 2;
+
+  // Bit questionable maybe - we can give main thread more CPU time during tracking;
+  if ([[NSRunLoop mainRunLoop].currentMode isEqualToString:UITrackingRunLoopMode])
+    --maxThreads;
+#endif
+  return maxThreads;
+}
+
 ASAsyncTransactionQueue::Group* ASAsyncTransactionQueue::createGroup()
 {
   Group *res = new GroupImpl(*this);
@@ -171,16 +339,21 @@ ASAsyncTransactionQueue::Group* ASAsyncTransactionQueue::createGroup()
 
 void ASAsyncTransactionQueue::GroupImpl::release()
 {
-  std::lock_guard<std::mutex> l(_queue._mutex);
+  bool shouldDelete;
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    shouldDelete = (_pendingOperations == 0);
+    if (!shouldDelete) {
+      _releaseCalled = YES;
+    }
+  }
   
-  if (_pendingOperations == 0)  {
+  if (shouldDelete) {
     delete this;
-  } else {
-    _releaseCalled = YES;
   }
 }
 
-ASAsyncTransactionQueue::Operation ASAsyncTransactionQueue::DispatchEntry::popNextOperation(bool respectPriority)
+ASAsyncTransactionQueue::Operation ASAsyncTransactionQueue::PriorityListExecutor::DispatchEntry::popNextOperation(bool respectPriority)
 {
   NSCAssert(!_operationQueue.empty() && !_operationPriorityMap.empty(), @"No scheduled operations available");
 
@@ -209,7 +382,7 @@ ASAsyncTransactionQueue::Operation ASAsyncTransactionQueue::DispatchEntry::popNe
   return res;
 }
 
-void ASAsyncTransactionQueue::DispatchEntry::pushOperation(ASAsyncTransactionQueue::Operation operation)
+void ASAsyncTransactionQueue::PriorityListExecutor::DispatchEntry::pushOperation(ASAsyncTransactionQueue::Operation operation)
 {
   _operationQueue.push_back(operation);
 
@@ -217,30 +390,14 @@ void ASAsyncTransactionQueue::DispatchEntry::pushOperation(ASAsyncTransactionQue
   list.push_back(--_operationQueue.end());
 }
 
-void ASAsyncTransactionQueue::GroupImpl::schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block)
+void ASAsyncTransactionQueue::PriorityListExecutor::schedule(dispatch_queue_t queue, const Operation &operation)
 {
-  ASAsyncTransactionQueue &q = _queue;
-  std::lock_guard<std::mutex> l(q._mutex);
+  std::lock_guard<std::mutex> l(_mutex);
   
-  DispatchEntry &entry = q._entries[queue];
-  
-  Operation operation;
-  operation._block = block;
-  operation._group = this;
-  operation._priority = priority;
+  DispatchEntry &entry = _entries[queue];
   entry.pushOperation(operation);
   
-  ++_pendingOperations; // enter group
-  
-#if ASDISPLAYNODE_DELAY_DISPLAY
-  NSUInteger maxThreads = 1;
-#else 
-  NSUInteger maxThreads = [NSProcessInfo processInfo].activeProcessorCount * 2;
-
-  // Bit questionable maybe - we can give main thread more CPU time during tracking;
-  if ([[NSRunLoop mainRunLoop].currentMode isEqualToString:UITrackingRunLoopMode])
-    --maxThreads;
-#endif
+  NSUInteger maxThreads = ASAsyncTransactionQueue::maxThreadCount();
   
   if (entry._threadCount < maxThreads) { // we need to spawn another thread
 
@@ -249,7 +406,7 @@ void ASAsyncTransactionQueue::GroupImpl::schedule(NSInteger priority, dispatch_q
     ++entry._threadCount;
     
     dispatch_async(queue, ^{
-      std::unique_lock<std::mutex> lock(q._mutex);
+      std::unique_lock<std::mutex> lock(_mutex);
       
       // go until there are no more pending operations
       while (!entry._operationQueue.empty()) {
@@ -266,15 +423,284 @@ void ASAsyncTransactionQueue::GroupImpl::schedule(NSInteger priority, dispatch_q
       
       if (entry._threadCount == 0) {
         NSCAssert(entry._operationQueue.empty() || entry._operationPriorityMap.empty(), @"No working threads but operations are still scheduled"); // this shouldn't happen
-        q._entries.erase(queue);
+        _entries.erase(queue);
       }
     });
   }
 }
 
+ASAsyncTransactionQueue::WorkStealingExecutor::WorkStealingExecutor(dispatch_queue_t queue)
+  : _dispatchQueue(queue)
+  , _workerCount(MAX([NSProcessInfo processInfo].activeProcessorCount * 2, (NSUInteger)1))
+  , _workers(new Worker[_workerCount])
+  , _nextWorker(0)
+  , _pendingCount(0)
+  , _activeWorkers(0)
+{
+  // Prime the pool for every worker so steady-state scheduling never allocates.
+  NodePool &pool = nodePool();
+  std::lock_guard<std::mutex> l(pool._mutex);
+  pool.reserve(_workerCount * kNodesPerWorker);
+}
+
+void ASAsyncTransactionQueue::WorkStealingExecutor::Worker::push(Node *node)
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  node->_next = nullptr;
+  node->_prev = _tail;
+  if (_tail) {
+    _tail->_next = node;
+  } else {
+    _head = node;
+  }
+  _tail = node;
+  
+  PriorityList &list = _priorityLists[node->_operation._priority];
+  node->_priorityNext = nullptr;
+  if (list._tail) {
+    list._tail->_priorityNext = node;
+  } else {
+    list._head = node;
+  }
+  list._tail = node;
+}
+
+ASAsyncTransactionQueue::WorkStealingExecutor::Node *ASAsyncTransactionQueue::WorkStealingExecutor::Worker::pop(bool respectPriority)
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  if (_head == nullptr) {
+    return nullptr;
+  }
+  
+  // Either way the node is the first of its priority: the earliest operation overall is also the
+  // earliest of its priority.
+  auto listIterator = respectPriority ? --_priorityLists.end() : _priorityLists.find(_head->_operation._priority);
+  PriorityList &list = listIterator->second;
+  Node *node = list._head;
+  NSCAssert(respectPriority || node == _head, @"Queue inconsistency");
+  
+  list._head = node->_priorityNext;
+  if (list._head == nullptr) {
+    _priorityLists.erase(listIterator);
+  }
+  
+  if (node->_prev) {
+    node->_prev->_next = node->_next;
+  } else {
+    _head = node->_next;
+  }
+  if (node->_next) {
+    node->_next->_prev = node->_prev;
+  } else {
+    _tail = node->_prev;
+  }
+  return node;
+}
+
+ASAsyncTransactionQueue::WorkStealingExecutor::NodePool &ASAsyncTransactionQueue::WorkStealingExecutor::nodePool()
+{
+  static NodePool *pool = new NodePool();
+  return *pool;
+}
+
+void ASAsyncTransactionQueue::WorkStealingExecutor::NodePool::reserve(NSUInteger count)
+{
+  while (_freeCount < count) {
+    Node *slab = new Node[kNodesPerSlab];
+    for (NSUInteger i = 0; i < kNodesPerSlab - 1; i++) {
+      slab[i]._next = &slab[i + 1];
+    }
+    slab[kNodesPerSlab - 1]._next = _freeNodes;
+    _slabs.emplace_back(slab);
+    _freeNodes = slab;
+    _freeCount += kNodesPerSlab;
+  }
+}
+
+ASAsyncTransactionQueue::WorkStealingExecutor::Node *ASAsyncTransactionQueue::WorkStealingExecutor::FreeList::detach(NSUInteger count)
+{
+  Node *first = _head;
+  Node *last = first;
+  for (NSUInteger i = 1; i < count; i++) {
+    last = last->_next;
+  }
+  _head = last->_next;
+  _count -= count;
+  last->_next = nullptr;
+  return first;
+}
+
+ASAsyncTransactionQueue::WorkStealingExecutor::FreeList::~FreeList()
+{
+  if (_count == 0) {
+    return;
+  }
+  NSUInteger count = _count;
+  Node *first = detach(count);
+  Node *last = first;
+  while (last->_next) {
+    last = last->_next;
+  }
+  
+  NodePool &pool = nodePool();
+  std::lock_guard<std::mutex> l(pool._mutex);
+  last->_next = pool._freeNodes;
+  pool._freeNodes = first;
+  pool._freeCount += count;
+}
+
+ASAsyncTransactionQueue::WorkStealingExecutor::Node *ASAsyncTransactionQueue::WorkStealingExecutor::allocNode()
+{
+  FreeList &freeList = tls_freeList;
+  if (freeList._head == nullptr) {
+    // Take a batch from the pool, so the pool lock is taken once per batch.
+    NodePool &pool = nodePool();
+    std::lock_guard<std::mutex> l(pool._mutex);
+    pool.reserve(kNodeBatchSize);
+    Node *last = pool._freeNodes;
+    for (NSUInteger i = 1; i < kNodeBatchSize; i++) {
+      last = last->_next;
+    }
+    freeList._head = pool._freeNodes;
+    freeList._count = kNodeBatchSize;
+    pool._freeNodes = last->_next;
+    pool._freeCount -= kNodeBatchSize;
+    last->_next = nullptr;
+  }
+  Node *node = freeList._head;
+  freeList._head = node->_next;
+  --freeList._count;
+  return node;
+}
+
+void ASAsyncTransactionQueue::WorkStealingExecutor::recycleNode(Node *node)
+{
+  FreeList &freeList = tls_freeList;
+  node->_next = freeList._head;
+  freeList._head = node;
+  ++freeList._count;
+  
+  // Workers recycle the nodes producers allocate, so give a batch back once a thread holds two.
+  if (freeList._count == 2 * kNodeBatchSize) {
+    Node *first = freeList.detach(kNodeBatchSize);
+    Node *last = first;
+    while (last->_next) {
+      last = last->_next;
+    }
+    
+    NodePool &pool = nodePool();
+    std::lock_guard<std::mutex> l(pool._mutex);
+    last->_next = pool._freeNodes;
+    pool._freeNodes = first;
+    pool._freeCount += kNodeBatchSize;
+  }
+}
+
+ASAsyncTransactionQueue::WorkStealingExecutor::Node *ASAsyncTransactionQueue::WorkStealingExecutor::nextNode(NSUInteger workerIndex)
+{
+  const bool respectPriority = (workerIndex != 0);
+  if (Node *node = _workers[workerIndex].pop(respectPriority)) {
+    return node;
+  }
+  
+  for (NSUInteger i = 1; i < _workerCount; i++) {
+    if (Node *node = _workers[(workerIndex + i) % _workerCount].pop(true)) {
+      return node;
+    }
+  }
+  return nullptr;
+}
+
+NSInteger ASAsyncTransactionQueue::WorkStealingExecutor::claimWorker()
+{
+  for (NSUInteger i = 0; i < _workerCount; i++) {
+    bool expected = false;
+    if (_workers[i]._claimed.compare_exchange_strong(expected, true)) {
+      return i;
+    }
+  }
+  return NSNotFound;
+}
+
+void ASAsyncTransactionQueue::WorkStealingExecutor::drain(NSInteger workerIndex)
+{
+  while (true) {
+    Node *node = nextNode(workerIndex);
+    if (node == nullptr) {
+      _workers[workerIndex]._claimed.store(false);
+      --_activeWorkers;
+      
+      // A producer may have pushed after our last look but seen us as active and not spawned.
+      // It bumps _pendingCount before checking _activeWorkers, so re-checking here closes that race.
+      NSUInteger active = _activeWorkers.load();
+      if (_pendingCount.load() == 0 || active >= _workerCount || !_activeWorkers.compare_exchange_strong(active, active + 1)) {
+        return;
+      }
+      workerIndex = claimWorker();
+      if (workerIndex == NSNotFound) {
+        --_activeWorkers;
+        return;
+      }
+      continue;
+    }
+    
+    --_pendingCount;
+    Operation &operation = node->_operation;
+    if (operation._block) {
+      operation._block();
+    }
+    operation._group->leave();
+    operation._block = nil; // free the block before returning the node to the pool
+    operation._group = nullptr;
+    recycleNode(node);
+  }
+}
+
+void ASAsyncTransactionQueue::WorkStealingExecutor::schedule(dispatch_queue_t queue, const Operation &operation)
+{
+  NSCAssert(queue == _dispatchQueue, @"Work stealing executor scheduled on the wrong queue.");
+  
+  Node *node = allocNode();
+  node->_operation = operation;
+  
+  NSUInteger workerIndex = _nextWorker.fetch_add(1) % _workerCount;
+  _workers[workerIndex].push(node);
+  ++_pendingCount;
+  
+  NSUInteger maxThreads = MIN(ASAsyncTransactionQueue::maxThreadCount(), _workerCount);
+  NSUInteger active = _activeWorkers.load();
+  while (active < maxThreads) {
+    if (_activeWorkers.compare_exchange_weak(active, active + 1)) {
+      dispatch_async(_dispatchQueue, ^{
+        NSInteger index = claimWorker();
+        if (index == NSNotFound) {
+          --_activeWorkers;
+          return;
+        }
+        drain(index);
+      });
+      break;
+    }
+  }
+}
+
+void ASAsyncTransactionQueue::GroupImpl::schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block)
+{
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    ++_pendingOperations; // enter group
+  }
+  
+  Operation operation;
+  operation._block = block;
+  operation._group = this;
+  operation._priority = priority;
+  _queue.executorForQueue(queue).schedule(queue, operation);
+}
+
 void ASAsyncTransactionQueue::GroupImpl::notify(dispatch_queue_t queue, dispatch_block_t block)
 {
-  std::lock_guard<std::mutex> l(_queue._mutex);
+  std::lock_guard<std::mutex> l(_mutex);
 
   if (_pendingOperations == 0) {
     dispatch_async(queue, block);
@@ -288,36 +714,41 @@ void ASAsyncTransactionQueue::GroupImpl::notify(dispatch_queue_t queue, dispatch
 
 void ASAsyncTransactionQueue::GroupImpl::enter()
 {
-  std::lock_guard<std::mutex> l(_queue._mutex);
+  std::lock_guard<std::mutex> l(_mutex);
   ++_pendingOperations;
 }
 
 void ASAsyncTransactionQueue::GroupImpl::leave()
 {
-  std::lock_guard<std::mutex> l(_queue._mutex);
-  --_pendingOperations;
-  
-  if (_pendingOperations == 0) {
-    std::list<GroupNotify> notifyList;
-    _notifyList.swap(notifyList);
-    
-    for (GroupNotify & notify : notifyList) {
-      dispatch_async(notify._queue, notify._block);
-    }
-    
-    _condition.notify_one();
+  bool shouldDelete = false;
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    --_pendingOperations;
     
-    // there was attempt to release the group before, but we still
-    // had operations scheduled so now is good time
-    if (_releaseCalled) {
-      delete this;
+    if (_pendingOperations == 0) {
+      std::list<GroupNotify> notifyList;
+      _notifyList.swap(notifyList);
+      
+      for (GroupNotify & notify : notifyList) {
+        dispatch_async(notify._queue, notify._block);
+      }
+      
+      _condition.notify_one();
+      
+      // there was attempt to release the group before, but we still
+      // had operations scheduled so now is good time
+      shouldDelete = _releaseCalled;
     }
   }
+  
+  if (shouldDelete) {
+    delete this;
+  }
 }
 
 void ASAsyncTransactionQueue::GroupImpl::wait()
 {
-  std::unique_lock<std::mutex> lock(_queue._mutex);
+  std::unique_lock<std::mutex> lock(_mutex);
   while (_pendingOperations > 0) {
     _condition.wait(lock);
   }
@@ -338,6 +769,7 @@ ASAsyncTransactionQueue & ASAsyncTransactionQueue::instance()
 {
   ASAsyncTransactionQueue::Group *_group;
   NSMutableArray<ASAsyncTransactionOperation *> *_operations;
+  CFTimeInterval _creationTime;  // Only set if display latencies are recorded.
 }
 
 #pragma mark -
@@ -348,6 +780,9 @@ ASAsyncTransactionQueue & ASAsyncTransactionQueue::instance()
   if ((self = [self init])) {
     _completionBlock = completionBlock;
     self.state = ASAsyncTransactionStateOpen;
+    if (ASActivateExperimentalFeature(ASExperimentalAdaptiveRangeTuning)) {
+      _creationTime = CACurrentMediaTime();
+    }
   }
   return self;
 }
@@ -481,6 +916,10 @@ ASAsyncTransactionQueue & ASAsyncTransactionQueue::instance()
     // (e.g. if we needed to force one in this runloop with -waitUntilComplete, but another was already scheduled)
     self.state = ASAsyncTransactionStateComplete;
 
+    if (_creationTime > 0 && !isCanceled && _operations.count > 0) {
+      [ASAdaptiveRangeTuner recordDisplayLatency:CACurrentMediaTime() - _creationTime];
+    }
+
     if (_completionBlock) {
       _completionBlock(self, isCanceled);
     }
@@ -17,7 +17,9 @@
 
 #import <AsyncDisplayKit/ASLayout.h>
 
-#import <queue>
+#import <memory>
+
+#import <AsyncDisplayKit/ASLayoutPrivate.h>
 
 #import <AsyncDisplayKit/ASDimension.h>
 #import <AsyncDisplayKit/ASLayoutSpecUtilities.h>
@@ -74,6 +76,7 @@ ASDISPLAYNODE_INLINE AS_WARN_UNUSED_RESULT BOOL ASLayoutIsFlattened(ASLayout *la
 @interface ASLayout () <ASDescriptionProvider>
 {
   ASLayoutElementType _layoutElementType;
+  std::unique_ptr<ASLayoutFlatBuffer> _flatBuffer;
 }
 
 /*
@@ -143,7 +146,7 @@ static std::atomic_bool static_retainsSublayoutLayoutElements = ATOMIC_VAR_INIT(
     _sublayouts = sublayouts != nil ? [sublayouts copy] : @[];
 
     if (_sublayouts.count > 0) {
-      _elementToRectMap = [ASRectMap rectMapForWeakObjectPointers];
+      _elementToRectMap = [ASRectMap rectMapForWeakObjectPointersWithCapacity:_sublayouts.count];
       for (ASLayout *layout in sublayouts) {
         [_elementToRectMap setRect:layout.frame forKey:layout.layoutElement];
       }
@@ -222,25 +225,40 @@ static std::atomic_bool static_retainsSublayoutLayoutElements = ATOMIC_VAR_INIT(
     // All flattened layouts must have this flag enabled
     // to ensure sublayout elements are retained until the layouts are applied.
     self.retainSublayoutLayoutElements = YES;
+    if (_flatBuffer == nullptr) {
+      auto flatBuffer = std::make_unique<ASLayoutFlatBuffer>();
+      flatBuffer->elements.reserve(_sublayouts.count);
+      flatBuffer->frames.reserve(_sublayouts.count);
+      for (ASLayout *sublayout in _sublayouts) {
+        flatBuffer->elements.push_back(sublayout.layoutElement);
+        flatBuffer->frames.push_back(sublayout.frame);
+      }
+      _flatBuffer = std::move(flatBuffer);
+    }
     return self;
   }
   
   struct Context {
-    ASLayout *layout;
+    __unsafe_unretained ASLayout *layout;
     CGPoint absolutePosition;
   };
   
-  // Queue used to keep track of sublayouts while traversing this layout in a DFS fashion.
-  std::deque<Context> queue;
-  for (ASLayout *sublayout in self.sublayouts) {
-    queue.push_back({sublayout, sublayout.position});
-  }
+  // Stack used to keep track of sublayouts while traversing this layout in a DFS fashion.
+  // Sublayouts are pushed in reverse so they are popped in order. The layouts are retained by this layout.
+  std::vector<Context> stack;
+  const auto pushSublayouts = [&stack](NSArray<ASLayout *> *sublayouts, CGPoint absolutePosition) {
+    for (ASLayout *sublayout in [sublayouts reverseObjectEnumerator]) {
+      stack.push_back({sublayout, absolutePosition + sublayout.position});
+    }
+  };
+  pushSublayouts(self.sublayouts, CGPointZero);
   
   NSMutableArray *flattenedSublayouts = [NSMutableArray array];
+  auto flatBuffer = std::make_unique<ASLayoutFlatBuffer>();
   
-  while (!queue.empty()) {
-    const Context context = queue.front();
-    queue.pop_front();
+  while (!stack.empty()) {
+    const Context context = stack.back();
+    stack.pop_back();
     
     ASLayout *layout = context.layout;
     const NSArray<ASLayout *> *sublayouts = layout.sublayouts;
@@ -256,12 +274,10 @@ static std::atomic_bool static_retainsSublayoutLayoutElements = ATOMIC_VAR_INIT(
                                         sublayouts:@[]];
       }
       [flattenedSublayouts addObject:layout];
+      flatBuffer->elements.push_back(layout.layoutElement);
+      flatBuffer->frames.push_back(layout.frame);
     } else if (sublayoutsCount > 0){
-      std::vector<Context> sublayoutContexts;
-      for (ASLayout *sublayout in sublayouts) {
-        sublayoutContexts.push_back({sublayout, absolutePosition + sublayout.position});
-      }
-      queue.insert(queue.cbegin(), sublayoutContexts.begin(), sublayoutContexts.end());
+      pushSublayouts(sublayouts, absolutePosition);
     }
   }
   
@@ -269,6 +285,7 @@ static std::atomic_bool static_retainsSublayoutLayoutElements = ATOMIC_VAR_INIT(
   // All flattened layouts must have this flag enabled
   // to ensure sublayout elements are retained until the layouts are applied.
   layout.retainSublayoutLayoutElements = YES;
+  layout->_flatBuffer = std::move(flatBuffer);
   return layout;
 }
 
@@ -301,6 +318,11 @@ static std::atomic_bool static_retainsSublayoutLayoutElements = ATOMIC_VAR_INIT(
   return _layoutElementType;
 }
 
+- (const ASLayoutFlatBuffer *)flatBuffer
+{
+  return _flatBuffer.get();
+}
+
 - (CGRect)frameForElement:(id<ASLayoutElement>)layoutElement
 {
   return _elementToRectMap ? [_elementToRectMap rectForKey:layoutElement] : CGRectNull;
@@ -30,7 +30,6 @@
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
 #import <AsyncDisplayKit/ASElementMap.h>
 #import <AsyncDisplayKit/ASEqualityHelpers.h>
-#import <AsyncDisplayKit/ASPageTable.h>
 
 static const ASRangeTuningParameters kASDefaultMeasureRangeTuningParameters = {
   .leadingBufferScreenfuls = 2.0,
@@ -42,6 +41,7 @@ static const ASScrollDirection kASStaticScrollDirection = (ASScrollDirectionRigh
 @interface ASCollectionLayout () <ASDataControllerLayoutDelegate> {
   ASCollectionLayoutCache *_layoutCache;
   ASCollectionLayoutState *_layout; // Main thread only.
+  ASCollectionLayoutState *_invalidatedLayout; // Main thread only. Its index is reused by the next layout.
 
   struct {
     unsigned int implementsAdditionalInfoForLayoutWithElements:1;
@@ -102,12 +102,22 @@ static const ASScrollDirection kASStaticScrollDirection = (ASScrollDirectionRigh
 }
 
 + (ASCollectionLayoutState *)calculateLayoutWithContext:(ASCollectionLayoutContext *)context
+{
+  return [self _calculateLayoutWithContext:context previousLayout:nil];
+}
+
+/**
+ * Calculates a layout. If the previous layout is of the same elements, e.g. after an invalidation,
+ * the new layout updates its index instead of building it from scratch.
+ */
++ (ASCollectionLayoutState *)_calculateLayoutWithContext:(ASCollectionLayoutContext *)context previousLayout:(ASCollectionLayoutState *)previousLayout
 {
   if (context.elements == nil) {
     return [[ASCollectionLayoutState alloc] initWithContext:context];
   }
 
   ASCollectionLayoutState *layout = [context.layoutDelegateClass calculateLayoutWithContext:context];
+  [layout updateIndexFromLayoutState:previousLayout];
   [context.layoutCache setLayout:layout forContext:context];
 
   // Measure elements in the measure range ahead of time
@@ -135,6 +145,8 @@ static const ASScrollDirection kASStaticScrollDirection = (ASScrollDirectionRigh
   [super prepareLayout];
 
   ASCollectionLayoutContext *context = [self layoutContextWithElements:_collectionNode.visibleElements];
+  ASCollectionLayoutState *invalidatedLayout = _invalidatedLayout;
+  _invalidatedLayout = nil;
   if (_layout != nil && ASObjectIsEqual(_layout.context, context)) {
     // The existing layout is still valid. No-op
     return;
@@ -144,7 +156,7 @@ static const ASScrollDirection kASStaticScrollDirection = (ASScrollDirectionRigh
     _layout = cachedLayout;
   } else {
     // A new layout is needed now. Calculate and apply it immediately
-    _layout = [ASCollectionLayout calculateLayoutWithContext:context];
+    _layout = [ASCollectionLayout _calculateLayoutWithContext:context previousLayout:(invalidatedLayout ?: _layout)];
   }
 }
 
@@ -154,6 +166,7 @@ static const ASScrollDirection kASStaticScrollDirection = (ASScrollDirectionRigh
   [super invalidateLayout];
   if (_layout != nil) {
     [_layoutCache removeLayoutForContext:_layout.context];
+    _invalidatedLayout = _layout;
     _layout = nil;
   }
 }
@@ -304,39 +317,21 @@ static const ASScrollDirection kASStaticScrollDirection = (ASScrollDirectionRigh
   }
 
   // Step 2: Get layout attributes of all elements within the specified outer rect
-  ASPageToLayoutAttributesTable *attrsTable = [layout getAndRemoveUnmeasuredLayoutAttributesPageTableInRect:rect];
-  if (attrsTable.count == 0) {
+  NSArray<UICollectionViewLayoutAttributes *> *attrsInRect = [layout getAndRemoveUnmeasuredLayoutAttributesInRect:rect];
+  if (attrsInRect.count == 0) {
     // No elements in this rect! Bail early
     return;
   }
 
   // Step 3: Split all those attributes into blocking and non-blocking buckets
-  // Use ordered sets here because some items may span multiple pages, and the sets will be accessed by indexes later on.
   ASCollectionLayoutContext *context = layout.context;
-  CGSize pageSize = context.viewportSize;
-  NSMutableOrderedSet<UICollectionViewLayoutAttributes *> *blockingAttrs = hasBlockingRect ? [NSMutableOrderedSet orderedSet] : nil;
-  NSMutableOrderedSet<UICollectionViewLayoutAttributes *> *nonBlockingAttrs = [NSMutableOrderedSet orderedSet];
-  for (id pagePtr in attrsTable) {
-    ASPageCoordinate page = (ASPageCoordinate)pagePtr;
-    NSArray<UICollectionViewLayoutAttributes *> *attrsInPage = [attrsTable objectForPage:page];
-    // Calculate the page's rect but only if it's going to be used.
-    CGRect pageRect = hasBlockingRect ? ASPageCoordinateGetPageRect(page, pageSize) : CGRectZero;
-
-    if (hasBlockingRect && CGRectContainsRect(blockingRect, pageRect)) {
-      // The page fits well within the blocking rect. All attributes in this page are blocking.
-      [blockingAttrs addObjectsFromArray:attrsInPage];
-    } else if (hasBlockingRect && CGRectIntersectsRect(blockingRect, pageRect)) {
-      // The page intersects the blocking rect. Some elements in this page are blocking, some are not.
-      for (UICollectionViewLayoutAttributes *attrs in attrsInPage) {
-        if (CGRectIntersectsRect(blockingRect, attrs.frame)) {
-          [blockingAttrs addObject:attrs];
-        } else {
-          [nonBlockingAttrs addObject:attrs];
-        }
-      }
+  NSMutableArray<UICollectionViewLayoutAttributes *> *blockingAttrs = hasBlockingRect ? [NSMutableArray array] : nil;
+  NSMutableArray<UICollectionViewLayoutAttributes *> *nonBlockingAttrs = [NSMutableArray array];
+  for (UICollectionViewLayoutAttributes *attrs in attrsInRect) {
+    if (hasBlockingRect && CGRectIntersectsRect(blockingRect, attrs.frame)) {
+      [blockingAttrs addObject:attrs];
     } else {
-      // The page doesn't intersect the blocking rect. All elements in this page are non-blocking.
-      [nonBlockingAttrs addObjectsFromArray:attrsInPage];
+      [nonBlockingAttrs addObject:attrs];
     }
   }
 
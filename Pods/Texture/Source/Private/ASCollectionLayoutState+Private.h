@@ -11,18 +11,27 @@
 //
 
 #import <AsyncDisplayKit/ASCollectionLayoutState.h>
-#import <AsyncDisplayKit/ASPageTable.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
 @interface ASCollectionLayoutState (Private)
 
 /**
- * Remove and returns layout attributes for unmeasured elements that intersect the specified rect
+ * Remove and returns layout attributes for unmeasured elements that intersect the specified rect.
+ * Each layout attributes is returned at most once.
  *
  * @discussion This method is atomic and thread-safe
  */
-- (nullable ASPageToLayoutAttributesTable *)getAndRemoveUnmeasuredLayoutAttributesPageTableInRect:(CGRect)rect;
+- (nullable NSArray<UICollectionViewLayoutAttributes *> *)getAndRemoveUnmeasuredLayoutAttributesInRect:(CGRect)rect;
+
+/**
+ * Takes over the page index of an earlier state of the same elements and moves only the items whose
+ * frames changed, instead of indexing every item again. Does nothing if the elements, content size or
+ * viewport differ, in which case the index is built on first use as usual.
+ *
+ * @discussion Call before the receiver is queried, since it may reorder -allLayoutAttributes.
+ */
+- (void)updateIndexFromLayoutState:(nullable ASCollectionLayoutState *)layoutState;
 
 @end
 
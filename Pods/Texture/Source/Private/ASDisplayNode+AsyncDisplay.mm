@@ -25,11 +25,231 @@
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/ASSignpost.h>
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
+#import <AsyncDisplayKit/ASWeakProxy.h>
+
+#import <algorithm>
+#import <vector>
 
 
 @interface ASDisplayNode () <_ASDisplayLayerDelegate>
 @end
 
+#pragma mark - Tiled Display
+
+typedef std::vector<std::pair<NSInteger, CGRect>> ASDisplayTileList;
+
+/// The part of the layer's bounds that is on screen, or CGRectNull if the layer isn't in a layer tree.
+static CGRect ASDisplayTileVisibleRect(CALayer *layer)
+{
+  CALayer *rootLayer = layer;
+  while (rootLayer.superlayer != nil) {
+    rootLayer = rootLayer.superlayer;
+  }
+  if (rootLayer == layer) {
+    return CGRectNull;
+  }
+  return CGRectIntersection([layer convertRect:rootLayer.bounds fromLayer:rootLayer], layer.bounds);
+}
+
+/// The visible rect plus roughly a screen's worth around it. Tiles in it are kept on memory warnings.
+static CGRect ASDisplayTileKeptRect(CGRect visibleRect)
+{
+  return CGRectIsNull(visibleRect) ? CGRectNull : CGRectInset(visibleRect, -visibleRect.size.width, -visibleRect.size.height);
+}
+
+@interface _ASDisplayTileLayer : CALayer
+@end
+
+@implementation _ASDisplayTileLayer
+
++ (id<CAAction>)defaultActionForKey:(NSString *)event
+{
+  return (id)kCFNull;
+}
+
+@end
+
+/**
+ * Holds the tile layers of a node that displays in tiles. Its bounds match the node layer's bounds, and it sits
+ * below the node's sublayers. Main thread only.
+ *
+ * Tiles dropped on a memory warning are remembered. While the container monitors its visible rect, it checks it
+ * every frame and calls evictedTilesBecameVisibleBlock once a dropped tile scrolls near the screen again.
+ */
+@interface _ASDisplayTileContainerLayer : CALayer
+
+/// Called when the visible rect changes and dropped tiles are near it.
+@property (nonatomic, copy) void (^evictedTilesBecameVisibleBlock)(void);
+
+/// Whether to check the visible rect for dropped tiles. Set while the node is visible.
+@property (nonatomic) BOOL monitorsVisibleRect;
+
+/// Drops tiles that don't belong to a grid of the given size, and forgets dropped tiles.
+- (void)prepareForColumns:(NSInteger)columns rows:(NSInteger)rows;
+
+- (void)setTileContents:(CGImageRef)contents scale:(CGFloat)scale atIndex:(NSInteger)index frame:(CGRect)frame;
+
+/// Returns the dropped tiles intersecting the rect, and stops tracking them since the caller redraws them.
+- (ASDisplayTileList)takeEvictedTilesInRect:(CGRect)rect;
+
+- (void)removeAllTiles;
+
+@end
+
+@implementation _ASDisplayTileContainerLayer {
+  NSMutableDictionary<NSNumber *, _ASDisplayTileLayer *> *_tiles;
+  NSInteger _columns;
+  // The frames of tiles dropped on a memory warning, by index.
+  NSMutableDictionary<NSNumber *, NSValue *> *_evictedTileFrames;
+  CADisplayLink *_displayLink;
+  CGRect _lastVisibleRect;
+}
+
++ (id<CAAction>)defaultActionForKey:(NSString *)event
+{
+  return (id)kCFNull;
+}
+
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _tiles = [NSMutableDictionary dictionary];
+    _evictedTileFrames = [NSMutableDictionary dictionary];
+    _lastVisibleRect = CGRectNull;
+    // Stay below the node's subnode layers, whatever index they are inserted at.
+    self.zPosition = -1;
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(didReceiveMemoryWarning:)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
+  }
+  return self;
+}
+
+- (void)dealloc
+{
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+  [_displayLink invalidate];
+}
+
+- (void)setMonitorsVisibleRect:(BOOL)monitorsVisibleRect
+{
+  ASDisplayNodeAssertMainThread();
+  _monitorsVisibleRect = monitorsVisibleRect;
+  [self updateDisplayLink];
+}
+
+- (void)prepareForColumns:(NSInteger)columns rows:(NSInteger)rows
+{
+  ASDisplayNodeAssertMainThread();
+  if (columns != _columns) {
+    [self removeAllTiles];
+    _columns = columns;
+  } else {
+    NSInteger count = columns * rows;
+    for (NSNumber *index in _tiles.allKeys) {
+      if (index.integerValue >= count) {
+        [_tiles[index] removeFromSuperlayer];
+        [_tiles removeObjectForKey:index];
+      }
+    }
+  }
+  [_evictedTileFrames removeAllObjects];
+  [self updateDisplayLink];
+}
+
+- (void)setTileContents:(CGImageRef)contents scale:(CGFloat)scale atIndex:(NSInteger)index frame:(CGRect)frame
+{
+  ASDisplayNodeAssertMainThread();
+  _ASDisplayTileLayer *tile = _tiles[@(index)];
+  if (tile == nil) {
+    tile = [_ASDisplayTileLayer layer];
+    _tiles[@(index)] = tile;
+    [self addSublayer:tile];
+  }
+  tile.frame = frame;
+  tile.contentsScale = scale;
+  tile.contents = (__bridge id)contents;
+}
+
+- (ASDisplayTileList)takeEvictedTilesInRect:(CGRect)rect
+{
+  ASDisplayNodeAssertMainThread();
+  ASDisplayTileList tiles;
+  for (NSNumber *index in _evictedTileFrames.allKeys) {
+    CGRect frame = _evictedTileFrames[index].CGRectValue;
+    if (CGRectIntersectsRect(frame, rect)) {
+      tiles.push_back({index.integerValue, frame});
+      [_evictedTileFrames removeObjectForKey:index];
+    }
+  }
+  [self updateDisplayLink];
+  return tiles;
+}
+
+- (void)removeAllTiles
+{
+  ASDisplayNodeAssertMainThread();
+  for (_ASDisplayTileLayer *tile in _tiles.objectEnumerator) {
+    [tile removeFromSuperlayer];
+  }
+  [_tiles removeAllObjects];
+  [_evictedTileFrames removeAllObjects];
+  [self updateDisplayLink];
+}
+
+- (void)didReceiveMemoryWarning:(NSNotification *)notification
+{
+  ASDisplayNodeAssertMainThread();
+  CGRect keptRect = ASDisplayTileKeptRect(ASDisplayTileVisibleRect(self));
+  for (NSNumber *index in _tiles.allKeys) {
+    _ASDisplayTileLayer *tile = _tiles[index];
+    if (!CGRectIntersectsRect(tile.frame, keptRect)) {
+      _evictedTileFrames[index] = [NSValue valueWithCGRect:tile.frame];
+      [tile removeFromSuperlayer];
+      [_tiles removeObjectForKey:index];
+    }
+  }
+  _lastVisibleRect = CGRectNull;
+  [self updateDisplayLink];
+}
+
+/// Runs the display link only while there are dropped tiles to bring back.
+- (void)updateDisplayLink
+{
+  BOOL needsDisplayLink = (_monitorsVisibleRect && _evictedTileFrames.count > 0);
+  if (needsDisplayLink && _displayLink == nil) {
+    _displayLink = [CADisplayLink displayLinkWithTarget:[ASWeakProxy weakProxyWithTarget:self] selector:@selector(displayLinkFired:)];
+    // Common modes, so that the check keeps running while a scroll view is tracking.
+    [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+  } else if (!needsDisplayLink && _displayLink != nil) {
+    [_displayLink invalidate];
+    _displayLink = nil;
+    _lastVisibleRect = CGRectNull;
+  }
+}
+
+- (void)displayLinkFired:(CADisplayLink *)displayLink
+{
+  CGRect visibleRect = ASDisplayTileVisibleRect(self);
+  if (CGRectEqualToRect(visibleRect, _lastVisibleRect)) {
+    return;
+  }
+  _lastVisibleRect = visibleRect;
+
+  CGRect keptRect = ASDisplayTileKeptRect(visibleRect);
+  for (NSValue *frame in _evictedTileFrames.objectEnumerator) {
+    if (CGRectIntersectsRect(frame.CGRectValue, keptRect)) {
+      if (_evictedTilesBecameVisibleBlock) {
+        _evictedTilesBecameVisibleBlock();
+      }
+      return;
+    }
+  }
+}
+
+@end
+
 @implementation ASDisplayNode (AsyncDisplay)
 
 #if ASDISPLAYNODE_DELAY_DISPLAY
@@ -266,18 +486,18 @@
   }
 
   /**
-   If we're profiling, wrap the display block with signpost start and end.
+   If we're profiling or recording a trace, wrap the display block with signpost start and end.
    Color the interval red if cancelled, green otherwise.
    */
-#if AS_KDEBUG_ENABLE
-  __unsafe_unretained id ptrSelf = self;
-  displayBlock = ^{
-    ASSignpostStartCustom(ASSignpostLayerDisplay, ptrSelf, 0);
-    id result = displayBlock();
-    ASSignpostEndCustom(ASSignpostLayerDisplay, ptrSelf, 0, isCancelledBlock() ? ASSignpostColorRed : ASSignpostColorGreen);
-    return result;
-  };
-#endif
+  if (displayBlock != nil && (AS_KDEBUG_ENABLE || ASTraceRecorderIsEnabled())) {
+    __unsafe_unretained id ptrSelf = self;
+    displayBlock = ^{
+      ASSignpostStartCustom(ASSignpostLayerDisplay, ptrSelf, 0);
+      id result = displayBlock();
+      ASSignpostEndCustom(ASSignpostLayerDisplay, ptrSelf, 0, isCancelledBlock() ? ASSignpostColorRed : ASSignpostColorGreen);
+      return result;
+    };
+  }
 
   return displayBlock;
 }
@@ -402,6 +622,10 @@
     };
   }
 
+  if ([self _displayInTilesAsynchronously:asynchronously isCancelledBlock:isCancelledBlock]) {
+    return;
+  }
+
   // Set up displayBlock to call either display or draw on the delegate and return a UIImage contents
   asyncdisplaykit_async_transaction_operation_block_t displayBlock = [self _displayBlockWithAsynchronous:asynchronously isCancelledBlock:isCancelledBlock rasterizing:NO];
   
@@ -463,6 +687,186 @@
   }
 }
 
+/**
+ * Draws the node as a grid of tiles if it displays in tiles and can be tiled, with one transaction operation per
+ * tile. Returns NO if the node should be displayed as a single bitmap instead.
+ */
+- (BOOL)_displayInTilesAsynchronously:(BOOL)asynchronously isCancelledBlock:(asdisplaynode_iscancelled_block_t)isCancelledBlock
+{
+  ASDisplayNodeAssertMainThread();
+
+  __instanceLock__.lock();
+  ASDisplayNodeFlags flags = _flags;
+  BOOL precompositesCorners = (_cornerRoundingType == ASCornerRoundingTypePrecomposited && _cornerRadius > 0.0);
+  CALayer *layer = _layer;
+  __instanceLock__.unlock();
+
+  CGRect bounds = self.bounds;
+  CGSize tileSize = self.displayTileSize;
+  BOOL canTile = (self.displaysInTiles && flags.implementsDrawRect && !flags.implementsImageDisplay && !flags.rasterizesSubtree
+                  && !precompositesCorners && tileSize.width > 0 && tileSize.height > 0);
+  if (!canTile || (bounds.size.width <= tileSize.width && bounds.size.height <= tileSize.height)) {
+    [_tileContainerLayer removeFromSuperlayer];
+    _tileContainerLayer = nil;
+    return NO;
+  }
+
+  if (_tileContainerLayer == nil) {
+    _tileContainerLayer = [_ASDisplayTileContainerLayer layer];
+    __weak ASDisplayNode *weakSelf = self;
+    _tileContainerLayer.evictedTilesBecameVisibleBlock = ^{
+      [weakSelf _redisplayEvictedTiles];
+    };
+    _tileContainerLayer.monitorsVisibleRect = self.isVisible;
+    [layer insertSublayer:_tileContainerLayer atIndex:0];
+  }
+  _ASDisplayTileContainerLayer *container = _tileContainerLayer;
+  container.bounds = bounds;
+  container.position = CGPointMake(CGRectGetMidX(bounds), CGRectGetMidY(bounds));
+
+  NSInteger columns = (NSInteger)ceil(bounds.size.width / tileSize.width);
+  NSInteger rows = (NSInteger)ceil(bounds.size.height / tileSize.height);
+  [container prepareForColumns:columns rows:rows];
+
+  ASDisplayTileList tiles;
+  tiles.reserve(columns * rows);
+  for (NSInteger row = 0; row < rows; row++) {
+    for (NSInteger column = 0; column < columns; column++) {
+      CGRect tileRect = CGRectMake(bounds.origin.x + column * tileSize.width, bounds.origin.y + row * tileSize.height, tileSize.width, tileSize.height);
+      tiles.push_back({row * columns + column, CGRectIntersection(tileRect, bounds)});
+    }
+  }
+
+  [self willDisplayAsyncLayer:self.asyncLayer asynchronously:asynchronously];
+  [self _displayTiles:tiles inContainer:container asynchronously:asynchronously isCancelledBlock:isCancelledBlock completion:^{
+    [self didDisplayAsyncLayer:self.asyncLayer];
+  }];
+  return YES;
+}
+
+/**
+ * Draws the given tiles into the container, one transaction operation per tile. Tiles in the visible rect go
+ * first, with a slightly higher priority. Each tile only draws its own rect.
+ */
+- (void)_displayTiles:(ASDisplayTileList)tiles
+          inContainer:(_ASDisplayTileContainerLayer *)container
+       asynchronously:(BOOL)asynchronously
+     isCancelledBlock:(asdisplaynode_iscancelled_block_t)isCancelledBlock
+           completion:(void (^)(void))completion
+{
+  ASDisplayNodeAssertMainThread();
+
+  __instanceLock__.lock();
+  CALayer *layer = _layer;
+  CGFloat contentsScaleForDisplay = _contentsScaleForDisplay;
+  __instanceLock__.unlock();
+
+  BOOL opaque = self.opaque;
+  UIColor *backgroundColor = self.backgroundColor;
+  CGColorRef borderColor = self.borderColor;
+  CGFloat borderWidth = self.borderWidth;
+  id drawParameters = [self drawParameters];
+  NSInteger drawingPriority = self.drawingPriority;
+
+  CGRect visibleRect = ASDisplayTileVisibleRect(layer);
+  std::stable_partition(tiles.begin(), tiles.end(), [&](const std::pair<NSInteger, CGRect> &tile) {
+    return CGRectIntersectsRect(tile.second, visibleRect);
+  });
+
+  _ASAsyncTransaction *transaction = nil;
+  if (asynchronously) {
+    CALayer *containerLayer = layer.asyncdisplaykit_parentTransactionContainer ? : layer;
+    transaction = containerLayer.asyncdisplaykit_asyncTransaction;
+  }
+
+  __block NSUInteger remainingTiles = tiles.size();
+  for (const auto &tile : tiles) {
+    NSInteger index = tile.first;
+    CGRect tileRect = tile.second;
+
+    asyncdisplaykit_async_transaction_operation_block_t displayBlock = ^id{
+      CHECK_CANCELLED_AND_RETURN_NIL();
+
+      ASGraphicsBeginImageContextWithOptions(tileRect.size, opaque, contentsScaleForDisplay);
+      CGContextRef context = UIGraphicsGetCurrentContext();
+      CGContextTranslateCTM(context, -tileRect.origin.x, -tileRect.origin.y);
+      CGContextClipToRect(context, tileRect);
+
+      UIImage *image = nil;
+      [self __willDisplayNodeContentWithRenderingContext:context drawParameters:drawParameters];
+      [self.class drawRect:tileRect withParameters:drawParameters isCancelled:isCancelledBlock isRasterizing:NO];
+      [self __didDisplayNodeContentWithRenderingContext:context image:&image drawParameters:drawParameters backgroundColor:backgroundColor borderWidth:borderWidth borderColor:borderColor];
+
+      CHECK_CANCELLED_AND_RETURN_NIL( ASGraphicsEndImageContext(); );
+      image = ASGraphicsGetImageAndEndCurrentContext();
+
+      ASDN_DELAY_FOR_DISPLAY();
+      return image;
+    };
+
+    asyncdisplaykit_async_transaction_operation_completion_block_t completionBlock = ^(id<NSObject> value, BOOL canceled){
+      ASDisplayNodeCAssertMainThread();
+      if (canceled || isCancelledBlock()) {
+        return;
+      }
+      // The tiles replace any contents from a previous, untiled display.
+      if (layer.contents != nil) {
+        layer.contents = nil;
+      }
+      [container setTileContents:((UIImage *)value).CGImage scale:contentsScaleForDisplay atIndex:index frame:tileRect];
+      if (--remainingTiles == 0 && completion) {
+        completion();
+      }
+    };
+
+    if (asynchronously) {
+      NSInteger priority = drawingPriority + (CGRectIntersectsRect(tileRect, visibleRect) ? 1 : 0);
+      [transaction addOperationWithBlock:displayBlock priority:priority queue:[_ASDisplayLayer displayQueue] completion:completionBlock];
+    } else {
+      completionBlock(displayBlock(), NO);
+    }
+  }
+}
+
+- (void)_clearTiles
+{
+  ASDisplayNodeAssertMainThread();
+  [_tileContainerLayer removeAllTiles];
+}
+
+- (void)_setTilesMonitorVisibleRect:(BOOL)monitorsVisibleRect
+{
+  ASDisplayNodeAssertMainThread();
+  _tileContainerLayer.monitorsVisibleRect = monitorsVisibleRect;
+  if (monitorsVisibleRect) {
+    [self _redisplayEvictedTiles];
+  }
+}
+
+/// Redraws the tiles dropped on a memory warning that are near the visible rect, without redrawing the others.
+- (void)_redisplayEvictedTiles
+{
+  ASDisplayNodeAssertMainThread();
+  _ASDisplayTileContainerLayer *container = _tileContainerLayer;
+  if (container == nil) {
+    return;
+  }
+
+  ASDisplayTileList tiles = [container takeEvictedTilesInRect:ASDisplayTileKeptRect(ASDisplayTileVisibleRect(container))];
+  if (tiles.empty()) {
+    return;
+  }
+
+  // Don't bump the display sentinel, so that a display in flight carries on, but give way to any later display.
+  uint displaySentinelValue = _displaySentinel.load();
+  __weak ASDisplayNode *weakSelf = self;
+  asdisplaynode_iscancelled_block_t isCancelledBlock = ^BOOL{
+    __strong ASDisplayNode *self = weakSelf;
+    return self == nil || (displaySentinelValue != self->_displaySentinel.load());
+  };
+  [self _displayTiles:tiles inContainer:container asynchronously:YES isCancelledBlock:isCancelledBlock completion:nil];
+}
+
 - (void)cancelDisplayAsyncLayer:(_ASDisplayLayer *)asyncLayer
 {
   _displaySentinel.fetch_add(1);
@@ -290,6 +290,17 @@ __unused static NSString * _Nonnull NSStringFromASHierarchyStateChange(ASHierarc
  */
 - (void)_layoutSublayouts;
 
+/**
+ * Returns the layout that another node of the same class and layoutContentHash calculated for constrainedSize, rebound
+ * to the nodes in layoutElement, or nil if there is none.
+ */
+- (nullable ASLayout *)_locked_memoizedLayoutThatFits:(ASSizeRange)constrainedSize layoutElement:(id<ASLayoutElement>)layoutElement;
+
+/**
+ * Shares a flattened layout calculated from layoutElement with other nodes of the same class and layoutContentHash.
+ */
+- (void)_locked_memoizeLayout:(ASLayout *)layout constrainedSize:(ASSizeRange)constrainedSize layoutElement:(id<ASLayoutElement>)layoutElement;
+
 @end
 
 @interface ASDisplayNode (ASLayoutTransitionInternal)
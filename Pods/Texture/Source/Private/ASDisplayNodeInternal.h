@@ -33,6 +33,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 @protocol _ASDisplayLayerDelegate;
 @class _ASDisplayLayer;
+@class _ASDisplayTileContainerLayer;
 @class _ASPendingState;
 struct ASDisplayNodeFlags;
 
@@ -162,6 +163,8 @@ FOUNDATION_EXPORT NSString * const ASRenderingEngineDidDisplayNodesScheduledBefo
   /// Sentinel for layout data. Incremented when we get -setNeedsLayout / -invalidateCalculatedLayout.
   /// Starts at 1.
   std::atomic<NSUInteger> _layoutVersion;
+
+  NSUInteger _layoutContentHash;
   
   ASDisplayNodeViewBlock _viewBlock;
   ASDisplayNodeLayerBlock _layerBlock;
@@ -173,6 +176,9 @@ FOUNDATION_EXPORT NSString * const ASRenderingEngineDidDisplayNodesScheduledBefo
   BOOL _placeholderEnabled;
   CALayer *_placeholderLayer;
 
+  // Holds the tile layers when displaysInTiles is enabled. Main thread only.
+  _ASDisplayTileContainerLayer *_tileContainerLayer;
+
   // keeps track of nodes/subnodes that have not finished display, used with placeholders
   ASWeakSet *_pendingDisplayNodes;
   
@@ -349,6 +355,16 @@ FOUNDATION_EXPORT NSString * const ASRenderingEngineDidDisplayNodesScheduledBefo
 
 @end
 
+@interface ASDisplayNode (AsyncDisplay)
+
+/// Releases the contents of all tiles, if the node displays in tiles. Main thread only.
+- (void)_clearTiles;
+
+/// Starts or stops redrawing tiles dropped on a memory warning as they come near the screen. Main thread only.
+- (void)_setTilesMonitorVisibleRect:(BOOL)monitorsVisibleRect;
+
+@end
+
 @interface ASDisplayNode (InternalPropertyBridge)
 
 @property (nonatomic) CGFloat layerCornerRadius;
@@ -0,0 +1,207 @@
+//
+//  ASPageBucketIndex.h
+//  Texture
+//
+//  Copyright (c) 2017-present, Pinterest, Inc.  All rights reserved.
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CGGeometry.h>
+
+#import <cmath>
+#import <vector>
+
+/**
+ * Buckets the indexes of items by the pages of a uniform grid that their frames overlap.
+ * All buckets share one contiguous array, with an offset per page, so a rect query only
+ * visits the pages it covers and never allocates.
+ */
+struct ASPageBucketIndex {
+  struct PageRange {
+    NSInteger minColumn, maxColumn, minRow, maxRow;
+  };
+
+  /// The indexes of the items in one page, in increasing order.
+  struct Span {
+    const uint32_t *first;
+    const uint32_t *last;
+
+    const uint32_t *begin() const { return first; }
+    const uint32_t *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+  };
+
+  CGSize pageSize = CGSizeZero;
+  NSInteger columns = 0;
+  NSInteger rows = 0;
+  std::vector<CGRect> frames;
+  // Offsets into pageItems for each page, plus a trailing end offset.
+  std::vector<uint32_t> pageStarts;
+  std::vector<uint32_t> pageItems;
+
+  /**
+   * Indexes the given frames. Pages have the preferred size, unless that would make for
+   * many more pages than items.
+   */
+  void build(std::vector<CGRect> &&newFrames, CGSize contentSize, CGSize preferredPageSize)
+  {
+    frames = std::move(newFrames);
+
+    CGSize size = (preferredPageSize.width > 0 && preferredPageSize.height > 0) ? preferredPageSize : contentSize;
+    if (frames.empty() || size.width <= 0 || size.height <= 0) {
+      // Nothing to subdivide. Keep a single page holding everything.
+      size = CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX);
+    }
+
+    // Avoid a grid that's much sparser than the number of items, e.g. for a tiny viewport.
+    const CGFloat maxPages = MAX(frames.size() * 4, (size_t)64);
+    columns = MAX(1, (NSInteger)ceil(contentSize.width / size.width));
+    rows = MAX(1, (NSInteger)ceil(contentSize.height / size.height));
+    if ((CGFloat)columns * rows > maxPages) {
+      CGFloat scale = sqrt(((CGFloat)columns * rows) / maxPages);
+      size = CGSizeMake(size.width * scale, size.height * scale);
+      columns = MAX(1, (NSInteger)ceil(contentSize.width / size.width));
+      rows = MAX(1, (NSInteger)ceil(contentSize.height / size.height));
+    }
+    pageSize = size;
+
+    // Count the items in each page, turn the counts into offsets, then fill the pages.
+    pageStarts.assign(columns * rows + 1, 0);
+    for (const CGRect &frame : frames) {
+      forEachPage(frame, [&](NSInteger page) { pageStarts[page + 1]++; });
+    }
+    for (size_t i = 1; i < pageStarts.size(); i++) {
+      pageStarts[i] += pageStarts[i - 1];
+    }
+    pageItems.resize(pageStarts.back());
+    std::vector<uint32_t> cursors(pageStarts.begin(), pageStarts.end() - 1);
+    for (uint32_t i = 0; i < frames.size(); i++) {
+      forEachPage(frames[i], [&](NSInteger page) { pageItems[cursors[page]++] = i; });
+    }
+  }
+
+  /**
+   * Replaces the frames of the items in [first, first + count) and moves them between pages,
+   * without revisiting the other items. The pages keep their size.
+   */
+  void updateFrames(uint32_t first, const CGRect *newFrames, uint32_t count)
+  {
+    const uint32_t last = first + count;
+    bool pagesChanged = false;
+    for (uint32_t i = 0; i < count; i++) {
+      PageRange oldRange = pageRangeForRect(frames[first + i]);
+      PageRange newRange = pageRangeForRect(newFrames[i]);
+      pagesChanged = pagesChanged || CGRectIsNull(frames[first + i]) != CGRectIsNull(newFrames[i])
+        || oldRange.minColumn != newRange.minColumn || oldRange.maxColumn != newRange.maxColumn
+        || oldRange.minRow != newRange.minRow || oldRange.maxRow != newRange.maxRow;
+      frames[first + i] = newFrames[i];
+    }
+    if (!pagesChanged) {
+      return;
+    }
+
+    // Each page keeps its items below the range, then gets the updated items, then keeps its items
+    // above the range, so the pages stay sorted.
+    const NSInteger pageCount = columns * rows;
+    std::vector<uint32_t> starts(pageCount + 1, 0);
+    for (NSInteger page = 0; page < pageCount; page++) {
+      for (uint32_t item : itemsInPage(page)) {
+        starts[page + 1] += (item < first || item >= last);
+      }
+    }
+    for (uint32_t i = first; i < last; i++) {
+      forEachPage(frames[i], [&](NSInteger page) { starts[page + 1]++; });
+    }
+    for (size_t i = 1; i < starts.size(); i++) {
+      starts[i] += starts[i - 1];
+    }
+
+    std::vector<uint32_t> items(starts.back());
+    std::vector<uint32_t> cursors(starts.begin(), starts.end() - 1);
+    for (NSInteger page = 0; page < pageCount; page++) {
+      for (uint32_t item : itemsInPage(page)) {
+        if (item >= first) {
+          break;
+        }
+        items[cursors[page]++] = item;
+      }
+    }
+    for (uint32_t i = first; i < last; i++) {
+      forEachPage(frames[i], [&](NSInteger page) { items[cursors[page]++] = i; });
+    }
+    for (NSInteger page = 0; page < pageCount; page++) {
+      for (uint32_t item : itemsInPage(page)) {
+        if (item >= last) {
+          items[cursors[page]++] = item;
+        }
+      }
+    }
+    pageStarts = std::move(starts);
+    pageItems = std::move(items);
+  }
+
+  /// Pages covered by the rect. Anything outside the content is clamped into the border pages.
+  PageRange pageRangeForRect(CGRect rect) const
+  {
+    // Clamp before converting so that huge rects, e.g. CGRectInfinite, stay in range.
+    auto clamp = [](CGFloat value, NSInteger count) {
+      return (NSInteger)MIN(MAX(floor(value), (CGFloat)0), (CGFloat)(count - 1));
+    };
+    return {
+      clamp(CGRectGetMinX(rect) / pageSize.width, columns),
+      clamp(CGRectGetMaxX(rect) / pageSize.width, columns),
+      clamp(CGRectGetMinY(rect) / pageSize.height, rows),
+      clamp(CGRectGetMaxY(rect) / pageSize.height, rows),
+    };
+  }
+
+  Span itemsInPage(NSInteger page) const
+  {
+    return { pageItems.data() + pageStarts[page], pageItems.data() + pageStarts[page + 1] };
+  }
+
+  template <typename F>
+  void forEachPage(CGRect frame, F f) const
+  {
+    if (CGRectIsNull(frame)) {
+      return;
+    }
+    PageRange range = pageRangeForRect(frame);
+    for (NSInteger row = range.minRow; row <= range.maxRow; row++) {
+      for (NSInteger column = range.minColumn; column <= range.maxColumn; column++) {
+        f(row * columns + column);
+      }
+    }
+  }
+
+  /// Calls f with the index of every frame that intersects the rect, once each.
+  template <typename F>
+  void forEachItemIntersectingRect(CGRect rect, F f) const
+  {
+    if (frames.empty() || CGRectIsNull(rect)) {
+      return;
+    }
+    PageRange range = pageRangeForRect(rect);
+    for (NSInteger row = range.minRow; row <= range.maxRow; row++) {
+      for (NSInteger column = range.minColumn; column <= range.maxColumn; column++) {
+        for (uint32_t item : itemsInPage(row * columns + column)) {
+          const CGRect &frame = frames[item];
+          // An item spanning several pages is only reported from the first page it shares with the query.
+          PageRange itemRange = pageRangeForRect(frame);
+          if (MAX(itemRange.minColumn, range.minColumn) != column || MAX(itemRange.minRow, range.minRow) != row) {
+            continue;
+          }
+          if (CGRectIntersectsRect(rect, frame)) {
+            f(item);
+          }
+        }
+      }
+    }
+  }
+};
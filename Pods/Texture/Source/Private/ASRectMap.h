@@ -17,14 +17,23 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * A category for indexing weak pointers to CGRects. Similar to ASIntegerMap.
+ *
+ * The rects are stored inline in a single open-addressed table. Copies share
+ * that table until one of them is mutated.
  */
-@interface ASRectMap : NSObject
+@interface ASRectMap : NSObject <NSCopying>
 
 /**
  * Creates a new rect map. The keys are never retained.
  */
 + (ASRectMap *)rectMapForWeakObjectPointers NS_RETURNS_RETAINED;
 
+/**
+ * Creates a new rect map with room for the given number of keys, so that
+ * setting them doesn't have to grow the table. The keys are never retained.
+ */
++ (ASRectMap *)rectMapForWeakObjectPointersWithCapacity:(NSUInteger)capacity NS_RETURNS_RETAINED;
+
 /**
  * Retrieves the rect for a given key, or CGRectNull if the key is not found.
  *
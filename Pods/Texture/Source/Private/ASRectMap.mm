@@ -13,10 +13,123 @@
 #import "ASRectMap.h"
 #import "ASObjectDescriptionHelpers.h"
 #import <UIKit/UIGeometry.h>
-#import <unordered_map>
+#import <algorithm>
+#import <memory>
+#import <vector>
+
+namespace {
+
+/**
+ * An open-addressed table from pointers to rects with linear probing. The
+ * capacity is a power of two, and the table is kept at most 3/4 full,
+ * counting slots whose keys were removed.
+ */
+struct ASRectTable {
+  struct Slot {
+    void *key;
+    CGRect rect;
+  };
+
+  std::vector<Slot> slots;
+  size_t count = 0;
+  size_t used = 0;
+
+  static void *removedKey() { return reinterpret_cast<void *>(uintptr_t(1)); }
+
+  static size_t capacityForCount(size_t count)
+  {
+    size_t capacity = 8;
+    while (capacity * 3 < count * 4) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  size_t indexForKey(void *key) const
+  {
+    // Objects are at least 16-byte aligned, so drop the low bits before mixing.
+    uint64_t h = uint64_t(reinterpret_cast<uintptr_t>(key) >> 4) * 0x9E3779B97F4A7C15ULL;
+    return size_t(h ^ (h >> 32)) & (slots.size() - 1);
+  }
+
+  const Slot *find(void *key) const
+  {
+    if (slots.empty()) {
+      return nullptr;
+    }
+    for (size_t i = indexForKey(key); ; i = (i + 1) & (slots.size() - 1)) {
+      const Slot &slot = slots[i];
+      if (slot.key == key) {
+        return &slot;
+      } else if (slot.key == nullptr) {
+        return nullptr;
+      }
+    }
+  }
+
+  void reserve(size_t newCount)
+  {
+    size_t capacity = capacityForCount(newCount);
+    if (capacity <= slots.size() && (used + 1) * 4 <= slots.size() * 3) {
+      return;
+    }
+    capacity = std::max(capacity, slots.size());
+
+    std::vector<Slot> oldSlots(capacity, Slot{nullptr, CGRectNull});
+    oldSlots.swap(slots);
+    used = count;
+    for (const Slot &slot : oldSlots) {
+      if (slot.key != nullptr && slot.key != removedKey()) {
+        for (size_t i = indexForKey(slot.key); ; i = (i + 1) & (slots.size() - 1)) {
+          if (slots[i].key == nullptr) {
+            slots[i] = slot;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  void set(void *key, CGRect rect)
+  {
+    reserve(count + 1);
+    Slot *reusable = nullptr;
+    for (size_t i = indexForKey(key); ; i = (i + 1) & (slots.size() - 1)) {
+      Slot &slot = slots[i];
+      if (slot.key == key) {
+        slot.rect = rect;
+        return;
+      } else if (slot.key == removedKey()) {
+        if (reusable == nullptr) {
+          reusable = &slot;
+        }
+      } else if (slot.key == nullptr) {
+        if (reusable == nullptr) {
+          reusable = &slot;
+          used++;
+        }
+        *reusable = Slot{key, rect};
+        count++;
+        return;
+      }
+    }
+  }
+
+  void remove(void *key)
+  {
+    Slot *slot = const_cast<Slot *>(find(key));
+    if (slot) {
+      slot->key = removedKey();
+      count--;
+    }
+  }
+};
+
+}
 
 @implementation ASRectMap {
-  std::unordered_map<void *, CGRect> _map;
+  // Shared between copies until one of them is mutated.
+  std::shared_ptr<ASRectTable> _table;
 }
 
 + (ASRectMap *)rectMapForWeakObjectPointers NS_RETURNS_RETAINED
@@ -24,35 +137,47 @@
   return [[self alloc] init];
 }
 
-- (CGRect)rectForKey:(id)key
++ (ASRectMap *)rectMapForWeakObjectPointersWithCapacity:(NSUInteger)capacity NS_RETURNS_RETAINED
+{
+  ASRectMap *map = [[self alloc] init];
+  [map mutableTable].reserve(capacity);
+  return map;
+}
+
+- (ASRectTable &)mutableTable
 {
-  auto result = _map.find((__bridge void *)key);
-  if (result != _map.end()) {
-    // result->first is the key; result->second is the value, a CGRect.
-    return result->second;
-  } else {
-    return CGRectNull;
+  if (_table == nullptr) {
+    _table = std::make_shared<ASRectTable>();
+  } else if (_table.use_count() > 1) {
+    _table = std::make_shared<ASRectTable>(*_table);
   }
+  return *_table;
+}
+
+- (CGRect)rectForKey:(id)key
+{
+  const ASRectTable::Slot *slot = (_table && key) ? _table->find((__bridge void *)key) : nullptr;
+  return slot ? slot->rect : CGRectNull;
 }
 
 - (void)setRect:(CGRect)rect forKey:(id)key
 {
   if (key) {
-    _map[(__bridge void *)key] = rect;
+    [self mutableTable].set((__bridge void *)key, rect);
   }
 }
 
 - (void)removeRectForKey:(id)key
 {
-  if (key) {
-    _map.erase((__bridge void *)key);
+  if (key && _table && _table->find((__bridge void *)key)) {
+    [self mutableTable].remove((__bridge void *)key);
   }
 }
 
 - (id)copyWithZone:(NSZone *)zone
 {
   ASRectMap *copy = [ASRectMap rectMapForWeakObjectPointers];
-  copy->_map = _map;
+  copy->_table = _table;
   return copy;
 }
 
@@ -62,8 +187,12 @@
 
   // { ptr1->rect1 ptr2->rect2 ptr3->rect3 }
   NSMutableString *str = [NSMutableString string];
-  for (auto it = _map.begin(); it != _map.end(); it++) {
-    [str appendFormat:@" %@->%@", it->first, NSStringFromCGRect(it->second)];
+  if (_table) {
+    for (const auto &slot : _table->slots) {
+      if (slot.key != nullptr && slot.key != ASRectTable::removedKey()) {
+        [str appendFormat:@" %@->%@", (__bridge id)slot.key, NSStringFromCGRect(slot.rect)];
+      }
+    }
   }
   [result addObject:@{ @"ASRectMap": str }];
 
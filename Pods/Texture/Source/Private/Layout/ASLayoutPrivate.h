@@ -0,0 +1,37 @@
+//
+//  ASLayoutPrivate.h
+//  Texture
+//
+//  Copyright (c) 2017-present, Pinterest, Inc.  All rights reserved.
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASLayout.h>
+
+#import <vector>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The sublayouts of a flattened layout as parallel arrays, in sublayout order.
+ * The elements are retained by the layout the buffer belongs to.
+ */
+struct ASLayoutFlatBuffer {
+  std::vector<__unsafe_unretained id<ASLayoutElement>> elements;
+  std::vector<CGRect> frames;
+};
+
+@interface ASLayout ()
+
+/**
+ * The frames of the sublayouts of a layout returned from -filteredNodeLayoutTree, or nullptr for any other layout.
+ */
+@property (nonatomic, readonly, nullable) const ASLayoutFlatBuffer *flatBuffer;
+
+@end
+
+NS_ASSUME_NONNULL_END
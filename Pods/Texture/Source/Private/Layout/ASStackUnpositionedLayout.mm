@@ -18,14 +18,19 @@
 #import <AsyncDisplayKit/ASStackUnpositionedLayout.h>
 
 #import <tgmath.h>
+#import <algorithm>
 #import <numeric>
 
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDispatch.h>
 #import <AsyncDisplayKit/ASLayoutSpecUtilities.h>
 #import <AsyncDisplayKit/ASLayoutElementStylePrivate.h>
 
 CGFloat const kViolationEpsilon = 0.01;
 
+/** The number of children at which a stack measures them concurrently, if exp_concurrent_wide_stacks is enabled. */
+static size_t const kStackConcurrentMeasurementChildThreshold = 16;
+
 static CGFloat resolveCrossDimensionMaxForStretchChild(const ASStackLayoutSpecStyle &style,
                                                        const ASStackLayoutSpecChild &child,
                                                        const CGFloat stackMax,
@@ -344,19 +349,28 @@ static void computeLinesCrossSizeAndBaseline(std::vector<ASStackUnpositionedLine
 }
 
 /**
- Returns a lambda that computes the relevant flex factor based on the given violation.
- @param violation The amount that the stack layout violates its size range.  See header for sign interpretation.
+ Computes the relevant flex factor of an item based on the given violation.
+ This is a plain functor rather than a std::function so that it can be inlined into the summing loops.
  */
-static std::function<CGFloat(const ASStackLayoutSpecItem &)> flexFactorInViolationDirection(const CGFloat violation)
-{
-  if (std::fabs(violation) < kViolationEpsilon) {
-    return [](const ASStackLayoutSpecItem &item) { return 0.0; };
-  } else if (violation > 0) {
-    return [](const ASStackLayoutSpecItem &item) { return item.child.style.flexGrow; };
-  } else {
-    return [](const ASStackLayoutSpecItem &item) { return item.child.style.flexShrink; };
+struct ASStackFlexFactor {
+  /** 0 for no violation, 1 when items should grow, -1 when they should shrink. */
+  const int direction;
+
+  ASStackFlexFactor(const CGFloat violation)
+    : direction(std::fabs(violation) < kViolationEpsilon ? 0 : (violation > 0 ? 1 : -1)) {}
+
+  CGFloat operator()(const ASStackLayoutSpecItem &item) const
+  {
+    switch (direction) {
+      case 1:
+        return item.child.style.flexGrow;
+      case -1:
+        return item.child.style.flexShrink;
+      default:
+        return 0.0;
+    }
   }
-}
+};
 
 static inline CGFloat scaledFlexShrinkFactor(const ASStackLayoutSpecItem &item,
                                              const ASStackLayoutSpecStyle &style,
@@ -366,69 +380,62 @@ static inline CGFloat scaledFlexShrinkFactor(const ASStackLayoutSpecItem &item,
 }
 
 /**
- Returns a lambda that computes a flex shrink adjustment for a given item based on the provided violation.
- @param items The unpositioned items from the original unconstrained layout pass.
- @param style The layout style to be applied to all children.
- @param violation The amount that the stack layout violates its size range.
- @param flexFactorSum The sum of each item's flex factor as determined by the provided violation.
- @return A lambda capable of computing the flex shrink adjustment, if any, for a particular item.
+ Sums the given functor over the items.
  */
-static std::function<CGFloat(const ASStackLayoutSpecItem &)> flexShrinkAdjustment(const std::vector<ASStackLayoutSpecItem> &items,
-                                                                                  const ASStackLayoutSpecStyle &style,
-                                                                                  const CGFloat violation,
-                                                                                  const CGFloat flexFactorSum)
+template <typename Functor>
+static inline CGFloat sumOverItems(const std::vector<ASStackLayoutSpecItem> &items, const CGFloat initialValue, const Functor &f)
 {
-  const CGFloat scaledFlexShrinkFactorSum = std::accumulate(items.begin(), items.end(), 0.0, [&](CGFloat x, const ASStackLayoutSpecItem &item) {
-    return x + scaledFlexShrinkFactor(item, style, flexFactorSum);
-  });
-  return [style, scaledFlexShrinkFactorSum, violation, flexFactorSum](const ASStackLayoutSpecItem &item) {
-    if (scaledFlexShrinkFactorSum == 0.0) {
-      return (CGFloat)0.0;
-    }
-    
-    const CGFloat scaledFlexShrinkFactorRatio = scaledFlexShrinkFactor(item, style, flexFactorSum) / scaledFlexShrinkFactorSum;
-    // The item should shrink proportionally to the scaled flex shrink factor ratio computed above.
-    // Unlike the flex grow adjustment the flex shrink adjustment needs to take the size of each item into account.
-    return -std::fabs(scaledFlexShrinkFactorRatio * violation);
-  };
+  CGFloat sum = initialValue;
+  for (const auto &item : items) {
+    sum += f(item);
+  }
+  return sum;
 }
 
 /**
- Returns a lambda that computes a flex grow adjustment for a given item based on the provided violation.
- @param items The unpositioned items from the original unconstrained layout pass.
- @param violation The amount that the stack layout violates its size range.
- @param flexFactorSum The sum of each item's flex factor as determined by the provided violation.
- @return A lambda capable of computing the flex grow adjustment, if any, for a particular item.
- */
-static std::function<CGFloat(const ASStackLayoutSpecItem &)> flexGrowAdjustment(const std::vector<ASStackLayoutSpecItem> &items,
-                                                                                const CGFloat violation,
-                                                                                const CGFloat flexFactorSum)
-{
-  // To compute the flex grow adjustment distribute the violation proportionally based on each item's flex grow factor.
-  return [violation, flexFactorSum](const ASStackLayoutSpecItem &item) {
-    return std::floor(violation * (item.child.style.flexGrow / flexFactorSum));
-  };
-}
+ Computes a flex adjustment for a given item based on the provided violation.
 
-/**
- Returns a lambda that computes a flex adjustment for a given item based on the provided violation.
- @param items The unpositioned items from the original unconstrained layout pass.
- @param style The layout style to be applied to all children.
- @param violation The amount that the stack layout violates its size range.
- @param flexFactorSum The sum of each item's flex factor as determined by the provided violation.
- @return A lambda capable of computing the flex adjustment for a particular item.
+ When the violation is positive, it is distributed proportionally based on each item's flex grow factor.
+ When it is negative, items shrink proportionally to their scaled flex shrink factor. Unlike the flex grow adjustment
+ the flex shrink adjustment needs to take the size of each item into account.
  */
-static std::function<CGFloat(const ASStackLayoutSpecItem &)> flexAdjustmentInViolationDirection(const std::vector<ASStackLayoutSpecItem> &items,
-                                                                                                const ASStackLayoutSpecStyle &style,
-                                                                                                const CGFloat violation,
-                                                                                                const CGFloat flexFactorSum)
-{
-  if (violation > 0) {
-    return flexGrowAdjustment(items, violation, flexFactorSum);
-  } else {
-    return flexShrinkAdjustment(items, style, violation, flexFactorSum);
+struct ASStackFlexAdjustment {
+  const ASStackLayoutSpecStyle style;
+  const CGFloat violation;
+  const CGFloat flexFactorSum;
+  /** Only used for shrinking. */
+  const CGFloat scaledFlexShrinkFactorSum;
+
+  /**
+   @param items The unpositioned items from the original unconstrained layout pass.
+   @param style The layout style to be applied to all children.
+   @param violation The amount that the stack layout violates its size range.
+   @param flexFactorSum The sum of each item's flex factor as determined by the provided violation.
+   */
+  ASStackFlexAdjustment(const std::vector<ASStackLayoutSpecItem> &items,
+                        const ASStackLayoutSpecStyle &style,
+                        const CGFloat violation,
+                        const CGFloat flexFactorSum)
+    : style(style),
+      violation(violation),
+      flexFactorSum(flexFactorSum),
+      scaledFlexShrinkFactorSum(violation > 0 ? 0.0 : sumOverItems(items, 0.0, [&](const ASStackLayoutSpecItem &item) {
+        return scaledFlexShrinkFactor(item, style, flexFactorSum);
+      })) {}
+
+  CGFloat operator()(const ASStackLayoutSpecItem &item) const
+  {
+    if (violation > 0) {
+      return std::floor(violation * (item.child.style.flexGrow / flexFactorSum));
+    }
+
+    if (scaledFlexShrinkFactorSum == 0.0) {
+      return (CGFloat)0.0;
+    }
+    const CGFloat scaledFlexShrinkFactorRatio = scaledFlexShrinkFactor(item, style, flexFactorSum) / scaledFlexShrinkFactorSum;
+    return -std::fabs(scaledFlexShrinkFactorRatio * violation);
   }
-}
+};
 
 ASDISPLAYNODE_INLINE BOOL isFlexibleInBothDirections(const ASStackLayoutSpecChild &child)
 {
@@ -573,15 +580,28 @@ static void flexLinesAlongStackDimension(std::vector<ASStackUnpositionedLine> &l
                                          const CGSize parentSize,
                                          const BOOL useOptimizedFlexing)
 {
-  for (auto &line : lines) {
-    auto &items = line.items;
+  // Resolve how much each line has to flex first. This is cheap and done serially; the re-layout of flexed items
+  // is then done in a single pass over the items of all lines, so wrapping stacks with many short lines
+  // are measured concurrently as well.
+  struct LineFlex {
+    ASStackFlexAdjustment adjustment;
+    CGFloat remainingViolation;
+    size_t firstFlexItem;
+    size_t firstItemOffset;
+  };
+  std::vector<LineFlex> lineFlexes;
+  std::vector<size_t> lineIndexes;
+  lineFlexes.reserve(lines.size());
+  lineIndexes.reserve(lines.size());
+  size_t flexItemCount = 0;
+
+  for (size_t l = 0; l < lines.size(); l++) {
+    auto &items = lines[l].items;
     const CGFloat violation = ASStackUnpositionedLayout::computeStackViolation(computeItemsStackDimensionSum(items, style), style, sizeRange);
-    std::function<CGFloat(const ASStackLayoutSpecItem &)> flexFactor = flexFactorInViolationDirection(violation);
+    const ASStackFlexFactor flexFactor(violation);
     // The flex factor sum is needed to determine if flexing is necessary.
     // This value is also needed if the violation is positive and flexible items need to grow, so keep it around.
-    const CGFloat flexFactorSum = std::accumulate(items.begin(), items.end(), 0.0, [&](CGFloat x, const ASStackLayoutSpecItem &item) {
-      return x + flexFactor(item);
-    });
+    const CGFloat flexFactorSum = sumOverItems(items, 0.0, flexFactor);
     
     // If no items are able to flex then there is nothing left to do with this line. Bail.
     if (flexFactorSum == 0) {
@@ -592,14 +612,9 @@ static void flexLinesAlongStackDimension(std::vector<ASStackUnpositionedLine> &l
       continue;
     }
     
-    std::function<CGFloat(const ASStackLayoutSpecItem &)> flexAdjustment = flexAdjustmentInViolationDirection(items,
-                                                                                                              style,
-                                                                                                              violation,
-                                                                                                              flexFactorSum);
+    const ASStackFlexAdjustment flexAdjustment(items, style, violation, flexFactorSum);
     // Compute any remaining violation to the first flexible item.
-    const CGFloat remainingViolation = std::accumulate(items.begin(), items.end(), violation, [&](CGFloat x, const ASStackLayoutSpecItem &item) {
-      return x - flexAdjustment(item);
-    });
+    const CGFloat remainingViolation = violation - sumOverItems(items, 0.0, flexAdjustment);
     
     size_t firstFlexItem = -1;
     for(size_t i = 0; i < items.size(); i++) {
@@ -613,36 +628,56 @@ static void flexLinesAlongStackDimension(std::vector<ASStackUnpositionedLine> &l
       continue;
     }
     
-    dispatchApplyIfNeeded(items.size(), concurrent, ^(size_t i) {
-      auto &item = items[i];
-      const CGFloat currentFlexAdjustment = flexAdjustment(item);
-      // Items are consider inflexible if they do not need to make a flex adjustment.
-      if (currentFlexAdjustment != 0) {
-        const CGFloat originalStackSize = stackDimension(style.direction, item.layout.size);
-        // Only apply the remaining violation for the first flexible item that has a flex grow factor.
-        const CGFloat flexedStackSize = originalStackSize + currentFlexAdjustment + (i == firstFlexItem && item.child.style.flexGrow > 0 ? remainingViolation : 0);
-        item.layout = crossChildLayout(item.child,
-                                       style,
-                                       MAX(flexedStackSize, 0),
-                                       MAX(flexedStackSize, 0),
-                                       crossDimension(style.direction, sizeRange.min),
-                                       crossDimension(style.direction, sizeRange.max),
-                                       parentSize);
-      }
-    });
+    lineFlexes.push_back({flexAdjustment, remainingViolation, firstFlexItem, flexItemCount});
+    lineIndexes.push_back(l);
+    flexItemCount += items.size();
+  }
+  
+  if (flexItemCount == 0) {
+    return;
   }
+  
+  const LineFlex *flexes = lineFlexes.data();
+  const size_t *indexes = lineIndexes.data();
+  const size_t flexLineCount = lineFlexes.size();
+  ASStackUnpositionedLine *linesData = lines.data();
+  dispatchApplyIfNeeded(flexItemCount, concurrent, ^(size_t k) {
+    // Find the line owning the k-th item.
+    size_t f = std::upper_bound(flexes, flexes + flexLineCount, k, [](size_t itemIndex, const LineFlex &lineFlex) {
+      return itemIndex < lineFlex.firstItemOffset;
+    }) - flexes - 1;
+    const LineFlex &lineFlex = flexes[f];
+    const size_t i = k - lineFlex.firstItemOffset;
+    auto &item = linesData[indexes[f]].items[i];
+    const CGFloat currentFlexAdjustment = lineFlex.adjustment(item);
+    // Items are consider inflexible if they do not need to make a flex adjustment.
+    if (currentFlexAdjustment != 0) {
+      const CGFloat originalStackSize = stackDimension(style.direction, item.layout.size);
+      // Only apply the remaining violation for the first flexible item that has a flex grow factor.
+      const CGFloat flexedStackSize = originalStackSize + currentFlexAdjustment + (i == lineFlex.firstFlexItem && item.child.style.flexGrow > 0 ? lineFlex.remainingViolation : 0);
+      item.layout = crossChildLayout(item.child,
+                                     style,
+                                     MAX(flexedStackSize, 0),
+                                     MAX(flexedStackSize, 0),
+                                     crossDimension(style.direction, sizeRange.min),
+                                     crossDimension(style.direction, sizeRange.max),
+                                     parentSize);
+    }
+  });
 }
 
 /**
  https://www.w3.org/TR/css-flexbox-1/#algo-line-break
  */
-static std::vector<ASStackUnpositionedLine> collectChildrenIntoLines(const std::vector<ASStackLayoutSpecItem> &items,
+static std::vector<ASStackUnpositionedLine> collectChildrenIntoLines(std::vector<ASStackLayoutSpecItem> &&items,
                                                                      const ASStackLayoutSpecStyle &style,
                                                                      const ASSizeRange &sizeRange)
 {
   //TODO if infinite max stack size, fast path
   if (style.flexWrap == ASStackLayoutFlexWrapNoWrap) {
-    return std::vector<ASStackUnpositionedLine> (1, {.items = std::move(items)});
+    std::vector<ASStackUnpositionedLine> lines(1);
+    lines[0].items = std::move(items);
+    return lines;
   }
   
   std::vector<ASStackUnpositionedLine> lines;
@@ -651,15 +686,18 @@ static std::vector<ASStackUnpositionedLine> collectChildrenIntoLines(const std::
   CGFloat interitemSpacing = 0;
 
   for(auto it = items.begin(); it != items.end(); ++it) {
-    const auto &item = *it;
+    auto &item = *it;
     const CGFloat itemStackDimension = stackDimension(style.direction, item.layout.size);
     const CGFloat itemAndSpacingStackDimension = item.child.style.spacingBefore + itemStackDimension + item.child.style.spacingAfter;
     const BOOL negativeViolationIfAddItem = (ASStackUnpositionedLayout::computeStackViolation(lineStackDimensionSum + interitemSpacing + itemAndSpacingStackDimension, style, sizeRange) < 0);
     const BOOL breakCurrentLine = negativeViolationIfAddItem && !lineItems.empty();
     
     if (breakCurrentLine) {
-      lines.push_back({.items = std::vector<ASStackLayoutSpecItem> (lineItems)});
-      lineItems.clear();
+      // Lines of a wrapping stack tend to be similar in length, so size the next one like this one.
+      const size_t lineCapacity = lineItems.size();
+      lines.push_back({.items = std::move(lineItems)});
+      lineItems = std::vector<ASStackLayoutSpecItem>();
+      lineItems.reserve(lineCapacity);
       lineStackDimensionSum = 0;
       interitemSpacing = 0;
     }
@@ -670,7 +708,7 @@ static std::vector<ASStackUnpositionedLine> collectChildrenIntoLines(const std::
   }
   
   // Handle last line
-  lines.push_back({.items = std::vector<ASStackLayoutSpecItem> (lineItems)});
+  lines.push_back({.items = std::move(lineItems)});
   
   return lines;
 }
@@ -724,32 +762,38 @@ ASStackUnpositionedLayout ASStackUnpositionedLayout::compute(const std::vector<A
   // We may be able to avoid some redundant layout passes
   const BOOL optimizedFlexing = useOptimizedFlexing(children, style, sizeRange);
 
-  std::vector<ASStackLayoutSpecItem> items = AS::map(children, [&](const ASStackLayoutSpecChild &child) -> ASStackLayoutSpecItem {
-    return {child, nil};
-  });
+  // Wide stacks may opt into concurrent measurement globally, regardless of their own concurrent flag.
+  const BOOL measureConcurrently = concurrent || (children.size() >= kStackConcurrentMeasurementChildThreshold
+                                                  && ASActivateExperimentalFeature(ASExperimentalConcurrentWideStacks));
+
+  std::vector<ASStackLayoutSpecItem> items;
+  items.reserve(children.size());
+  for (const auto &child : children) {
+    items.push_back({child, nil});
+  }
   
   // We do a first pass of all the children, generating an unpositioned layout for each with an unbounded range along
   // the stack dimension.  This allows us to compute the "intrinsic" size of each child and find the available violation
   // which determines whether we must grow or shrink the flexible children.
   layoutItemsAlongUnconstrainedStackDimension(items,
                                               style,
-                                              concurrent,
+                                              measureConcurrently,
                                               sizeRange,
                                               parentSize,
                                               optimizedFlexing);
   
   // Collect items into lines (https://www.w3.org/TR/css-flexbox-1/#algo-line-break)
-  std::vector<ASStackUnpositionedLine> lines = collectChildrenIntoLines(items, style, sizeRange);
+  std::vector<ASStackUnpositionedLine> lines = collectChildrenIntoLines(std::move(items), style, sizeRange);
   
   // Resolve the flexible lengths (https://www.w3.org/TR/css-flexbox-1/#resolve-flexible-lengths)
-  flexLinesAlongStackDimension(lines, style, concurrent, sizeRange, parentSize, optimizedFlexing);
+  flexLinesAlongStackDimension(lines, style, measureConcurrently, sizeRange, parentSize, optimizedFlexing);
   
   // Calculate the cross size of each flex line (https://www.w3.org/TR/css-flexbox-1/#algo-cross-line)
   computeLinesCrossSizeAndBaseline(lines, style, sizeRange);
   
   // Handle 'align-content: stretch' (https://www.w3.org/TR/css-flexbox-1/#algo-line-stretch)
   // Determine the used cross size of each item (https://www.w3.org/TR/css-flexbox-1/#algo-stretch)
-  stretchLinesAlongCrossDimension(lines, style, concurrent, sizeRange, parentSize);
+  stretchLinesAlongCrossDimension(lines, style, measureConcurrently, sizeRange, parentSize);
   
   // Compute stack dimension sum of each line and the whole stack
   CGFloat layoutStackDimensionSum = 0;
@@ -225,9 +225,9 @@ extern const CGSize ASTextContainerMaxSize;
 @property (nonatomic, readonly) NSAttributedString *text;
 ///< The text range in full text
 @property (nonatomic, readonly) NSRange range;
-///< CTFrameSetter
+///< CTFrameSetter, or NULL if the text was laid out one paragraph at a time
 @property (nonatomic, readonly) CTFramesetterRef frameSetter;
-///< CTFrame
+///< CTFrame, or NULL if the text was laid out one paragraph at a time
 @property (nonatomic, readonly) CTFrameRef frame;
 ///< Array of `ASTextLine`, no truncated
 @property (nonatomic, readonly) NSArray<ASTextLine *> *lines;
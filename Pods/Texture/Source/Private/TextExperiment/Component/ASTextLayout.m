@@ -16,6 +16,8 @@
 //
 
 #import <AsyncDisplayKit/ASTextLayout.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASTextParagraphLayout.h>
 #import <AsyncDisplayKit/ASTextUtilities.h>
 #import <AsyncDisplayKit/ASTextAttribute.h>
 #import <AsyncDisplayKit/NSAttributedString+ASText.h>
@@ -379,7 +381,9 @@ dispatch_semaphore_signal(_lock);
   CTFramesetterRef ctSetter = NULL;
   CTFrameRef ctFrame = NULL;
   CFArrayRef ctLines = nil;
+  CFArrayRef paragraphLines = NULL;
   CGPoint *lineOrigins = NULL;
+  NSUInteger *lineStringOffsets = NULL;
   NSUInteger lineCount = 0;
   NSMutableArray *lines = nil;
   NSMutableArray *attachments = nil;
@@ -399,7 +403,9 @@ dispatch_semaphore_signal(_lock);
   if (cgPath) CFRelease(cgPath); \
   if (ctSetter) CFRelease(ctSetter); \
   if (ctFrame) CFRelease(ctFrame); \
+  if (paragraphLines) CFRelease(paragraphLines); \
   if (lineOrigins) free(lineOrigins); \
+  if (lineStringOffsets) free(lineStringOffsets); \
   if (lineRowsEdge) free(lineRowsEdge); \
   if (lineRowsIndex) free(lineRowsIndex); \
   return nil; }
@@ -484,19 +490,30 @@ dispatch_semaphore_signal(_lock);
     frameAttrs[(id)kCTFrameProgressionAttributeName] = @(kCTFrameProgressionRightToLeft);
   }
   
+  // Long text in an extended rect is laid out one paragraph at a time, reusing the lines of unchanged paragraphs.
+  if (constraintSizeIsExtended && !isVerticalForm && range.location == 0 && range.length == text.length
+      && ASActivateExperimentalFeature(ASExperimentalParagraphTextLayout)) {
+    paragraphLines = ASTextParagraphLayoutCreateLines(text, cgPathBox.size, frameAttrs, &lineOrigins, &lineStringOffsets, &visibleRange);
+  }
+  
   // create CoreText objects
-  ctSetter = CTFramesetterCreateWithAttributedString((CFAttributedStringRef)text);
-  if (!ctSetter) FAIL_AND_RETURN
-  ctFrame = CTFramesetterCreateFrame(ctSetter, ASTextCFRangeFromNSRange(range), cgPath, (CFDictionaryRef)frameAttrs);
-  if (!ctFrame) FAIL_AND_RETURN
-  lines = [NSMutableArray new];
-  ctLines = CTFrameGetLines(ctFrame);
-  lineCount = CFArrayGetCount(ctLines);
-  if (lineCount > 0) {
-    lineOrigins = (CGPoint *)malloc(lineCount * sizeof(CGPoint));
-    if (lineOrigins == NULL) FAIL_AND_RETURN
-    CTFrameGetLineOrigins(ctFrame, CFRangeMake(0, lineCount), lineOrigins);
+  if (paragraphLines) {
+    ctLines = paragraphLines;
+    lineCount = CFArrayGetCount(ctLines);
+  } else {
+    ctSetter = CTFramesetterCreateWithAttributedString((CFAttributedStringRef)text);
+    if (!ctSetter) FAIL_AND_RETURN
+    ctFrame = CTFramesetterCreateFrame(ctSetter, ASTextCFRangeFromNSRange(range), cgPath, (CFDictionaryRef)frameAttrs);
+    if (!ctFrame) FAIL_AND_RETURN
+    ctLines = CTFrameGetLines(ctFrame);
+    lineCount = CFArrayGetCount(ctLines);
+    if (lineCount > 0) {
+      lineOrigins = (CGPoint *)malloc(lineCount * sizeof(CGPoint));
+      if (lineOrigins == NULL) FAIL_AND_RETURN
+      CTFrameGetLineOrigins(ctFrame, CFRangeMake(0, lineCount), lineOrigins);
+    }
   }
+  lines = [NSMutableArray new];
   
   CGRect textBoundingRect = CGRectZero;
   CGSize textBoundingSize = CGSizeZero;
@@ -524,7 +541,8 @@ dispatch_semaphore_signal(_lock);
     position.x = cgPathBox.origin.x + ctLineOrigin.x;
     position.y = cgPathBox.size.height + cgPathBox.origin.y - ctLineOrigin.y;
     
-    ASTextLine *line = [ASTextLine lineWithCTLine:ctLine position:position vertical:isVerticalForm];
+    NSUInteger stringOffset = lineStringOffsets ? lineStringOffsets[i] : 0;
+    ASTextLine *line = [ASTextLine lineWithCTLine:ctLine position:position vertical:isVerticalForm stringOffset:stringOffset];
     CGRect rect = line.bounds;
     
     if (constraintSizeIsExtended) {
@@ -670,7 +688,9 @@ dispatch_semaphore_signal(_lock);
     textBoundingSize = size;
   }
   
-  visibleRange = ASTextNSRangeFromCFRange(CTFrameGetVisibleStringRange(ctFrame));
+  if (ctFrame) {
+    visibleRange = ASTextNSRangeFromCFRange(CTFrameGetVisibleStringRange(ctFrame));
+  }
   if (needTruncation) {
     ASTextLine *lastLine = lines.lastObject;
     NSRange lastRange = lastLine.range;
@@ -873,9 +893,11 @@ dispatch_semaphore_signal(_lock);
   layout.lineRowsEdge = lineRowsEdge;
   layout.lineRowsIndex = lineRowsIndex;
   CFRelease(cgPath);
-  CFRelease(ctSetter);
-  CFRelease(ctFrame);
+  if (ctSetter) CFRelease(ctSetter);
+  if (ctFrame) CFRelease(ctFrame);
+  if (paragraphLines) CFRelease(paragraphLines);
   if (lineOrigins) free(lineOrigins);
+  if (lineStringOffsets) free(lineStringOffsets);
   return layout;
 }
 
@@ -1010,6 +1032,7 @@ dispatch_semaphore_signal(_lock);
   for (NSUInteger i = 0, max = CFArrayGetCount(runs); i < max; i++) {
     CTRunRef run = (CTRunRef)CFArrayGetValueAtIndex(runs, i);
     CFRange range = CTRunGetStringRange(run);
+    range.location += line.stringOffset;
     if (position.affinity == ASTextAffinityBackward) {
       if (range.location < position.offset && position.offset <= range.location + range.length) {
         return run;
@@ -1079,6 +1102,7 @@ dispatch_semaphore_signal(_lock);
     NSUInteger glyphCount = CTRunGetGlyphCount(run);
     if (glyphCount == 0) continue;
     CFRange range = CTRunGetStringRange(run);
+    range.location += line.stringOffset;
     if (range.length <= 1) continue;
     if (position <= range.location || position >= range.location + range.length) continue;
     CFDictionaryRef attrs = CTRunGetAttributes(run);
@@ -1089,8 +1113,8 @@ dispatch_semaphore_signal(_lock);
     CFIndex indices[glyphCount];
     CTRunGetStringIndices(run, CFRangeMake(0, glyphCount), indices);
     for (NSUInteger g = 0; g < glyphCount; g++) {
-      CFIndex prev = indices[g];
-      CFIndex next = g + 1 < glyphCount ? indices[g + 1] : range.location + range.length;
+      CFIndex prev = indices[g] + line.stringOffset;
+      CFIndex next = g + 1 < glyphCount ? indices[g + 1] + line.stringOffset : range.location + range.length;
       if (position == prev) break; // Emoji edge
       if (prev < position && position < next) { // inside an emoji (such as National Flag Emoji)
         CGPoint pos = CGPointZero;
@@ -1248,10 +1272,10 @@ dispatch_semaphore_signal(_lock);
 - (CGFloat)offsetForTextPosition:(NSUInteger)position lineIndex:(NSUInteger)lineIndex {
   if (lineIndex >= _lines.count) return CGFLOAT_MAX;
   ASTextLine *line = _lines[lineIndex];
-  CFRange range = CTLineGetStringRange(line.CTLine);
+  NSRange range = line.range;
   if (position < range.location || position > range.location + range.length) return CGFLOAT_MAX;
   
-  CGFloat offset = CTLineGetOffsetForStringIndex(line.CTLine, position, NULL);
+  CGFloat offset = CTLineGetOffsetForStringIndex(line.CTLine, position - line.stringOffset, NULL);
   return _container.verticalForm ? (offset + line.position.y) : (offset + line.position.x);
 }
 
@@ -1303,7 +1327,7 @@ dispatch_semaphore_signal(_lock);
           NSUInteger next = indices[g + 1];
           do {
             if (next == range.location + range.length) break;
-            unichar c = [_text.string characterAtIndex:next];
+            unichar c = [_text.string characterAtIndex:next + line.stringOffset];
             if ((c == 0xFE0E || c == 0xFE0F)) { // unicode variant form for emoji style
               next++;
             } else break;
@@ -1316,7 +1340,7 @@ dispatch_semaphore_signal(_lock);
       break;
     }
   }
-  return idx;
+  return idx + line.stringOffset;
 }
 
 - (ASTextPosition *)closestPositionToPoint:(CGPoint)point {
@@ -2706,6 +2730,7 @@ static void ASTextDrawBorder(ASTextLayout *layout, CGContextRef context, CGSize
       
       CFRange runRange = CTRunGetStringRange(run);
       if (runRange.location == kCFNotFound || runRange.length == 0) continue;
+      runRange.location += line.stringOffset;
       if (runRange.location + runRange.length > layout.text.length) continue;
       
       NSMutableArray *runRects = [NSMutableArray new];
@@ -2836,6 +2861,7 @@ static void ASTextDrawDecoration(ASTextLayout *layout, CGContextRef context, CGS
       
       CFRange runRange = CTRunGetStringRange(run);
       if (runRange.location == kCFNotFound || runRange.length == 0) continue;
+      runRange.location += line.stringOffset;
       if (runRange.location + runRange.length > layout.text.length) continue;
       NSString *runStr = [layout.text attributedSubstringFromRange:NSMakeRange(runRange.location, runRange.length)].string;
       if (ASTextIsLinebreakString(runStr)) continue; // may need more checks...
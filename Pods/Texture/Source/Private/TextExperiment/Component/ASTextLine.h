@@ -30,12 +30,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)lineWithCTLine:(CTLineRef)CTLine position:(CGPoint)position vertical:(BOOL)isVertical NS_RETURNS_RETAINED;
 
+/// For a CTLine created from a substring of the text, that starts at `stringOffset` in the text.
++ (instancetype)lineWithCTLine:(CTLineRef)CTLine position:(CGPoint)position vertical:(BOOL)isVertical stringOffset:(NSUInteger)stringOffset NS_RETURNS_RETAINED;
+
 @property (nonatomic) NSUInteger index;     ///< line index
 @property (nonatomic) NSUInteger row;       ///< line row
 @property (nullable, nonatomic) NSArray<NSArray<ASTextRunGlyphRange *> *> *verticalRotateRange; ///< Run rotate range
 
 @property (nonatomic, readonly) CTLineRef CTLine;   ///< CoreText line
 @property (nonatomic, readonly) NSRange range;      ///< string range
+@property (nonatomic, readonly) NSUInteger stringOffset; ///< string index of the CTLine's string index 0
 @property (nonatomic, readonly) BOOL vertical;      ///< vertical form
 
 @property (nonatomic, readonly) CGRect bounds;      ///< bounds (ascent + descent)
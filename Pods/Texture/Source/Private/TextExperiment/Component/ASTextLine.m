@@ -23,10 +23,15 @@
 }
 
 + (instancetype)lineWithCTLine:(CTLineRef)CTLine position:(CGPoint)position vertical:(BOOL)isVertical NS_RETURNS_RETAINED {
+  return [self lineWithCTLine:CTLine position:position vertical:isVertical stringOffset:0];
+}
+
++ (instancetype)lineWithCTLine:(CTLineRef)CTLine position:(CGPoint)position vertical:(BOOL)isVertical stringOffset:(NSUInteger)stringOffset NS_RETURNS_RETAINED {
   if (!CTLine) return nil;
   ASTextLine *line = [self new];
   line->_position = position;
   line->_vertical = isVertical;
+  line->_stringOffset = stringOffset;
   [line setCTLine:CTLine];
   return line;
 }
@@ -43,7 +48,7 @@
     if (_CTLine) {
       _lineWidth = CTLineGetTypographicBounds(_CTLine, &_ascent, &_descent, &_leading);
       CFRange range = CTLineGetStringRange(_CTLine);
-      _range = NSMakeRange(range.location, range.length);
+      _range = NSMakeRange(_stringOffset + range.location, range.length);
       if (CTLineGetGlyphCount(_CTLine) > 0) {
         CFArrayRef runs = CTLineGetGlyphRuns(_CTLine);
         CTRunRef run = (CTRunRef)CFArrayGetValueAtIndex(runs, 0);
@@ -112,6 +117,7 @@
       }
       
       NSRange runRange = ASTextNSRangeFromCFRange(CTRunGetStringRange(run));
+      runRange.location += _stringOffset;
       [attachments addObject:attachment];
       [attachmentRanges addObject:[NSValue valueWithRange:runRange]];
       [attachmentRects addObject:[NSValue valueWithCGRect:runTypoBounds]];
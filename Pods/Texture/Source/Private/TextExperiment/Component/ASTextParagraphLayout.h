@@ -0,0 +1,53 @@
+//
+//  ASTextParagraphLayout.h
+//  Texture
+//
+//  Copyright (c) 2018-present, Pinterest, Inc.  All rights reserved.
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <UIKit/UIKit.h>
+#import <CoreText/CoreText.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+ASDISPLAYNODE_EXTERN_C_BEGIN
+
+/**
+ * Lays out text in a horizontal, rectangular frame one paragraph at a time, as a replacement for
+ * CTFramesetterCreateFrame() on long text.
+ *
+ * Lines and line positions are cached per paragraph, keyed by the attributed contents of the
+ * paragraph and the width of the frame, so that after an edit only the edited paragraphs are typeset
+ * again. Paragraphs that are not in the cache are broken into lines concurrently.
+ *
+ * Returns NULL if the text is too short to benefit, or uses attributes whose lines could differ from the
+ * lines of a CTFrame, e.g. justified alignment, hyphenation or tab stops. Use a CTFrame in that case.
+ *
+ * @param text The text to lay out. All of it is laid out.
+ * @param boxSize The size of the bounding box of the frame path.
+ * @param frameAttributes The attributes to create CTFrames with.
+ * @param lineOrigins On success, a malloc'd array with the origin of each line, like CTFrameGetLineOrigins()
+ * returns it for a frame path with the given bounding box. The caller must free it.
+ * @param lineStringOffsets On success, a malloc'd array with the location of the paragraph of each line in
+ * the text. The caller must free it.
+ * @param visibleRange On success, the range of text that fits in the box.
+ *
+ * @return The CTLines of the text. Their string indexes are relative to their paragraph, add the line's
+ * string offset to get indexes into the given text.
+ */
+CFArrayRef _Nullable ASTextParagraphLayoutCreateLines(NSAttributedString *text,
+                                                      CGSize boxSize,
+                                                      NSDictionary * _Nullable frameAttributes,
+                                                      CGPoint * _Nullable * _Nonnull lineOrigins,
+                                                      NSUInteger * _Nullable * _Nonnull lineStringOffsets,
+                                                      NSRange *visibleRange) CF_RETURNS_RETAINED;
+
+ASDISPLAYNODE_EXTERN_C_END
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,291 @@
+//
+//  ASTextParagraphLayout.mm
+//  Texture
+//
+//  Copyright (c) 2018-present, Pinterest, Inc.  All rights reserved.
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASTextParagraphLayout.h>
+
+#import <AsyncDisplayKit/ASDispatch.h>
+#import <AsyncDisplayKit/ASTextLayout.h>
+#import <AsyncDisplayKit/ASTextUtilities.h>
+
+#import <vector>
+
+// Shorter text is laid out in a single CTFrame quickly enough.
+static const NSUInteger kMinimumTextLength = 1000;
+// The cost of a cache entry is the length of its text.
+static const NSUInteger kCacheCostLimit = 500000;
+
+/**
+ * The lines of a piece of text laid out in a frame of its own.
+ */
+@interface ASTextParagraphLines : NSObject {
+@package
+  // The CTLines of the frame. Their string indexes are relative to the start of the text.
+  NSArray *_lines;
+  // Relative to the start of the text.
+  std::vector<NSRange> _ranges;
+  // x from the left edge of the frame, y from the top edge of the frame down to the baseline.
+  std::vector<CGPoint> _positions;
+}
+@end
+
+@implementation ASTextParagraphLines
+@end
+
+@interface ASTextParagraphKey : NSObject {
+@package
+  NSAttributedString *_text;
+  CGFloat _width;
+  NSUInteger _hash;
+}
+@end
+
+@implementation ASTextParagraphKey
+
+- (instancetype)initWithText:(NSAttributedString *)text width:(CGFloat)width
+{
+  if (self = [super init]) {
+    _text = text;
+    _width = width;
+    _hash = text.hash * 31 + (NSUInteger)width;
+  }
+  return self;
+}
+
+- (NSUInteger)hash
+{
+  return _hash;
+}
+
+- (BOOL)isEqual:(ASTextParagraphKey *)object
+{
+  if (self == object) {
+    return YES;
+  }
+  if (![object isKindOfClass:[ASTextParagraphKey class]]) {
+    return NO;
+  }
+  return _hash == object->_hash && _width == object->_width && [_text isEqualToAttributedString:object->_text];
+}
+
+@end
+
+static NSCache<ASTextParagraphKey *, ASTextParagraphLines *> *ASTextParagraphLayoutGetCache()
+{
+  static NSCache *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = [[NSCache alloc] init];
+    cache.totalCostLimit = kCacheCostLimit;
+  });
+  return cache;
+}
+
+static BOOL ASTextParagraphLayoutSupportsText(NSAttributedString *text)
+{
+  // Tab stops are measured from where a line is created, which a typesetter may not do like a CTFrame.
+  // U+0085 separates paragraphs for CoreText, but not for NSString.
+  static NSCharacterSet *unsupportedCharacters;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSMutableCharacterSet *characters = [NSMutableCharacterSet characterSetWithCharactersInString:@"\t"];
+    [characters addCharactersInRange:NSMakeRange(0x85, 1)];
+    unsupportedCharacters = [characters copy];
+  });
+  if ([text.string rangeOfCharacterFromSet:unsupportedCharacters].location != NSNotFound) {
+    return NO;
+  }
+
+  // CTFrames justify, hyphenate and truncate lines. Lines created by a typesetter are left as they are.
+  __block BOOL supported = YES;
+  [text enumerateAttribute:NSParagraphStyleAttributeName inRange:NSMakeRange(0, text.length) options:NSAttributedStringEnumerationLongestEffectiveRangeNotRequired usingBlock:^(id value, NSRange range, BOOL *stop) {
+    if (value == nil) {
+      return;
+    }
+    NSParagraphStyle *style = [value isKindOfClass:[NSParagraphStyle class]] ? value : nil;
+    if (style == nil || style.alignment == NSTextAlignmentJustified || style.hyphenationFactor > 0
+        || (style.lineBreakMode != NSLineBreakByWordWrapping && style.lineBreakMode != NSLineBreakByCharWrapping)) {
+      supported = NO;
+      *stop = YES;
+    }
+  }];
+  return supported;
+}
+
+static ASTextParagraphLines *ASTextParagraphLinesCreate(NSAttributedString *text, CGFloat width, NSDictionary *frameAttributes)
+{
+  ASTextParagraphLines *result = nil;
+  CTFramesetterRef ctSetter = CTFramesetterCreateWithAttributedString((__bridge CFAttributedStringRef)text);
+  CGPathRef cgPath = CGPathCreateWithRect(CGRectMake(0, 0, width, ASTextContainerMaxSize.height), NULL);
+  CTFrameRef ctFrame = NULL;
+  if (ctSetter && cgPath) {
+    ctFrame = CTFramesetterCreateFrame(ctSetter, CFRangeMake(0, text.length), cgPath, (__bridge CFDictionaryRef)frameAttributes);
+  }
+  if (ctFrame) {
+    CFArrayRef ctLines = CTFrameGetLines(ctFrame);
+    CFIndex lineCount = CFArrayGetCount(ctLines);
+    std::vector<CGPoint> origins(lineCount);
+    if (lineCount > 0) {
+      CTFrameGetLineOrigins(ctFrame, CFRangeMake(0, lineCount), origins.data());
+    }
+    result = [[ASTextParagraphLines alloc] init];
+    result->_lines = [(__bridge NSArray *)ctLines copy];
+    result->_ranges.reserve(lineCount);
+    result->_positions.reserve(lineCount);
+    for (CFIndex i = 0; i < lineCount; i++) {
+      CTLineRef ctLine = (CTLineRef)CFArrayGetValueAtIndex(ctLines, i);
+      result->_ranges.push_back(ASTextNSRangeFromCFRange(CTLineGetStringRange(ctLine)));
+      result->_positions.push_back(CGPointMake(origins[i].x, ASTextContainerMaxSize.height - origins[i].y));
+    }
+  }
+  if (ctFrame) CFRelease(ctFrame);
+  if (cgPath) CFRelease(cgPath);
+  if (ctSetter) CFRelease(ctSetter);
+  return result;
+}
+
+/**
+ * Looks up the lines of each key in the cache, and lays out the missing ones concurrently.
+ * Returns NO if any of them can't be laid out.
+ */
+static BOOL ASTextParagraphLayoutFetchLines(std::vector<ASTextParagraphKey *> &keys, std::vector<ASTextParagraphLines *> &results, NSDictionary *frameAttributes)
+{
+  NSCache<ASTextParagraphKey *, ASTextParagraphLines *> *cache = ASTextParagraphLayoutGetCache();
+  std::vector<size_t> misses;
+  results.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    results[i] = [cache objectForKey:keys[i]];
+    if (results[i] == nil) {
+      misses.push_back(i);
+    }
+  }
+
+  ASTextParagraphKey * __strong *keysData = keys.data();
+  ASTextParagraphLines * __strong *resultsData = results.data();
+  const size_t *missesData = misses.data();
+  void (^work)(size_t) = ^(size_t m) {
+    ASTextParagraphKey *key = keysData[missesData[m]];
+    ASTextParagraphLines *lines = ASTextParagraphLinesCreate(key->_text, key->_width, frameAttributes);
+    if (lines) {
+      [cache setObject:lines forKey:key cost:key->_text.length];
+    }
+    resultsData[missesData[m]] = lines;
+  };
+  if (misses.size() > 1) {
+    ASDispatchApply(misses.size(), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), 0, work);
+  } else if (misses.size() == 1) {
+    work(0);
+  }
+
+  for (ASTextParagraphLines *lines : results) {
+    if (lines == nil || lines->_ranges.empty()) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+CFArrayRef ASTextParagraphLayoutCreateLines(NSAttributedString *text, CGSize boxSize, NSDictionary *frameAttributes, CGPoint **lineOrigins, NSUInteger **lineStringOffsets, NSRange *visibleRange)
+{
+  NSString *string = text.string;
+  const NSUInteger length = string.length;
+  if (length < kMinimumTextLength || !ASTextParagraphLayoutSupportsText(text)) {
+    return NULL;
+  }
+
+  std::vector<NSRange> paragraphs;
+  for (NSUInteger location = 0; location < length;) {
+    NSUInteger end;
+    [string getParagraphStart:NULL end:&end contentsEnd:NULL forRange:NSMakeRange(location, 0)];
+    paragraphs.push_back(NSMakeRange(location, end - location));
+    location = end;
+  }
+  const size_t paragraphCount = paragraphs.size();
+  if (paragraphCount < 2) {
+    return NULL;
+  }
+
+  // Break each paragraph into lines.
+  std::vector<ASTextParagraphKey *> keys;
+  keys.reserve(paragraphCount);
+  for (const NSRange &paragraph : paragraphs) {
+    keys.push_back([[ASTextParagraphKey alloc] initWithText:[text attributedSubstringFromRange:paragraph] width:boxSize.width]);
+  }
+  std::vector<ASTextParagraphLines *> results;
+  if (!ASTextParagraphLayoutFetchLines(keys, results, frameAttributes)) {
+    return NULL;
+  }
+
+  // The space between two paragraphs depends on both of them. Measure it by laying out the last line of
+  // one and the first line of the next on their own. Make the frame wide enough to keep them on a line each.
+  std::vector<ASTextParagraphKey *> gapKeys;
+  gapKeys.reserve(paragraphCount - 1);
+  for (size_t i = 0; i + 1 < paragraphCount; i++) {
+    NSRange lastLine = results[i]->_ranges.back();
+    NSRange firstLine = results[i + 1]->_ranges.front();
+    if (NSMaxRange(lastLine) != paragraphs[i].length || firstLine.location != 0) {
+      return NULL;
+    }
+    NSRange gapRange = NSMakeRange(paragraphs[i].location + lastLine.location, lastLine.length + firstLine.length);
+    gapKeys.push_back([[ASTextParagraphKey alloc] initWithText:[text attributedSubstringFromRange:gapRange] width:ASTextContainerMaxSize.width]);
+  }
+  std::vector<ASTextParagraphLines *> gapResults;
+  if (!ASTextParagraphLayoutFetchLines(gapKeys, gapResults, frameAttributes)) {
+    return NULL;
+  }
+  for (size_t i = 0; i + 1 < paragraphCount; i++) {
+    ASTextParagraphLines *gap = gapResults[i];
+    if (gap->_ranges.size() < 2 || gap->_ranges[1].location != results[i]->_ranges.back().length) {
+      return NULL;
+    }
+  }
+
+  // Stack the cached lines of the paragraphs. Their string indexes stay relative to their paragraph.
+  CFMutableArrayRef ctLines = CFArrayCreateMutable(kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks);
+  std::vector<CGPoint> origins;
+  std::vector<NSUInteger> offsets;
+  NSUInteger visibleEnd = 0;
+  CGFloat paragraphTop = results[0]->_positions[0].y;
+  for (size_t i = 0; i < paragraphCount; i++) {
+    ASTextParagraphLines *lines = results[i];
+    const CGFloat firstTop = lines->_positions[0].y;
+    BOOL filled = NO;
+    for (size_t j = 0; j < lines->_ranges.size(); j++) {
+      CGFloat top = paragraphTop + lines->_positions[j].y - firstTop;
+      if (top > boxSize.height) {
+        filled = YES;
+        break;
+      }
+      CFArrayAppendValue(ctLines, (__bridge CTLineRef)lines->_lines[j]);
+      origins.push_back(CGPointMake(lines->_positions[j].x, boxSize.height - top));
+      offsets.push_back(paragraphs[i].location);
+      visibleEnd = paragraphs[i].location + NSMaxRange(lines->_ranges[j]);
+    }
+    if (filled) {
+      break;
+    }
+    if (i + 1 < paragraphCount) {
+      ASTextParagraphLines *gap = gapResults[i];
+      paragraphTop += (lines->_positions.back().y - firstTop) + (gap->_positions[1].y - gap->_positions[0].y);
+    }
+  }
+
+  *lineOrigins = NULL;
+  *lineStringOffsets = NULL;
+  if (!origins.empty()) {
+    *lineOrigins = (CGPoint *)malloc(origins.size() * sizeof(CGPoint));
+    memcpy(*lineOrigins, origins.data(), origins.size() * sizeof(CGPoint));
+    *lineStringOffsets = (NSUInteger *)malloc(offsets.size() * sizeof(NSUInteger));
+    memcpy(*lineStringOffsets, offsets.data(), offsets.size() * sizeof(NSUInteger));
+  }
+  *visibleRange = NSMakeRange(0, visibleEnd);
+  return ctLines;
+}
@@ -214,6 +214,22 @@ NSString *NSStringFromASHierarchyChangeType(_ASHierarchyChangeType changeType);
 - (void)moveSection:(NSInteger)section toSection:(NSInteger)newSection animationOptions:(ASDataControllerAnimationOptions)options;
 - (void)moveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath animationOptions:(ASDataControllerAnimationOptions)options;
 
+/**
+ * Adds the item deletions and insertions that turn oldItems into newItems in the given section.
+ * The arrays are diffed with -asdk_diffWithArray:insertions:deletions:, comparing items with
+ * `isEqual:` and `hash`. Moved items become a deletion and an insertion, like -moveItemAtIndexPath:toIndexPath:.
+ *
+ * Until the change set is handed to the data controller, this can be called on any thread, so whole snapshots
+ * of a section can be diffed off the main thread.
+ */
+- (void)updateItemsInSection:(NSInteger)section fromArray:(NSArray *)oldItems toArray:(NSArray *)newItems animationOptions:(ASDataControllerAnimationOptions)options;
+
+/**
+ * Adds item deletions and insertions in the given section, e.g. from a diff that was computed earlier.
+ * Deletions are indexes in the old items and insertions are indexes in the new items.
+ */
+- (void)deleteItemsAtIndexes:(NSIndexSet *)deletions insertItemsAtIndexes:(NSIndexSet *)insertions inSection:(NSInteger)section animationOptions:(ASDataControllerAnimationOptions)options;
+
 @end
 
 NS_ASSUME_NONNULL_END
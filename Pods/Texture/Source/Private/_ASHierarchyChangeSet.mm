@@ -18,6 +18,7 @@
 #import <AsyncDisplayKit/_ASHierarchyChangeSet.h>
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/NSIndexSet+ASHelpers.h>
+#import <AsyncDisplayKit/NSArray+Diffing.h>
 #import <AsyncDisplayKit/ASAssert.h>
 #import <AsyncDisplayKit/ASDisplayNode+Beta.h>
 #import <AsyncDisplayKit/ASObjectDescriptionHelpers.h>
@@ -421,6 +422,36 @@ NSString *NSStringFromASHierarchyChangeType(_ASHierarchyChangeType changeType)
   [self insertItems:@[ newIndexPath ] animationOptions:options];
 }
 
+- (void)updateItemsInSection:(NSInteger)section fromArray:(NSArray *)oldItems toArray:(NSArray *)newItems animationOptions:(ASDataControllerAnimationOptions)options
+{
+  NSIndexSet *insertions, *deletions;
+  [oldItems asdk_diffWithArray:newItems insertions:&insertions deletions:&deletions];
+  [self deleteItemsAtIndexes:deletions insertItemsAtIndexes:insertions inSection:section animationOptions:options];
+}
+
+- (void)deleteItemsAtIndexes:(NSIndexSet *)deletions insertItemsAtIndexes:(NSIndexSet *)insertions inSection:(NSInteger)section animationOptions:(ASDataControllerAnimationOptions)options
+{
+  [self _ensureNotCompleted];
+
+  // Index sets enumerate in ascending order, so the changes don't need to sort their index paths again.
+  NSArray *(^indexPathsForIndexes)(NSIndexSet *) = ^NSArray *(NSIndexSet *indexes) {
+    NSMutableArray *indexPaths = [NSMutableArray arrayWithCapacity:indexes.count];
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL * _Nonnull stop) {
+      [indexPaths addObject:[NSIndexPath indexPathForItem:idx inSection:section]];
+    }];
+    return indexPaths;
+  };
+
+  if (deletions.count > 0) {
+    _ASHierarchyItemChange *change = [[_ASHierarchyItemChange alloc] initWithChangeType:_ASHierarchyChangeTypeOriginalDelete indexPaths:indexPathsForIndexes(deletions) animationOptions:options presorted:YES];
+    [_originalDeleteItemChanges addObject:change];
+  }
+  if (insertions.count > 0) {
+    _ASHierarchyItemChange *change = [[_ASHierarchyItemChange alloc] initWithChangeType:_ASHierarchyChangeTypeOriginalInsert indexPaths:indexPathsForIndexes(insertions) animationOptions:options presorted:YES];
+    [_originalInsertItemChanges addObject:change];
+  }
+}
+
 - (void)moveSection:(NSInteger)section toSection:(NSInteger)newSection animationOptions:(ASDataControllerAnimationOptions)options
 {
   /**
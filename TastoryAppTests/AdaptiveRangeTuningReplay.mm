@@ -0,0 +1,211 @@
+//
+//  AdaptiveRangeTuningReplay.mm
+//  TastoryAppTests
+//
+
+#import <XCTest/XCTest.h>
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASAbstractLayoutController.h>
+
+#import <vector>
+
+typedef struct {
+  CFTimeInterval timestamp;
+  CGFloat offset;
+} ScrollTraceSample;
+
+static const CGSize kViewportSize = { 375, 667 };
+static const CGFloat kCellHeight = 250;
+static const CFTimeInterval kFrameInterval = 1.0 / 60.0;
+static const CGFloat kDecelerationRate = 0.998;  // UIScrollViewDecelerationRateNormal, per millisecond.
+
+/// The full range mode display range of ASAbstractLayoutController.
+static const ASRangeTuningParameters kBaseDisplayTuningParameters = { .leadingBufferScreenfuls = 1.0, .trailingBufferScreenfuls = 0.5 };
+
+/**
+ * Replays scroll traces through a feed of fixed height cells and counts the cells that scroll into view before
+ * their contents are displayed, with the configured display range and with the one an ASAdaptiveRangeTuner picks.
+ * A cell's contents are ready a fixed latency after it enters the display range, and are cleared when it leaves.
+ *
+ * Recorded traces are JSON arrays of [timestamp, contentOffset.y] pairs in files ending in .scrolltrace.json,
+ * added to the test bundle. Without any, synthetic reading, steady and fling traces are replayed.
+ */
+@interface AdaptiveRangeTuningReplay : XCTestCase
+@end
+
+@implementation AdaptiveRangeTuningReplay
+
++ (std::vector<ScrollTraceSample>)readingTrace
+{
+  std::vector<ScrollTraceSample> trace;
+  CFTimeInterval t = 0;
+  CGFloat offset = 0;
+  for (NSInteger page = 0; page < 20; page++) {
+    for (CFTimeInterval end = t + 1.5; t < end; t += kFrameInterval) {
+      trace.push_back({t, offset});
+      offset += 40 * kFrameInterval;
+    }
+    for (CFTimeInterval end = t + 1.0; t < end; t += kFrameInterval) {
+      trace.push_back({t, offset});
+    }
+  }
+  return trace;
+}
+
++ (std::vector<ScrollTraceSample>)steadyTrace
+{
+  std::vector<ScrollTraceSample> trace;
+  for (CFTimeInterval t = 0; t < 10; t += kFrameInterval) {
+    trace.push_back({t, (CGFloat)(1200 * t)});
+  }
+  return trace;
+}
+
++ (std::vector<ScrollTraceSample>)flingTrace
+{
+  std::vector<ScrollTraceSample> trace;
+  CFTimeInterval t = 0;
+  CGFloat offset = 0;
+  for (NSInteger fling = 0; fling < 6; fling++) {
+    for (CGFloat velocity = 6000; velocity > 10; velocity *= pow(kDecelerationRate, kFrameInterval * 1000)) {
+      trace.push_back({t, offset});
+      offset += velocity * kFrameInterval;
+      t += kFrameInterval;
+    }
+    for (CFTimeInterval end = t + 0.4; t < end; t += kFrameInterval) {
+      trace.push_back({t, offset});
+    }
+  }
+  return trace;
+}
+
++ (NSDictionary<NSString *, NSURL *> *)recordedTraceURLs
+{
+  NSMutableDictionary<NSString *, NSURL *> *traces = [NSMutableDictionary dictionary];
+  for (NSURL *URL in [[NSBundle bundleForClass:self] URLsForResourcesWithExtension:@"json" subdirectory:nil]) {
+    if ([URL.lastPathComponent hasSuffix:@".scrolltrace.json"]) {
+      traces[URL.lastPathComponent] = URL;
+    }
+  }
+  return traces;
+}
+
++ (std::vector<ScrollTraceSample>)traceWithContentsOfURL:(NSURL *)URL
+{
+  std::vector<ScrollTraceSample> trace;
+  NSData *data = [NSData dataWithContentsOfURL:URL];
+  NSArray<NSArray<NSNumber *> *> *samples = data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL] : nil;
+  for (NSArray<NSNumber *> *sample in samples) {
+    trace.push_back({sample[0].doubleValue, (CGFloat)sample[1].doubleValue});
+  }
+  return trace;
+}
+
+/// Counts the cells that appeared before their contents were ready, and the mean number of cells in the display range.
+- (void)replayTrace:(const std::vector<ScrollTraceSample> &)trace
+            latency:(CFTimeInterval)latency
+              tuner:(ASAdaptiveRangeTuner *)tuner
+         blankCells:(NSInteger *)blankCells
+        appearances:(NSInteger *)appearances
+    meanRangedCells:(CGFloat *)meanRangedCells
+{
+  CGFloat maxOffset = 0;
+  for (const auto &sample : trace) {
+    maxOffset = MAX(maxOffset, sample.offset);
+  }
+  const NSInteger cellCount = (NSInteger)ceil((maxOffset + kViewportSize.height * 8) / kCellHeight);
+  std::vector<CFTimeInterval> rangeEntryTimes(cellCount, -1);
+  std::vector<bool> visible(cellCount, false);
+
+  ASScrollDirection scrollDirection = ASScrollDirectionDown;
+  CGFloat previousOffset = trace.empty() ? 0 : trace.front().offset;
+  NSInteger blank = 0, appeared = 0, rangedCellFrames = 0;
+
+  for (const auto &sample : trace) {
+    if (sample.offset != previousOffset) {
+      scrollDirection = sample.offset > previousOffset ? ASScrollDirectionDown : ASScrollDirectionUp;
+      previousOffset = sample.offset;
+    }
+
+    const CGRect viewport = (CGRect){ CGPointMake(0, sample.offset), kViewportSize };
+    ASRangeTuningParameters parameters = kBaseDisplayTuningParameters;
+    if (tuner != nil) {
+      [tuner recordViewportBounds:viewport scrollableDirections:ASScrollDirectionVerticalDirections timestamp:sample.timestamp];
+      parameters = [tuner tuningParametersForBaseTuningParameters:parameters rangeType:ASLayoutRangeTypeDisplay];
+    }
+    const CGRect range = CGRectExpandToRangeWithScrollableDirections(viewport, parameters, ASScrollDirectionVerticalDirections, scrollDirection);
+
+    for (NSInteger i = 0; i < cellCount; i++) {
+      const CGFloat top = i * kCellHeight, bottom = top + kCellHeight;
+      if (bottom <= CGRectGetMinY(range) || top >= CGRectGetMaxY(range)) {
+        rangeEntryTimes[i] = -1;
+        visible[i] = false;
+        continue;
+      }
+      if (rangeEntryTimes[i] < 0) {
+        rangeEntryTimes[i] = sample.timestamp;
+      }
+      rangedCellFrames++;
+
+      const bool isVisible = bottom > CGRectGetMinY(viewport) && top < CGRectGetMaxY(viewport);
+      if (isVisible && !visible[i]) {
+        appeared++;
+        if (sample.timestamp - rangeEntryTimes[i] < latency) {
+          blank++;
+        }
+      }
+      visible[i] = isVisible;
+    }
+  }
+
+  *blankCells = blank;
+  *appearances = appeared;
+  *meanRangedCells = trace.empty() ? 0 : (CGFloat)rangedCellFrames / trace.size();
+}
+
+- (void)replayTrace:(const std::vector<ScrollTraceSample> &)trace named:(NSString *)name
+{
+  for (CFTimeInterval latency : {0.05, 0.15}) {
+    // The tuner smooths the latencies it is given, so settle it on the simulated one first.
+    for (NSInteger i = 0; i < 100; i++) {
+      [ASAdaptiveRangeTuner recordDisplayLatency:latency];
+    }
+
+    NSInteger staticBlank, staticAppearances, adaptiveBlank, adaptiveAppearances;
+    CGFloat staticRanged, adaptiveRanged;
+    [self replayTrace:trace latency:latency tuner:nil
+           blankCells:&staticBlank appearances:&staticAppearances meanRangedCells:&staticRanged];
+    [self replayTrace:trace latency:latency tuner:[[ASAdaptiveRangeTuner alloc] init]
+           blankCells:&adaptiveBlank appearances:&adaptiveAppearances meanRangedCells:&adaptiveRanged];
+    XCTAssertEqual(staticAppearances, adaptiveAppearances);
+
+    NSLog(@"%@, %.0f ms display latency: configured range %ld/%ld cells blank, %.1f cells in range; "
+          @"adaptive range %ld/%ld cells blank, %.1f cells in range",
+          name, latency * 1000, (long)staticBlank, (long)staticAppearances, staticRanged,
+          (long)adaptiveBlank, (long)adaptiveAppearances, adaptiveRanged);
+  }
+}
+
+- (void)testReplayReadingTrace
+{
+  [self replayTrace:[[self class] readingTrace] named:@"Reading"];
+}
+
+- (void)testReplaySteadyScrollTrace
+{
+  [self replayTrace:[[self class] steadyTrace] named:@"Steady scroll"];
+}
+
+- (void)testReplayFlingTrace
+{
+  [self replayTrace:[[self class] flingTrace] named:@"Flings"];
+}
+
+- (void)testReplayRecordedTraces
+{
+  [[[self class] recordedTraceURLs] enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSURL *URL, BOOL *stop) {
+    [self replayTrace:[[self class] traceWithContentsOfURL:URL] named:name];
+  }];
+}
+
+@end
@@ -0,0 +1,125 @@
+//
+//  GZIPBenchmarks.m
+//  TastoryAppTests
+//
+
+#import <XCTest/XCTest.h>
+#import <AWSCore/AWSCore.h>
+
+static const NSUInteger kMegabyte = 1024 * 1024;
+static const NSUInteger kStreamChunkSize = 64 * 1024;
+
+/**
+ * Gzip and gunzip throughput over JSON payloads of 1 MB to 100 MB, one-shot through the NSData category and
+ * incrementally through AWSGZIPStream.
+ */
+@interface GZIPBenchmarks : XCTestCase
+@end
+
+@implementation GZIPBenchmarks
+
++ (NSData *)JSONPayloadOfLength:(NSUInteger)length {
+    NSMutableData *payload = [NSMutableData dataWithCapacity:length + 256];
+    [payload appendBytes:"[" length:1];
+    for (NSUInteger i = 0; payload.length < length - 1; i++) {
+        NSString *record = [NSString stringWithFormat:@"{\"objectId\":\"%08x\",\"index\":%lu,\"title\":\"Story %lu\",\"score\":%u.%02u,\"tags\":[\"food\",\"travel\"]},",
+                            arc4random(), (unsigned long)i, (unsigned long)i, arc4random_uniform(100), arc4random_uniform(100)];
+        [payload appendData:[record dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    payload.length = length - 1;
+    [payload appendBytes:"]" length:1];
+    return payload;
+}
+
+- (void)logThroughputOf:(NSString *)operation length:(NSUInteger)length seconds:(CFTimeInterval)seconds {
+    NSLog(@"%@ %lu MB: %.0f MB/s", operation, (unsigned long)(length / kMegabyte), length / kMegabyte / seconds);
+}
+
+- (void)gzipPayloadOfLength:(NSUInteger)length {
+    NSData *payload = [[self class] JSONPayloadOfLength:length];
+    __block CFTimeInterval fastest = DBL_MAX;
+    __block NSUInteger compressedLength = 0;
+    [self measureBlock:^{
+        @autoreleasepool {
+            CFTimeInterval start = CACurrentMediaTime();
+            NSData *compressed = [payload awsgzip_gzippedData];
+            fastest = MIN(fastest, CACurrentMediaTime() - start);
+            compressedLength = compressed.length;
+        }
+    }];
+    [self logThroughputOf:@"Gzip" length:length seconds:fastest];
+    NSLog(@"Gzip %lu MB: compressed to %.1f%%", (unsigned long)(length / kMegabyte), 100.0 * compressedLength / length);
+}
+
+- (void)gunzipPayloadOfLength:(NSUInteger)length {
+    NSData *compressed = [[[self class] JSONPayloadOfLength:length] awsgzip_gzippedData];
+    __block CFTimeInterval fastest = DBL_MAX;
+    [self measureBlock:^{
+        @autoreleasepool {
+            CFTimeInterval start = CACurrentMediaTime();
+            NSData *decompressed = [compressed awsgzip_gunzippedData];
+            fastest = MIN(fastest, CACurrentMediaTime() - start);
+            XCTAssertEqual(decompressed.length, length);
+        }
+    }];
+    [self logThroughputOf:@"Gunzip" length:length seconds:fastest];
+}
+
+- (void)testGzip1MB {
+    [self gzipPayloadOfLength:kMegabyte];
+}
+
+- (void)testGzip10MB {
+    [self gzipPayloadOfLength:10 * kMegabyte];
+}
+
+- (void)testGzip100MB {
+    [self gzipPayloadOfLength:100 * kMegabyte];
+}
+
+- (void)testGunzip1MB {
+    [self gunzipPayloadOfLength:kMegabyte];
+}
+
+- (void)testGunzip10MB {
+    [self gunzipPayloadOfLength:10 * kMegabyte];
+}
+
+- (void)testGunzip100MB {
+    [self gunzipPayloadOfLength:100 * kMegabyte];
+}
+
+/// 100 MB fed through one compressor and one decompressor in 64 KB chunks, as a payload read from a stream would be.
+- (void)testStreamingRoundTrip100MB {
+    NSUInteger length = 100 * kMegabyte;
+    NSData *payload = [[self class] JSONPayloadOfLength:length];
+    AWSGZIPStream *compressor = [[AWSGZIPStream alloc] initCompressorWithCompressionLevel:-1.0f];
+    AWSGZIPStream *decompressor = [[AWSGZIPStream alloc] initDecompressor];
+    __block CFTimeInterval fastest = DBL_MAX;
+
+    [self measureBlock:^{
+        [compressor reset];
+        [decompressor reset];
+        __block NSUInteger decompressedLength = 0;
+        AWSGZIPOutputHandler countDecompressed = ^(const void *bytes, NSUInteger outputLength) {
+            decompressedLength += outputLength;
+        };
+        AWSGZIPOutputHandler decompress = ^(const void *bytes, NSUInteger outputLength) {
+            XCTAssertTrue([decompressor processBytes:bytes length:outputLength outputHandler:countDecompressed]);
+        };
+
+        CFTimeInterval start = CACurrentMediaTime();
+        for (NSUInteger offset = 0; offset < length; offset += kStreamChunkSize) {
+            [compressor processBytes:(const uint8_t *)payload.bytes + offset
+                              length:MIN(kStreamChunkSize, length - offset)
+                       outputHandler:decompress];
+        }
+        [compressor finishWithOutputHandler:decompress];
+        XCTAssertTrue([decompressor finishWithOutputHandler:countDecompressed]);
+        fastest = MIN(fastest, CACurrentMediaTime() - start);
+        XCTAssertEqual(decompressedLength, length);
+    }];
+    [self logThroughputOf:@"Streaming gzip and gunzip" length:length seconds:fastest];
+}
+
+@end
@@ -0,0 +1,102 @@
+//
+//  ImageBufferPoolBenchmarks.m
+//  TastoryAppTests
+//
+
+#import <XCTest/XCTest.h>
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASCGImageBuffer.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <mach/mach.h>
+
+// Texture's hook for switching experiments in tests.
+@interface ASConfigurationManager (ImageBufferPoolBenchmarks)
++ (void)test_resetWithConfiguration:(ASConfiguration *)configuration;
+@end
+
+static const NSInteger kCellCount = 200;
+static const NSInteger kCellsEnteringPerFrame = 4;
+static const NSInteger kCellsOnScreen = 12;
+static const CGSize kCellSize = { 375, 250 };
+
+static uint64_t ImageBufferPoolBenchmarksFootprint(void)
+{
+  task_vm_info_data_t info;
+  mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+  if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  return info.phys_footprint;
+}
+
+/**
+ * Backing store allocation over a synthetic scroll through 200 cells at 60 fps, with and without the
+ * pool of recycled buffers. Every frame draws the cells that enter the screen and drops those that leave.
+ */
+@interface ImageBufferPoolBenchmarks : XCTestCase
+@end
+
+@implementation ImageBufferPoolBenchmarks
+
+- (void)tearDown
+{
+  [ASConfigurationManager test_resetWithConfiguration:nil];
+  [ASCGImageBuffer trimPool];
+  [super tearDown];
+}
+
+- (void)scrollWithExperiments:(ASExperimentalFeatures)experiments
+{
+  ASConfiguration *configuration = [[ASConfiguration alloc] init];
+  configuration.experimentalFeatures = experiments;
+  [ASConfigurationManager test_resetWithConfiguration:configuration];
+  [ASCGImageBuffer trimPool];
+
+  ASCGImageBufferPoolStatistics before = [ASCGImageBuffer poolStatistics];
+  __block uint64_t footprintGrowth = 0;
+  __block uint64_t peakFootprint = 0;
+  __block CFTimeInterval slowestFrame = 0;
+
+  [self measureBlock:^{
+    NSMutableArray<UIImage *> *visibleCells = [NSMutableArray array];
+    uint64_t footprint = ImageBufferPoolBenchmarksFootprint();
+    for (NSInteger first = 0; first < kCellCount; first += kCellsEnteringPerFrame) {
+      CFTimeInterval frameStart = CACurrentMediaTime();
+      @autoreleasepool {
+        for (NSInteger i = first; i < MIN(first + kCellsEnteringPerFrame, kCellCount); i++) {
+          ASGraphicsBeginImageContextWithOptions(kCellSize, YES, 3);
+          [[UIColor colorWithHue:(CGFloat)i / kCellCount saturation:0.5 brightness:0.9 alpha:1] setFill];
+          UIRectFill((CGRect){ CGPointZero, kCellSize });
+          [visibleCells addObject:ASGraphicsGetImageAndEndCurrentContext()];
+        }
+        while (visibleCells.count > kCellsOnScreen) {
+          [visibleCells removeObjectAtIndex:0];
+        }
+      }
+      slowestFrame = MAX(slowestFrame, CACurrentMediaTime() - frameStart);
+
+      uint64_t newFootprint = ImageBufferPoolBenchmarksFootprint();
+      footprintGrowth += (newFootprint > footprint ? newFootprint - footprint : 0);
+      peakFootprint = MAX(peakFootprint, newFootprint);
+      footprint = newFootprint;
+    }
+  }];
+
+  ASCGImageBufferPoolStatistics after = [ASCGImageBuffer poolStatistics];
+  NSLog(@"Image buffer pool %@: %lu hits, %lu misses, %.1f MB resident; footprint growth %.1f MB, peak %.1f MB; slowest frame %.2f ms",
+        (experiments & ASExperimentalImageBufferPool) ? @"on" : @"off",
+        (unsigned long)(after.hits - before.hits), (unsigned long)(after.misses - before.misses),
+        after.bytesResident / 1048576.0, footprintGrowth / 1048576.0, peakFootprint / 1048576.0, slowestFrame * 1000);
+}
+
+- (void)testScrollWithoutPool
+{
+  [self scrollWithExperiments:ASExperimentalGraphicsContexts];
+}
+
+- (void)testScrollWithPool
+{
+  [self scrollWithExperiments:ASExperimentalGraphicsContexts | ASExperimentalImageBufferPool];
+}
+
+@end
@@ -0,0 +1,134 @@
+//
+//  LayoutApplyBenchmarks.m
+//  TastoryAppTests
+//
+
+#import <XCTest/XCTest.h>
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+
+// Texture's main thread pass that applies a node's calculated layout to its subnodes.
+@interface ASDisplayNode (LayoutApplyBenchmarks)
+- (void)_layoutSublayouts;
+@end
+
+static const NSInteger kCellCount = 500;
+static const NSInteger kRowsPerCell = 8;
+static const NSInteger kSubnodesPerRow = 5;
+static const NSInteger kPassCount = 10;
+
+// Applies a layout tree as it came out of the layout specs, accumulating positions down to every node.
+static void LayoutApplyBenchmarksApplyTree(ASLayout *layout, CGPoint origin)
+{
+  for (ASLayout *sublayout in layout.sublayouts) {
+    CGPoint position = CGPointMake(origin.x + sublayout.position.x, origin.y + sublayout.position.y);
+    if (sublayout.type == ASLayoutElementTypeDisplayNode) {
+      ((ASDisplayNode *)sublayout.layoutElement).frame = (CGRect){ position, sublayout.size };
+    } else {
+      LayoutApplyBenchmarksApplyTree(sublayout, position);
+    }
+  }
+}
+
+/**
+ * Applying the layouts of cells with 40 subnodes in nested stacks: by walking the layout tree, by looking up every
+ * subnode in a flattened layout, and through the flat buffer that -_layoutSublayouts walks.
+ */
+@interface LayoutApplyBenchmarks : XCTestCase
+@end
+
+@implementation LayoutApplyBenchmarks {
+  NSArray<ASDisplayNode *> *_cells;
+}
+
+- (void)setUp
+{
+  [super setUp];
+  ASDisplayNode.shouldStoreUnflattenedLayouts = YES;
+
+  NSMutableArray<ASDisplayNode *> *cells = [NSMutableArray arrayWithCapacity:kCellCount];
+  for (NSInteger i = 0; i < kCellCount; i++) {
+    NSMutableArray<ASDisplayNode *> *subnodes = [NSMutableArray arrayWithCapacity:kRowsPerCell * kSubnodesPerRow];
+    for (NSInteger j = 0; j < kRowsPerCell * kSubnodesPerRow; j++) {
+      ASDisplayNode *subnode = [[ASDisplayNode alloc] init];
+      subnode.style.preferredSize = CGSizeMake(40 + j % 3 * 10, 20 + j % 4 * 5);
+      [subnodes addObject:subnode];
+    }
+
+    ASDisplayNode *cell = [[ASDisplayNode alloc] init];
+    cell.automaticallyManagesSubnodes = YES;
+    cell.layoutSpecBlock = ^ASLayoutSpec *(__kindof ASDisplayNode *node, ASSizeRange constrainedSize) {
+      NSMutableArray<ASLayoutSpec *> *rows = [NSMutableArray arrayWithCapacity:kRowsPerCell];
+      for (NSInteger row = 0; row < kRowsPerCell; row++) {
+        ASStackLayoutSpec *rowStack = [ASStackLayoutSpec horizontalStackLayoutSpec];
+        rowStack.spacing = 8;
+        rowStack.alignItems = ASStackLayoutAlignItemsCenter;
+        rowStack.children = [subnodes subarrayWithRange:NSMakeRange(row * kSubnodesPerRow, kSubnodesPerRow)];
+        [rows addObject:[ASInsetLayoutSpec insetLayoutSpecWithInsets:UIEdgeInsetsMake(2, 4, 2, 4) child:rowStack]];
+      }
+      ASStackLayoutSpec *stack = [ASStackLayoutSpec verticalStackLayoutSpec];
+      stack.children = rows;
+      return [ASInsetLayoutSpec insetLayoutSpecWithInsets:UIEdgeInsetsMake(12, 16, 12, 16) child:stack];
+    };
+
+    CGSize size = [cell layoutThatFits:ASSizeRangeMake(CGSizeMake(375, 0), CGSizeMake(375, CGFLOAT_MAX))].size;
+    cell.frame = (CGRect){ CGPointZero, size };
+    [cell.view layoutIfNeeded];
+    [cells addObject:cell];
+  }
+  _cells = cells;
+}
+
+- (void)tearDown
+{
+  _cells = nil;
+  ASDisplayNode.shouldStoreUnflattenedLayouts = NO;
+  [super tearDown];
+}
+
+- (void)testApplyLayoutTree
+{
+  [self measureBlock:^{
+    for (NSInteger pass = 0; pass < kPassCount; pass++) {
+      for (ASDisplayNode *cell in self->_cells) {
+        LayoutApplyBenchmarksApplyTree(cell.unflattenedCalculatedLayout, CGPointZero);
+      }
+    }
+  }];
+}
+
+- (void)testApplyFlattenedLayoutByLookup
+{
+  // Copies of the flattened layouts without a flat buffer, applied the way -_layoutSublayouts falls back to.
+  NSMutableArray<ASLayout *> *layouts = [NSMutableArray arrayWithCapacity:kCellCount];
+  for (ASDisplayNode *cell in _cells) {
+    ASLayout *layout = cell.calculatedLayout;
+    [layouts addObject:[ASLayout layoutWithLayoutElement:cell size:layout.size sublayouts:layout.sublayouts]];
+  }
+
+  [self measureBlock:^{
+    for (NSInteger pass = 0; pass < kPassCount; pass++) {
+      [self->_cells enumerateObjectsUsingBlock:^(ASDisplayNode *cell, NSUInteger idx, BOOL *stop) {
+        ASLayout *layout = layouts[idx];
+        for (ASDisplayNode *node in cell.subnodes) {
+          CGRect frame = [layout frameForElement:node];
+          if (!CGRectIsNull(frame)) {
+            node.frame = frame;
+          }
+        }
+      }];
+    }
+  }];
+}
+
+- (void)testApplyFlatBuffer
+{
+  [self measureBlock:^{
+    for (NSInteger pass = 0; pass < kPassCount; pass++) {
+      for (ASDisplayNode *cell in self->_cells) {
+        [cell _layoutSublayouts];
+      }
+    }
+  }];
+}
+
+@end
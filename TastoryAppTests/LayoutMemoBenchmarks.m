@@ -0,0 +1,145 @@
+//
+//  LayoutMemoBenchmarks.m
+//  TastoryAppTests
+//
+
+#import <XCTest/XCTest.h>
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASDisplayNode+Beta.h>
+
+static const NSInteger kItemCount = 5000;
+static const NSInteger kTemplateCount = 50;
+static const CGFloat kCollectionWidth = 375;
+
+/// A feed cell with a thumbnail, a title and a body, whose layout only depends on its template.
+@interface LayoutMemoBenchmarkCellNode : ASCellNode
+@end
+
+@implementation LayoutMemoBenchmarkCellNode {
+  ASImageNode *_thumbnailNode;
+  ASTextNode *_titleNode;
+  ASTextNode *_bodyNode;
+}
+
+- (instancetype)initWithTemplate:(NSInteger)templateIndex
+{
+  if (self = [super init]) {
+    self.automaticallyManagesSubnodes = YES;
+
+    _thumbnailNode = [[ASImageNode alloc] init];
+    _thumbnailNode.style.preferredSize = CGSizeMake(60, 60);
+
+    _titleNode = [[ASTextNode alloc] init];
+    _titleNode.maximumNumberOfLines = 2;
+    _titleNode.attributedText = [[NSAttributedString alloc] initWithString:[NSString stringWithFormat:@"Dish number %ld", (long)templateIndex]
+                                                                attributes:@{ NSFontAttributeName : [UIFont boldSystemFontOfSize:17] }];
+
+    NSMutableString *body = [NSMutableString string];
+    for (NSInteger i = 0; i <= templateIndex; i++) {
+      [body appendString:@"Slow roasted, served with seasonal greens. "];
+    }
+    _bodyNode = [[ASTextNode alloc] init];
+    _bodyNode.attributedText = [[NSAttributedString alloc] initWithString:body
+                                                               attributes:@{ NSFontAttributeName : [UIFont systemFontOfSize:14] }];
+  }
+  return self;
+}
+
+- (ASLayoutSpec *)layoutSpecThatFits:(ASSizeRange)constrainedSize
+{
+  _titleNode.style.flexShrink = 1;
+  _bodyNode.style.flexShrink = 1;
+  ASStackLayoutSpec *textStack = [ASStackLayoutSpec verticalStackLayoutSpec];
+  textStack.spacing = 4;
+  textStack.style.flexShrink = 1;
+  textStack.children = @[ _titleNode, _bodyNode ];
+
+  ASStackLayoutSpec *stack = [ASStackLayoutSpec horizontalStackLayoutSpec];
+  stack.spacing = 12;
+  stack.children = @[ _thumbnailNode, textStack ];
+  return [ASInsetLayoutSpec insetLayoutSpecWithInsets:UIEdgeInsetsMake(12, 16, 12, 16) child:stack];
+}
+
+@end
+
+/**
+ * Cell allocation and measurement for 5k inserted items drawn from 50 templates, with and without the layout
+ * memo cache. Every insert uses new hashes, so each run starts with a cold cache.
+ */
+@interface LayoutMemoBenchmarks : XCTestCase <ASCollectionDataSource, ASCollectionDelegate>
+@end
+
+@implementation LayoutMemoBenchmarks {
+  NSInteger _itemCount;
+  BOOL _memoizes;
+  NSUInteger _hashSalt;
+}
+
+- (NSInteger)collectionNode:(ASCollectionNode *)collectionNode numberOfItemsInSection:(NSInteger)section
+{
+  return _itemCount;
+}
+
+- (ASCellNodeBlock)collectionNode:(ASCollectionNode *)collectionNode nodeBlockForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+  NSInteger templateIndex = indexPath.item % kTemplateCount;
+  NSUInteger contentHash = _memoizes ? _hashSalt * kTemplateCount + templateIndex + 1 : 0;
+  return ^{
+    LayoutMemoBenchmarkCellNode *node = [[LayoutMemoBenchmarkCellNode alloc] initWithTemplate:templateIndex];
+    node.layoutContentHash = contentHash;
+    return node;
+  };
+}
+
+- (ASSizeRange)collectionNode:(ASCollectionNode *)collectionNode constrainedSizeForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+  return ASSizeRangeMake(CGSizeMake(kCollectionWidth, 0), CGSizeMake(kCollectionWidth, CGFLOAT_MAX));
+}
+
+- (void)insertItemsWithMemoization:(BOOL)memoizes
+{
+  _memoizes = memoizes;
+  ASDisplayNodeLayoutMemoStatistics before = [ASDisplayNode layoutMemoStatistics];
+
+  [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+    self->_itemCount = 0;
+    self->_hashSalt++;
+    ASCollectionNode *collectionNode = [[ASCollectionNode alloc] initWithCollectionViewLayout:[[UICollectionViewFlowLayout alloc] init]];
+    collectionNode.frame = CGRectMake(0, 0, kCollectionWidth, 667);
+    collectionNode.dataSource = self;
+    collectionNode.delegate = self;
+    [collectionNode reloadData];
+    [collectionNode waitUntilAllUpdatesAreProcessed];
+
+    NSMutableArray<NSIndexPath *> *indexPaths = [NSMutableArray arrayWithCapacity:kItemCount];
+    for (NSInteger i = 0; i < kItemCount; i++) {
+      [indexPaths addObject:[NSIndexPath indexPathForItem:i inSection:0]];
+    }
+
+    [self startMeasuring];
+    self->_itemCount = kItemCount;
+    [collectionNode insertItemsAtIndexPaths:indexPaths];
+    [collectionNode waitUntilAllUpdatesAreProcessed];
+    [self stopMeasuring];
+
+    XCTAssertEqual([collectionNode numberOfItemsInSection:0], kItemCount);
+    collectionNode.dataSource = nil;
+    collectionNode.delegate = nil;
+  }];
+
+  ASDisplayNodeLayoutMemoStatistics after = [ASDisplayNode layoutMemoStatistics];
+  NSLog(@"Layout memo cache %@: %lu hits, %lu misses", memoizes ? @"on" : @"off",
+        (unsigned long)(after.hits - before.hits), (unsigned long)(after.misses - before.misses));
+}
+
+- (void)testInsert5kItemsWithoutMemoization
+{
+  [self insertItemsWithMemoization:NO];
+}
+
+- (void)testInsert5kItemsWithMemoization
+{
+  [self insertItemsWithMemoization:YES];
+}
+
+@end
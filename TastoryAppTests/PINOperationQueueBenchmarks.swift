@@ -0,0 +1,58 @@
+//
+//  PINOperationQueueBenchmarks.swift
+//  TastoryAppTests
+//
+
+import XCTest
+import PINOperation
+
+/// Throughput and scheduling latency of PINOperationQueue for tiny operations from 1, 4 and 8 producers.
+class PINOperationQueueBenchmarks: XCTestCase {
+
+  private let operationCount = 100_000
+
+  private func run(producers: Int) {
+    let queue = PINOperationQueue(maxConcurrentOperations: UInt(max(ProcessInfo.processInfo.activeProcessorCount, 2)))
+    let latencies = UnsafeMutableBufferPointer<CFTimeInterval>.allocate(capacity: operationCount)
+    defer { latencies.deallocate() }
+    let priorities: [PINOperationQueuePriority] = [.low, .default, .high]
+    let operationsPerProducer = operationCount / producers
+
+    let start = CACurrentMediaTime()
+    DispatchQueue.concurrentPerform(iterations: producers) { producer in
+      for i in 0..<operationsPerProducer {
+        let slot = producer * operationsPerProducer + i
+        let scheduled = CACurrentMediaTime()
+        queue.scheduleOperation({
+          latencies[slot] = CACurrentMediaTime() - scheduled
+        }, with: priorities[i % priorities.count])
+      }
+    }
+    queue.waitUntilAllOperationsAreFinished()
+    let elapsed = CACurrentMediaTime() - start
+
+    let count = operationsPerProducer * producers
+    let sorted = latencies[0..<count].sorted()
+    let percentile = { (p: Double) in sorted[min(count - 1, Int(Double(count) * p))] * 1_000_000 }
+    print(String(format: "PINOperationQueue, %d producers: %.0f ops/s, latency p50 %.0f us, p99 %.0f us, p99.9 %.0f us, max %.0f us",
+                 producers, Double(count) / elapsed, percentile(0.5), percentile(0.99), percentile(0.999), percentile(1)))
+  }
+
+  func testThroughputAndLatencyWith1Producer() {
+    measure {
+      run(producers: 1)
+    }
+  }
+
+  func testThroughputAndLatencyWith4Producers() {
+    measure {
+      run(producers: 4)
+    }
+  }
+
+  func testThroughputAndLatencyWith8Producers() {
+    measure {
+      run(producers: 8)
+    }
+  }
+}
@@ -0,0 +1,85 @@
+//
+//  ParagraphTextLayoutBenchmarks.m
+//  TastoryAppTests
+//
+
+#import <XCTest/XCTest.h>
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+
+// Texture's hook for switching experiments in tests.
+@interface ASConfigurationManager (ParagraphTextLayoutBenchmarks)
++ (void)test_resetWithConfiguration:(ASConfiguration *)configuration;
+@end
+
+static const NSUInteger kTextLength = 20000;
+static const NSUInteger kParagraphLength = 200;
+
+/**
+ * Relayout of a 20k character text in a text node after a single character is inserted in the middle of it,
+ * with the text laid out as one frame and paragraph by paragraph.
+ */
+@interface ParagraphTextLayoutBenchmarks : XCTestCase
+@end
+
+@implementation ParagraphTextLayoutBenchmarks
+
+- (void)tearDown
+{
+  [ASConfigurationManager test_resetWithConfiguration:nil];
+  [super tearDown];
+}
+
++ (NSString *)text
+{
+  NSString *sentence = @"The broth simmers for twelve hours with charred onions, star anise and a little rock sugar. ";
+  NSMutableString *text = [NSMutableString stringWithCapacity:kTextLength];
+  while (text.length < kTextLength) {
+    NSMutableString *paragraph = [NSMutableString string];
+    while (paragraph.length < kParagraphLength - sentence.length) {
+      [paragraph appendString:sentence];
+    }
+    [paragraph appendString:@"\n"];
+    [text appendString:paragraph];
+  }
+  return text;
+}
+
+- (void)relayoutAfterEditWithExperiments:(ASExperimentalFeatures)experiments
+{
+  ASConfiguration *configuration = [[ASConfiguration alloc] init];
+  configuration.experimentalFeatures = experiments;
+  [ASConfigurationManager test_resetWithConfiguration:configuration];
+
+  NSDictionary *attributes = @{ NSFontAttributeName : [UIFont systemFontOfSize:15] };
+  NSMutableAttributedString *text = [[NSMutableAttributedString alloc] initWithString:[[self class] text] attributes:attributes];
+  ASSizeRange sizeRange = ASSizeRangeMake(CGSizeMake(375, 0), CGSizeMake(375, CGFLOAT_MAX));
+
+  ASTextNode2 *textNode = [[ASTextNode2 alloc] init];
+  textNode.attributedText = text;
+  [textNode layoutThatFits:sizeRange];
+
+  __block NSUInteger editLocation = text.length / 2;
+  [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+    // Every edit is new, so no layout of the whole text is reused.
+    [text insertAttributedString:[[NSAttributedString alloc] initWithString:@"x" attributes:attributes] atIndex:editLocation++];
+    NSAttributedString *editedText = [text copy];
+
+    [self startMeasuring];
+    textNode.attributedText = editedText;
+    [textNode layoutThatFits:sizeRange];
+    [self stopMeasuring];
+  }];
+}
+
+- (void)testRelayoutAfterEditAsOneFrame
+{
+  [self relayoutAfterEditWithExperiments:0];
+}
+
+- (void)testRelayoutAfterEditByParagraph
+{
+  [self relayoutAfterEditWithExperiments:ASExperimentalParagraphTextLayout];
+}
+
+@end
@@ -0,0 +1,135 @@
+//
+//  ParseLocalDatastoreBenchmarks.m
+//  TastoryAppTests
+//
+
+#import <XCTest/XCTest.h>
+#import <Parse/Parse.h>
+
+// Builds an object in its saved state, the way query results are decoded. Objects with unsaved
+// changes are always matched in memory, so only saved objects exercise the SQL path.
+@interface PFObject (LocalDatastoreBenchmarks)
++ (id)_objectFromDictionary:(NSDictionary *)dictionary defaultClassName:(NSString *)defaultClassName completeData:(BOOL)completeData;
+@end
+
+static NSString *const kBenchmarkClassName = @"LocalDatastoreBenchmarkObject";
+static NSString *const kBenchmarkStorePinName = @"LocalDatastoreBenchmarkStore";
+static const NSInteger kBenchmarkStoreObjectCount = 100000;
+static NSString *const kBenchmarkPinName = @"LocalDatastoreBenchmarkPin";
+static const NSInteger kBenchmarkPinObjectCount = 10000;
+
+/// Local datastore benchmarks, run against the host app's datastore under pins of their own.
+@interface ParseLocalDatastoreBenchmarks : XCTestCase
+@end
+
+@implementation ParseLocalDatastoreBenchmarks
+
++ (NSArray<PFObject *> *)savedObjectsWithPrefix:(NSString *)prefix count:(NSInteger)count
+{
+    NSMutableArray<PFObject *> *objects = [NSMutableArray arrayWithCapacity:count];
+    for (NSInteger i = 0; i < count; i++) {
+        NSDictionary *data = @{ @"objectId" : [NSString stringWithFormat:@"%@%07ld", prefix, (long)i],
+                                @"index" : @(i),
+                                @"bucket" : @(i % 100),
+                                @"score" : @((double)((i * 7919) % 10000) / 100),
+                                @"name" : [NSString stringWithFormat:@"object %ld", (long)i] };
+        [objects addObject:[PFObject _objectFromDictionary:data defaultClassName:kBenchmarkClassName completeData:YES]];
+    }
+    return objects;
+}
+
+/// A synthetic store of 100k saved objects, pinned once for the query benchmarks.
++ (void)setUp
+{
+    [super setUp];
+    NSError *error = nil;
+    if (![PFObject pinAll:[self savedObjectsWithPrefix:@"store" count:kBenchmarkStoreObjectCount]
+                 withName:kBenchmarkStorePinName
+                    error:&error]) {
+        NSLog(@"Couldn't pin the synthetic store: %@", error);
+    }
+}
+
++ (void)tearDown
+{
+    [PFObject unpinAllObjectsWithName:kBenchmarkStorePinName error:nil];
+    [super tearDown];
+}
+
+- (PFQuery *)storeQuery
+{
+    PFQuery *query = [PFQuery queryWithClassName:kBenchmarkClassName];
+    [query fromPinWithName:kBenchmarkStorePinName];
+    return query;
+}
+
+/// Equality, comparisons, $in, ordering, limit and skip, all of which are compiled to SQL.
+- (void)testPushedDownQueryOn100kObjects
+{
+    [self measureBlock:^{
+        PFQuery *query = [self storeQuery];
+        [query whereKey:@"bucket" containedIn:@[ @3, @17, @42, @64 ]];
+        [query whereKey:@"score" greaterThan:@25];
+        [query whereKey:@"score" lessThanOrEqualTo:@75];
+        [query orderByDescending:@"score"];
+        query.skip = 20;
+        query.limit = 100;
+        XCTAssertEqual([query findObjects:nil].count, 100);
+    }];
+}
+
+- (void)testPushedDownEqualityOn100kObjects
+{
+    [self measureBlock:^{
+        PFQuery *query = [self storeQuery];
+        [query whereKey:@"index" equalTo:@54321];
+        XCTAssertEqual([query findObjects:nil].count, 1);
+    }];
+}
+
+- (void)testObjectIdOn100kObjects
+{
+    [self measureBlock:^{
+        PFQuery *query = [self storeQuery];
+        [query whereKey:@"objectId" equalTo:@"store0012345"];
+        XCTAssertEqual([query findObjects:nil].count, 1);
+    }];
+}
+
+/// Pinning 10k objects, which links them to the pin with one reused statement in one transaction.
+- (void)testPin10kObjects
+{
+    [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+        NSArray<PFObject *> *objects = [[self class] savedObjectsWithPrefix:@"pin" count:kBenchmarkPinObjectCount];
+
+        [self startMeasuring];
+        XCTAssertTrue([PFObject pinAll:objects withName:kBenchmarkPinName error:nil]);
+        [self stopMeasuring];
+
+        [PFObject unpinAllObjectsWithName:kBenchmarkPinName error:nil];
+    }];
+}
+
+- (void)testUnpin10kObjects
+{
+    [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+        NSArray<PFObject *> *objects = [[self class] savedObjectsWithPrefix:@"pin" count:kBenchmarkPinObjectCount];
+        [PFObject pinAll:objects withName:kBenchmarkPinName error:nil];
+
+        [self startMeasuring];
+        XCTAssertTrue([PFObject unpinAll:objects withName:kBenchmarkPinName error:nil]);
+        [self stopMeasuring];
+    }];
+}
+
+/// A constraint that isn't compiled, so every object goes through the in-memory matcher.
+- (void)testMatcherFallbackOn100kObjects
+{
+    [self measureBlock:^{
+        PFQuery *query = [self storeQuery];
+        [query whereKey:@"name" hasPrefix:@"object 9999"];
+        XCTAssertEqual([query findObjects:nil].count, 11);
+    }];
+}
+
+@end
@@ -0,0 +1,77 @@
+//
+//  RunLoopQueueBenchmarks.swift
+//  TastoryAppTests
+//
+
+import XCTest
+import AsyncDisplayKit
+
+/// Enqueue throughput of ASRunLoopQueue from 8 producer threads, and how long objects wait
+/// before the main run loop drains them.
+class RunLoopQueueBenchmarks: XCTestCase {
+
+  private class Stamp: NSObject {
+    let enqueueTime = CACurrentMediaTime()
+  }
+
+  private let producerCount = 8
+  private let objectsPerProducer = 20_000
+
+  private func drain(_ queue: ASRunLoopQueue<Stamp>) {
+    while !queue.isEmpty {
+      RunLoop.main.run(until: Date(timeIntervalSinceNow: 0.001))
+    }
+  }
+
+  func testEnqueueThroughputFrom8Producers() {
+    let queue = ASRunLoopQueue<Stamp>(runLoop: CFRunLoopGetMain(), retainObjects: true) { _, _ in }
+    queue.batchSize = 1024
+
+    measureMetrics([XCTPerformanceMetric.wallClockTime], automaticallyStartMeasuring: false) {
+      // Allocate up front so only enqueuing is measured.
+      let batches = (0..<producerCount).map { _ in (0..<objectsPerProducer).map { _ in Stamp() } }
+
+      startMeasuring()
+      DispatchQueue.concurrentPerform(iterations: producerCount) { producer in
+        for object in batches[producer] {
+          queue.enqueue(object)
+        }
+      }
+      stopMeasuring()
+
+      drain(queue)
+    }
+  }
+
+  func testMainThreadDrainLatency() {
+    let total = producerCount * objectsPerProducer
+    var latencies = [CFTimeInterval]()
+    latencies.reserveCapacity(total)
+
+    // Configured like the render queue: bounded batches within a main thread time budget.
+    let queue = ASRunLoopQueue<Stamp>(runLoop: CFRunLoopGetMain(), retainObjects: true) { stamp, _ in
+      latencies.append(CACurrentMediaTime() - stamp.enqueueTime)
+    }
+    queue.batchSize = 64
+    queue.timeBudget = ASRunLoopQueueMainThreadTimeBudget
+
+    DispatchQueue.global().async {
+      DispatchQueue.concurrentPerform(iterations: self.producerCount) { _ in
+        for _ in 0..<self.objectsPerProducer {
+          queue.enqueue(Stamp())
+        }
+      }
+    }
+
+    let deadline = Date(timeIntervalSinceNow: 60)
+    while latencies.count < total && Date() < deadline {
+      RunLoop.main.run(until: Date(timeIntervalSinceNow: 0.001))
+    }
+    XCTAssertEqual(latencies.count, total)
+
+    latencies.sort()
+    let percentile = { (p: Double) in latencies[min(latencies.count - 1, Int(Double(latencies.count) * p))] * 1000 }
+    print(String(format: "ASRunLoopQueue drain latency: p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+                 percentile(0.5), percentile(0.99), percentile(1)))
+  }
+}
@@ -0,0 +1,117 @@
+//
+//  S3PartFileBenchmarks.m
+//  TastoryAppTests
+//
+
+#import <XCTest/XCTest.h>
+#import <AWSS3/AWSS3.h>
+#import <mach/mach.h>
+
+// The transfer utility's copy of one part of a multipart upload into the file the background session uploads.
+@interface AWSS3TransferUtility (PartFileBenchmarks)
+- (NSString *)createTemporaryFileForPart:(NSString *)fileName
+                              partNumber:(long)partNumber
+                              dataLength:(NSUInteger)dataLength
+                                   error:(NSError **)error;
+@end
+
+static NSString *const kTransferUtilityKey = @"S3PartFileBenchmarks";
+static const NSUInteger kSourceFileSize = 100 * 1024 * 1024;
+static const NSUInteger kPartSize = 5 * 1024 * 1024;
+
+static uint64_t S3PartFileBenchmarksFootprint(void)
+{
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.phys_footprint;
+}
+
+/**
+ * Splitting a 100 MB file into the 5 MB part files of a multipart upload, reporting the bytes written to disk
+ * and the peak memory growth while parts are copied, sampled every millisecond.
+ *
+ * Only the part-serving path is measured. The uploads themselves go through a background NSURLSession, which
+ * runs out of process and can't be pointed at an in-process mock endpoint.
+ */
+@interface S3PartFileBenchmarks : XCTestCase
+@end
+
+@implementation S3PartFileBenchmarks {
+    NSString *_sourceFile;
+    AWSS3TransferUtility *_transferUtility;
+}
+
+- (void)setUp {
+    [super setUp];
+
+    AWSStaticCredentialsProvider *credentialsProvider = [[AWSStaticCredentialsProvider alloc] initWithAccessKey:@"benchmark"
+                                                                                                      secretKey:@"benchmark"];
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSWest1
+                                                                         credentialsProvider:credentialsProvider];
+    [AWSS3TransferUtility registerS3TransferUtilityWithConfiguration:configuration forKey:kTransferUtilityKey];
+    _transferUtility = [AWSS3TransferUtility S3TransferUtilityForKey:kTransferUtilityKey];
+
+    _sourceFile = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [[NSFileManager defaultManager] createFileAtPath:_sourceFile contents:nil attributes:nil];
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:_sourceFile];
+    NSMutableData *chunk = [NSMutableData dataWithLength:1024 * 1024];
+    for (NSUInteger written = 0; written < kSourceFileSize; written += chunk.length) {
+        arc4random_buf(chunk.mutableBytes, chunk.length);
+        [fileHandle writeData:chunk];
+    }
+    [fileHandle closeFile];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:_sourceFile error:nil];
+    [AWSS3TransferUtility removeS3TransferUtilityForKey:kTransferUtilityKey];
+    _transferUtility = nil;
+    [super tearDown];
+}
+
+- (void)testCreatePartFilesFor100MBUpload {
+    __block uint64_t bytesWritten = 0;
+    __block uint64_t peakFootprintGrowth = 0;
+
+    [self measureBlock:^{
+        uint64_t baseline = S3PartFileBenchmarksFootprint();
+        __block uint64_t peakFootprint = baseline;
+        dispatch_queue_t samplingQueue = dispatch_queue_create("S3PartFileBenchmarks.sampling", DISPATCH_QUEUE_SERIAL);
+        dispatch_source_t sampler = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, samplingQueue);
+        dispatch_source_set_timer(sampler, DISPATCH_TIME_NOW, NSEC_PER_MSEC, 0);
+        dispatch_source_set_event_handler(sampler, ^{
+            peakFootprint = MAX(peakFootprint, S3PartFileBenchmarksFootprint());
+        });
+        dispatch_resume(sampler);
+
+        bytesWritten = 0;
+        NSUInteger partCount = (kSourceFileSize + kPartSize - 1) / kPartSize;
+        for (long partNumber = 1; partNumber <= partCount; partNumber++) {
+            @autoreleasepool {
+                NSUInteger dataLength = MIN(kPartSize, kSourceFileSize - (partNumber - 1) * kPartSize);
+                NSError *error = nil;
+                NSString *partFile = [self->_transferUtility createTemporaryFileForPart:self->_sourceFile
+                                                                             partNumber:partNumber
+                                                                             dataLength:dataLength
+                                                                                  error:&error];
+                XCTAssertNotNil(partFile, @"%@", error);
+                bytesWritten += [[[NSFileManager defaultManager] attributesOfItemAtPath:partFile error:nil] fileSize];
+                [[NSFileManager defaultManager] removeItemAtPath:partFile error:nil];
+            }
+        }
+
+        dispatch_source_cancel(sampler);
+        dispatch_sync(samplingQueue, ^{
+            peakFootprintGrowth = MAX(peakFootprintGrowth, peakFootprint - baseline);
+        });
+        XCTAssertEqual(bytesWritten, kSourceFileSize);
+    }];
+
+    NSLog(@"S3 part files for %.0f MB: %.1f MB written to disk, peak memory growth %.1f MB",
+          kSourceFileSize / 1048576.0, bytesWritten / 1048576.0, peakFootprintGrowth / 1048576.0);
+}
+
+@end